@@ -10,9 +10,20 @@
 #include "bmap.h"
 
 
-@interface GSTileRect : NSObject < NSPasteboardReading, NSPasteboardWriting > {
+struct GSTileBuffer;
+
+@interface GSTileRect : NSObject < NSCopying, NSPasteboardReading, NSPasteboardWriting > {
   GSRect rect;
+  struct GSTileBuffer *buffer;  // shared between copies until one of them is modified
   GSTile *tiles;
+
+  // objects carried with the tiles, coordinates are relative to the origin of rect
+  int npills;
+  int nbases;
+  int nstarts;
+  struct BMAP_PillInfo pills[MAX_PILLS];
+  struct BMAP_BaseInfo bases[MAX_BASES];
+  struct BMAP_StartInfo starts[MAX_STARTS];
 }
 
 + (id)tileRectWithTiles:(const GSTile *)aTiles inRect:(GSRect)aRect;
@@ -24,9 +35,23 @@
 - (id)initWithTileRect:(GSTileRect *)tileRect inRect:(GSRect)aRect;
 
 - (GSRect)rect;
+- (const GSTile *)tiles;
 - (void)setOrigin:(GSPoint)origin;
 - (void)offsetX:(int)dx y:(int)dy;
 
+// object accessors use map coordinates
+- (NSUInteger)pillCount;
+- (struct BMAP_PillInfo)pillAtIndex:(NSUInteger)i;
+- (void)addPill:(struct BMAP_PillInfo)pill;
+
+- (NSUInteger)baseCount;
+- (struct BMAP_BaseInfo)baseAtIndex:(NSUInteger)i;
+- (void)addBase:(struct BMAP_BaseInfo)base;
+
+- (NSUInteger)startCount;
+- (struct BMAP_StartInfo)startAtIndex:(NSUInteger)i;
+- (void)addStart:(struct BMAP_StartInfo)start;
+
 - (void)drawFilledEllipse:(GSTile)tile;
 
 - (void)drawEllipse:(GSTile)tile;
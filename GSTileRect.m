@@ -7,13 +7,45 @@
 //
 
 #import "GSTileRect.h"
+#include "transform.h"
 
 
 static NSString * const GSUTIString = @"com.robertchrzanowski.xbolo.map.rect";
 
+#define MAX_POOLED_BUFFERS  (8)
+
+// reference counted tile storage, only used from the main thread
+struct GSTileBuffer {
+  struct GSTileBuffer *next;
+  int refs;
+  size_t capacity;
+  GSTile tiles[];
+} ;
+
+// released buffers are kept for reuse so that transient tile rects
+// created on every mouse event do not go through malloc
+static struct GSTileBuffer *pool = NULL;
+static int pooled = 0;
+
+static struct GSTileBuffer *bufferCreate(size_t size);
+static struct GSTileBuffer *bufferRetain(struct GSTileBuffer *buffer);
+static void bufferRelease(struct GSTileBuffer *buffer);
 
 static void floodFillTilesWithSize(GSTile *tiles, GSSize size, GSTile from, GSTile to, GSPoint point);
 
+// maps a point relative to the origin of a rect of a size to its transformed position
+typedef GSPoint (*GSPointTransform)(GSPoint point, GSSize size);
+
+static GSPoint rotateLeftPoint(GSPoint point, GSSize size);
+static GSPoint rotateRightPoint(GSPoint point, GSSize size);
+static GSPoint flipHorizontalPoint(GSPoint point, GSSize size);
+static GSPoint flipVerticalPoint(GSPoint point, GSSize size);
+
+@interface GSTileRect (Private)
+- (void)makeUnique;
+- (void)transformObjects:(GSPointTransform)transform;
+@end
+
 
 @implementation GSTileRect
 
@@ -32,34 +64,27 @@ static void floodFillTilesWithSize(GSTile *tiles, GSSize size, GSTile from, GSTi
   self = [super init];
 
   if (self) {
-    NSDictionary *temp;
-    NSPropertyListFormat format;
-    NSString *errorDesc = nil;
-    NSDictionary *origin;
-    NSDictionary *size;
-    NSData *data;
-
-    temp = (NSDictionary *)[NSPropertyListSerialization
-            propertyListFromData:propertyList
-            mutabilityOption:NSPropertyListMutableContainersAndLeaves
-            format:&format
-            errorDescription:&errorDesc];
-
-    if (!temp) {
-      NSLog(@"Error reading plist: %@, format: %d", errorDesc, format);
+    NSData *data = propertyList;
+    struct BMAP_Preamble preamble;
+
+    if (loadClipRect([data bytes], [data length], &rect) == -1) {
+      NSLog(@"Error reading clip: %s", strerror(errno));
+      [self release];
+      return nil;
     }
 
-    origin = [temp objectForKey:@"origin"];
-    rect.origin = GSMakePoint([[origin objectForKey:@"x"] intValue], [[origin objectForKey:@"y"] intValue]);
+    buffer = bufferCreate(GSWidth(rect) * GSHeight(rect) * sizeof(GSTile));
+    tiles = buffer->tiles;
 
-    size = [temp objectForKey:@"size"];
-    rect.size = GSMakeSize([[size objectForKey:@"width"] intValue], [[size objectForKey:@"height"] intValue]);
+    if (loadClip([data bytes], [data length], &preamble, pills, bases, starts, tiles) == -1) {
+      NSLog(@"Error reading clip: %s", strerror(errno));
+      [self release];
+      return nil;
+    }
 
-    data = [temp objectForKey:@"tiles"];
-    NSAssert([data length] == (GSWidth(rect) * GSHeight(rect) * sizeof(GSTile)), @"Error reading plist: Data length does not match rect size.");
-    tiles = (GSTile *)malloc([data length]);
-    NSAssert(tiles, @"Malloc() Failed");
-    [data getBytes:tiles length:[data length]];
+    npills = preamble.npills;
+    nbases = preamble.nbases;
+    nstarts = preamble.nstarts;
   }
 
   return self;
@@ -74,32 +99,47 @@ static void floodFillTilesWithSize(GSTile *tiles, GSSize size, GSTile from, GSTi
 
 - (id)pasteboardPropertyListForType:(NSString *)type {
   if ([type isEqual:GSUTIString]) {
-    NSString *error;
-    NSDictionary *plistDict;
-    NSData *plistData;
-
-    plistDict =
-      [NSDictionary dictionaryWithObjects:[NSArray arrayWithObjects:
-        [NSDictionary dictionaryWithObjects:[NSArray arrayWithObjects:[NSNumber numberWithUnsignedInt:GSMinX(rect)], [NSNumber numberWithUnsignedInt:GSMinY(rect)], nil] forKeys:[NSArray arrayWithObjects:@"x", @"y", nil]],
-        [NSDictionary dictionaryWithObjects:[NSArray arrayWithObjects:[NSNumber numberWithUnsignedInt:GSWidth(rect)], [NSNumber numberWithUnsignedInt:GSHeight(rect)], nil] forKeys:[NSArray arrayWithObjects:@"width", @"height", nil]],
-        [NSData dataWithBytes:tiles length:GSWidth(rect) * GSHeight(rect) * sizeof(GSTile)],
-        nil]
-      forKeys:[NSArray arrayWithObjects:
-        @"origin", @"size", @"tiles", nil]];
-
-    plistData = [NSPropertyListSerialization dataFromPropertyList:plistDict format:NSPropertyListXMLFormat_v1_0 errorDescription:&error];
-
-    if(!plistData) {
-      NSLog(@"%@", error);
-      [error release];
+    struct BMAP_Preamble preamble;
+    void *data;
+    ssize_t length;
+
+    bzero(&preamble, sizeof(preamble));
+    preamble.npills = npills;
+    preamble.nbases = nbases;
+    preamble.nstarts = nstarts;
+
+    if ((length = saveClip(&data, rect, tiles, &preamble, pills, bases, starts)) == -1) {
+      NSLog(@"Error writing clip: %s", strerror(errno));
+      return nil;
     }
 
-    return plistData;
+    return [NSData dataWithBytesNoCopy:data length:length freeWhenDone:YES];
   }
 
   return nil;
 }
 
+// NSCopying Protocol Methods
+
+
+- (id)copyWithZone:(NSZone *)zone {
+  GSTileRect *copy = [[[self class] allocWithZone:zone] init];
+
+  if (copy) {
+    copy->rect = rect;
+    copy->buffer = buffer ? bufferRetain(buffer) : NULL;
+    copy->tiles = tiles;
+    copy->npills = npills;
+    copy->nbases = nbases;
+    copy->nstarts = nstarts;
+    bcopy(pills, copy->pills, sizeof(pills));
+    bcopy(bases, copy->bases, sizeof(bases));
+    bcopy(starts, copy->starts, sizeof(starts));
+  }
+
+  return copy;
+}
+
 // Factory Class Methods
 
 
@@ -125,17 +165,17 @@ static void floodFillTilesWithSize(GSTile *tiles, GSSize size, GSTile from, GSTi
     rect = aRect;
 
     if (!GSIsEmptyRect(aRect)) {
-      int x, y;
+      int y;
 
-      tiles = (GSTile *)malloc(GSWidth(aRect) * GSHeight(aRect) * sizeof(GSTile));
+      buffer = bufferCreate(GSWidth(aRect) * GSHeight(aRect) * sizeof(GSTile));
+      tiles = buffer->tiles;
 
       for (y = 0; y < GSHeight(rect); y++) {
-        for (x = 0; x < GSWidth(rect); x++) {
-          tiles[(y * GSWidth(rect)) + x] = aTiles[((y + GSMinY(rect)) * WIDTH) + (x + GSMinX(rect))];
-        }
+        bcopy(aTiles + ((y + GSMinY(rect)) * WIDTH) + GSMinX(rect), tiles + (y * GSWidth(rect)), GSWidth(rect) * sizeof(GSTile));
       }
     }
     else {
+      buffer = NULL;
       tiles = NULL;
     }
   }
@@ -150,15 +190,12 @@ static void floodFillTilesWithSize(GSTile *tiles, GSSize size, GSTile from, GSTi
     rect = aRect;
 
     if (!GSIsEmptyRect(aRect)) {
-      int i;
-
-      tiles = (GSTile *)malloc(GSWidth(aRect) * GSHeight(aRect) * sizeof(GSTile));
-
-      for (i = 0; i < GSWidth(rect) * GSHeight(rect); i++) {
-        tiles[i] = tile;
-      }
+      buffer = bufferCreate(GSWidth(aRect) * GSHeight(aRect) * sizeof(GSTile));
+      tiles = buffer->tiles;
+      memset(tiles, tile, GSWidth(rect) * GSHeight(rect) * sizeof(GSTile));
     }
     else {
+      buffer = NULL;
       tiles = NULL;
     }
   }
@@ -173,19 +210,47 @@ static void floodFillTilesWithSize(GSTile *tiles, GSSize size, GSTile from, GSTi
     rect = GSIntersectionRect(aRect, [tileRect rect]);
     aRect = [tileRect rect];
 
-    if (!GSIsEmptyRect(rect)) {
-      int x, y;
+    if (GSIsEmptyRect(rect)) {
+      buffer = NULL;
+      tiles = NULL;
+    }
+    else if (GSEqualRects(rect, aRect)) {
+      // share the whole buffer
+      buffer = bufferRetain(tileRect->buffer);
+      tiles = buffer->tiles;
+    }
+    else {
+      int y;
 
-      tiles = (GSTile *)malloc(GSWidth(aRect) * GSHeight(aRect) * sizeof(GSTile));
+      buffer = bufferCreate(GSWidth(rect) * GSHeight(rect) * sizeof(GSTile));
+      tiles = buffer->tiles;
 
       for (y = 0; y < GSHeight(rect); y++) {
-        for (x = 0; x < GSWidth(rect); x++) {
-          tiles[(y * GSWidth(rect)) + x] = tileRect->tiles[(((GSMinY(rect) + y) - GSMinY(aRect)) * GSWidth(aRect)) + ((GSMinX(rect) + x) - GSMinX(aRect))];
-        }
+        bcopy(tileRect->tiles + (((GSMinY(rect) + y) - GSMinY(aRect)) * GSWidth(aRect)) + (GSMinX(rect) - GSMinX(aRect)), tiles + (y * GSWidth(rect)), GSWidth(rect) * sizeof(GSTile));
       }
     }
-    else {
-      tiles = NULL;
+
+    // keep the objects that are still inside
+    if (!GSIsEmptyRect(rect)) {
+      int i;
+
+      for (i = 0; i < tileRect->npills; i++) {
+        if (GSPointInRect(rect, GSMakePoint(GSMinX(aRect) + tileRect->pills[i].x, GSMinY(aRect) + tileRect->pills[i].y))) {
+          [self addPill:[tileRect pillAtIndex:i]];
+        }
+      }
+
+      for (i = 0; i < tileRect->nbases; i++) {
+        if (GSPointInRect(rect, GSMakePoint(GSMinX(aRect) + tileRect->bases[i].x, GSMinY(aRect) + tileRect->bases[i].y))) {
+          [self addBase:[tileRect baseAtIndex:i]];
+        }
+      }
+
+      for (i = 0; i < tileRect->nstarts; i++) {
+        if (GSPointInRect(rect, GSMakePoint(GSMinX(aRect) + tileRect->starts[i].x, GSMinY(aRect) + tileRect->starts[i].y))) {
+          [self addStart:[tileRect startAtIndex:i]];
+        }
+      }
     }
   }
 
@@ -196,8 +261,8 @@ static void floodFillTilesWithSize(GSTile *tiles, GSSize size, GSTile from, GSTi
 
 
 - (void)dealloc {
-  if (tiles) {
-    free(tiles);
+  if (buffer) {
+    bufferRelease(buffer);
   }
 
   [super dealloc];
@@ -210,6 +275,10 @@ static void floodFillTilesWithSize(GSTile *tiles, GSSize size, GSTile from, GSTi
   return rect;
 }
 
+- (const GSTile *)tiles {
+  return tiles;
+}
+
 - (void)setOrigin:(GSPoint)origin {
   if (!GSEqualPoints(rect.origin, origin)) {
     rect.origin = origin;
@@ -220,6 +289,81 @@ static void floodFillTilesWithSize(GSTile *tiles, GSSize size, GSTile from, GSTi
   rect = GSOffsetRect(rect, dx, dy);
 }
 
+- (NSUInteger)pillCount {
+  return npills;
+}
+
+- (struct BMAP_PillInfo)pillAtIndex:(NSUInteger)i {
+  struct BMAP_PillInfo pill;
+
+  NSAssert(i < npills, @"Pill Out of Bounds");
+
+  pill = pills[i];
+  pill.x += GSMinX(rect);
+  pill.y += GSMinY(rect);
+
+  return pill;
+}
+
+- (void)addPill:(struct BMAP_PillInfo)pill {
+  NSAssert(npills < MAX_PILLS, @"Too Many Pills");
+  NSAssert(GSPointInRect(rect, GSMakePoint(pill.x, pill.y)), @"Pill Location Out of Bounds");
+
+  pill.x -= GSMinX(rect);
+  pill.y -= GSMinY(rect);
+  pills[npills++] = pill;
+}
+
+- (NSUInteger)baseCount {
+  return nbases;
+}
+
+- (struct BMAP_BaseInfo)baseAtIndex:(NSUInteger)i {
+  struct BMAP_BaseInfo base;
+
+  NSAssert(i < nbases, @"Base Out of Bounds");
+
+  base = bases[i];
+  base.x += GSMinX(rect);
+  base.y += GSMinY(rect);
+
+  return base;
+}
+
+- (void)addBase:(struct BMAP_BaseInfo)base {
+  NSAssert(nbases < MAX_BASES, @"Too Many Bases");
+  NSAssert(GSPointInRect(rect, GSMakePoint(base.x, base.y)), @"Base Location Out of Bounds");
+
+  base.x -= GSMinX(rect);
+  base.y -= GSMinY(rect);
+  bases[nbases++] = base;
+}
+
+- (NSUInteger)startCount {
+  return nstarts;
+}
+
+- (struct BMAP_StartInfo)startAtIndex:(NSUInteger)i {
+  struct BMAP_StartInfo start;
+
+  NSAssert(i < nstarts, @"Start Out of Bounds");
+
+  start = starts[i];
+  start.x += GSMinX(rect);
+  start.y += GSMinY(rect);
+
+  return start;
+}
+
+- (void)addStart:(struct BMAP_StartInfo)start {
+  NSAssert(nstarts < MAX_STARTS, @"Too Many Starts");
+  NSAssert(GSPointInRect(rect, GSMakePoint(start.x, start.y)), @"Start Location Out of Bounds");
+
+  start.x -= GSMinX(rect);
+  start.y -= GSMinY(rect);
+  starts[nstarts++] = start;
+}
+
 // Draw Methods
 
 - (void)drawFilledEllipse:(GSTile)tile {
@@ -230,6 +374,8 @@ static void floodFillTilesWithSize(GSTile *tiles, GSSize size, GSTile from, GSTi
   float aa, bb, yf;
   int  xc, yc, x, y, xstart;
 
+  [self makeUnique];
+
   xc = GSWidth(rect) - 1;
   yc = GSHeight(rect) - 1;
   aa *= (aa = xc * 0.5f);
@@ -279,6 +425,8 @@ static void floodFillTilesWithSize(GSTile *tiles, GSSize size, GSTile from, GSTi
   float aa, bb, yf;
   int  xc, yc, x, y, xstart;
 
+  [self makeUnique];
+
   xc = GSWidth(rect) - 1;
   yc = GSHeight(rect) - 1;
   aa *= (aa = xc * 0.5f);
@@ -387,6 +535,8 @@ static void floodFillTilesWithSize(GSTile *tiles, GSSize size, GSTile from, GSTi
 - (void)drawRectangle:(GSTile)tile {
   int x, y;
 
+  [self makeUnique];
+
   // draw bottom and top of rectangle
   for (x = 0; x < GSWidth(rect); x++) {
     tiles[x] = tile;
@@ -403,6 +553,8 @@ static void floodFillTilesWithSize(GSTile *tiles, GSSize size, GSTile from, GSTi
 - (void)drawLine:(GSTile)tile fromPoint:(GSPoint)from toPoint:(GSPoint)to {
   int x, y;
 
+  [self makeUnique];
+
   // draw bottom and top of rectangle
   for (x = 0; x < GSWidth(rect); x++) {
     tiles[x] = tile;
@@ -417,36 +569,42 @@ static void floodFillTilesWithSize(GSTile *tiles, GSSize size, GSTile from, GSTi
 }
 
 - (void)floodFillWithTile:(GSTile)tile atPoint:(GSPoint)point {
+  [self makeUnique];
   NSAssert(tiles[((point.y - GSMinY(rect)) * GSWidth(rect)) + (point.x - GSMinX(rect))] != tile, @"");
   floodFillTilesWithSize(tiles, rect.size, tiles[((point.y - GSMinY(rect)) * GSWidth(rect)) + (point.x - GSMinX(rect))], tile, GSMakePoint(point.x - GSMinX(rect), point.y - GSMinY(rect)));
 }
 
 - (void)copyToTiles:(GSTile *)aTiles {
-  int x, y;
+  int y;
 
   for (y = 0; y < GSHeight(rect); y++) {
-    for (x = 0; x < GSWidth(rect); x++) {
-      aTiles[((y + GSMinY(rect)) * WIDTH) + (x + GSMinX(rect))] = tiles[(y * GSWidth(rect)) + x];
-    }
+    bcopy(tiles + (y * GSWidth(rect)), aTiles + ((y + GSMinY(rect)) * WIDTH) + GSMinX(rect), GSWidth(rect) * sizeof(GSTile));
   }
 }
 
 - (void)rotateLeft {
-  GSTile *newTiles;
-  int x, y;
   int offset;
 
-  newTiles = (GSTile *)malloc(GSWidth(rect) * GSHeight(rect) * sizeof(GSTile));
-  NSAssert(newTiles != NULL, @"Malloc Failed");
+  [self transformObjects:rotateLeftPoint];
 
-  // translate tiles
-  for (y = 0; y < GSHeight(rect); y++) {
-    for (x = 0; x < GSWidth(rect); x++) {
-      newTiles[((GSWidth(rect) - 1 - x) * GSHeight(rect)) + y] = tiles[(y * GSWidth(rect)) + x];
-    }
+  if (GSWidth(rect) == GSHeight(rect)) {
+    // square rects rotate in place
+    [self makeUnique];
+    rotateSquareTilesLeft(tiles, GSWidth(rect));
   }
+  else {
+    struct GSTileBuffer *newBuffer;
+
+    newBuffer = bufferCreate(GSWidth(rect) * GSHeight(rect) * sizeof(GSTile));
+    rotateTilesLeft(newBuffer->tiles, tiles, GSWidth(rect), GSHeight(rect));
+
+    if (buffer) {
+      bufferRelease(buffer);
+    }
 
-  free(tiles);
+    buffer = newBuffer;
+    tiles = newBuffer->tiles;
+  }
 
   // keep rect centered
   offset = (GSWidth(rect) - GSHeight(rect))/2;
@@ -456,26 +614,31 @@ static void floodFillTilesWithSize(GSTile *tiles, GSSize size, GSTile from, GSTi
   // shift if outside of bounds
   rect = GSOffsetRect(rect, GSMinX(kSeaRect) > GSMinX(rect) ? GSMinX(kSeaRect) - GSMinX(rect) : 0, GSMinY(kSeaRect) > GSMinY(rect) ? GSMinY(kSeaRect) - GSMinY(rect) : 0);
   rect = GSOffsetRect(rect, GSMaxX(rect) > GSMaxX(kSeaRect) ? GSMaxX(kSeaRect) - GSMaxX(rect) : 0, GSMaxY(rect) > GSMaxY(kSeaRect) ? GSMaxY(kSeaRect) - GSMaxY(rect) : 0);
-
-  tiles = newTiles;
 }
 
 - (void)rotateRight {
-  GSTile *newTiles;
-  int x, y;
   int offset;
 
-  newTiles = (GSTile *)malloc(GSWidth(rect) * GSHeight(rect) * sizeof(GSTile));
-  NSAssert(newTiles != NULL, @"Malloc Failed");
+  [self transformObjects:rotateRightPoint];
 
-  // translate tiles
-  for (y = 0; y < GSHeight(rect); y++) {
-    for (x = 0; x < GSWidth(rect); x++) {
-      newTiles[(x * GSHeight(rect)) + (GSHeight(rect) - 1 - y)] = tiles[(y * GSWidth(rect)) + x];
-    }
+  if (GSWidth(rect) == GSHeight(rect)) {
+    // square rects rotate in place
+    [self makeUnique];
+    rotateSquareTilesRight(tiles, GSWidth(rect));
   }
+  else {
+    struct GSTileBuffer *newBuffer;
 
-  free(tiles);
+    newBuffer = bufferCreate(GSWidth(rect) * GSHeight(rect) * sizeof(GSTile));
+    rotateTilesRight(newBuffer->tiles, tiles, GSWidth(rect), GSHeight(rect));
+
+    if (buffer) {
+      bufferRelease(buffer);
+    }
+
+    buffer = newBuffer;
+    tiles = newBuffer->tiles;
+  }
 
   // keep rect centered
   offset = (GSWidth(rect) - GSHeight(rect))/2;
@@ -485,40 +648,107 @@ static void floodFillTilesWithSize(GSTile *tiles, GSSize size, GSTile from, GSTi
   // shift if outside of bounds
   rect = GSOffsetRect(rect, GSMinX(kSeaRect) > GSMinX(rect) ? GSMinX(kSeaRect) - GSMinX(rect) : 0, GSMinY(kSeaRect) > GSMinY(rect) ? GSMinY(kSeaRect) - GSMinY(rect) : 0);
   rect = GSOffsetRect(rect, GSMaxX(rect) > GSMaxX(kSeaRect) ? GSMaxX(kSeaRect) - GSMaxX(rect) : 0, GSMaxY(rect) > GSMaxY(kSeaRect) ? GSMaxY(kSeaRect) - GSMaxY(rect) : 0);
-
-  tiles = newTiles;
 }
 
 - (void)flipHorizontal {
-  int x, y;
+  [self makeUnique];
+  flipTilesHorizontal(tiles, GSWidth(rect), GSHeight(rect));
+  [self transformObjects:flipHorizontalPoint];
+}
 
-  for (y = 0; y < GSHeight(rect); y++) {
-    for (x = 0; x < GSWidth(rect)/2; x++) {
-      GSTile t;
+- (void)flipVertical {
+  [self makeUnique];
+  flipTilesVertical(tiles, GSWidth(rect), GSHeight(rect));
+  [self transformObjects:flipVerticalPoint];
+}
 
-      t = tiles[(y * GSWidth(rect)) + x];
-      tiles[(y * GSWidth(rect)) + x] = tiles[(y * GSWidth(rect)) + GSWidth(rect) - 1 - x];
-      tiles[(y * GSWidth(rect)) + GSWidth(rect) - 1 - x] = t;
-    }
+- (void)makeUnique {
+  if (buffer && buffer->refs > 1) {
+    struct GSTileBuffer *newBuffer;
+
+    newBuffer = bufferCreate(GSWidth(rect) * GSHeight(rect) * sizeof(GSTile));
+    bcopy(tiles, newBuffer->tiles, GSWidth(rect) * GSHeight(rect) * sizeof(GSTile));
+    bufferRelease(buffer);
+    buffer = newBuffer;
+    tiles = buffer->tiles;
   }
 }
 
-- (void)flipVertical {
-  int x, y;
+// must be called before rect changes
+- (void)transformObjects:(GSPointTransform)transform {
+  GSPoint point;
+  int i;
 
-  for (y = 0; y < GSHeight(rect)/2; y++) {
-    for (x = 0; x < GSWidth(rect); x++) {
-      GSTile t;
+  for (i = 0; i < npills; i++) {
+    point = transform(GSMakePoint(pills[i].x, pills[i].y), rect.size);
+    pills[i].x = point.x;
+    pills[i].y = point.y;
+  }
 
-      t = tiles[(y * GSWidth(rect)) + x];
-      tiles[(y * GSWidth(rect)) + x] = tiles[((GSHeight(rect) - y - 1) * GSWidth(rect)) + x];
-      tiles[((GSHeight(rect) - y - 1) * GSWidth(rect)) + x] = t;
-    }
+  for (i = 0; i < nbases; i++) {
+    point = transform(GSMakePoint(bases[i].x, bases[i].y), rect.size);
+    bases[i].x = point.x;
+    bases[i].y = point.y;
+  }
+
+  for (i = 0; i < nstarts; i++) {
+    point = transform(GSMakePoint(starts[i].x, starts[i].y), rect.size);
+    starts[i].x = point.x;
+    starts[i].y = point.y;
   }
 }
 
 @end
 
+struct GSTileBuffer *bufferCreate(size_t size) {
+  struct GSTileBuffer **prev, **best, *buffer;
+
+  // reuse the smallest pooled buffer that fits, but not one over twice the
+  // size or a whole map buffer would end up holding a single tile
+  best = NULL;
+
+  for (prev = &pool; *prev != NULL; prev = &(*prev)->next) {
+    if ((*prev)->capacity >= size && (*prev)->capacity <= 2*size && (best == NULL || (*prev)->capacity < (*best)->capacity)) {
+      best = prev;
+    }
+  }
+
+  if (best != NULL) {
+    buffer = *best;
+    *best = buffer->next;
+    pooled--;
+    buffer->next = NULL;
+    buffer->refs = 1;
+    return buffer;
+  }
+
+  buffer = (struct GSTileBuffer *)malloc(sizeof(struct GSTileBuffer) + size);
+  NSCAssert(buffer != NULL, @"Malloc() Failed");
+  buffer->next = NULL;
+  buffer->refs = 1;
+  buffer->capacity = size;
+
+  return buffer;
+}
+
+struct GSTileBuffer *bufferRetain(struct GSTileBuffer *buffer) {
+  buffer->refs++;
+  return buffer;
+}
+
+void bufferRelease(struct GSTileBuffer *buffer) {
+  if (--buffer->refs == 0) {
+    if (pooled < MAX_POOLED_BUFFERS) {
+      buffer->next = pool;
+      pool = buffer;
+      pooled++;
+    }
+    else {
+      free(buffer);
+    }
+  }
+}
+
 // flood fill algorithm that works on a GSTileRect.  does do bounds checking.
 void floodFillTilesWithSize(GSTile *tiles, GSSize size, GSTile from, GSTile to, GSPoint point) {
   if (tiles[(point.y * size.width) + point.x] == from) {
@@ -540,4 +770,20 @@ void floodFillTilesWithSize(GSTile *tiles, GSSize size, GSTile from, GSTile to,
       floodFillTilesWithSize(tiles, size, from, to, GSMakePoint(point.x, point.y + 1));
     }
   }
-}
\ No newline at end of file
+}
+
+GSPoint rotateLeftPoint(GSPoint point, GSSize size) {
+  return GSMakePoint(point.y, size.width - 1 - point.x);
+}
+
+GSPoint rotateRightPoint(GSPoint point, GSSize size) {
+  return GSMakePoint(size.height - 1 - point.y, point.x);
+}
+
+GSPoint flipHorizontalPoint(GSPoint point, GSSize size) {
+  return GSMakePoint(size.width - 1 - point.x, point.y);
+}
+
+GSPoint flipVerticalPoint(GSPoint point, GSSize size) {
+  return GSMakePoint(point.x, size.height - 1 - point.y);
+}
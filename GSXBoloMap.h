@@ -8,6 +8,14 @@
 
 #import <Cocoa/Cocoa.h>
 #include "bmap.h"
+#include "chokes.h"
+#include "coverage.h"
+#include "feed.h"
+#include "journal.h"
+#include "occupancy.h"
+#include "region.h"
+#include "sat.h"
+#include "visibility.h"
 
 
 @class GSXBoloMapView, GSTileRect;
@@ -21,6 +29,51 @@
 
   GSImage images[WIDTH][WIDTH];
 
+  // per layer tile counts of any rect, kept up to date on every tile write
+  GSSummedArea *summedArea;
+
+  // rows and columns holding land or objects, for mapRect
+  GSOccupancy *occupancy;
+
+  // changes to tiles and objects queued for the analyses below, which
+  // catch up a budget at a time on each flush
+  GSFeed *feed;
+  int coverageSubscriber;
+  int chokesSubscriber;
+  int visibilitySubscriber;
+
+  // pills that can hit each tile, drawn over the map when shown
+  GSCoverage *coverage;
+  BOOL showsCoverage;
+
+  // articulation tiles and least cuts from starts to bases, found again
+  // when the feed hands over a tile, base or start change while shown
+  struct GSChokes *chokes;
+  uint8_t chokeMarks[WIDTH][WIDTH];
+  BOOL showsChokes;
+  BOOL chokesStale;
+
+  // what each tile sees and is seen from, made the first time hiding
+  // places are shown and caught up with the tiles when shown again
+  GSVisibility *visibility;
+  BOOL showsHidingPlaces;
+  BOOL visibilityStale;
+
+  // images to remap and rects to redraw on the next flush
+  GSRegion remapRegion;
+  GSRegion displayRegion;
+  BOOL flushScheduled;
+
+  GSJournal *journal;
+
+  // a selection being dragged, drawn over the map without modifying it
+  GSTileRect *floatSelection;
+  GSTileRect *floatUnder;
+  GSRect floatWritten;
+  GSRect floatRect;
+  GSTile (*floatTiles)[WIDTH];
+  GSImage (*floatImages)[WIDTH];
+
   IBOutlet GSXBoloMapView *boloView;
 }
 
@@ -37,8 +90,26 @@
 - (GSTile)tileAtX:(NSUInteger)x y:(NSUInteger)y;
 - (GSTile)tileAtPoint:(GSPoint)point;
 - (GSTileRect *)tilesInRect:(GSRect)rect;
+- (GSTileRect *)tilesAndObjectsInRect:(GSRect)rect;
 - (GSTileRect *)tilesRectFloodAtPoint:(GSPoint)point;
 
+// number of tiles in rect counting towards layer, a tile class or a layer of sat.h
+- (NSUInteger)countOfTileLayer:(int)layer inRect:(GSRect)rect;
+
+// pills that can hit a tile, of a floating selection while one is dragged
+- (NSUInteger)coverageAtPoint:(GSPoint)point;
+- (struct GSCoverageStats)coverageStats;
+- (BOOL)showsCoverage;
+- (void)setShowsCoverage:(BOOL)flag;
+
+// tiles whose loss splits an island or cuts its starts from its bases
+- (BOOL)showsChokes;
+- (void)setShowsChokes:(BOOL)flag;
+
+// tiles a tank in forest is hidden in, and those it can snipe from
+- (BOOL)showsHidingPlaces;
+- (void)setShowsHidingPlaces:(BOOL)flag;
+
 // modifiers
 - (void)createPillAt:(GSPoint)point;
 - (void)insertPill:(struct BMAP_PillInfo)pill atIndex:(NSUInteger)i;
@@ -57,6 +128,15 @@
 
 - (void)setTile:(GSTile)tile at:(GSPoint)point;
 - (void)setTileRect:(GSTileRect *)tileRect;
+- (void)setTileRectAndObjects:(GSTileRect *)tileRect;
+
+// draws tileRect over the map with under restored beneath its original rect, nil ends floating
+- (void)floatTileRect:(GSTileRect *)tileRect over:(GSTileRect *)under;
+
+// changes between beginStroke and endStroke are undone as a single step
+- (void)beginStroke;
+- (void)endStroke;
+- (void)setUndoMemoryBudget:(size_t)budget;
 
 - (void)offsetObjectsInRect:(GSRect)rect dX:(int)dX dY:(int)dY;
 - (void)flipHorinzontalObjectsInRect:(GSRect)rect;
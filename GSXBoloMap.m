@@ -19,15 +19,59 @@ static void floodSizeRight(GSTile tiles[][WIDTH], GSTile from, GSPoint point, in
 static void floodSizeDown(GSTile tiles[][WIDTH], GSTile from, GSPoint point, int *minx, int *maxx, int *miny, int *maxy);
 static void floodSizeUp(GSTile tiles[][WIDTH], GSTile from, GSPoint point, int *minx, int *maxx, int *miny, int *maxy);
 static void flood(GSTile tiles[][WIDTH], GSTile to, GSPoint point);
+static void coverageFed(void *context, GSRect rect, unsigned objects);
+static void chokesFed(void *context, GSRect rect, unsigned objects);
+static void visibilityFed(void *context, GSRect rect, unsigned objects);
 
 NSString *const GSXBoloErrorDomain = @"GSXBoloErrorDomain";
 
 static NSImage *img = nil;
 static NSImage *sprites = nil;
 
+static NSString * const GSUndoMemoryBudgetKey = @"GSUndoMemoryBudget";
+
+#define ANALYSIS_BUDGET (8192)  // tiles of analyses reworked per flush
+
+// how a tile is drawn when chokes are shown
+enum {
+  kChokeNone = 0,
+  kChokeArticulation,
+  kChokeCut
+} ;
+
+// an undo action's hold on a journal entry, the entry is discarded when the
+// undo manager drops the last action holding it
+@interface GSJournalEntryRef : NSObject {
+  GSJournal *journal;
+  GSJournalEntry *entry;
+}
+
+- (id)initWithJournal:(GSJournal *)aJournal entry:(GSJournalEntry *)anEntry;
+- (GSJournalEntry *)entry;
+@end
+
 @interface GSXBoloMap (Private)
 - (void)remapImagesInRect:(GSRect)rect;
+- (void)setNeedsDisplayInWorldRect:(GSRect)rect;
+- (void)scheduleFlush;
+- (void)remapDamage;
+- (void)flushDamage;
+- (void)drawImage:(GSImage)image at:(GSPoint)world;
 - (void)drawSprite:(GSImage)sprite at:(GSPoint)world;
+- (void)getObjectTables:(struct GSObjectTables *)objects;
+- (void)setObjectTables:(const struct GSObjectTables *)objects;
+- (void)countObjects;
+- (void)publishTilesInRect:(GSRect)rect;
+- (void)publishObjects:(unsigned)objects;
+- (void)updateCoverageInRect:(GSRect)rect pills:(BOOL)pills;
+- (void)updateCoverage;
+- (void)redrawCoverageInRect:(GSRect)rect;
+- (void)updateChokes;
+- (void)updateVisibilityInRect:(GSRect)rect;
+- (void)setNeedsDisplayForObjects;
+- (void)beginJournal;
+- (void)commitJournal;
+- (void)applyJournalEntry:(GSJournalEntryRef *)ref;
 @end
 
 @implementation GSXBoloMap
@@ -44,6 +88,13 @@ static NSImage *sprites = nil;
 
   if (self) {
     int x, y;
+    NSInteger budget;
+
+    budget = [[NSUserDefaults standardUserDefaults] integerForKey:GSUndoMemoryBudgetKey];
+
+    if ((journal = journalCreate(budget > 0 ? budget : DEFAULT_JOURNAL_BUDGET)) == NULL) {
+      [NSException raise:NSMallocException format:@"Malloc() Failed"];
+    }
 
     bcopy(MAP_FILE_IDENT, preamble.ident, MAP_FILE_IDENT_LEN);
     preamble.version = CURRENT_MAP_VERSION;
@@ -57,12 +108,47 @@ static NSImage *sprites = nil;
       }
     }
 
+    if ((summedArea = summedAreaCreate(tiles)) == NULL || (occupancy = occupancyCreate(tiles)) == NULL ||
+        (coverage = coverageCreate(tiles)) == NULL || (chokes = malloc(sizeof(struct GSChokes))) == NULL ||
+        (feed = feedCreate()) == NULL) {
+      [NSException raise:NSMallocException format:@"Malloc() Failed"];
+    }
+
+    // chokes and visibility only listen while they are kept
+    coverageSubscriber = feedSubscribe(feed, coverageFed, self, FEED_TILES | FEED_PILLS, PILL_RANGE);
+    chokesSubscriber = feedSubscribe(feed, chokesFed, self, 0, FEED_WHOLE_MAP);
+    visibilitySubscriber = feedSubscribe(feed, visibilityFed, self, 0, SIGHT_RANGE);
+    chokesStale = YES;
+
     [self remapImagesInRect:kWorldRect];
   }
 
   return self;
 }
 
+- (void)dealloc {
+  [[NSRunLoop currentRunLoop] cancelPerformSelectorsWithTarget:self];
+
+  // the refs held by undo actions discard their entries from the journal
+  [[self undoManager] removeAllActionsWithTarget:self];
+  journalDestroy(journal);
+  summedAreaDestroy(summedArea);
+  occupancyDestroy(occupancy);
+  coverageDestroy(coverage);
+  free(chokes);
+  feedDestroy(feed);
+
+  if (visibility != NULL) {
+    visibilityDestroy(visibility);
+  }
+
+  [floatSelection release];
+  [floatUnder release];
+  free(floatTiles);
+  free(floatImages);
+  [super dealloc];
+}
+
 // accessors
 - (NSUInteger)pillCount {
   return preamble.npills;
@@ -109,6 +195,33 @@ static NSImage *sprites = nil;
   return [GSTileRect tileRectWithTiles:(GSTile *)tiles inRect:rect];
 }
 
+- (GSTileRect *)tilesAndObjectsInRect:(GSRect)rect {
+  GSTileRect *tileRect;
+  int i;
+
+  tileRect = [GSTileRect tileRectWithTiles:(GSTile *)tiles inRect:rect];
+
+  for (i = 0; i < preamble.npills; i++) {
+    if (GSPointInRect(rect, GSMakePoint(pills[i].x, pills[i].y))) {
+      [tileRect addPill:pills[i]];
+    }
+  }
+
+  for (i = 0; i < preamble.nbases; i++) {
+    if (GSPointInRect(rect, GSMakePoint(bases[i].x, bases[i].y))) {
+      [tileRect addBase:bases[i]];
+    }
+  }
+
+  for (i = 0; i < preamble.nstarts; i++) {
+    if (GSPointInRect(rect, GSMakePoint(starts[i].x, starts[i].y))) {
+      [tileRect addStart:starts[i]];
+    }
+  }
+
+  return tileRect;
+}
+
 - (GSTileRect *)tilesRectFloodAtPoint:(GSPoint)point {
   GSTile tile;
   int minx, maxx, miny, maxy;
@@ -121,19 +234,139 @@ static NSImage *sprites = nil;
   return [GSTileRect tileRectWithTiles:(GSTile *)tiles inRect:GSMakeRect(minx, miny, maxx - minx + 1, maxy - miny + 1)];
 }
 
-// updates image map
+- (NSUInteger)countOfTileLayer:(int)layer inRect:(GSRect)rect {
+  return summedAreaCount(summedArea, layer, rect);
+}
+
+- (NSUInteger)coverageAtPoint:(GSPoint)point {
+  NSAssert(GSPointInRect(kWorldRect, point), @"Point out of bounds.");
+  feedDrainSubscriber(feed, coverageSubscriber);
+  return coverageGrid(coverage)[point.y][point.x];
+}
+
+- (struct GSCoverageStats)coverageStats {
+  struct GSCoverageStats stats;
+
+  feedDrainSubscriber(feed, coverageSubscriber);
+  coverageStats(coverage, &stats);
+
+  return stats;
+}
+
+- (BOOL)showsCoverage {
+  return showsCoverage;
+}
+
+- (void)setShowsCoverage:(BOOL)flag {
+  if (flag != showsCoverage) {
+    showsCoverage = flag;
+    [self setNeedsDisplayInWorldRect:kWorldRect];
+  }
+}
+
+- (BOOL)showsChokes {
+  return showsChokes;
+}
+
+// changes made while chokes are hidden are not followed, so they are found
+// again when next shown
+- (void)setShowsChokes:(BOOL)flag {
+  if (flag != showsChokes) {
+    showsChokes = flag;
+    chokesStale = chokesStale || !flag;
+    feedSetInterests(feed, chokesSubscriber, flag ? FEED_TILES | FEED_BASES | FEED_STARTS : 0);
+    [self setNeedsDisplayInWorldRect:kWorldRect];
+  }
+}
+
+- (BOOL)showsHidingPlaces {
+  return showsHidingPlaces;
+}
+
+// like chokes, changes made while hiding places are hidden are not
+// followed, so the views are brought up to date when next shown
+- (void)setShowsHidingPlaces:(BOOL)flag {
+  if (flag != showsHidingPlaces) {
+    showsHidingPlaces = flag;
+
+    if (flag && visibility == NULL) {
+      if ((visibility = visibilityCreate(tiles)) == NULL) {
+        [NSException raise:NSMallocException format:@"Malloc() Failed"];
+      }
+    }
+    else if (flag && visibilityStale) {
+      visibilityUpdateRect(visibility, tiles, kWorldRect);
+    }
+
+    visibilityStale = !flag;
+    feedSetInterests(feed, visibilitySubscriber, flag ? FEED_TILES : 0);
+    [self setNeedsDisplayInWorldRect:kWorldRect];
+  }
+}
+
+// damage is collected in regions and flushed once per pass of the run loop
 
 - (void)remapImagesInRect:(GSRect)rect {
-  int x, y;
+  rect = GSIntersectionRect(rect, kWorldRect);
+  GSRegionAddRect(&remapRegion, rect);
+  GSRegionAddRect(&displayRegion, rect);
+  [self scheduleFlush];
+}
+
+- (void)setNeedsDisplayInWorldRect:(GSRect)rect {
+  GSRegionAddRect(&displayRegion, GSIntersectionRect(rect, kWorldRect));
+  [self scheduleFlush];
+}
+
+- (void)scheduleFlush {
+  if (!flushScheduled) {
+    flushScheduled = YES;
+    [[NSRunLoop currentRunLoop] performSelector:@selector(flushDamage) target:self argument:nil order:0 modes:[NSArray arrayWithObjects:NSDefaultRunLoopMode, NSEventTrackingRunLoopMode, NSModalPanelRunLoopMode, nil]];
+  }
+}
 
-  for (y = GSMinY(rect); y <= GSMaxY(rect); y++) {
-    for (x = GSMinX(rect); x <= GSMaxX(rect); x++) {
-      images[y][x] = mapImage(tiles, x, y);
+- (void)remapDamage {
+  int i;
+
+  for (i = 0; i < remapRegion.count; i++) {
+    GSRect rect = remapRegion.rects[i];
+    int x, y;
+
+    for (y = GSMinY(rect); y <= GSMaxY(rect); y++) {
+      for (x = GSMinX(rect); x <= GSMaxX(rect); x++) {
+        images[y][x] = mapImage(tiles, x, y);
+      }
     }
   }
 
+  GSEmptyRegion(&remapRegion);
+}
+
+// analyses that fall behind while painting catch up a budget at a time
+// over the following passes, with the events between them handled first
+- (void)flushDamage {
+  BOOL behind;
+  int i;
+
+  // flushScheduled stays set until the end, so damage the analyses add is
+  // flushed with the rest rather than on another pass
+  [self remapDamage];
+  behind = feedDrain(feed, ANALYSIS_BUDGET);
+
+  if (showsChokes && chokesStale) {
+    [self updateChokes];
+  }
+
+  for (i = 0; i < displayRegion.count; i++) {
+    [boloView setNeedsDisplayInRect:GSRect2NSRect(displayRegion.rects[i])];
+  }
+
+  GSEmptyRegion(&displayRegion);
+  flushScheduled = NO;
 
-  [boloView setNeedsDisplayInRect:GSRect2NSRect(rect)];
+  if (behind) {
+    [self scheduleFlush];
+  }
 }
 
 - (NSString *)windowNibName {
@@ -179,76 +412,31 @@ static NSImage *sprites = nil;
     return NO;
   }
 
+  summedAreaBuild(summedArea, tiles);
+  occupancyBuild(occupancy, tiles);
+  [self countObjects];
+  [self publishTilesInRect:kWorldRect];
+  [self publishObjects:FEED_OBJECTS];
+  feedDrainSubscriber(feed, coverageSubscriber);
   [self remapImagesInRect:kWorldRect];
 
   return YES;
 }
 
+// the bounds are kept by the occupancy counts, objects only widen a map
+// that has land
 - (GSRect)mapRect {
-  int x, y;
-
-  for (y = GSMinY(kSeaRect); y <= GSMaxY(kSeaRect); y++) {
-    for (x = GSMinX(kSeaRect); x <= GSMaxX(kSeaRect); x++) {
-      if (tiles[y][x] != kSeaTile) {
-        int i, minx, maxx, miny, maxy;
-
-        minx = x;
-        maxx = x;
-        miny = y;
-        maxy = y;
-
-        for (x = GSMaxX(kSeaRect); x > maxx; x--) {
-          if (tiles[y][x] != kSeaTile) {
-            maxx = x;
-            break;
-          }
-        }
+  GSRect land, objects;
 
-        for (y++; y <= GSMaxY(kSeaRect); y++) {
-          for (x = GSMinX(kSeaRect); x <= GSMaxX(kSeaRect); x++) {
-            if (tiles[y][x] != kSeaTile) {
-              minx = MIN(minx, x);
-              maxy = y;
-
-              for (x = GSMaxX(kSeaRect); x > maxx; x--) {
-                if (tiles[y][x] != kSeaTile) {
-                  maxx = x;
-                  break;
-                }
-              }
+  land = occupancyLandBounds(occupancy);
 
-              break;
-            }
-          }
-        }
-
-        for (i = 0; i < preamble.npills; i++) {
-          minx = MIN(minx, pills[i].x);
-          maxx = MAX(maxx, pills[i].x);
-          miny = MIN(miny, pills[i].y);
-          maxy = MAX(maxy, pills[i].y);
-        }
-
-        for (i = 0; i < preamble.nbases; i++) {
-          minx = MIN(minx, bases[i].x);
-          maxx = MAX(maxx, bases[i].x);
-          miny = MIN(miny, bases[i].y);
-          maxy = MAX(maxy, bases[i].y);
-        }
-
-        for (i = 0; i < preamble.nstarts; i++) {
-          minx = MIN(minx, starts[i].x);
-          maxx = MAX(maxx, starts[i].x);
-          miny = MIN(miny, starts[i].y);
-          maxy = MAX(maxy, starts[i].y);
-        }
-
-        return GSMakeRect(minx, miny, maxx - minx + 1, maxy - miny + 1);
-      }
-    }
+  if (GSIsEmptyRect(land)) {
+    return kSeaRect;
   }
 
-  return kSeaRect;
+  objects = occupancyObjectBounds(occupancy);
+
+  return GSIsEmptyRect(objects) ? land : GSUnionRect(land, objects);
 }
 
 // draws document in rect
@@ -257,6 +445,8 @@ static NSImage *sprites = nil;
   int min_i, max_i, min_j, max_j;
   int min_x, max_x, min_y, max_y;
   int y, x, i;
+  GSRect liftedRect;
+  const uint8_t (*hits)[WIDTH] = coverageGrid(coverage);
   GSRect worldRect =
     GSIntersectionRect(
       NSRect2GSRect(rect),
@@ -271,6 +461,9 @@ static NSImage *sprites = nil;
       kSeaRect
     );
 
+  // tiles changed since the last flush
+  [self remapDamage];
+
   min_i = ((int)floorf(NSMinX(rect)))/16;
   max_i = ((int)ceilf(NSMaxX(rect)))/16;
 
@@ -286,7 +479,9 @@ static NSImage *sprites = nil;
   /* draw the tiles in the rect */
   for (y = min_y; y <= max_y; y++) {
     for (x = min_x; x <= max_x; x++) {
-      GSImage image = images[y][x];
+      // the floating selection is drawn from its own composite
+      BOOL floating = GSPointInRect(floatRect, GSMakePoint(x, y));
+      GSImage image = floating ? floatImages[y][x] : images[y][x];
       NSRect dstRect = NSMakeRect(16.0*x, 16.0*(255 - y), 16.0, 16.0);
       NSRect srcRect = NSMakeRect((image%16)*16, (image/16)*16, 16.0, 16.0);
 
@@ -294,46 +489,107 @@ static NSImage *sprites = nil;
       [img drawInRect:dstRect fromRect:srcRect operation:NSCompositeCopy fraction:1.0];
 
       /* draw mine */
-      if (isMinedTile(tiles, x, y)) {
+      if (isMinedTile(floating ? floatTiles : tiles, x, y)) {
         NSRect mineImageRect;
 
         mineImageRect = NSMakeRect((MINE00IMAGE%16)*16, (MINE00IMAGE/16)*16, 16.0, 16.0);
         [img drawInRect:dstRect fromRect:mineImageRect operation:NSCompositeSourceOver fraction:1.0];
       }
+
+      /* draw coverage, redder the more pills hit the tile */
+      if (showsCoverage && hits[y][x] > 0) {
+        [[NSColor colorWithCalibratedRed:1.0 green:0.0 blue:0.0 alpha:MIN(0.2*hits[y][x], 0.6)] set];
+        NSRectFillUsingOperation(dstRect, NSCompositeSourceOver);
+      }
+
+      /* draw hiding places, snipes apart */
+      if (showsHidingPlaces && visibilityIsConcealed(visibility, GSMakePoint(x, y))) {
+        if (visibilityIsSnipe(visibility, GSMakePoint(x, y))) {
+          [[NSColor colorWithCalibratedRed:0.6 green:0.0 blue:0.8 alpha:0.5] set];
+        }
+        else {
+          [[NSColor colorWithCalibratedRed:0.0 green:0.5 blue:0.0 alpha:0.4] set];
+        }
+
+        NSRectFillUsingOperation(dstRect, NSCompositeSourceOver);
+      }
+
+      /* draw chokes, cut tiles over articulation tiles */
+      if (showsChokes && chokeMarks[y][x] != kChokeNone) {
+        if (chokeMarks[y][x] == kChokeCut) {
+          [[NSColor colorWithCalibratedRed:0.2 green:0.4 blue:1.0 alpha:0.6] set];
+        }
+        else {
+          [[NSColor colorWithCalibratedRed:1.0 green:0.6 blue:0.0 alpha:0.45] set];
+        }
+
+        NSRectFillUsingOperation(dstRect, NSCompositeSourceOver);
+      }
     }
   }
 
+  // objects under a floating selection are drawn with it
+  liftedRect = floatSelection ? [floatUnder rect] : GSMakeRect(0, 0, 0, 0);
+
   for (i = 0; i < preamble.npills; i++) {
     GSPoint p = GSMakePoint(pills[i].x, pills[i].y);
 
-    if (GSPointInRect(worldRect, p)) {
-      GSImage image = HPIL00IMAGE + pills[i].armour;
-      NSRect dstRect = NSMakeRect(16.0*p.x, 16.0*(255 - p.y), 16.0, 16.0);
-      NSRect srcRect = NSMakeRect((image%16)*16, (image/16)*16, 16.0, 16.0);
-
-      [img drawInRect:dstRect fromRect:srcRect operation:NSCompositeSourceOver fraction:1.0];
+    if (GSPointInRect(worldRect, p) && !GSPointInRect(liftedRect, p)) {
+      [self drawImage:HPIL00IMAGE + pills[i].armour at:p];
     }
   }
 
   for (i = 0; i < preamble.nbases; i++) {
     GSPoint p = GSMakePoint(bases[i].x, bases[i].y);
 
-    if (GSPointInRect(worldRect, p)) {
-      GSImage image = bases[i].owner == NEUTRAL ? NBAS00IMAGE : HBAS00IMAGE;
-      NSRect dstRect = NSMakeRect(16.0*p.x, 16.0*(255 - p.y), 16.0, 16.0);
-      NSRect srcRect = NSMakeRect((image%16)*16, (image/16)*16, 16.0, 16.0);
-
-      [img drawInRect:dstRect fromRect:srcRect operation:NSCompositeSourceOver fraction:1.0];
+    if (GSPointInRect(worldRect, p) && !GSPointInRect(liftedRect, p)) {
+      [self drawImage:bases[i].owner == NEUTRAL ? NBAS00IMAGE : HBAS00IMAGE at:p];
     }
   }
 
   for (i = 0; i < preamble.nstarts; i++) {
     GSPoint p = GSMakePoint(starts[i].x, starts[i].y);
 
-    if (GSPointInRect(worldRect, p)) {
+    if (GSPointInRect(worldRect, p) && !GSPointInRect(liftedRect, p)) {
       [self drawSprite:PTKB00IMAGE + starts[i].dir at:p];
     }
   }
+
+  for (i = 0; i < [floatSelection pillCount]; i++) {
+    struct BMAP_PillInfo pill = [floatSelection pillAtIndex:i];
+    GSPoint p = GSMakePoint(pill.x, pill.y);
+
+    if (GSPointInRect(worldRect, p)) {
+      [self drawImage:HPIL00IMAGE + pill.armour at:p];
+    }
+  }
+
+  for (i = 0; i < [floatSelection baseCount]; i++) {
+    struct BMAP_BaseInfo base = [floatSelection baseAtIndex:i];
+    GSPoint p = GSMakePoint(base.x, base.y);
+
+    if (GSPointInRect(worldRect, p)) {
+      [self drawImage:base.owner == NEUTRAL ? NBAS00IMAGE : HBAS00IMAGE at:p];
+    }
+  }
+
+  for (i = 0; i < [floatSelection startCount]; i++) {
+    struct BMAP_StartInfo start = [floatSelection startAtIndex:i];
+    GSPoint p = GSMakePoint(start.x, start.y);
+
+    if (GSPointInRect(worldRect, p)) {
+      [self drawSprite:PTKB00IMAGE + start.dir at:p];
+    }
+  }
+}
+
+- (void)drawImage:(GSImage)image at:(GSPoint)world {
+  NSRect srcRect;
+  NSRect dstRect;
+
+  srcRect = NSMakeRect((image % 16) * TILE_WIDTH, (image / 16) * TILE_WIDTH, TILE_WIDTH, TILE_WIDTH);
+  dstRect = NSMakeRect(world.x * TILE_WIDTH, (WIDTH - world.y - 1) * TILE_WIDTH, TILE_WIDTH, TILE_WIDTH);
+  [img drawInRect:dstRect fromRect:srcRect operation:NSCompositeSourceOver fraction:1.0];
 }
 
 - (void)drawSprite:(GSImage)sprite at:(GSPoint)world {
@@ -347,30 +603,379 @@ static NSImage *sprites = nil;
 
 - (void)setTile:(GSTile)tile at:(GSPoint)point {
   if (tiles[point.y][point.x] != tile) {
-    GSRect rect;
-    int x, y;
-
-    [[[self undoManager] prepareWithInvocationTarget:self] setTile:tiles[point.y][point.x] at:point];
+    if (journalIsOpen(journal)) {
+      journalRecordTile(journal, point, tiles[point.y][point.x], tile);
+    }
+    else {
+      [self beginJournal];
+      journalRecordTile(journal, point, tiles[point.y][point.x], tile);
+      [self commitJournal];
+    }
 
+    summedAreaSetTile(summedArea, point.x, point.y, tiles[point.y][point.x], tile);
+    occupancySetTile(occupancy, point.x, point.y, tiles[point.y][point.x], tile);
     tiles[point.y][point.x] = tile;
 
-    rect = GSMakeRect(point.x - 1, point.y - 1, 3, 3);
+    [self publishTilesInRect:GSMakeRect(point.x, point.y, 1, 1)];
+    [self remapImagesInRect:GSMakeRect(point.x - 1, point.y - 1, 3, 3)];
+  }
+}
 
-    for (y = GSMinY(rect); y <= GSMaxY(rect); y++) {
-      for (x = GSMinX(rect); x <= GSMaxX(rect); x++) {
-        images[y][x] = mapImage(tiles, x, y);
+- (void)setTileRect:(GSTileRect *)tileRect {
+  if (journalIsOpen(journal)) {
+    journalRecordRect(journal, [tileRect rect], tiles, [tileRect tiles]);
+  }
+  else {
+    // only the tiles that differ are kept for undo
+    [self beginJournal];
+    journalRecordRect(journal, [tileRect rect], tiles, [tileRect tiles]);
+    [self commitJournal];
+  }
+
+  occupancyCountTiles(occupancy, tiles, [tileRect rect], -1);
+  [tileRect copyToTiles:(void *)tiles];
+  occupancyCountTiles(occupancy, tiles, [tileRect rect], 1);
+  summedAreaUpdateRect(summedArea, tiles, [tileRect rect]);
+  [self publishTilesInRect:[tileRect rect]];
+  [self remapImagesInRect:GSIntersectionRect(GSInsetRect([tileRect rect], -1, -1), kSeaRect)];
+}
+
+// replaces the tiles and objects under tileRect, objects that do not fit are dropped
+- (void)setTileRectAndObjects:(GSTileRect *)tileRect {
+  BOOL oneShot;
+  int i;
+
+  oneShot = !journalIsOpen(journal);
+
+  if (oneShot) {
+    [self beginJournal];
+  }
+
+  [self setTileRect:tileRect];
+  [self deleteObjectsInRect:[tileRect rect]];
+
+  for (i = 0; i < [tileRect pillCount]; i++) {
+    struct BMAP_PillInfo pill = [tileRect pillAtIndex:i];
+
+    if (preamble.npills < MAX_PILLS && GSPointInRect(kSeaRect, GSMakePoint(pill.x, pill.y))) {
+      [self insertPill:pill atIndex:preamble.npills];
+    }
+  }
+
+  for (i = 0; i < [tileRect baseCount]; i++) {
+    struct BMAP_BaseInfo base = [tileRect baseAtIndex:i];
+
+    if (preamble.nbases < MAX_BASES && GSPointInRect(kSeaRect, GSMakePoint(base.x, base.y))) {
+      [self insertBase:base atIndex:preamble.nbases];
+    }
+  }
+
+  for (i = 0; i < [tileRect startCount]; i++) {
+    struct BMAP_StartInfo start = [tileRect startAtIndex:i];
+
+    if (preamble.nstarts < MAX_STARTS && GSPointInRect(kSeaRect, GSMakePoint(start.x, start.y))) {
+      [self insertStart:start atIndex:preamble.nstarts];
+    }
+  }
+
+  [self setAppropriateTilesForObjectsInRect:[tileRect rect]];
+
+  if (oneShot) {
+    [self commitJournal];
+  }
+}
+
+- (void)floatTileRect:(GSTileRect *)tileRect over:(GSTileRect *)under {
+  GSRect oldRect, oldWritten;
+  int y;
+
+  oldRect = floatRect;
+  oldWritten = floatWritten;
+
+  if (tileRect == nil) {
+    [self redrawCoverageInRect:coverageUpdateRect(coverage, tiles, floatWritten)];
+    [floatSelection release];
+    [floatUnder release];
+    floatSelection = nil;
+    floatUnder = nil;
+    [self updateCoverage];
+    floatWritten = GSMakeRect(0, 0, 0, 0);
+    floatRect = GSMakeRect(0, 0, 0, 0);
+    [self setNeedsDisplayInWorldRect:oldRect];
+    return;
+  }
+
+  // the coverage must be current before it follows the composite
+  if (floatSelection == nil) {
+    feedDrainSubscriber(feed, coverageSubscriber);
+  }
+
+  if (floatTiles == NULL) {
+    if ((floatTiles = malloc(sizeof(tiles))) == NULL || (floatImages = malloc(sizeof(images))) == NULL) {
+      [NSException raise:NSMallocException format:@"Malloc() Failed"];
+    }
+  }
+
+  if (floatSelection == nil) {
+    bcopy(tiles, floatTiles, sizeof(tiles));
+  }
+  else {
+    // only the last composite differs from the map
+    for (y = GSMinY(floatWritten); y <= GSMaxY(floatWritten); y++) {
+      bcopy(tiles[y] + GSMinX(floatWritten), floatTiles[y] + GSMinX(floatWritten), GSWidth(floatWritten) * sizeof(GSTile));
+    }
+  }
+
+  [tileRect retain];
+  [floatSelection release];
+  floatSelection = tileRect;
+
+  [under retain];
+  [floatUnder release];
+  floatUnder = under;
+
+  [floatUnder copyToTiles:(GSTile *)floatTiles];
+  [floatSelection copyToTiles:(GSTile *)floatTiles];
+
+  floatWritten = GSUnionRect([floatUnder rect], [floatSelection rect]);
+  floatRect = GSIntersectionRect(GSInsetRect(floatWritten, -1, -1), kWorldRect);
+
+  // the coverage follows the composite so it moves with the drag
+  [self redrawCoverageInRect:coverageUpdateRect(coverage, floatTiles, GSIsEmptyRect(oldWritten) ? floatWritten : GSUnionRect(oldWritten, floatWritten))];
+  [self updateCoverage];
+
+  for (y = GSMinY(floatRect); y <= GSMaxY(floatRect); y++) {
+    int x;
+
+    for (x = GSMinX(floatRect); x <= GSMaxX(floatRect); x++) {
+      floatImages[y][x] = mapImage(floatTiles, x, y);
+    }
+  }
+
+  if (!GSIsEmptyRect(oldRect)) {
+    [self setNeedsDisplayInWorldRect:oldRect];
+  }
+
+  [self setNeedsDisplayInWorldRect:floatRect];
+}
+
+- (void)beginStroke {
+  NSAssert(!journalIsOpen(journal), @"Stroke Already Begun");
+  [self beginJournal];
+}
+
+- (void)endStroke {
+  NSAssert(journalIsOpen(journal), @"Stroke Not Begun");
+  [self commitJournal];
+}
+
+- (void)setUndoMemoryBudget:(size_t)budget {
+  journalSetBudget(journal, budget);
+}
+
+- (void)getObjectTables:(struct GSObjectTables *)objects {
+  bcopy(&preamble, &objects->preamble, sizeof(preamble));
+  bcopy(pills, objects->pills, sizeof(pills));
+  bcopy(bases, objects->bases, sizeof(bases));
+  bcopy(starts, objects->starts, sizeof(starts));
+}
+
+- (void)setObjectTables:(const struct GSObjectTables *)objects {
+  bcopy(&objects->preamble, &preamble, sizeof(preamble));
+  bcopy(objects->pills, pills, sizeof(pills));
+  bcopy(objects->bases, bases, sizeof(bases));
+  bcopy(objects->starts, starts, sizeof(starts));
+  [self countObjects];
+  [self publishObjects:FEED_OBJECTS];
+}
+
+- (void)countObjects {
+  int i;
+
+  occupancyClearObjects(occupancy);
+
+  for (i = 0; i < preamble.npills; i++) {
+    occupancyCountObject(occupancy, pills[i].x, pills[i].y, 1);
+  }
+
+  for (i = 0; i < preamble.nbases; i++) {
+    occupancyCountObject(occupancy, bases[i].x, bases[i].y, 1);
+  }
+
+  for (i = 0; i < preamble.nstarts; i++) {
+    occupancyCountObject(occupancy, starts[i].x, starts[i].y, 1);
+  }
+}
+
+// analyses hear of changes on the next flush
+- (void)publishTilesInRect:(GSRect)rect {
+  feedPublishTiles(feed, rect);
+  [self scheduleFlush];
+}
+
+- (void)publishObjects:(unsigned)objects {
+  feedPublishObjects(feed, objects);
+  [self scheduleFlush];
+}
+
+- (void)updateCoverageInRect:(GSRect)rect pills:(BOOL)pills {
+  if (!GSIsEmptyRect(rect)) {
+    [self redrawCoverageInRect:coverageUpdateRect(coverage, tiles, rect)];
+  }
+
+  if (pills) {
+    [self updateCoverage];
+  }
+}
+
+// a floating selection's pills replace the pills lifted from under it
+- (void)updateCoverage {
+  struct BMAP_PillInfo hitters[MAX_PILLS];
+  GSRect liftedRect;
+  int npills, i;
+
+  if (floatSelection == nil) {
+    [self redrawCoverageInRect:coverageSetPills(coverage, pills, preamble.npills)];
+    return;
+  }
+
+  liftedRect = [floatUnder rect];
+  npills = 0;
+
+  for (i = 0; i < preamble.npills; i++) {
+    if (!GSPointInRect(liftedRect, GSMakePoint(pills[i].x, pills[i].y))) {
+      hitters[npills++] = pills[i];
+    }
+  }
+
+  for (i = 0; i < [floatSelection pillCount] && npills < MAX_PILLS; i++) {
+    struct BMAP_PillInfo pill = [floatSelection pillAtIndex:i];
+
+    if (GSPointInRect(kSeaRect, GSMakePoint(pill.x, pill.y))) {
+      hitters[npills++] = pill;
+    }
+  }
+
+  [self redrawCoverageInRect:coverageSetPills(coverage, hitters, npills)];
+}
+
+- (void)redrawCoverageInRect:(GSRect)rect {
+  if (showsCoverage && !GSIsEmptyRect(rect)) {
+    [self setNeedsDisplayInWorldRect:rect];
+  }
+}
+
+// only tiles whose marks changed are redrawn
+- (void)updateChokes {
+  uint8_t marks[WIDTH][WIDTH];
+  int x, y, i, j;
+
+  if (mapChokes(&preamble, bases, starts, tiles, CHOKE_LAND_CLASSES, chokes) == -1) {
+    [NSException raise:NSMallocException format:@"Malloc() Failed"];
+  }
+
+  chokesStale = NO;
+
+  for (y = 0; y < WIDTH; y++) {
+    for (x = 0; x < WIDTH; x++) {
+      marks[y][x] = chokes->cutoff[y][x] > 0 ? kChokeArticulation : kChokeNone;
+    }
+  }
+
+  for (i = 0; i < chokes->ncuts; i++) {
+    for (j = 0; j < chokes->cuts[i].size; j++) {
+      marks[chokes->cuts[i].tiles[j].y][chokes->cuts[i].tiles[j].x] = kChokeCut;
+    }
+  }
+
+  for (y = 0; y < WIDTH; y++) {
+    for (x = 0; x < WIDTH; x++) {
+      if (marks[y][x] != chokeMarks[y][x]) {
+        chokeMarks[y][x] = marks[y][x];
+        [self setNeedsDisplayInWorldRect:GSMakeRect(x, y, 1, 1)];
       }
     }
+  }
+}
+
+// views are only kept once hiding places have been shown
+- (void)updateVisibilityInRect:(GSRect)rect {
+  if (visibility != NULL) {
+    GSRect changed = visibilityUpdateRect(visibility, tiles, rect);
 
-    [boloView setNeedsDisplayInRect:NSMakeRect(GSMinX(rect) * TILE_WIDTH, (WIDTH - 1 - GSMaxY(rect)) * TILE_WIDTH, GSWidth(rect) * TILE_WIDTH, GSHeight(rect) * TILE_WIDTH)];
+    if (showsHidingPlaces && !GSIsEmptyRect(changed)) {
+      [self setNeedsDisplayInWorldRect:changed];
+    }
   }
 }
 
-- (void)setTileRect:(GSTileRect *)tileRect {
-  NSUndoManager *undoManager = [self undoManager];
-  [undoManager registerUndoWithTarget:self selector:@selector(setTileRect:) object:[GSTileRect tileRectWithTiles:(GSTile *)tiles inRect:[tileRect rect]]];
-  [tileRect copyToTiles:(void *)tiles];
-  [self remapImagesInRect:GSIntersectionRect(GSInsetRect([tileRect rect], -1, -1), kSeaRect)];
+- (void)setNeedsDisplayForObjects {
+  int i;
+
+  for (i = 0; i < preamble.npills; i++) {
+    [self setNeedsDisplayInWorldRect:GSMakeRect(pills[i].x, pills[i].y, 1, 1)];
+  }
+
+  for (i = 0; i < preamble.nbases; i++) {
+    [self setNeedsDisplayInWorldRect:GSMakeRect(bases[i].x, bases[i].y, 1, 1)];
+  }
+
+  for (i = 0; i < preamble.nstarts; i++) {
+    [self setNeedsDisplayInWorldRect:GSMakeRect(starts[i].x, starts[i].y, 1, 1)];
+  }
+}
+
+- (void)beginJournal {
+  struct GSObjectTables objects;
+
+  [self getObjectTables:&objects];
+  journalBegin(journal, &objects);
+}
+
+- (void)commitJournal {
+  struct GSObjectTables objects;
+  GSJournalEntry *entry;
+
+  [self getObjectTables:&objects];
+
+  if (journalCommit(journal, &objects, &entry) == -1) {
+    [NSException raise:NSMallocException format:@"Journal Commit Failed: %s", strerror(errno)];
+  }
+
+  // entry is NULL if nothing changed
+  if (entry != NULL) {
+    GSJournalEntryRef *ref = [[GSJournalEntryRef alloc] initWithJournal:journal entry:entry];
+    [[self undoManager] registerUndoWithTarget:self selector:@selector(applyJournalEntry:) object:ref];
+    [ref release];
+  }
+}
+
+// entries are their own inverse so undo and redo apply the same entry
+- (void)applyJournalEntry:(GSJournalEntryRef *)ref {
+  GSJournalEntry *entry = [ref entry];
+  struct GSObjectTables objects;
+
+  [self setNeedsDisplayForObjects];
+  [self getObjectTables:&objects];
+
+  occupancyCountTiles(occupancy, tiles, journalEntryRect(entry), -1);
+
+  if (journalApply(journal, entry, tiles, &objects) == -1) {
+    [NSException raise:NSGenericException format:@"Journal Apply Failed: %s", strerror(errno)];
+  }
+
+  occupancyCountTiles(occupancy, tiles, journalEntryRect(entry), 1);
+
+  [self setObjectTables:&objects];
+  [self setNeedsDisplayForObjects];
+
+  if (!GSIsEmptyRect(journalEntryRect(entry))) {
+    summedAreaUpdateRect(summedArea, tiles, journalEntryRect(entry));
+    [self publishTilesInRect:journalEntryRect(entry)];
+    [self remapImagesInRect:GSIntersectionRect(GSInsetRect(journalEntryRect(entry), -1, -1), kWorldRect)];
+  }
+
+  [[self undoManager] registerUndoWithTarget:self selector:@selector(applyJournalEntry:) object:ref];
 }
 
 - (void)createPillAt:(GSPoint)point {
@@ -396,7 +1001,9 @@ static NSImage *sprites = nil;
   NSAssert(pill.armour <= MAX_PILL_ARMOUR, @"Pill Armour Value Out of Bounds");
   NSAssert(pill.speed <= MAX_PILL_SPEED, @"Pill Speed Value Out of Bounds");
 
-  [[[self undoManager] prepareWithInvocationTarget:self] removePillAtIndex:i];
+  if (!journalIsOpen(journal)) {
+    [[[self undoManager] prepareWithInvocationTarget:self] removePillAtIndex:i];
+  }
 
   for (j = preamble.npills; j > i; j--) {
     pills[j] = pills[j - 1];
@@ -404,19 +1011,26 @@ static NSImage *sprites = nil;
 
   pills[i] = pill;
   preamble.npills++;
+  occupancyCountObject(occupancy, pill.x, pill.y, 1);
+  [self publishObjects:FEED_PILLS];
 
-  [boloView setNeedsDisplayInRect:GSRect2NSRect(GSMakeRect(pill.x, pill.y, 1, 1))];
+  [self setNeedsDisplayInWorldRect:GSMakeRect(pill.x, pill.y, 1, 1)];
 }
 
 - (void)removePillAtIndex:(NSUInteger)i {
   NSAssert(i < preamble.npills, @"Pill Out of Bounds");
-  [[[self undoManager] prepareWithInvocationTarget:self] insertPill:pills[i] atIndex:i];
-  [boloView setNeedsDisplayInRect:GSRect2NSRect(GSMakeRect(pills[i].x, pills[i].y, 1, 1))];
+  if (!journalIsOpen(journal)) {
+    [[[self undoManager] prepareWithInvocationTarget:self] insertPill:pills[i] atIndex:i];
+  }
+  [self setNeedsDisplayInWorldRect:GSMakeRect(pills[i].x, pills[i].y, 1, 1)];
+  occupancyCountObject(occupancy, pills[i].x, pills[i].y, -1);
   preamble.npills--;
 
   for (; i < preamble.npills; i++) {
     pills[i] = pills[i + 1];
   }
+
+  [self publishObjects:FEED_PILLS];
 }
 
 - (void)setPillAtIndex:(NSUInteger)i toPill:(struct BMAP_PillInfo)pill {
@@ -430,14 +1044,19 @@ static NSImage *sprites = nil;
     !GSEqualPoints(GSMakePoint(pills[i].x, pills[i].y), GSMakePoint(pill.x, pill.y)) ||
     pills[i].owner != pill.owner || pills[i].armour != pill.armour || pills[i].speed != pill.speed
   ) {
-    [[[self undoManager] prepareWithInvocationTarget:self] setPillAtIndex:i toPill:pills[i]];
+    if (!journalIsOpen(journal)) {
+      [[[self undoManager] prepareWithInvocationTarget:self] setPillAtIndex:i toPill:pills[i]];
+    }
 
     if (!GSEqualPoints(GSMakePoint(pills[i].x, pills[i].y), GSMakePoint(pill.x, pill.y))) {
-      [boloView setNeedsDisplayInRect:GSRect2NSRect(GSMakeRect(pills[i].x, pills[i].y, 1, 1))];
+      [self setNeedsDisplayInWorldRect:GSMakeRect(pills[i].x, pills[i].y, 1, 1)];
     }
 
+    occupancyCountObject(occupancy, pills[i].x, pills[i].y, -1);
+    occupancyCountObject(occupancy, pill.x, pill.y, 1);
     pills[i] = pill;
-    [boloView setNeedsDisplayInRect:GSRect2NSRect(GSMakeRect(pill.x, pill.y, 1, 1))];
+    [self publishObjects:FEED_PILLS];
+    [self setNeedsDisplayInWorldRect:GSMakeRect(pill.x, pill.y, 1, 1)];
   }
 }
 
@@ -466,7 +1085,9 @@ static NSImage *sprites = nil;
   NSAssert(base.shells <= MAX_BASE_SHELLS, @"Base Shell Value Out of Bounds");
   NSAssert(base.mines <= MAX_BASE_MINES, @"Base Mine Value Out of Bounds");
 
-  [[[self undoManager] prepareWithInvocationTarget:self] removeBaseAtIndex:i];
+  if (!journalIsOpen(journal)) {
+    [[[self undoManager] prepareWithInvocationTarget:self] removeBaseAtIndex:i];
+  }
 
   for (j = preamble.nbases; j > i; j--) {
     bases[j] = bases[j - 1];
@@ -474,14 +1095,20 @@ static NSImage *sprites = nil;
 
   bases[i] = base;
   preamble.nbases++;
+  occupancyCountObject(occupancy, base.x, base.y, 1);
+  [self publishObjects:FEED_BASES];
 
-  [boloView setNeedsDisplayInRect:GSRect2NSRect(GSMakeRect(base.x, base.y, 1, 1))];
+  [self setNeedsDisplayInWorldRect:GSMakeRect(base.x, base.y, 1, 1)];
 }
 
 - (void)removeBaseAtIndex:(NSUInteger)i {
   NSAssert(i < preamble.nbases, @"Base Out of Bounds");
-  [[[self undoManager] prepareWithInvocationTarget:self] insertBase:bases[i] atIndex:i];
-  [boloView setNeedsDisplayInRect:GSRect2NSRect(GSMakeRect(bases[i].x, bases[i].y, 1, 1))];
+  if (!journalIsOpen(journal)) {
+    [[[self undoManager] prepareWithInvocationTarget:self] insertBase:bases[i] atIndex:i];
+  }
+  [self setNeedsDisplayInWorldRect:GSMakeRect(bases[i].x, bases[i].y, 1, 1)];
+  occupancyCountObject(occupancy, bases[i].x, bases[i].y, -1);
+  [self publishObjects:FEED_BASES];
   preamble.nbases--;
 
   for (; i < preamble.nbases; i++) {
@@ -501,14 +1128,19 @@ static NSImage *sprites = nil;
     !GSEqualPoints(GSMakePoint(bases[i].x, bases[i].y), GSMakePoint(base.x, base.y)) ||
     bases[i].owner != base.owner || bases[i].armour != base.armour || bases[i].shells != base.shells || bases[i].mines != base.mines
   ) {
-    [[[self undoManager] prepareWithInvocationTarget:self] setBaseAtIndex:i toBase:bases[i]];
+    if (!journalIsOpen(journal)) {
+      [[[self undoManager] prepareWithInvocationTarget:self] setBaseAtIndex:i toBase:bases[i]];
+    }
 
     if (!GSEqualPoints(GSMakePoint(bases[i].x, bases[i].y), GSMakePoint(base.x, base.y))) {
-      [boloView setNeedsDisplayInRect:GSRect2NSRect(GSMakeRect(bases[i].x, bases[i].y, 1, 1))];
+      [self setNeedsDisplayInWorldRect:GSMakeRect(bases[i].x, bases[i].y, 1, 1)];
     }
 
+    occupancyCountObject(occupancy, bases[i].x, bases[i].y, -1);
+    occupancyCountObject(occupancy, base.x, base.y, 1);
+    [self publishObjects:FEED_BASES];
     bases[i] = base;
-    [boloView setNeedsDisplayInRect:GSRect2NSRect(GSMakeRect(base.x, base.y, 1, 1))];
+    [self setNeedsDisplayInWorldRect:GSMakeRect(base.x, base.y, 1, 1)];
   }
 }
 
@@ -531,7 +1163,9 @@ static NSImage *sprites = nil;
   NSAssert(GSPointInRect(kSeaRect, GSMakePoint(start.x, start.y)), @"Start Location Out of Bounds");
   NSAssert(start.dir < 16, @"Start Direction Out of Bounds");
 
-  [[[self undoManager] prepareWithInvocationTarget:self] removeStartAtIndex:i];
+  if (!journalIsOpen(journal)) {
+    [[[self undoManager] prepareWithInvocationTarget:self] removeStartAtIndex:i];
+  }
 
   for (j = preamble.nstarts; j > i; j--) {
     starts[j] = starts[j - 1];
@@ -539,14 +1173,20 @@ static NSImage *sprites = nil;
 
   starts[i] = start;
   preamble.nstarts++;
+  occupancyCountObject(occupancy, start.x, start.y, 1);
+  [self publishObjects:FEED_STARTS];
 
-  [boloView setNeedsDisplayInRect:GSRect2NSRect(GSMakeRect(start.x, start.y, 1, 1))];
+  [self setNeedsDisplayInWorldRect:GSMakeRect(start.x, start.y, 1, 1)];
 }
 
 - (void)removeStartAtIndex:(NSUInteger)i {
   NSAssert(i < preamble.nstarts, @"Start Out of Bounds");
-  [[[self undoManager] prepareWithInvocationTarget:self] insertStart:starts[i] atIndex:i];
-  [boloView setNeedsDisplayInRect:GSRect2NSRect(GSMakeRect(starts[i].x, starts[i].y, 1, 1))];
+  if (!journalIsOpen(journal)) {
+    [[[self undoManager] prepareWithInvocationTarget:self] insertStart:starts[i] atIndex:i];
+  }
+  [self setNeedsDisplayInWorldRect:GSMakeRect(starts[i].x, starts[i].y, 1, 1)];
+  occupancyCountObject(occupancy, starts[i].x, starts[i].y, -1);
+  [self publishObjects:FEED_STARTS];
   preamble.nstarts--;
 
   for (; i < preamble.nstarts; i++) {
@@ -560,14 +1200,19 @@ static NSImage *sprites = nil;
   NSAssert(start.dir < 16, @"Start Direction Out of Bounds");
 
   if (starts[i].dir != start.dir || !GSEqualPoints(GSMakePoint(starts[i].x, starts[i].y), GSMakePoint(start.x, start.y))) {
-    [[[self undoManager] prepareWithInvocationTarget:self] setStartAtIndex:i toStart:starts[i]];
+    if (!journalIsOpen(journal)) {
+      [[[self undoManager] prepareWithInvocationTarget:self] setStartAtIndex:i toStart:starts[i]];
+    }
 
     if (!GSEqualPoints(GSMakePoint(bases[i].x, bases[i].y), GSMakePoint(start.x, start.y))) {
-      [boloView setNeedsDisplayInRect:GSRect2NSRect(GSMakeRect(starts[i].x, starts[i].y, 1, 1))];
+      [self setNeedsDisplayInWorldRect:GSMakeRect(starts[i].x, starts[i].y, 1, 1)];
     }
 
+    occupancyCountObject(occupancy, starts[i].x, starts[i].y, -1);
+    occupancyCountObject(occupancy, start.x, start.y, 1);
+    [self publishObjects:FEED_STARTS];
     starts[i] = start;
-    [boloView setNeedsDisplayInRect:GSRect2NSRect(GSMakeRect(start.x, start.y, 1, 1))];
+    [self setNeedsDisplayInWorldRect:GSMakeRect(start.x, start.y, 1, 1)];
   }
 }
 
@@ -1171,6 +1816,43 @@ static NSImage *sprites = nil;
 
 @end
 
+@implementation GSJournalEntryRef
+
+- (id)initWithJournal:(GSJournal *)aJournal entry:(GSJournalEntry *)anEntry {
+  self = [super init];
+
+  if (self) {
+    journal = aJournal;
+    entry = anEntry;
+  }
+
+  return self;
+}
+
+- (void)dealloc {
+  journalDiscard(journal, entry);
+  [super dealloc];
+}
+
+- (GSJournalEntry *)entry {
+  return entry;
+}
+
+@end
+
+
+// the feed's subscribers, context is the map
+void coverageFed(void *context, GSRect rect, unsigned objects) {
+  [(GSXBoloMap *)context updateCoverageInRect:rect pills:(objects & FEED_PILLS) != 0];
+}
+
+void chokesFed(void *context, GSRect rect, unsigned objects) {
+  [(GSXBoloMap *)context updateChokes];
+}
+
+void visibilityFed(void *context, GSRect rect, unsigned objects) {
+  [(GSXBoloMap *)context updateVisibilityInRect:rect];
+}
 
 // flood fill algorithm to find size of the fill area
 // doesn't do out of bounds checks which is fine since there is a mine border that doesn't change
@@ -28,6 +28,8 @@
   // selection tool variables
   GSTileRect *underSelection;
   BOOL move;
+  GSTileRect *liftedSelection;   // tiles and objects being moved, at their original rect
+  GSTileRect *floatSelection;    // liftedSelection clipped and offset to where it is dragged
 }
 
 // menu actions
@@ -42,6 +44,9 @@
 - (IBAction)flipHorizontal:(id)sender;
 - (IBAction)flipVertical:(id)sender;
 - (IBAction)center:(id)sender;
+- (IBAction)toggleCoverage:(id)sender;
+- (IBAction)toggleChokes:(id)sender;
+- (IBAction)toggleHidingPlaces:(id)sender;
 
 @end
 
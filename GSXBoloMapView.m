@@ -34,6 +34,8 @@ static NSMutableArray *boloMapViews = nil;
 - (NSInteger)baseAtPoint:(GSPoint)point;
 - (NSInteger)startAtPoint:(GSPoint)point;
 - (void)setUnderSelection:(GSTileRect *)newUnderSelection;
+- (void)dropSelection;
+- (GSRect)selectionRect;
 - (void)setNeedsDisplayInSelectionRect;
 @end
 
@@ -49,6 +51,9 @@ static NSMutableArray *boloMapViews = nil;
 
 - (void)awakeFromNib {
   [self center:self];
+
+  // the selection statistics, the tip asks for them when it is shown
+  [self addToolTipRect:[self bounds] owner:self userData:NULL];
 }
 
 - (id)initWithFrame:(NSRect)frameRect {
@@ -65,6 +70,8 @@ static NSMutableArray *boloMapViews = nil;
 
     underSelection = nil;
     move = FALSE;
+    liftedSelection = nil;
+    floatSelection = nil;
 
     [boloMapViews addObject:self];
   } 
@@ -85,9 +92,40 @@ static NSMutableArray *boloMapViews = nil;
   [boloMapViews makeObjectsPerformSelector:@selector(setNeedsDisplayInSelectionRect)];
 }
 
+- (GSRect)selectionRect {
+  return floatSelection ? [floatSelection rect] : [underSelection rect];
+}
+
+// the size of the selection and its tiles of each class and mined, from
+// the map's summed-area tables so any selection costs a few lookups
+- (NSString *)view:(NSView *)view stringForToolTip:(NSToolTipTag)tag point:(NSPoint)point userData:(void *)data {
+  static NSString * const kLayerNames[kMinedLayer + 1] = { @"Sea", @"River", @"Wall", @"Road", @"Grass", @"Forest", @"Rough", @"Mined" };
+  NSMutableString *tip;
+  GSRect rect;
+  int layer;
+
+  rect = [self selectionRect];
+
+  if (underSelection == nil || !GSPointInRect(rect, GSMakePoint((int)(point.x/TILE_WIDTH), WIDTH - (int)(point.y/TILE_WIDTH) - 1))) {
+    return nil;
+  }
+
+  tip = [NSMutableString stringWithFormat:@"%d x %d", GSWidth(rect), GSHeight(rect)];
+
+  for (layer = 0; layer <= kMinedLayer; layer++) {
+    NSUInteger count = [boloMap countOfTileLayer:layer inRect:rect];
+
+    if (count > 0) {
+      [tip appendFormat:@"\n%@: %lu", kLayerNames[layer], (unsigned long)count];
+    }
+  }
+
+  return tip;
+}
+
 - (void)setNeedsDisplayInSelectionRect {
   if (underSelection) {
-    GSRect rect = [underSelection rect];
+    GSRect rect = [self selectionRect];
     [self setNeedsDisplayInRect:NSMakeRect(GSMinX(rect) * TILE_WIDTH, (WIDTH - (GSMinY(rect) + GSHeight(rect))) * TILE_WIDTH, GSWidth(rect) * TILE_WIDTH, 1.0f)];
     [self setNeedsDisplayInRect:NSMakeRect(GSMinX(rect) * TILE_WIDTH, ((WIDTH - GSMinY(rect)) * TILE_WIDTH) - 1.0f, GSWidth(rect) * TILE_WIDTH, 1.0f)];
     [self setNeedsDisplayInRect:NSMakeRect(GSMinX(rect) * TILE_WIDTH, ((WIDTH - (GSMinY(rect) + GSHeight(rect))) * TILE_WIDTH) + 1.0f, 1.0f, (GSHeight(rect) * TILE_WIDTH) - 2.0f)];
@@ -112,7 +150,7 @@ static NSMutableArray *boloMapViews = nil;
     NSBezierPath *b;
     NSInteger count = 2;
     CGFloat pattern[2] = { 5.0f, 5.0f };
-    rect = [underSelection rect];
+    rect = [self selectionRect];
     b = [NSBezierPath bezierPathWithRect:NSMakeRect((GSMinX(rect) * TILE_WIDTH) + 0.5f, ((WIDTH - (GSMinY(rect) + GSHeight(rect))) * TILE_WIDTH) + 0.5f, (GSWidth(rect) * TILE_WIDTH) - 1.0f, (GSHeight(rect) * TILE_WIDTH) - 1.0f)];
     [b setLineDash:pattern count:count phase:(CGFloat)phase];
     [[NSColor selectedControlColor] set];
@@ -323,6 +361,36 @@ static NSMutableArray *boloMapViews = nil;
   }
 }
 
+// writes a dragged selection into the map as a single undoable move
+- (void)dropSelection {
+  GSTileRect *over = [floatSelection autorelease];
+  int dX = lastMouseEvent.x - firstMouseEvent.x;
+  int dY = lastMouseEvent.y - firstMouseEvent.y;
+
+  [self setNeedsDisplayInSelectionRect];
+  floatSelection = nil;
+  [liftedSelection release];
+  liftedSelection = nil;
+  [boloMap floatTileRect:nil over:nil];
+  [self setNeedsDisplayInSelectionRect];
+
+  if (over && (dX != 0 || dY != 0)) {
+    [boloMap beginStroke];
+    // write under copy
+    [boloMap setTileRect:underSelection];
+    // offset objects
+    [boloMap offsetObjectsInRect:[underSelection rect] dX:dX dY:dY];
+    // set new under selection
+    [self setUnderSelection:[boloMap tilesInRect:[over rect]]];
+    // write copy
+    [boloMap setTileRect:over];
+    // for objects that entered
+    [boloMap setAppropriateTilesForObjectsInRect:[over rect]];
+    [boloMap endStroke];
+    [[boloMap undoManager] setActionName:@"Move"];
+  }
+}
+
 - (void)setUnderSelection:(GSTileRect *)newUnderSelection {
   [[boloMap undoManager] registerUndoWithTarget:self selector:@selector(setUnderSelection:) object:underSelection];
 
@@ -386,6 +454,7 @@ static NSMutableArray *boloMapViews = nil;
 
         [undoManager setGroupsByEvent:NO];
         [undoManager beginUndoGrouping];
+        [boloMap beginStroke];
 
         if (GSPointInRect(kSeaRect, mouseEvent) && (!underSelection || GSPointInRect([underSelection rect], mouseEvent))) {
           [boloMap setTile:[GSPaletteController palette] at:lastMouseEvent];
@@ -404,8 +473,9 @@ static NSMutableArray *boloMapViews = nil;
 
     case kSelectTool:
       if (underSelection && GSPointInRect([underSelection rect], firstMouseEvent)) {
+        // the selection floats over the map until the mouse is released
         move = TRUE;
-        [[boloMap undoManager] setActionName:@"Move"];
+        liftedSelection = [[boloMap tilesAndObjectsInRect:[underSelection rect]] retain];
       }
       else {
         [self setUnderSelection:nil];
@@ -448,6 +518,7 @@ static NSMutableArray *boloMapViews = nil;
 
         [undoManager setGroupsByEvent:NO];
         [undoManager beginUndoGrouping];
+        [boloMap beginStroke];
 
         if (GSPointInRect(kSeaRect, mouseEvent) && (!underSelection || GSPointInRect([underSelection rect], mouseEvent))) {
           [self mineTool];
@@ -585,30 +656,21 @@ static NSMutableArray *boloMapViews = nil;
           break;
 
         case kSelectTool:
-          // undo last move from mouse drag
-          [[boloMap undoManager] undo];
-
           if (move) {
             int dX = lastMouseEvent.x - firstMouseEvent.x;
             int dY = lastMouseEvent.y - firstMouseEvent.y;
-            // copy selected rect after clipping with edge
-            GSTileRect *over = [boloMap tilesInRect:GSOffsetRect(GSIntersectionRect(GSOffsetRect([underSelection rect], dX, dY), kSeaRect), -dX, -dY)];
-            // offset copy
-            [over offsetX:dX y:dY];
-            // write under copy
-            [boloMap setTileRect:underSelection];
-            // offset objects
-            [boloMap offsetObjectsInRect:[underSelection rect] dX:dX dY:dY];
-            // set new under selection
-            [self setUnderSelection:[boloMap tilesInRect:[over rect]]];
-            // write copy
-            [boloMap setTileRect:over];
-            // for objects that entered
-            [boloMap setAppropriateTilesForObjectsInRect:[over rect]];
-            // set undo name
-            [[boloMap undoManager] setActionName:@"Move"];
+
+            [self setNeedsDisplayInSelectionRect];
+            [floatSelection release];
+            // clip selected rect with edge and offset
+            floatSelection = [[GSTileRect alloc] initWithTileRect:liftedSelection inRect:GSOffsetRect(GSIntersectionRect(GSOffsetRect([liftedSelection rect], dX, dY), kSeaRect), -dX, -dY)];
+            [floatSelection offsetX:dX y:dY];
+            [boloMap floatTileRect:floatSelection over:underSelection];
+            [self setNeedsDisplayInSelectionRect];
           }
           else {
+            // undo last selection from mouse drag
+            [[boloMap undoManager] undo];
             [self setUnderSelection:[GSTileRect tileRectWithTile:kSeaTile inRect:[self getSelection]]];
             [[boloMap undoManager] setActionName:@"Select"];
           }
@@ -707,6 +769,7 @@ static NSMutableArray *boloMapViews = nil;
           break;
         }
 
+        [boloMap endStroke];
         [undoManager setActionName:actionName];
         [undoManager endUndoGrouping];
         [undoManager setGroupsByEvent:YES];
@@ -717,6 +780,7 @@ static NSMutableArray *boloMapViews = nil;
     case kMineTool:
       {
         NSUndoManager *undoManager = [boloMap undoManager];
+        [boloMap endStroke];
         [undoManager setActionName:@"Draw Mines"];
         [undoManager endUndoGrouping];
         [undoManager setGroupsByEvent:YES];
@@ -737,7 +801,11 @@ static NSMutableArray *boloMapViews = nil;
       break;
 
     case kSelectTool:
-      move = FALSE;
+      if (move) {
+        [self dropSelection];
+        move = FALSE;
+      }
+
       break;
 
     default:
@@ -754,7 +822,7 @@ static NSMutableArray *boloMapViews = nil;
   if (!GSEqualPoints(firstMouseEvent, GSMakePoint(-1, -1))) {
     switch ([GSToolsController tool]) {
     case kSelectTool:
-      if (underSelection) {
+      if (underSelection && !move) {
         [[boloMap undoManager] undo];
         [self setUnderSelection:[GSTileRect tileRectWithTile:kSeaTile inRect:[self getSelection]]];
         [[boloMap undoManager] setActionName:@"Select"];
@@ -797,11 +865,10 @@ static NSMutableArray *boloMapViews = nil;
     [pasteboard clearContents];
 
     // copy selection to pasteboard
-    [pasteboard writeObjects:[NSArray arrayWithObject:[boloMap tilesInRect:[underSelection rect]]]];
+    [pasteboard writeObjects:[NSArray arrayWithObject:[boloMap tilesAndObjectsInRect:[underSelection rect]]]];
 
-    // overwrite selection with kSeaTile
-    [boloMap setTileRect:[GSTileRect tileRectWithTile:kSeaTile inRect:[underSelection rect]]];
-    [boloMap setAppropriateTilesForObjectsInRect:[underSelection rect]];
+    // overwrite selection with kSeaTile, the objects went with the tiles
+    [boloMap setTileRectAndObjects:[GSTileRect tileRectWithTile:kSeaTile inRect:[underSelection rect]]];
     [[boloMap undoManager] setActionName:@"Cut"];
   }
 }
@@ -815,7 +882,7 @@ static NSMutableArray *boloMapViews = nil;
     [pasteboard clearContents];
 
     // copy selection to pasteboard
-    [pasteboard writeObjects:[NSArray arrayWithObject:[boloMap tilesInRect:[underSelection rect]]]];
+    [pasteboard writeObjects:[NSArray arrayWithObject:[boloMap tilesAndObjectsInRect:[underSelection rect]]]];
   }
 }
 
@@ -836,8 +903,7 @@ static NSMutableArray *boloMapViews = nil;
     tileRect = [objectsToPaste objectAtIndex:0];
 
     [self setUnderSelection:[boloMap tilesInRect:[tileRect rect]]];
-    [boloMap setTileRect:tileRect];
-    [boloMap setAppropriateTilesForObjectsInRect:[tileRect rect]];
+    [boloMap setTileRectAndObjects:tileRect];
     [[boloMap undoManager] setActionName:@"Paste"];
   }
 }
@@ -954,6 +1020,18 @@ static NSMutableArray *boloMapViews = nil;
   [self scrollRectToVisible:NSInsetRect(rect, (NSWidth(rect) - size.width) * 0.5f, (NSHeight(rect) - size.height) * 0.5f)];
 }
 
+- (IBAction)toggleCoverage:(id)sender {
+  [boloMap setShowsCoverage:![boloMap showsCoverage]];
+}
+
+- (IBAction)toggleChokes:(id)sender {
+  [boloMap setShowsChokes:![boloMap showsChokes]];
+}
+
+- (IBAction)toggleHidingPlaces:(id)sender {
+  [boloMap setShowsHidingPlaces:![boloMap showsHidingPlaces]];
+}
+
 - (BOOL)validateUserInterfaceItem:(id < NSValidatedUserInterfaceItem >)anItem {
   if ([anItem action] == @selector(cut:)) {
     return underSelection != nil;
@@ -996,6 +1074,27 @@ static NSMutableArray *boloMapViews = nil;
   else if ([anItem action] == @selector(center:)) {
     return TRUE;
   }
+  else if ([anItem action] == @selector(toggleCoverage:)) {
+    if ([(id)anItem respondsToSelector:@selector(setState:)]) {
+      [(id)anItem setState:[boloMap showsCoverage] ? NSOnState : NSOffState];
+    }
+
+    return TRUE;
+  }
+  else if ([anItem action] == @selector(toggleChokes:)) {
+    if ([(id)anItem respondsToSelector:@selector(setState:)]) {
+      [(id)anItem setState:[boloMap showsChokes] ? NSOnState : NSOffState];
+    }
+
+    return TRUE;
+  }
+  else if ([anItem action] == @selector(toggleHidingPlaces:)) {
+    if ([(id)anItem respondsToSelector:@selector(setState:)]) {
+      [(id)anItem setState:[boloMap showsHidingPlaces] ? NSOnState : NSOffState];
+    }
+
+    return TRUE;
+  }
 
   return NO;
 }
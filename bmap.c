@@ -12,6 +12,7 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <stddef.h>
 #include <assert.h>
 
 
@@ -20,6 +21,9 @@ const GSRect kSeaRect = { { MINE_BORDER_WIDTH, MINE_BORDER_WIDTH }, { WIDTH - (M
 const float k2Pif = 6.283185307179586;
 
 static ssize_t mapSize(const struct BMAP_Preamble *preamble, const struct BMAP_PillInfo pills[], const struct BMAP_BaseInfo bases[], const struct BMAP_StartInfo starts[], GSTile tiles[][WIDTH]);
+static int writeRowRun(struct BMAP_Run run, const void *buf, GSTile *row, int width);
+static int readClipRun(const GSTile *row, int width, int *x, struct BMAP_Run *run, void *data);
+static ssize_t clipSize(GSRect rect, const GSTile *tiles, const struct BMAP_Preamble *preamble, int *encoding);
 static int readNibble(const void *buf, size_t i);
 static void writeNibble(void *buf, size_t i, int nibble);
 
@@ -97,6 +101,11 @@ END
 }
 
 int writeRun(struct BMAP_Run run, const void *buf, GSTile tiles[][WIDTH]) {
+  return writeRowRun(run, buf, tiles[run.y], WIDTH);
+}
+
+// decodes a run into a row of width tiles
+int writeRowRun(struct BMAP_Run run, const void *buf, GSTile *row, int width) {
   int i;
   int x;
   int offset;
@@ -116,6 +125,8 @@ TRY
     if (len >= 0 && len <= 7) {  // this is a sequence of different tiles
       len += 1;
 
+      if (x + len > width) LOGFAIL(ECORFILE)
+
       if (sizeof(struct BMAP_Run) + (offset + len + 1)/2 > run.datalen) {
         LOGFAIL(ECORFILE)
       }
@@ -125,12 +136,14 @@ TRY
           LOGFAIL(ECORFILE)
         }
 
-        tiles[run.y][x++] = serverTileType;
+        row[x++] = serverTileType;
       }
     }
     else if (len >= 8 && len <= 15) {  // this is a sequence of like tiles
       len -= 6;
 
+      if (x + len > width) LOGFAIL(ECORFILE)
+
       if (sizeof(struct BMAP_Run) + (offset + 2)/2 > run.datalen) {
         LOGFAIL(ECORFILE)
       }
@@ -140,7 +153,7 @@ TRY
       }
 
       for (i = 0; i < len; i++) {
-        tiles[run.y][x++] = serverTileType;
+        row[x++] = serverTileType;
       }
     }
     else {
@@ -250,37 +263,30 @@ TRY
 
   // fix invalid pill info
   for (i = 0; i < preamble->npills; i++) {
-    int j;
+    int j, discard;
 
     // delete pills out of bounds
-    if (!GSPointInRect(kSeaRect, GSMakePoint(pills[i].x, pills[i].y))) {
-      preamble->npills--;
-
-      for (j = i; j < preamble->npills; j--) {
-        pills[j] = pills[j + 1];
-      }
-    }
+    discard = !GSPointInRect(kSeaRect, GSMakePoint(pills[i].x, pills[i].y));
 
     // delete pills under bases
-    for (j = 0; j < preamble->nbases; j++) {
-      if (GSEqualPoints(GSMakePoint(bases[j].x, bases[j].y), GSMakePoint(pills[i].x, pills[i].y))) {
-        preamble->npills--;
-
-        for (j = i; j < preamble->npills; j--) {
-          pills[j] = pills[j + 1];
-        }
-      }
+    for (j = 0; !discard && j < preamble->nbases; j++) {
+      discard = GSEqualPoints(GSMakePoint(bases[j].x, bases[j].y), GSMakePoint(pills[i].x, pills[i].y));
     }
 
     // delete pills under starts
-    for (j = 0; j < preamble->nstarts; j++) {
-      if (GSEqualPoints(GSMakePoint(starts[j].x, starts[j].y), GSMakePoint(pills[i].x, pills[i].y))) {
-        preamble->npills--;
+    for (j = 0; !discard && j < preamble->nstarts; j++) {
+      discard = GSEqualPoints(GSMakePoint(starts[j].x, starts[j].y), GSMakePoint(pills[i].x, pills[i].y));
+    }
 
-        for (j = i; j < preamble->npills; j--) {
-          pills[j] = pills[j + 1];
-        }
+    if (discard) {
+      preamble->npills--;
+
+      for (j = i; j < preamble->npills; j++) {
+        pills[j] = pills[j + 1];
       }
+
+      i--;
+      continue;
     }
 
     if (!(pills[i].owner == NEUTRAL || pills[i].owner < MAX_PLAYERS)) {
@@ -300,26 +306,25 @@ TRY
 
   // fix invalid base info
   for (i = 0; i < preamble->nbases; i++) {
-    int j;
+    int j, discard;
 
     // delete base out of bounds
-    if (!GSPointInRect(kSeaRect, GSMakePoint(bases[i].x, bases[i].y))) {
-      preamble->nbases--;
+    discard = !GSPointInRect(kSeaRect, GSMakePoint(bases[i].x, bases[i].y));
 
-      for (j = i; j < preamble->nbases; j--) {
-        bases[j] = bases[j + 1];
-      }
+    // delete base under starts
+    for (j = 0; !discard && j < preamble->nstarts; j++) {
+      discard = GSEqualPoints(GSMakePoint(starts[j].x, starts[j].y), GSMakePoint(bases[i].x, bases[i].y));
     }
 
-    // delete base under starts
-    for (j = 0; j < preamble->nstarts; j++) {
-      if (GSEqualPoints(GSMakePoint(starts[j].x, starts[j].y), GSMakePoint(bases[i].x, bases[i].y))) {
-        preamble->nbases--;
+    if (discard) {
+      preamble->nbases--;
 
-        for (j = i; j < preamble->nbases; j--) {
-          bases[j] = bases[j + 1];
-        }
+      for (j = i; j < preamble->nbases; j++) {
+        bases[j] = bases[j + 1];
       }
+
+      i--;
+      continue;
     }
 
     if (!(bases[i].owner == NEUTRAL || bases[i].owner < MAX_PLAYERS)) {
@@ -345,13 +350,16 @@ TRY
   for (i = 0; i < preamble->nstarts; i++) {
     int j;
 
-    // delete base out of bounds
+    // delete start out of bounds
     if (!GSPointInRect(kSeaRect, GSMakePoint(starts[i].x, starts[i].y))) {
       preamble->nstarts--;
 
-      for (j = i; j < preamble->nstarts; j--) {
+      for (j = i; j < preamble->nstarts; j++) {
         starts[j] = starts[j + 1];
       }
+
+      i--;
+      continue;
     }
 
     starts[i].dir %= 16;
@@ -364,6 +372,206 @@ ERRHANDLER(0, -1)
 END
 }
 
+// records the problem and fails with the matching errno
+#define DIAGNOSE(why, where, anObject, aRun, aRow) { \
+  diagnostic->reason = (why); \
+  diagnostic->offset = (where); \
+  diagnostic->object = (anObject); \
+  diagnostic->run = (aRun); \
+  diagnostic->row = (aRow); \
+  FAIL((why) == kMapBadVersion ? EINCMPAT : ECORFILE) \
+}
+
+int validateMap(const void *buf, size_t nbytes, struct BMAP_Diagnostic *diagnostic) {
+  const struct BMAP_Preamble *preamble;
+  size_t offset;
+  const struct BMAP_BaseInfo *bases;
+  const struct BMAP_StartInfo *starts;
+  int i, j, run;
+
+  assert(diagnostic != NULL);
+
+TRY
+  diagnostic->reason = kMapValid;
+  diagnostic->offset = 0;
+  diagnostic->object = -1;
+  diagnostic->run = -1;
+  diagnostic->row = -1;
+
+  if (nbytes < sizeof(struct BMAP_Preamble)) DIAGNOSE(kMapTruncated, nbytes, -1, -1, -1)
+
+  preamble = buf;
+
+  if (strncmp((char *)preamble->ident, MAP_FILE_IDENT, MAP_FILE_IDENT_LEN) != 0) DIAGNOSE(kMapBadIdent, 0, -1, -1, -1)
+  if (preamble->version != CURRENT_MAP_VERSION) DIAGNOSE(kMapBadVersion, offsetof(struct BMAP_Preamble, version), -1, -1, -1)
+  if (preamble->npills > MAX_PILLS) DIAGNOSE(kMapTooManyObjects, offsetof(struct BMAP_Preamble, npills), -1, -1, -1)
+  if (preamble->nbases > MAX_BASES) DIAGNOSE(kMapTooManyObjects, offsetof(struct BMAP_Preamble, nbases), -1, -1, -1)
+  if (preamble->nstarts > MAX_STARTS) DIAGNOSE(kMapTooManyObjects, offsetof(struct BMAP_Preamble, nstarts), -1, -1, -1)
+
+  if (nbytes <
+      sizeof(struct BMAP_Preamble) +
+      preamble->npills*sizeof(struct BMAP_PillInfo) +
+      preamble->nbases*sizeof(struct BMAP_BaseInfo) +
+      preamble->nstarts*sizeof(struct BMAP_StartInfo))
+    DIAGNOSE(kMapTruncated, nbytes, -1, -1, -1)
+
+  offset = sizeof(struct BMAP_Preamble);
+  bases = buf + offset + preamble->npills*sizeof(struct BMAP_PillInfo);
+  starts = (const void *)bases + preamble->nbases*sizeof(struct BMAP_BaseInfo);
+
+  for (i = 0; i < preamble->npills; i++, offset += sizeof(struct BMAP_PillInfo)) {
+    const struct BMAP_PillInfo *pill = buf + offset;
+
+    if (
+      !GSPointInRect(kSeaRect, GSMakePoint(pill->x, pill->y)) ||
+      !(pill->owner == NEUTRAL || pill->owner < MAX_PLAYERS) ||
+      pill->armour > MAX_PILL_ARMOUR || pill->speed > MAX_PILL_SPEED
+    ) {
+      DIAGNOSE(kMapBadPill, offset, i, -1, -1)
+    }
+
+    // loadMap() deletes pills under bases and starts
+    for (j = 0; j < preamble->nbases; j++) {
+      if (pill->x == bases[j].x && pill->y == bases[j].y) DIAGNOSE(kMapOverlappingObject, offset, i, -1, -1)
+    }
+
+    for (j = 0; j < preamble->nstarts; j++) {
+      if (pill->x == starts[j].x && pill->y == starts[j].y) DIAGNOSE(kMapOverlappingObject, offset, i, -1, -1)
+    }
+  }
+
+  for (i = 0; i < preamble->nbases; i++, offset += sizeof(struct BMAP_BaseInfo)) {
+    const struct BMAP_BaseInfo *base = buf + offset;
+
+    if (
+      !GSPointInRect(kSeaRect, GSMakePoint(base->x, base->y)) ||
+      !(base->owner == NEUTRAL || base->owner < MAX_PLAYERS) ||
+      base->armour > MAX_BASE_ARMOUR || base->shells > MAX_BASE_SHELLS || base->mines > MAX_BASE_MINES
+    ) {
+      DIAGNOSE(kMapBadBase, offset, i, -1, -1)
+    }
+
+    // and bases under starts
+    for (j = 0; j < preamble->nstarts; j++) {
+      if (base->x == starts[j].x && base->y == starts[j].y) DIAGNOSE(kMapOverlappingObject, offset, i, -1, -1)
+    }
+  }
+
+  for (i = 0; i < preamble->nstarts; i++, offset += sizeof(struct BMAP_StartInfo)) {
+    const struct BMAP_StartInfo *start = buf + offset;
+
+    if (!GSPointInRect(kSeaRect, GSMakePoint(start->x, start->y)) || start->dir > 15) {
+      DIAGNOSE(kMapBadStart, offset, i, -1, -1)
+    }
+  }
+
+  // walk the nibble tokens of every run without decoding them
+  for (run = 0;; run++) {
+    struct BMAP_Run header;
+    const void *data;
+    size_t nibs, nib;
+    int x;
+
+    if (offset + sizeof(struct BMAP_Run) > nbytes) DIAGNOSE(kMapMissingTerminator, offset, -1, run, -1)
+
+    header = *(const struct BMAP_Run *)(buf + offset);
+
+    // if last run, trailing bytes are ignored like loadMap() does
+    if (header.datalen == 4 && header.y == 0xff && header.startx == 0xff && header.endx == 0xff) {
+      break;
+    }
+
+    if (header.datalen < sizeof(struct BMAP_Run) || offset + header.datalen > nbytes) DIAGNOSE(kMapBadRunHeader, offset, -1, run, header.y)
+    if (header.startx >= header.endx) DIAGNOSE(kMapBadRunBounds, offset, -1, run, header.y)
+
+    data = buf + offset + sizeof(struct BMAP_Run);
+    nibs = (header.datalen - sizeof(struct BMAP_Run))*2;
+    nib = 0;
+    x = header.startx;
+
+    while (x < header.endx) {
+      size_t token = nib;
+      int len;
+
+      if (nib >= nibs) DIAGNOSE(kMapBadRunData, offset + sizeof(struct BMAP_Run) + token/2, -1, run, header.y)
+
+      len = readNibble(data, nib++);
+
+      if (len <= 7) {  // sequence of different tiles
+        len += 1;
+        nib += len;
+      }
+      else {  // sequence of like tiles
+        len -= 6;
+        nib += 1;
+      }
+
+      if (nib > nibs || x + len > header.endx) DIAGNOSE(kMapBadRunData, offset + sizeof(struct BMAP_Run) + token/2, -1, run, header.y)
+
+      x += len;
+    }
+
+    if (sizeof(struct BMAP_Run) + (nib + 1)/2 != header.datalen) DIAGNOSE(kMapRunLengthMismatch, offset, -1, run, header.y)
+
+    offset += header.datalen;
+  }
+
+CLEANUP
+ERRHANDLER(0, -1)
+END
+}
+
+#undef DIAGNOSE
+
+const char *mapDiagnosticString(int reason) {
+  switch (reason) {
+  case kMapValid:
+    return "valid";
+
+  case kMapTruncated:
+    return "file is truncated";
+
+  case kMapBadIdent:
+    return "not a BMAPBOLO file";
+
+  case kMapBadVersion:
+    return "unsupported map version";
+
+  case kMapTooManyObjects:
+    return "too many pills, bases or starts";
+
+  case kMapBadPill:
+    return "pill out of bounds or out of range";
+
+  case kMapBadBase:
+    return "base out of bounds or out of range";
+
+  case kMapBadStart:
+    return "start out of bounds or out of range";
+
+  case kMapOverlappingObject:
+    return "object on top of another";
+
+  case kMapBadRunHeader:
+    return "run length is invalid";
+
+  case kMapBadRunBounds:
+    return "run starts after it ends";
+
+  case kMapBadRunData:
+    return "run data overruns the run";
+
+  case kMapRunLengthMismatch:
+    return "run data does not match run length";
+
+  case kMapMissingTerminator:
+    return "runs are not terminated";
+
+  default:
+    return "unknown";
+  }
+}
+
 ssize_t saveMap(void **data, struct BMAP_Preamble *preamble, struct BMAP_PillInfo pills[], struct BMAP_BaseInfo bases[], struct BMAP_StartInfo starts[], GSTile tiles[][WIDTH]) {
   size_t y, x;
   void *runData;
@@ -424,6 +632,224 @@ ERRHANDLER(size, -1)
 END
 }
 
+int loadClipRect(const void *buf, size_t nbytes, GSRect *rect) {
+  const struct BMAP_ClipPreamble *clip;
+
+TRY
+  if (nbytes < sizeof(struct BMAP_ClipPreamble)) LOGFAIL(ECORFILE)
+
+  clip = buf;
+
+  if (strncmp((char *)clip->ident, CLIP_IDENT, CLIP_IDENT_LEN) != 0) LOGFAIL(ECORFILE)
+  if (clip->version != CURRENT_CLIP_VERSION) LOGFAIL(EINCMPAT)
+
+  *rect = GSMakeRect(clip->x, clip->y, (clip->width[0] << 8) | clip->width[1], (clip->height[0] << 8) | clip->height[1]);
+
+  if (!GSContainsRect(kWorldRect, *rect)) LOGFAIL(ECORFILE)
+
+CLEANUP
+ERRHANDLER(0, -1)
+END
+}
+
+int loadClip(const void *buf, size_t nbytes, struct BMAP_Preamble *preamble, struct BMAP_PillInfo pills[], struct BMAP_BaseInfo bases[], struct BMAP_StartInfo starts[], GSTile *tiles) {
+  const struct BMAP_ClipPreamble *clip;
+  GSRect rect;
+  size_t objectsLen;
+  const void *runData;
+  size_t runDataLen;
+  size_t offset;
+  int i, y;
+
+TRY
+  if (loadClipRect(buf, nbytes, &rect) == -1) LOGFAIL(errno)
+
+  clip = buf;
+
+  if (clip->npills > MAX_PILLS) LOGFAIL(ECORFILE)
+  if (clip->nbases > MAX_BASES) LOGFAIL(ECORFILE)
+  if (clip->nstarts > MAX_STARTS) LOGFAIL(ECORFILE)
+
+  objectsLen =
+    clip->npills*sizeof(struct BMAP_PillInfo) +
+    clip->nbases*sizeof(struct BMAP_BaseInfo) +
+    clip->nstarts*sizeof(struct BMAP_StartInfo);
+
+  if (nbytes < sizeof(struct BMAP_ClipPreamble) + objectsLen) LOGFAIL(ECORFILE)
+
+  bzero(preamble, sizeof(struct BMAP_Preamble));
+  preamble->npills = clip->npills;
+  preamble->nbases = clip->nbases;
+  preamble->nstarts = clip->nstarts;
+
+  buf += sizeof(struct BMAP_ClipPreamble);
+
+  bcopy(buf, pills, preamble->npills * sizeof(struct BMAP_PillInfo));
+  buf += preamble->npills * sizeof(struct BMAP_PillInfo);
+
+  bcopy(buf, bases, preamble->nbases * sizeof(struct BMAP_BaseInfo));
+  buf += preamble->nbases * sizeof(struct BMAP_BaseInfo);
+
+  bcopy(buf, starts, preamble->nstarts * sizeof(struct BMAP_StartInfo));
+  buf += preamble->nstarts * sizeof(struct BMAP_StartInfo);
+
+  // objects must lie inside of the rect and hold the values validateMap() accepts
+  for (i = 0; i < preamble->npills; i++) {
+    if (pills[i].x >= GSWidth(rect) || pills[i].y >= GSHeight(rect)) LOGFAIL(ECORFILE)
+    if (!(pills[i].owner == NEUTRAL || pills[i].owner < MAX_PLAYERS)) LOGFAIL(ECORFILE)
+    if (pills[i].armour > MAX_PILL_ARMOUR || pills[i].speed > MAX_PILL_SPEED) LOGFAIL(ECORFILE)
+  }
+
+  for (i = 0; i < preamble->nbases; i++) {
+    if (bases[i].x >= GSWidth(rect) || bases[i].y >= GSHeight(rect)) LOGFAIL(ECORFILE)
+    if (!(bases[i].owner == NEUTRAL || bases[i].owner < MAX_PLAYERS)) LOGFAIL(ECORFILE)
+    if (bases[i].armour > MAX_BASE_ARMOUR || bases[i].shells > MAX_BASE_SHELLS || bases[i].mines > MAX_BASE_MINES) LOGFAIL(ECORFILE)
+  }
+
+  for (i = 0; i < preamble->nstarts; i++) {
+    if (starts[i].x >= GSWidth(rect) || starts[i].y >= GSHeight(rect)) LOGFAIL(ECORFILE)
+    if (starts[i].dir > 15) LOGFAIL(ECORFILE)
+  }
+
+  runData = buf;
+  runDataLen = nbytes - (sizeof(struct BMAP_ClipPreamble) + objectsLen);
+
+  switch (clip->encoding) {
+  case kClipRawEncoding:
+    if (runDataLen != GSWidth(rect) * GSHeight(rect)) LOGFAIL(ECORFILE)
+
+    for (i = 0; i < GSWidth(rect) * GSHeight(rect); i++) {
+      if (((const GSTile *)runData)[i] > kMinedSeaTile) LOGFAIL(ECORFILE)
+    }
+
+    bcopy(runData, tiles, runDataLen);
+    break;
+
+  case kClipRunEncoding:
+    // everything outside of a run is sea
+    memset(tiles, kSeaTile, GSWidth(rect) * GSHeight(rect));
+
+    offset = 0;
+    y = 0;
+
+    for (;;) {
+      struct BMAP_Run run;
+
+      if (offset + sizeof(struct BMAP_Run) > runDataLen) LOGFAIL(ECORFILE)
+
+      run = *(struct BMAP_Run *)(runData + offset);
+
+      // if last run
+      if (run.datalen == 4 && run.y == 0xff && run.startx == 0xff && run.endx == 0xff) {
+        if (offset + run.datalen != runDataLen) LOGFAIL(ECORFILE)
+        break;
+      }
+
+      // runs are in order and within the rect
+      if (run.y < y || run.y >= GSHeight(rect) || run.startx >= run.endx || run.endx > GSWidth(rect)) LOGFAIL(ECORFILE)
+      if (run.datalen < sizeof(struct BMAP_Run) || offset + run.datalen > runDataLen) LOGFAIL(ECORFILE)
+      if (writeRowRun(run, runData + offset + sizeof(struct BMAP_Run), tiles + (run.y * GSWidth(rect)), run.endx) == -1) LOGFAIL(errno)
+
+      y = run.y;
+      offset += run.datalen;
+    }
+
+    break;
+
+  default:
+    LOGFAIL(EINCMPAT)
+  }
+
+CLEANUP
+ERRHANDLER(0, -1)
+END
+}
+
+ssize_t saveClip(void **data, GSRect rect, const GSTile *tiles, const struct BMAP_Preamble *preamble, const struct BMAP_PillInfo pills[], const struct BMAP_BaseInfo bases[], const struct BMAP_StartInfo starts[]) {
+  struct BMAP_ClipPreamble *clip;
+  ssize_t size;
+  int encoding;
+  void *buf;
+
+  *data = NULL;
+  size = 0;
+
+TRY
+  if (!GSContainsRect(kWorldRect, rect)) LOGFAIL(EINVAL)
+
+  // find the size of the clip
+  if ((size = clipSize(rect, tiles, preamble, &encoding)) == -1) LOGFAIL(errno)
+
+  // allocate memory
+  if ((buf = malloc(size)) == NULL) LOGFAIL(errno)
+  *data = buf;
+
+  // zero the bytes
+  bzero(*data, size);
+
+  clip = buf;
+  bcopy(CLIP_IDENT, clip->ident, CLIP_IDENT_LEN);
+  clip->version = CURRENT_CLIP_VERSION;
+  clip->encoding = encoding;
+  clip->x = GSMinX(rect);
+  clip->y = GSMinY(rect);
+  clip->width[0] = GSWidth(rect) >> 8;
+  clip->width[1] = GSWidth(rect) & 0xff;
+  clip->height[0] = GSHeight(rect) >> 8;
+  clip->height[1] = GSHeight(rect) & 0xff;
+  clip->npills = preamble->npills;
+  clip->nbases = preamble->nbases;
+  clip->nstarts = preamble->nstarts;
+  buf += sizeof(struct BMAP_ClipPreamble);
+
+  // copy structs
+  bcopy(pills, buf, preamble->npills * sizeof(struct BMAP_PillInfo));
+  buf += preamble->npills * sizeof(struct BMAP_PillInfo);
+
+  bcopy(bases, buf, preamble->nbases * sizeof(struct BMAP_BaseInfo));
+  buf += preamble->nbases * sizeof(struct BMAP_BaseInfo);
+
+  bcopy(starts, buf, preamble->nstarts * sizeof(struct BMAP_StartInfo));
+  buf += preamble->nstarts * sizeof(struct BMAP_StartInfo);
+
+  if (encoding == kClipRawEncoding) {
+    bcopy(tiles, buf, GSWidth(rect) * GSHeight(rect) * sizeof(GSTile));
+  }
+  else {
+    struct BMAP_Run *run;
+    int x, y;
+
+    for (y = 0; y < GSHeight(rect); y++) {
+      x = 0;
+      run = buf;
+
+      while (readClipRun(tiles + (y * GSWidth(rect)), GSWidth(rect), &x, run, run + 1) == 0) {
+        run->y = y;
+        buf += run->datalen;
+        run = buf;
+      }
+    }
+
+    // write the last run
+    run = buf;
+    run->datalen = 4;
+    run->y = 0xff;
+    run->startx = 0xff;
+    run->endx = 0xff;
+  }
+
+  data = NULL;
+
+CLEANUP
+  if (data != NULL && *data != NULL) {
+    free(*data);
+    *data = NULL;
+  }
+
+ERRHANDLER(size, -1)
+END
+}
+
 GSTile appropriateTileForPill(GSTile tile) {
   switch (tile) {
   case kSeaTile:
@@ -532,3 +958,113 @@ CLEANUP
 ERRHANDLER(len, -1)
 END
 }
+
+// finds the next run in a row of a clip starting at *x, returns 1 when the row has no more runs
+int readClipRun(const GSTile *row, int width, int *x, struct BMAP_Run *run, void *data) {
+  int nibs, len, i;
+
+  while (*x < width && row[*x] == kSeaTile) {
+    (*x)++;
+  }
+
+  if (*x >= width) {
+    return 1;
+  }
+
+  nibs = 0;
+  run->startx = *x;
+
+  do {
+    if (*x + 1 < width && row[*x + 1] == row[*x]) {  // sequence of like tiles
+      for (len = 2; *x + len < width && len < 9 && row[*x + len] == row[*x]; len++);
+
+      writeNibble(data, nibs++, len + 6);
+      writeNibble(data, nibs++, row[*x]);
+    }
+    else {  // sequence of different tiles
+      len = 1;
+
+      while (
+        (*x + len < width) && (len < 8) &&
+        (row[*x + len] != kSeaTile) &&
+        (*x + len + 1 >= width || row[*x + len] != row[*x + len + 1])
+      ) {
+        len++;
+      }
+
+      writeNibble(data, nibs++, len - 1);
+
+      for (i = 0; i < len; i++) {
+        writeNibble(data, nibs++, row[*x + i]);
+      }
+    }
+
+    *x += len;
+  } while (*x < width && row[*x] != kSeaTile);
+
+  run->endx = *x;
+  run->datalen = sizeof(struct BMAP_Run) + (nibs + 1)/2;
+
+  return 0;
+}
+
+// runs are used when every tile is a nibble or sea and the rect fits
+// in the 8 bit run coordinates, unless the raw tiles would be smaller
+ssize_t clipSize(GSRect rect, const GSTile *tiles, const struct BMAP_Preamble *preamble, int *encoding) {
+  size_t len, rawLen, runLen;
+  int i;
+
+  assert(preamble != NULL);
+
+  len = 0;
+  rawLen = 0;
+  runLen = 0;
+
+TRY
+  if (preamble->npills > MAX_PILLS) LOGFAIL(EINVAL)
+  if (preamble->nbases > MAX_BASES) LOGFAIL(EINVAL)
+  if (preamble->nstarts > MAX_STARTS) LOGFAIL(EINVAL)
+
+  len =
+    sizeof(struct BMAP_ClipPreamble) +
+    preamble->npills*sizeof(struct BMAP_PillInfo) +
+    preamble->nbases*sizeof(struct BMAP_BaseInfo) +
+    preamble->nstarts*sizeof(struct BMAP_StartInfo);
+
+  rawLen = GSWidth(rect) * GSHeight(rect) * sizeof(GSTile);
+  *encoding = kClipRawEncoding;
+
+  if (GSWidth(rect) <= 0xff && GSHeight(rect) <= 0xff) {
+    for (i = 0; i < GSWidth(rect) * GSHeight(rect); i++) {
+      if (tiles[i] > kMinedGrassTile && tiles[i] != kSeaTile) {
+        break;
+      }
+    }
+
+    if (i == GSWidth(rect) * GSHeight(rect)) {
+      int x, y;
+
+      runLen = sizeof(struct BMAP_Run);  // last run
+
+      for (y = 0; y < GSHeight(rect) && runLen < rawLen; y++) {
+        struct BMAP_Run run;
+        char buf[256];
+
+        x = 0;
+
+        while (readClipRun(tiles + (y * GSWidth(rect)), GSWidth(rect), &x, &run, buf) == 0) {
+          runLen += run.datalen;
+        }
+      }
+
+      if (runLen < rawLen) {
+        *encoding = kClipRunEncoding;
+        SUCCESS
+      }
+    }
+  }
+
+CLEANUP
+ERRHANDLER(len + (*encoding == kClipRunEncoding ? runLen : rawLen), -1)
+END
+}
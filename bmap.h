@@ -38,6 +38,10 @@
 #define MAP_FILE_IDENT      ("BMAPBOLO")
 #define MAP_FILE_IDENT_LEN  (8)
 
+#define CLIP_IDENT          ("BCLPBOLO")
+#define CLIP_IDENT_LEN      (8)
+#define CURRENT_CLIP_VERSION (1)
+
 #define WIDTH               (256)
 #define FWIDTH              (256.0)
 
@@ -85,6 +89,55 @@ struct BMAP_Run {
 //	uint8_t data[0xFF];  // actual length of data is always much less than 0xFF
 } __attribute__((__packed__));
 
+// clipboard encoding of a rect of tiles and the objects inside of it
+struct BMAP_ClipPreamble {
+  uint8_t ident[8];   // "BCLPBOLO"
+  uint8_t version;    // currently 1
+  uint8_t encoding;   // kClipRunEncoding or kClipRawEncoding
+  uint8_t x;          // origin of the rect
+  uint8_t y;
+  uint8_t width[2];   // big endian, up to 256
+  uint8_t height[2];  // big endian, up to 256
+  uint8_t npills;     // object coordinates are relative to the origin
+  uint8_t nbases;
+  uint8_t nstarts;
+} __attribute__((__packed__));
+
+enum {
+  kClipRunEncoding = 0,  // BMAP_Run per row segment, sea separates runs, 0xff terminated
+  kClipRawEncoding = 1   // one byte per tile, used when runs cannot express the rect
+} ;
+
+// reasons validateMap() rejects a map, the run reasons marked below are
+// stricter than loadMap() which loads those maps without complaint
+enum {
+  kMapValid = 0,
+  kMapTruncated,          // the file ends inside the preamble or an object record
+  kMapBadIdent,           // the file does not start with "BMAPBOLO"
+  kMapBadVersion,         // unsupported map version
+  kMapTooManyObjects,     // more pills, bases or starts than allowed
+  kMapBadPill,            // pill outside of the mine border or a field out of range
+  kMapBadBase,            // base outside of the mine border or a field out of range
+  kMapBadStart,           // start outside of the mine border or direction out of range
+  kMapOverlappingObject,  // pill on a base or start, or base on a start
+  kMapBadRunHeader,       // run shorter than its header or running past the end of the file
+  kMapBadRunBounds,       // run with startx >= endx, loadMap() takes it as an empty run
+  kMapBadRunData,         // nibble tokens run past datalen, or past endx which
+                          // loadMap() allows as long as they stay in the row
+  kMapRunLengthMismatch,  // nibble tokens do not fill datalen exactly, loadMap()
+                          // skips the unused bytes
+  kMapMissingTerminator   // the runs are not ended by the 0xff run, loadMap()
+                          // stops at the end of the file
+} ;
+
+struct BMAP_Diagnostic {
+  int reason;     // kMapValid if the map is valid
+  size_t offset;  // byte offset of the problem in the file
+  int object;     // index of the bad pill, base or start, otherwise -1
+  int run;        // index of the bad run, otherwise -1
+  int row;        // y of the bad run, otherwise -1
+} ;
+
 #include "rect.h"
 #include "tiles.h"
 #include "images.h"
@@ -104,10 +157,27 @@ int loadMap(const void *buf, size_t nbytes, struct BMAP_Preamble *preamble,
             struct BMAP_PillInfo pills[], struct BMAP_BaseInfo bases[],
             struct BMAP_StartInfo starts[], GSTile tiles[][WIDTH]);
 
+// checks a map without decoding it, the map is valid if 0 is returned
+// unlike loadMap() objects loadMap() would repair are reported as errors,
+// and so are the sloppy runs noted above, a map failing validation may
+// still be loadable
+int validateMap(const void *buf, size_t nbytes, struct BMAP_Diagnostic *diagnostic);
+const char *mapDiagnosticString(int reason);
+
 ssize_t saveMap(void **data, struct BMAP_Preamble *preamble,
                 struct BMAP_PillInfo pills[], struct BMAP_BaseInfo bases[],
                 struct BMAP_StartInfo starts[], GSTile tiles[][WIDTH]);
 
+// load/save clipboard data, tiles has a stride of GSWidth(rect)
+int loadClipRect(const void *buf, size_t nbytes, GSRect *rect);
+int loadClip(const void *buf, size_t nbytes, struct BMAP_Preamble *preamble,
+             struct BMAP_PillInfo pills[], struct BMAP_BaseInfo bases[],
+             struct BMAP_StartInfo starts[], GSTile *tiles);
+
+ssize_t saveClip(void **data, GSRect rect, const GSTile *tiles,
+                 const struct BMAP_Preamble *preamble, const struct BMAP_PillInfo pills[],
+                 const struct BMAP_BaseInfo bases[], const struct BMAP_StartInfo starts[]);
+
 GSTile appropriateTileForPill(GSTile tile);
 GSTile appropriateTileForBase(GSTile tile);
 GSTile appropriateTileForStart(GSTile tile);
@@ -0,0 +1,1978 @@
+//
+//  bmaptool.c
+//  XBolo Map Editor
+//
+//  Created by Robert Chrzanowski on 10/19/26.
+//  Copyright 2026 Robert Chrzanowski. All rights reserved.
+//
+
+// headless map tool for bulk processing a map repository
+//
+//   bmaptool <command> [-d] [-j threads] [-m megabytes] [-n matches] [-o dir] [-q map]
+//            [-s scale] [-S] [-t similarity] [path ...]
+//   bmaptool query file [column<=value ...]
+//
+// paths are map files or directories searched recursively, "-" or no
+// paths reads a single map from stdin.  one JSON line is written to
+// stdout per map in the order the paths were given, directory entries
+// are visited in sorted order so the output is the same for any
+// number of threads.  files are read in batches by ingest.c with at
+// most -m megabytes of map data in memory, and each map is run on a work
+// stealing pool as soon as it is read since a dense map can take far
+// longer than a sparse one.  -S prints the pool's counters to stderr.
+//
+// dedup hashes every map in parallel and marks each map whose decoded
+// tiles and objects match an earlier one, with -d maps that match up to
+// a rotation or mirror image count as the same.
+//
+// similar adds a MinHash signature of every map to an LSH index as the
+// maps are read, then lists the maps most like each map, or only like the
+// -q map, once every map is in the index.
+//
+// index writes a catalog.c column file of every map to -o or stdout, and
+// query prints the maps of such a file whose columns are in the given
+// ranges without decoding any maps.
+//
+// reach finds the start closest to every pill and base of each map over
+// reach.c's default terrain costs and how evenly they are shared out,
+// and travel prints the cost of driving from every start to every pill
+// and from every base to every other base found on a path.c graph.
+//
+// coverage prints how much of each map its pills can hit and how many
+// pills hit each base, and place proposes pills covering the approaches
+// to the bases found by placement.c's annealing search.
+//
+// chokes prints the land tiles whose loss would split the most off an
+// island and the fewest tiles cutting each island's starts from its bases.
+//
+// distance prints how far each base is from the nearest sea, wall and mine
+// by distance.c's exact euclidean transform.
+//
+// visibility prints how far each map lets a tank see and how many places
+// it has to hide in forest, and to snipe from, by visibility.c.
+//
+// symmetry prints how nearly each map is the same turned or mirrored and
+// the tiles spoiling its best symmetry, by symmetry.c.
+
+#include "bmap.h"
+#include "hash.h"
+#include "similar.h"
+#include "catalog.h"
+#include "reach.h"
+#include "path.h"
+#include "coverage.h"
+#include "placement.h"
+#include "chokes.h"
+#include "distance.h"
+#include "visibility.h"
+#include "symmetry.h"
+#include "pool.h"
+#include "ingest.h"
+#include "errchk.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <stdarg.h>
+#include <math.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+
+#define MAX_MAP_SIZE  (1 << 20)  // larger files can not be maps
+#define MAX_SCALE     (16)
+#define MAX_MATCHES   (1000)
+#define MAX_CHOKES    (16)  // articulation tiles printed by chokes
+#define MAX_MISMATCHES (32)  // tiles printed by symmetry
+
+enum {
+  kInfoCommand,
+  kValidateCommand,
+  kReencodeCommand,
+  kPreviewCommand,
+  kHashCommand,
+  kDedupCommand,
+  kSimilarCommand,
+  kIndexCommand,
+  kReachCommand,
+  kTravelCommand,
+  kCoverageCommand,
+  kPlaceCommand,
+  kChokesCommand,
+  kDistanceCommand,
+  kVisibilityCommand,
+  kSymmetryCommand,
+  kQueryCommand,
+  kCommandCount
+} ;
+
+static const char *kCommandNames[kCommandCount] = { "info", "validate", "reencode", "preview", "hash", "dedup", "similar", "index", "reach", "travel", "coverage", "place", "chokes", "distance", "visibility", "symmetry", "query" };
+
+static const char *kSymmetryNames[kSymmetryCount] = { "identity", "flip_horizontal", "flip_vertical", "rotate_half", "transpose", "antitranspose", "rotate_left", "rotate_right" };
+
+struct Job {
+  char *path;     // NULL for stdin
+  char *name;     // path of the output relative to the output directory
+  void *data;     // contents of the file once read
+  size_t nbytes;
+  int readError;
+  char *result;   // JSON line, NULL if it could not be built
+  uint64_t hash;  // content hash for dedup
+  int hashed;
+  struct GSMapSignature *signature;  // added to the similar index
+  struct GSMapFeatures *features;    // row of the feature index
+  int failed;     // the map is bad or could not be processed
+  int finished;
+} ;
+
+struct Batch {
+  int command;
+  const char *outdir;  // NULL writes output to stdout
+  int scale;
+  int dihedral;        // hash the same up to rotations and mirrors
+  GSSimilarIndex *similar;
+  double threshold;    // least similarity listed
+  size_t nmatches;     // most maps listed per map
+  int query;           // only the first job is queried
+  int placeThreads;    // threads the pill search of each map runs on
+
+  struct Job *jobs;
+  size_t njobs;
+  size_t capacity;
+
+  GSPool *pool;
+  GSIngest *ingest;
+  char **paths;      // paths of the jobs read from files
+  size_t *pathJobs;  // job of each path
+  size_t npaths;
+
+  pthread_mutex_t lock;
+  pthread_cond_t finished;
+} ;
+
+struct Map {
+  struct BMAP_Preamble preamble;
+  struct BMAP_PillInfo pills[MAX_PILLS];
+  struct BMAP_BaseInfo bases[MAX_BASES];
+  struct BMAP_StartInfo starts[MAX_STARTS];
+  GSTile tiles[WIDTH][WIDTH];
+} ;
+
+// a growable string for building JSON lines
+struct Line {
+  char *buf;
+  size_t len;
+  size_t capacity;
+} ;
+
+static void usage(void);
+static int addJob(struct Batch *batch, const char *path, const char *name);
+static int addPath(struct Batch *batch, const char *path, const char *name);
+static int addDirectory(struct Batch *batch, const char *path, const char *name);
+static void *ingestMain(void *arg);
+static void mapRead(void *context, size_t index, void *data, size_t nbytes, int error);
+static void runJobs(GSPool *pool, void *context, size_t begin, size_t end);
+static void queryJobs(GSPool *pool, void *context, size_t begin, size_t end);
+static void printStatistics(GSPool *pool);
+static void runJob(struct Batch *batch, struct Job *job);
+static ssize_t readStdin(void **data);
+static ssize_t readFile(const char *path, void **data);
+static int writeFile(struct Batch *batch, struct Job *job, const char *suffix, const void *data, size_t nbytes);
+static int makeParents(char *path);
+static size_t findDuplicate(struct Batch *batch, size_t *table, size_t mask, size_t i);
+static int printDuplicate(FILE *report, struct Batch *batch, struct Job *job, struct Job *first);
+
+// commands return 0 on success, 1 if the map fails and -1 on error
+static int info(struct Line *line, const void *data, size_t nbytes, struct Map *map);
+static int validate(struct Line *line, const void *data, size_t nbytes);
+static int reencode(struct Batch *batch, struct Job *job, struct Line *line, const void *data, size_t nbytes, struct Map *map);
+static int preview(struct Batch *batch, struct Job *job, struct Line *line, const void *data, size_t nbytes, struct Map *map);
+static int hash(struct Batch *batch, struct Job *job, struct Line *line, const void *data, size_t nbytes, struct Map *map);
+static int sign(struct Batch *batch, struct Job *job, struct Line *line, const void *data, size_t nbytes, struct Map *map);
+static int listSimilar(struct Batch *batch, struct Job *job, struct Line *line);
+static int extract(struct Job *job, struct Line *line, const void *data, size_t nbytes, struct Map *map);
+static int territory(struct Line *line, const void *data, size_t nbytes, struct Map *map);
+static int travel(struct Line *line, const void *data, size_t nbytes, struct Map *map);
+static int coverage(struct Line *line, const void *data, size_t nbytes, struct Map *map);
+static int place(struct Batch *batch, struct Line *line, const void *data, size_t nbytes, struct Map *map);
+static int narrows(struct Line *line, const void *data, size_t nbytes, struct Map *map);
+static int clearances(struct Line *line, const void *data, size_t nbytes, struct Map *map);
+static int sight(struct Line *line, const void *data, size_t nbytes, struct Map *map);
+static int symmetries(struct Line *line, const void *data, size_t nbytes, struct Map *map);
+static int appendStarts(struct Line *line, const char *key, const uint8_t starts[], int n);
+static int queryIndex(int argc, char *const argv[]);
+
+static ssize_t renderPreview(void **data, const struct Map *map, int scale);
+
+static const char *errorString(int error);
+static int append(struct Line *line, const char *format, ...) __attribute__((format(printf, 2, 3)));
+static int appendString(struct Line *line, const char *string);
+
+int main(int argc, char *argv[]) {
+  struct Batch batch;
+  pthread_t reader;
+  FILE *report;
+  GSFeatureTable *features;
+  const char *query;
+  long nthreads, budget;
+  size_t *table, mask, i, unique, duplicateBytes;
+  int opt, failures, statistics;
+
+  bzero(&batch, sizeof(batch));
+  batch.scale = 1;
+  batch.threshold = 0.5;
+  batch.nmatches = 10;
+  query = NULL;
+  features = NULL;
+  nthreads = 0;
+  budget = DEFAULT_INGEST_BUDGET >> 20;
+  failures = 0;
+  statistics = 0;
+  table = NULL;
+  mask = 0;
+  unique = 0;
+  duplicateBytes = 0;
+
+  if (argc < 2) {
+    usage();
+    return 2;
+  }
+
+  for (batch.command = 0; batch.command < kCommandCount; batch.command++) {
+    if (strcmp(argv[1], kCommandNames[batch.command]) == 0) {
+      break;
+    }
+  }
+
+  if (batch.command == kCommandCount) {
+    usage();
+    return 2;
+  }
+
+  if (batch.command == kQueryCommand) {
+    return queryIndex(argc - 2, argv + 2);
+  }
+
+  optind = 2;
+
+  while ((opt = getopt(argc, argv, "dj:m:n:o:q:s:St:")) != -1) {
+    switch (opt) {
+    case 'd':
+      batch.dihedral = 1;
+      break;
+
+    case 'j':
+      nthreads = strtol(optarg, NULL, 10);
+      break;
+
+    case 'm':
+      budget = strtol(optarg, NULL, 10);
+      break;
+
+    case 'n':
+      batch.nmatches = strtoul(optarg, NULL, 10);
+      break;
+
+    case 'o':
+      batch.outdir = optarg;
+      break;
+
+    case 'q':
+      query = optarg;
+      break;
+
+    case 's':
+      batch.scale = (int)strtol(optarg, NULL, 10);
+      break;
+
+    case 'S':
+      statistics = 1;
+      break;
+
+    case 't':
+      batch.threshold = strtod(optarg, NULL);
+      break;
+
+    default:
+      usage();
+      return 2;
+    }
+  }
+
+  if (nthreads < 0 || nthreads > MAX_POOL_THREADS || budget < 1 || batch.scale < 1 || batch.scale > MAX_SCALE ||
+    batch.nmatches < 1 || batch.nmatches > MAX_MATCHES || !(batch.threshold >= 0.0 && batch.threshold <= 1.0) ||
+    (query != NULL && batch.command != kSimilarCommand)
+  ) {
+    usage();
+    return 2;
+  }
+
+  // the query is the first job
+  if (query != NULL) {
+    if (addPath(&batch, query, NULL) == -1) {
+      fprintf(stderr, "bmaptool: %s: %s\n", query, strerror(errno));
+      return 1;
+    }
+
+    if (batch.njobs != 1) {
+      fprintf(stderr, "bmaptool: -q needs a single map\n");
+      return 2;
+    }
+
+    batch.query = 1;
+  }
+
+  if (optind == argc && query == NULL) {
+    if (addJob(&batch, NULL, "stdin") == -1) {
+      perror("bmaptool");
+      return 1;
+    }
+  }
+  else {
+    for (; optind < argc; optind++) {
+      if (addPath(&batch, argv[optind], NULL) == -1) {
+        fprintf(stderr, "bmaptool: %s: %s\n", argv[optind], strerror(errno));
+        return 1;
+      }
+    }
+  }
+
+  // many maps are searched a thread each, a single map on every thread
+  batch.placeThreads = batch.njobs == 1 ? (int)nthreads : 1;
+
+  // without an output directory the map or preview goes to stdout and the report to stderr
+  report = stdout;
+
+  if ((batch.command == kReencodeCommand || batch.command == kPreviewCommand) && batch.outdir == NULL) {
+    if (batch.njobs != 1) {
+      fprintf(stderr, "bmaptool: %s of more than one map needs -o\n", kCommandNames[batch.command]);
+      return 2;
+    }
+
+    report = stderr;
+  }
+
+  // the index is written to -o or to stdout
+  if (batch.command == kIndexCommand) {
+    if ((features = featureTableCreate()) == NULL) {
+      perror("bmaptool");
+      return 1;
+    }
+
+    if (batch.outdir == NULL) {
+      report = stderr;
+    }
+  }
+
+  // open addressing table of job index + 1 keyed by hash, at most half full
+  if (batch.command == kDedupCommand) {
+    for (mask = 1; mask < batch.njobs*2; mask <<= 1);
+
+    if ((table = calloc(mask, sizeof(size_t))) == NULL) {
+      perror("bmaptool");
+      return 1;
+    }
+
+    mask--;
+  }
+
+  if (batch.command == kSimilarCommand && (batch.similar = similarCreate()) == NULL) {
+    perror("bmaptool");
+    return 1;
+  }
+
+  pthread_mutex_init(&batch.lock, NULL);
+  pthread_cond_init(&batch.finished, NULL);
+
+  if (
+    (batch.paths = malloc(batch.njobs*sizeof(char *))) == NULL ||
+    (batch.pathJobs = malloc(batch.njobs*sizeof(size_t))) == NULL ||
+    (batch.pool = poolCreate((int)nthreads)) == NULL ||
+    (batch.ingest = ingestCreate((size_t)budget << 20, MAX_MAP_SIZE)) == NULL
+  ) {
+    perror("bmaptool");
+    return 1;
+  }
+
+  for (i = 0; i < batch.njobs; i++) {
+    struct Job *job = batch.jobs + i;
+
+    if (job->path != NULL) {
+      batch.paths[batch.npaths] = job->path;
+      batch.pathJobs[batch.npaths] = i;
+      batch.npaths++;
+    }
+    else {
+      ssize_t nbytes;
+
+      // stdin is read here before anything else runs
+      if ((nbytes = readStdin(&job->data)) == -1) {
+        job->readError = errno;
+        CLEARERRLOG
+      }
+      else {
+        job->nbytes = nbytes;
+      }
+
+      if (poolSubmit(batch.pool, runJobs, &batch, i, i + 1, 1) == -1) {
+        perror("bmaptool");
+        return 1;
+      }
+    }
+  }
+
+  // files are handed to the pool as they are read
+  if (pthread_create(&reader, NULL, ingestMain, &batch) != 0) {
+    perror("bmaptool");
+    return 1;
+  }
+
+  // maps are only compared once all of them are in the index
+  if (batch.similar != NULL) {
+    pthread_mutex_lock(&batch.lock);
+
+    for (i = 0; i < batch.njobs; i++) {
+      while (!batch.jobs[i].finished) {
+        pthread_cond_wait(&batch.finished, &batch.lock);
+      }
+    }
+
+    pthread_mutex_unlock(&batch.lock);
+
+    if (poolSubmit(batch.pool, queryJobs, &batch, 0, batch.query ? 1 : batch.njobs, 8) == -1) {
+      perror("bmaptool");
+      return 1;
+    }
+
+    poolWait(batch.pool);
+  }
+
+  // print results in order as they finish
+  for (i = 0; i < batch.njobs; i++) {
+    struct Job *job = batch.jobs + i;
+
+    pthread_mutex_lock(&batch.lock);
+
+    while (!job->finished) {
+      pthread_cond_wait(&batch.finished, &batch.lock);
+    }
+
+    pthread_mutex_unlock(&batch.lock);
+
+    if (job->result != NULL && job->hashed && table != NULL) {
+      size_t first = findDuplicate(&batch, table, mask, i);
+
+      if (first == i) {
+        unique++;
+      }
+      else {
+        duplicateBytes += job->nbytes;
+      }
+
+      if (printDuplicate(report, &batch, job, first != i ? batch.jobs + first : NULL) == -1) {
+        fprintf(report, "{\"error\":\"%s\"}\n", strerror(ENOMEM));
+        CLEARERRLOG
+      }
+    }
+    else if (batch.query && i > 0 && !job->failed) {
+      // only the query and the maps that could not be indexed are listed
+    }
+    else if (job->result != NULL) {
+      fputs(job->result, report);
+    }
+    else {
+      fprintf(report, "{\"error\":\"%s\"}\n", strerror(ENOMEM));
+    }
+
+    if (job->features != NULL && featureTableAppend(features, job->path != NULL ? job->path : "-", job->features) == -1) {
+      perror("bmaptool");
+      return 1;
+    }
+
+    failures += job->failed;
+    free(job->result);
+    free(job->features);
+    job->result = NULL;
+    job->features = NULL;
+  }
+
+  pthread_join(reader, NULL);
+  poolWait(batch.pool);
+
+  if (table != NULL) {
+    fprintf(stderr, "{\"maps\":%zu,\"unique\":%zu,\"duplicates\":%zu,\"duplicate_bytes\":%zu}\n",
+            batch.njobs, unique, batch.njobs - failures - unique, duplicateBytes);
+  }
+
+  if (features != NULL) {
+    void *out;
+    ssize_t size;
+    int fd;
+
+    fd = STDOUT_FILENO;
+
+    if (
+      (size = saveFeatureTable(&out, features)) == -1 ||
+      (batch.outdir != NULL && (fd = open(batch.outdir, O_WRONLY | O_CREAT | O_TRUNC, 0666)) == -1) ||
+      write(fd, out, size) != size ||
+      (fd != STDOUT_FILENO && close(fd) == -1)
+    ) {
+      fprintf(stderr, "bmaptool: %s: %s\n", batch.outdir != NULL ? batch.outdir : "stdout", errorString(errno));
+      return 1;
+    }
+
+    free(out);
+    featureTableDestroy(features);
+  }
+
+  if (statistics) {
+    fprintf(stderr, "{\"ingest\":\"%s\"}\n", ingestMethod(batch.ingest));
+    printStatistics(batch.pool);
+  }
+
+  poolDestroy(batch.pool);
+  ingestDestroy(batch.ingest);
+  free(batch.paths);
+  free(batch.pathJobs);
+  free(table);
+  similarDestroy(batch.similar);
+
+  // paths are kept until the end since later duplicates name the first map
+  for (i = 0; i < batch.njobs; i++) {
+    free(batch.jobs[i].path);
+    free(batch.jobs[i].name);
+    free(batch.jobs[i].signature);
+  }
+
+  pthread_cond_destroy(&batch.finished);
+  pthread_mutex_destroy(&batch.lock);
+  free(batch.jobs);
+
+  if (fflush(report) == EOF) {
+    perror("bmaptool");
+    return 1;
+  }
+
+  return failures > 0 ? 1 : 0;
+}
+
+void usage(void) {
+  fprintf(stderr,
+    "usage: bmaptool info|validate|reencode|preview|hash|dedup|similar|index|reach|travel|coverage|place|chokes|distance|visibility|symmetry [-d] [-j threads] [-m megabytes] [-n matches] [-o dir]\n"
+    "                [-q map] [-s scale] [-S] [-t similarity] [path ...]\n"
+    "       bmaptool query file [column<=value ...]\n"
+    "  info      print the object counts and land bounds of each map\n"
+    "  validate  check each map without decoding it\n"
+    "  reencode  decode and encode each map into dir\n"
+    "  preview   render each map into dir as a PPM image, scale pixels per tile\n"
+    "  hash      print a hash of the decoded tiles and objects of each map\n"
+    "  dedup     name the first earlier map with the same hash as each map\n"
+    "  similar   list the maps most like each map, or like the -q map\n"
+    "  index     write a feature index of the maps to the file -o or to stdout\n"
+    "  reach     print the closest start to each pill and base and how evenly they are shared\n"
+    "  travel    print the cost of driving from each start to each pill and between the bases\n"
+    "  coverage  print the tiles the pills can hit and the pills that can hit each base\n"
+    "  place     propose pills covering the approaches to the bases, on -j threads for one map\n"
+    "  chokes    print the land tiles splitting the most off an island and the cuts from starts to bases\n"
+    "  distance  print the distance from each base to the nearest sea, wall and mine\n"
+    "  visibility  print the tiles seen from each tile and the places to hide and snipe from\n"
+    "  symmetry  print how nearly each map matches itself turned or mirrored about its land\n"
+    "  query     print the maps of a feature index whose columns satisfy every\n"
+    "            comparison, one of < <= = >= >, such as pills>=12 or width<120\n"
+    "  -d        hash maps that are rotations or mirror images of each other the same\n"
+    "  -m        most megabytes of map files held in memory at once\n"
+    "  -n        most maps listed by similar, 10 by default\n"
+    "  -t        least similarity from 0 to 1 listed by similar, 0.5 by default\n"
+    "  -S        print the thread pool counters to stderr\n");
+}
+
+int addJob(struct Batch *batch, const char *path, const char *name) {
+  struct Job *job;
+
+TRY
+  if (batch->njobs == batch->capacity) {
+    size_t capacity = batch->capacity > 0 ? batch->capacity*2 : 64;
+    struct Job *jobs;
+
+    if ((jobs = realloc(batch->jobs, capacity*sizeof(struct Job))) == NULL) LOGFAIL(errno)
+    batch->jobs = jobs;
+    batch->capacity = capacity;
+  }
+
+  job = batch->jobs + batch->njobs;
+  bzero(job, sizeof(struct Job));
+
+  if (path != NULL && (job->path = strdup(path)) == NULL) LOGFAIL(errno)
+
+  if ((job->name = strdup(name)) == NULL) {
+    free(job->path);
+    LOGFAIL(errno)
+  }
+
+  batch->njobs++;
+
+CLEANUP
+ERRHANDLER(0, -1)
+END
+}
+
+// name is the path relative to the argument the path was found under
+int addPath(struct Batch *batch, const char *path, const char *name) {
+  struct stat st;
+
+TRY
+  if (strcmp(path, "-") == 0) {
+    if (addJob(batch, NULL, "stdin") == -1) LOGFAIL(errno)
+    SUCCESS
+  }
+
+  if (stat(path, &st) == -1) LOGFAIL(errno)
+
+  if (S_ISDIR(st.st_mode)) {
+    if (addDirectory(batch, path, name) == -1) LOGFAIL(errno)
+  }
+  else if (S_ISREG(st.st_mode)) {
+    const char *base;
+
+    if (name == NULL) {
+      base = strrchr(path, '/');
+      name = base != NULL ? base + 1 : path;
+    }
+
+    if (addJob(batch, path, name) == -1) LOGFAIL(errno)
+  }
+
+CLEANUP
+ERRHANDLER(0, -1)
+END
+}
+
+int addDirectory(struct Batch *batch, const char *path, const char *name) {
+  struct dirent **entries;
+  int nentries, i;
+  char *subpath, *subname;
+
+  entries = NULL;
+  nentries = 0;
+  subpath = NULL;
+  subname = NULL;
+
+TRY
+  if ((nentries = scandir(path, &entries, NULL, alphasort)) == -1) {
+    nentries = 0;
+    LOGFAIL(errno)
+  }
+
+  for (i = 0; i < nentries; i++) {
+    // skip ".", ".." and hidden files
+    if (entries[i]->d_name[0] == '.') {
+      continue;
+    }
+
+    if (asprintf(&subpath, "%s/%s", path, entries[i]->d_name) == -1) {
+      subpath = NULL;
+      LOGFAIL(ENOMEM)
+    }
+
+    if (name != NULL) {
+      if (asprintf(&subname, "%s/%s", name, entries[i]->d_name) == -1) {
+        subname = NULL;
+        LOGFAIL(ENOMEM)
+      }
+    }
+    else if ((subname = strdup(entries[i]->d_name)) == NULL) LOGFAIL(errno)
+
+    if (addPath(batch, subpath, subname) == -1) LOGFAIL(errno)
+
+    free(subpath);
+    subpath = NULL;
+    free(subname);
+    subname = NULL;
+  }
+
+CLEANUP
+  free(subpath);
+  free(subname);
+
+  for (i = 0; i < nentries; i++) {
+    free(entries[i]);
+  }
+
+  free(entries);
+
+ERRHANDLER(0, -1)
+END
+}
+
+void *ingestMain(void *arg) {
+  struct Batch *batch = arg;
+
+  // every path is handed to mapRead() even when ingestFiles() fails
+  ingestFiles(batch->ingest, batch->paths, batch->npaths, mapRead, batch);
+  CLEARERRLOG
+
+  return NULL;
+}
+
+void mapRead(void *context, size_t index, void *data, size_t nbytes, int error) {
+  struct Batch *batch = context;
+  size_t i = batch->pathJobs[index];
+  struct Job *job = batch->jobs + i;
+
+  job->data = data;
+  job->nbytes = nbytes;
+  job->readError = error;
+
+  if (poolSubmit(batch->pool, runJobs, batch, i, i + 1, 1) == -1) {
+    CLEARERRLOG
+    runJob(batch, job);
+  }
+}
+
+void runJobs(GSPool *pool, void *context, size_t begin, size_t end) {
+  struct Batch *batch = context;
+  size_t i;
+
+  for (i = begin; i < end; i++) {
+    runJob(batch, batch->jobs + i);
+  }
+}
+
+// replaces the line of each indexed map with its list of similar maps
+void queryJobs(GSPool *pool, void *context, size_t begin, size_t end) {
+  struct Batch *batch = context;
+  size_t i;
+
+  for (i = begin; i < end; i++) {
+    struct Job *job = batch->jobs + i;
+    struct Line line;
+
+    if (job->signature == NULL) {
+      continue;
+    }
+
+    bzero(&line, sizeof(line));
+
+    if (listSimilar(batch, job, &line) == -1) {
+      free(line.buf);
+      line.buf = NULL;
+      job->failed = 1;
+      CLEARERRLOG
+    }
+
+    free(job->result);
+    job->result = line.buf;
+  }
+}
+
+// one JSON line per worker
+void printStatistics(GSPool *pool) {
+  struct GSPoolStatistics stats[MAX_POOL_THREADS];
+  int i, n;
+
+  n = poolStatistics(pool, stats, MAX_POOL_THREADS);
+
+  for (i = 0; i < n; i++) {
+    fprintf(stderr, "{\"worker\":%d,\"tasks\":%llu,\"maps\":%llu,\"splits\":%llu,\"steals\":%llu,\"failed_steals\":%llu,\"idle_ms\":%.3f}\n",
+            i, (unsigned long long)stats[i].tasks, (unsigned long long)stats[i].items, (unsigned long long)stats[i].splits,
+            (unsigned long long)stats[i].steals, (unsigned long long)stats[i].failedSteals, stats[i].idleNanos/1e6);
+  }
+}
+
+void runJob(struct Batch *batch, struct Job *job) {
+  struct Line line;
+  struct Map *map;
+  void *data;
+  size_t nbytes;
+  int result, error;
+
+  bzero(&line, sizeof(line));
+  data = job->data;
+  nbytes = job->nbytes;
+  map = NULL;
+  result = -1;
+
+  if (append(&line, "{\"file\":") == -1 || appendString(&line, job->path != NULL ? job->path : "-") == -1) {
+    goto done;
+  }
+
+  if (job->readError != 0) {
+    errno = job->readError;
+    goto done;
+  }
+
+  if (batch->command != kValidateCommand && (map = malloc(sizeof(struct Map))) == NULL) {
+    goto done;
+  }
+
+  switch (batch->command) {
+  case kInfoCommand:
+    result = info(&line, data, nbytes, map);
+    break;
+
+  case kValidateCommand:
+    result = validate(&line, data, nbytes);
+    break;
+
+  case kReencodeCommand:
+    result = reencode(batch, job, &line, data, nbytes, map);
+    break;
+
+  case kPreviewCommand:
+    result = preview(batch, job, &line, data, nbytes, map);
+    break;
+
+  case kHashCommand:
+  case kDedupCommand:
+    result = hash(batch, job, &line, data, nbytes, map);
+    break;
+
+  case kSimilarCommand:
+    result = sign(batch, job, &line, data, nbytes, map);
+    break;
+
+  case kIndexCommand:
+    result = extract(job, &line, data, nbytes, map);
+    break;
+
+  case kReachCommand:
+    result = territory(&line, data, nbytes, map);
+    break;
+
+  case kTravelCommand:
+    result = travel(&line, data, nbytes, map);
+    break;
+
+  case kCoverageCommand:
+    result = coverage(&line, data, nbytes, map);
+    break;
+
+  case kPlaceCommand:
+    result = place(batch, &line, data, nbytes, map);
+    break;
+
+  case kChokesCommand:
+    result = narrows(&line, data, nbytes, map);
+    break;
+
+  case kDistanceCommand:
+    result = clearances(&line, data, nbytes, map);
+    break;
+
+  case kVisibilityCommand:
+    result = sight(&line, data, nbytes, map);
+    break;
+
+  case kSymmetryCommand:
+    result = symmetries(&line, data, nbytes, map);
+    break;
+
+  default:
+    assert(0);
+    break;
+  }
+
+done:
+  error = errno;
+
+  // the line is only lost when memory runs out
+  if (
+    (result == -1 && (append(&line, ",\"error\":") == -1 || appendString(&line, errorString(error)) == -1)) ||
+    append(&line, "}\n") == -1
+  ) {
+    free(line.buf);
+    line.buf = NULL;
+  }
+
+  if (job->path != NULL) {
+    ingestRelease(batch->ingest, data, nbytes);
+  }
+  else {
+    free(data);
+  }
+
+  job->data = NULL;
+  free(map);
+  CLEARERRLOG
+
+  pthread_mutex_lock(&batch->lock);
+  job->result = line.buf;
+  job->failed = result != 0 || line.buf == NULL;
+  job->finished = 1;
+  pthread_cond_broadcast(&batch->finished);
+  pthread_mutex_unlock(&batch->lock);
+}
+
+// reads all of stdin
+ssize_t readStdin(void **data) {
+  size_t size;
+  ssize_t nread;
+  void *buf;
+
+  *data = NULL;
+  size = 0;
+  buf = NULL;
+
+TRY
+  if ((buf = malloc(MAX_MAP_SIZE + 1)) == NULL) LOGFAIL(errno)
+
+  // read one byte past the limit to catch oversized files
+  while (size <= MAX_MAP_SIZE) {
+    if ((nread = read(STDIN_FILENO, buf + size, MAX_MAP_SIZE + 1 - size)) == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+
+      LOGFAIL(errno)
+    }
+
+    if (nread == 0) {
+      break;
+    }
+
+    size += nread;
+  }
+
+  if (size > MAX_MAP_SIZE) LOGFAIL(EFBIG)
+
+  *data = buf;
+  buf = NULL;
+
+CLEANUP
+  free(buf);
+
+ERRHANDLER(size, -1)
+END
+}
+
+// reads all of a file, which may be a pipe
+ssize_t readFile(const char *path, void **data) {
+  size_t size, capacity;
+  ssize_t nread;
+  void *buf;
+  int fd;
+
+  *data = NULL;
+  size = 0;
+  capacity = 0;
+  buf = NULL;
+  fd = -1;
+
+TRY
+  if ((fd = open(path, O_RDONLY)) == -1) LOGFAIL(errno)
+
+  for (;;) {
+    if (size == capacity) {
+      void *p;
+
+      capacity = capacity > 0 ? capacity*2 : 1 << 16;
+      if ((p = realloc(buf, capacity)) == NULL) LOGFAIL(errno)
+      buf = p;
+    }
+
+    if ((nread = read(fd, buf + size, capacity - size)) == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+
+      LOGFAIL(errno)
+    }
+
+    if (nread == 0) {
+      break;
+    }
+
+    size += nread;
+  }
+
+  *data = buf;
+  buf = NULL;
+
+CLEANUP
+  free(buf);
+
+  if (fd != -1) {
+    close(fd);
+  }
+
+ERRHANDLER(size, -1)
+END
+}
+
+// writes to the output directory or to stdout
+int writeFile(struct Batch *batch, struct Job *job, const char *suffix, const void *data, size_t nbytes) {
+  char *path;
+  int fd;
+  ssize_t nwritten;
+
+  path = NULL;
+  fd = -1;
+
+TRY
+  if (batch->outdir == NULL) {
+    fd = STDOUT_FILENO;
+  }
+  else {
+    if (asprintf(&path, "%s/%s%s", batch->outdir, job->name, suffix) == -1) {
+      path = NULL;
+      LOGFAIL(ENOMEM)
+    }
+
+    if (makeParents(path) == -1) LOGFAIL(errno)
+    if ((fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0666)) == -1) LOGFAIL(errno)
+  }
+
+  while (nbytes > 0) {
+    if ((nwritten = write(fd, data, nbytes)) == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+
+      LOGFAIL(errno)
+    }
+
+    data += nwritten;
+    nbytes -= nwritten;
+  }
+
+CLEANUP
+  if (fd != -1 && fd != STDOUT_FILENO && close(fd) == -1 && ERROR == 0) {
+    ERROR = errno;
+  }
+
+  free(path);
+
+ERRHANDLER(0, -1)
+END
+}
+
+// creates the directories leading up to the last component of path
+int makeParents(char *path) {
+  char *slash;
+
+TRY
+  for (slash = strchr(path + 1, '/'); slash != NULL; slash = strchr(slash + 1, '/')) {
+    *slash = '\0';
+
+    if (mkdir(path, 0777) == -1 && errno != EEXIST) {
+      *slash = '/';
+      LOGFAIL(errno)
+    }
+
+    *slash = '/';
+  }
+
+CLEANUP
+ERRHANDLER(0, -1)
+END
+}
+
+// returns the first job before i with the same hash, or i after adding it to the table
+size_t findDuplicate(struct Batch *batch, size_t *table, size_t mask, size_t i) {
+  uint64_t hash = batch->jobs[i].hash;
+  size_t slot;
+
+  for (slot = hash & mask; table[slot] != 0; slot = (slot + 1) & mask) {
+    if (batch->jobs[table[slot] - 1].hash == hash) {
+      return table[slot] - 1;
+    }
+  }
+
+  table[slot] = i + 1;
+
+  return i;
+}
+
+// the worker's line is reopened to name the map it duplicates, first is NULL if it is the first
+int printDuplicate(FILE *report, struct Batch *batch, struct Job *job, struct Job *first) {
+  struct Line line;
+
+  bzero(&line, sizeof(line));
+
+TRY
+  if (append(&line, "%.*s,\"duplicate_of\":", (int)strlen(job->result) - 2, job->result) == -1) LOGFAIL(errno)
+
+  if (first != NULL) {
+    if (appendString(&line, first->path != NULL ? first->path : "-") == -1) LOGFAIL(errno)
+  }
+  else if (append(&line, "null") == -1) LOGFAIL(errno)
+
+  if (append(&line, "}\n") == -1) LOGFAIL(errno)
+  fputs(line.buf, report);
+
+CLEANUP
+  free(line.buf);
+
+ERRHANDLER(0, -1)
+END
+}
+
+int info(struct Line *line, const void *data, size_t nbytes, struct Map *map) {
+  int x, y, land, mines, minx, miny, maxx, maxy;
+
+TRY
+  if (loadMap(data, nbytes, &map->preamble, map->pills, map->bases, map->starts, map->tiles) == -1) LOGFAIL(errno)
+
+  land = 0;
+  mines = 0;
+  minx = WIDTH;
+  miny = WIDTH;
+  maxx = -1;
+  maxy = -1;
+
+  for (y = 0; y < WIDTH; y++) {
+    for (x = 0; x < WIDTH; x++) {
+      GSTile tile = map->tiles[y][x];
+
+      if (tile != defaultTile(x, y)) {
+        minx = MIN(minx, x);
+        miny = MIN(miny, y);
+        maxx = MAX(maxx, x);
+        maxy = MAX(maxy, y);
+      }
+
+      if (tile != kSeaTile && tile != kMinedSeaTile) {
+        land++;
+      }
+
+      // the mine border is not counted
+      if (isMinedTile(map->tiles, x, y) && GSPointInRect(kSeaRect, GSMakePoint(x, y))) {
+        mines++;
+      }
+    }
+  }
+
+  if (append(line, ",\"bytes\":%zu,\"version\":%d,\"pills\":%d,\"bases\":%d,\"starts\":%d,\"land\":%d,\"mines\":%d",
+             nbytes, map->preamble.version, map->preamble.npills, map->preamble.nbases, map->preamble.nstarts, land, mines) == -1)
+    LOGFAIL(errno)
+
+  if (maxx >= 0) {
+    if (append(line, ",\"bounds\":[%d,%d,%d,%d]", minx, miny, maxx - minx + 1, maxy - miny + 1) == -1) LOGFAIL(errno)
+  }
+  else if (append(line, ",\"bounds\":null") == -1) LOGFAIL(errno)
+
+CLEANUP
+ERRHANDLER(0, -1)
+END
+}
+
+int validate(struct Line *line, const void *data, size_t nbytes) {
+  struct BMAP_Diagnostic diagnostic;
+
+  diagnostic.reason = kMapValid;
+
+TRY
+  if (validateMap(data, nbytes, &diagnostic) == 0) {
+    if (append(line, ",\"valid\":true") == -1) LOGFAIL(errno)
+  }
+  else {
+    if (append(line, ",\"valid\":false,\"reason\":") == -1) LOGFAIL(errno)
+    if (appendString(line, mapDiagnosticString(diagnostic.reason)) == -1) LOGFAIL(errno)
+
+    if (append(line, ",\"offset\":%zu,\"object\":%d,\"run\":%d,\"row\":%d",
+               diagnostic.offset, diagnostic.object, diagnostic.run, diagnostic.row) == -1)
+      LOGFAIL(errno)
+  }
+
+CLEANUP
+ERRHANDLER(diagnostic.reason == kMapValid ? 0 : 1, -1)
+END
+}
+
+int reencode(struct Batch *batch, struct Job *job, struct Line *line, const void *data, size_t nbytes, struct Map *map) {
+  void *out;
+  ssize_t size;
+
+  out = NULL;
+
+TRY
+  if (loadMap(data, nbytes, &map->preamble, map->pills, map->bases, map->starts, map->tiles) == -1) LOGFAIL(errno)
+  if ((size = saveMap(&out, &map->preamble, map->pills, map->bases, map->starts, map->tiles)) == -1) LOGFAIL(errno)
+  if (writeFile(batch, job, "", out, size) == -1) LOGFAIL(errno)
+  if (append(line, ",\"bytes\":%zu,\"encoded\":%zd", nbytes, size) == -1) LOGFAIL(errno)
+
+CLEANUP
+  free(out);
+
+ERRHANDLER(0, -1)
+END
+}
+
+int preview(struct Batch *batch, struct Job *job, struct Line *line, const void *data, size_t nbytes, struct Map *map) {
+  void *out;
+  ssize_t size;
+
+  out = NULL;
+
+TRY
+  if (loadMap(data, nbytes, &map->preamble, map->pills, map->bases, map->starts, map->tiles) == -1) LOGFAIL(errno)
+  if ((size = renderPreview(&out, map, batch->scale)) == -1) LOGFAIL(errno)
+  if (writeFile(batch, job, ".ppm", out, size) == -1) LOGFAIL(errno)
+  if (append(line, ",\"width\":%d,\"height\":%d", WIDTH*batch->scale, WIDTH*batch->scale) == -1) LOGFAIL(errno)
+
+CLEANUP
+  free(out);
+
+ERRHANDLER(0, -1)
+END
+}
+
+int hash(struct Batch *batch, struct Job *job, struct Line *line, const void *data, size_t nbytes, struct Map *map) {
+TRY
+  if (loadMap(data, nbytes, &map->preamble, map->pills, map->bases, map->starts, map->tiles) == -1) LOGFAIL(errno)
+
+  if (batch->dihedral) {
+    if (hashMapDihedral(&map->preamble, map->pills, map->bases, map->starts, map->tiles, &job->hash) == -1) LOGFAIL(errno)
+  }
+  else {
+    job->hash = hashMap(&map->preamble, map->pills, map->bases, map->starts, map->tiles);
+  }
+
+  job->hashed = 1;
+  if (append(line, ",\"hash\":\"%016llx\"", (unsigned long long)job->hash) == -1) LOGFAIL(errno)
+
+CLEANUP
+ERRHANDLER(0, -1)
+END
+}
+
+int sign(struct Batch *batch, struct Job *job, struct Line *line, const void *data, size_t nbytes, struct Map *map) {
+  struct GSMapSignature *signature;
+
+  signature = NULL;
+
+TRY
+  if (loadMap(data, nbytes, &map->preamble, map->pills, map->bases, map->starts, map->tiles) == -1) LOGFAIL(errno)
+  if ((signature = malloc(sizeof(struct GSMapSignature))) == NULL) LOGFAIL(errno)
+  mapSignature(&map->preamble, map->pills, map->bases, map->starts, map->tiles, signature);
+  if (similarAdd(batch->similar, job - batch->jobs, signature) == -1) LOGFAIL(errno)
+  job->signature = signature;
+
+CLEANUP
+  switch (ERROR) {
+  case 0:
+    RETURN(0)
+
+  default:
+    free(signature);
+    RETERR(-1)
+  }
+END
+}
+
+int listSimilar(struct Batch *batch, struct Job *job, struct Line *line) {
+  struct GSSimilarMatch matches[MAX_MATCHES];
+  ssize_t nmatches, i;
+
+TRY
+  if ((nmatches = similarQuery(batch->similar, job->signature, batch->threshold, job - batch->jobs, matches, batch->nmatches)) == -1)
+    LOGFAIL(errno)
+
+  if (append(line, "{\"file\":") == -1 || appendString(line, job->path != NULL ? job->path : "-") == -1) LOGFAIL(errno)
+  if (append(line, ",\"similar\":[") == -1) LOGFAIL(errno)
+
+  for (i = 0; i < nmatches; i++) {
+    struct Job *match = batch->jobs + matches[i].id;
+
+    if (append(line, i > 0 ? ",{\"file\":" : "{\"file\":") == -1) LOGFAIL(errno)
+    if (appendString(line, match->path != NULL ? match->path : "-") == -1) LOGFAIL(errno)
+    if (append(line, ",\"similarity\":%.3f}", matches[i].similarity) == -1) LOGFAIL(errno)
+  }
+
+  if (append(line, "]}\n") == -1) LOGFAIL(errno)
+
+CLEANUP
+ERRHANDLER(0, -1)
+END
+}
+
+int extract(struct Job *job, struct Line *line, const void *data, size_t nbytes, struct Map *map) {
+  struct GSMapFeatures *features;
+
+  features = NULL;
+
+TRY
+  if (loadMap(data, nbytes, &map->preamble, map->pills, map->bases, map->starts, map->tiles) == -1) LOGFAIL(errno)
+  if ((features = malloc(sizeof(struct GSMapFeatures))) == NULL) LOGFAIL(errno)
+  if (mapFeatures(&map->preamble, map->pills, map->bases, map->starts, map->tiles, features) == -1) LOGFAIL(errno)
+
+  if (append(line, ",\"pills\":%d,\"bases\":%d,\"starts\":%d,\"land\":%d,\"islands\":%d,\"lakes\":%d,\"bounds\":[%d,%d,%d,%d]",
+             features->pills, features->bases, features->starts, features->land, features->islands, features->lakes,
+             features->left, features->top, features->width, features->height) == -1)
+    LOGFAIL(errno)
+
+  job->features = features;
+
+CLEANUP
+  switch (ERROR) {
+  case 0:
+    RETURN(0)
+
+  default:
+    free(features);
+    RETERR(-1)
+  }
+END
+}
+
+int territory(struct Line *line, const void *data, size_t nbytes, struct Map *map) {
+  struct GSTerritory territory;
+  int s;
+
+TRY
+  if (loadMap(data, nbytes, &map->preamble, map->pills, map->bases, map->starts, map->tiles) == -1) LOGFAIL(errno)
+  if (mapTerritory(&map->preamble, map->pills, map->bases, map->starts, map->tiles, &kDefaultReachCosts, &territory) == -1)
+    LOGFAIL(errno)
+
+  if (appendStarts(line, "pill_starts", territory.pillStarts, MIN(map->preamble.npills, MAX_PILLS)) == -1) LOGFAIL(errno)
+  if (appendStarts(line, "base_starts", territory.baseStarts, MIN(map->preamble.nbases, MAX_BASES)) == -1) LOGFAIL(errno)
+  if (append(line, ",\"starts\":[") == -1) LOGFAIL(errno)
+
+  for (s = 0; s < MIN(map->preamble.nstarts, MAX_STARTS); s++) {
+    if (append(line, "%s{\"pills\":%d,\"bases\":%d,\"nearest_base\":", s > 0 ? "," : "",
+               territory.startPills[s], territory.startBases[s]) == -1)
+      LOGFAIL(errno)
+
+    if (territory.nearestBase[s] == REACH_UNREACHED) {
+      if (append(line, "null}") == -1) LOGFAIL(errno)
+    }
+    else if (append(line, "%u}", territory.nearestBase[s]) == -1) LOGFAIL(errno)
+  }
+
+  if (append(line, "],\"shared\":%d,\"unreached\":%d,\"base_spread\":%u,\"balance\":%.3f",
+             territory.shared, territory.unreached, territory.baseSpread, territory.balance) == -1)
+    LOGFAIL(errno)
+
+CLEANUP
+ERRHANDLER(0, -1)
+END
+}
+
+// rows of costs by start and pill then by base and base, null where
+// there is no way
+int travel(struct Line *line, const void *data, size_t nbytes, struct Map *map) {
+  GSPathGraph *graph;
+  uint32_t cost;
+  int i, j, npills, nbases, nstarts;
+
+  graph = NULL;
+
+TRY
+  if (loadMap(data, nbytes, &map->preamble, map->pills, map->bases, map->starts, map->tiles) == -1) LOGFAIL(errno)
+  if ((graph = pathCreate(map->tiles, &kDefaultReachCosts)) == NULL) LOGFAIL(errno)
+
+  npills = MIN(map->preamble.npills, MAX_PILLS);
+  nbases = MIN(map->preamble.nbases, MAX_BASES);
+  nstarts = MIN(map->preamble.nstarts, MAX_STARTS);
+
+  if (append(line, ",\"start_pills\":[") == -1) LOGFAIL(errno)
+
+  for (i = 0; i < nstarts; i++) {
+    if (append(line, i > 0 ? ",[" : "[") == -1) LOGFAIL(errno)
+
+    for (j = 0; j < npills; j++) {
+      GSPoint from = GSMakePoint(map->starts[i].x, map->starts[i].y), to = GSMakePoint(map->pills[j].x, map->pills[j].y);
+
+      if (pathEstimate(graph, from, to, &cost) == -1) LOGFAIL(errno)
+      if ((cost == REACH_UNREACHED ? append(line, "%snull", j > 0 ? "," : "") : append(line, "%s%u", j > 0 ? "," : "", cost)) == -1)
+        LOGFAIL(errno)
+    }
+
+    if (append(line, "]") == -1) LOGFAIL(errno)
+  }
+
+  if (append(line, "],\"base_bases\":[") == -1) LOGFAIL(errno)
+
+  for (i = 0; i < nbases; i++) {
+    if (append(line, i > 0 ? ",[" : "[") == -1) LOGFAIL(errno)
+
+    for (j = 0; j < nbases; j++) {
+      GSPoint from = GSMakePoint(map->bases[i].x, map->bases[i].y), to = GSMakePoint(map->bases[j].x, map->bases[j].y);
+
+      if (pathEstimate(graph, from, to, &cost) == -1) LOGFAIL(errno)
+      if ((cost == REACH_UNREACHED ? append(line, "%snull", j > 0 ? "," : "") : append(line, "%s%u", j > 0 ? "," : "", cost)) == -1)
+        LOGFAIL(errno)
+    }
+
+    if (append(line, "]") == -1) LOGFAIL(errno)
+  }
+
+  if (append(line, "]") == -1) LOGFAIL(errno)
+
+CLEANUP
+  if (graph != NULL) {
+    pathDestroy(graph);
+  }
+
+ERRHANDLER(0, -1)
+END
+}
+
+// tiles hit by one or more and two or more pills, the most pills hitting
+// a tile and the pills hitting each base
+int coverage(struct Line *line, const void *data, size_t nbytes, struct Map *map) {
+  GSCoverage *field;
+  struct GSCoverageStats stats;
+  int i;
+
+  field = NULL;
+
+TRY
+  if (loadMap(data, nbytes, &map->preamble, map->pills, map->bases, map->starts, map->tiles) == -1) LOGFAIL(errno)
+  if ((field = coverageCreate(map->tiles)) == NULL) LOGFAIL(errno)
+
+  coverageSetPills(field, map->pills, MIN(map->preamble.npills, MAX_PILLS));
+  coverageStats(field, &stats);
+
+  if (append(line, ",\"covered\":%d,\"overlapped\":%d,\"most\":%d,\"base_pills\":[", stats.covered, stats.overlapped, stats.most) == -1)
+    LOGFAIL(errno)
+
+  for (i = 0; i < MIN(map->preamble.nbases, MAX_BASES); i++) {
+    if (append(line, "%s%d", i > 0 ? "," : "", coverageGrid(field)[map->bases[i].y][map->bases[i].x]) == -1) LOGFAIL(errno)
+  }
+
+  if (append(line, "]") == -1) LOGFAIL(errno)
+
+CLEANUP
+  if (field != NULL) {
+    coverageDestroy(field);
+  }
+
+ERRHANDLER(0, -1)
+END
+}
+
+// the proposed pills and the share of the approaches they and the map's
+// own pills cover
+int place(struct Batch *batch, struct Line *line, const void *data, size_t nbytes, struct Map *map) {
+  struct GSPlacementSearch search;
+  struct GSPlacement placement;
+  int i;
+
+TRY
+  if (loadMap(data, nbytes, &map->preamble, map->pills, map->bases, map->starts, map->tiles) == -1) LOGFAIL(errno)
+
+  search = kDefaultPlacementSearch;
+  search.nthreads = batch->placeThreads;
+
+  if (placePills(&map->preamble, map->pills, map->bases, map->starts, map->tiles, &search, &placement) == -1) LOGFAIL(errno)
+  if (append(line, ",\"pills\":[") == -1) LOGFAIL(errno)
+
+  for (i = 0; i < placement.npills; i++) {
+    if (append(line, "%s[%d,%d]", i > 0 ? "," : "", placement.pills[i].x, placement.pills[i].y) == -1) LOGFAIL(errno)
+  }
+
+  if (append(line, "],\"covered\":%.3f,\"covered_before\":%.3f,\"moves\":%llu", placement.covered, placement.coveredBefore,
+             (unsigned long long)placement.moves) == -1)
+    LOGFAIL(errno)
+
+CLEANUP
+ERRHANDLER(0, -1)
+END
+}
+
+// the articulation tiles splitting the most off their islands as x, y and
+// cutoff, most first, and the cut of each island with starts and bases,
+// null if wider than CHOKE_MAX_CUT
+int narrows(struct Line *line, const void *data, size_t nbytes, struct Map *map) {
+  struct GSChokes *chokes;
+  int top[MAX_CHOKES], ntop;
+  int x, y, i, j;
+
+  chokes = NULL;
+
+TRY
+  if (loadMap(data, nbytes, &map->preamble, map->pills, map->bases, map->starts, map->tiles) == -1) LOGFAIL(errno)
+  if ((chokes = malloc(sizeof(struct GSChokes))) == NULL) LOGFAIL(errno)
+  if (mapChokes(&map->preamble, map->bases, map->starts, map->tiles, CHOKE_LAND_CLASSES, chokes) == -1) LOGFAIL(errno)
+
+  // insertion into a short list sorted by cutoff, ties in map order
+  ntop = 0;
+
+  for (y = 0; y < WIDTH; y++) {
+    for (x = 0; x < WIDTH; x++) {
+      int cutoff = chokes->cutoff[y][x];
+
+      if (cutoff == 0 || (ntop == MAX_CHOKES && cutoff <= chokes->cutoff[top[ntop - 1]/WIDTH][top[ntop - 1]%WIDTH])) {
+        continue;
+      }
+
+      for (i = MIN(ntop, MAX_CHOKES - 1); i > 0 && chokes->cutoff[top[i - 1]/WIDTH][top[i - 1]%WIDTH] < cutoff; i--) {
+        top[i] = top[i - 1];
+      }
+
+      top[i] = y*WIDTH + x;
+      ntop = MIN(ntop + 1, MAX_CHOKES);
+    }
+  }
+
+  if (append(line, ",\"articulations\":%d,\"chokes\":[", chokes->narticulations) == -1) LOGFAIL(errno)
+
+  for (i = 0; i < ntop; i++) {
+    if (append(line, "%s[%d,%d,%d]", i > 0 ? "," : "", top[i]%WIDTH, top[i]/WIDTH, chokes->cutoff[top[i]/WIDTH][top[i]%WIDTH]) == -1)
+      LOGFAIL(errno)
+  }
+
+  if (append(line, "],\"cuts\":[") == -1) LOGFAIL(errno)
+
+  for (i = 0; i < chokes->ncuts; i++) {
+    const struct GSChokeCut *cut = chokes->cuts + i;
+
+    if (append(line, "%s{\"starts\":%d,\"bases\":%d,\"tiles\":", i > 0 ? "," : "", cut->starts, cut->bases) == -1) LOGFAIL(errno)
+
+    if (cut->size == CHOKE_WIDE) {
+      if (append(line, "null}") == -1) LOGFAIL(errno)
+      continue;
+    }
+
+    if (append(line, "[") == -1) LOGFAIL(errno)
+
+    for (j = 0; j < cut->size; j++) {
+      if (append(line, "%s[%d,%d]", j > 0 ? "," : "", cut->tiles[j].x, cut->tiles[j].y) == -1) LOGFAIL(errno)
+    }
+
+    if (append(line, "]}") == -1) LOGFAIL(errno)
+  }
+
+  if (append(line, "]") == -1) LOGFAIL(errno)
+
+CLEANUP
+  free(chokes);
+
+ERRHANDLER(0, -1)
+END
+}
+
+// the straight line distance from each base to the nearest tile of each
+// kind, null if the map has none
+int clearances(struct Line *line, const void *data, size_t nbytes, struct Map *map) {
+  static const char *kKeys[] = { "base_sea", "base_walls", "base_mines" };
+  static const unsigned kSources[] = { 1 << kSeaClass, 1 << kWallClass, DISTANCE_MINED };
+  uint32_t (*field)[WIDTH];
+  int i, j;
+
+  field = NULL;
+
+TRY
+  if (loadMap(data, nbytes, &map->preamble, map->pills, map->bases, map->starts, map->tiles) == -1) LOGFAIL(errno)
+  if ((field = malloc(sizeof(uint32_t)*WIDTH*WIDTH)) == NULL) LOGFAIL(errno)
+
+  for (i = 0; i < (int)(sizeof(kKeys)/sizeof(kKeys[0])); i++) {
+    if (distanceTransform(NULL, map->tiles, kSources[i], kEuclideanDistance, field) == -1) LOGFAIL(errno)
+    if (append(line, ",\"%s\":[", kKeys[i]) == -1) LOGFAIL(errno)
+
+    for (j = 0; j < MIN(map->preamble.nbases, MAX_BASES); j++) {
+      uint32_t d = field[map->bases[j].y][map->bases[j].x];
+
+      if (d == DISTANCE_NONE) {
+        if (append(line, "%snull", j > 0 ? "," : "") == -1) LOGFAIL(errno)
+      }
+      else {
+        if (append(line, "%s%.1f", j > 0 ? "," : "", sqrt(d)) == -1) LOGFAIL(errno)
+      }
+    }
+
+    if (append(line, "]") == -1) LOGFAIL(errno)
+  }
+
+CLEANUP
+  free(field);
+
+ERRHANDLER(0, -1)
+END
+}
+
+// the tiles a tank sees on average, the tiles a tank in forest is hidden
+// in and those of them seeing at least half an open view
+int sight(struct Line *line, const void *data, size_t nbytes, struct Map *map) {
+  GSVisibility *visibility;
+  struct GSVisibilityStats stats;
+
+  visibility = NULL;
+
+TRY
+  if (loadMap(data, nbytes, &map->preamble, map->pills, map->bases, map->starts, map->tiles) == -1) LOGFAIL(errno)
+  if ((visibility = visibilityCreate(map->tiles)) == NULL) LOGFAIL(errno)
+
+  visibilityStats(visibility, &stats);
+
+  if (append(line, ",\"viewers\":%d,\"mean_sees\":%.1f,\"concealed\":%d,\"snipes\":%d",
+             stats.viewers, stats.meanSees, stats.concealed, stats.snipes) == -1)
+    LOGFAIL(errno)
+
+CLEANUP
+  if (visibility != NULL) {
+    visibilityDestroy(visibility);
+  }
+
+ERRHANDLER(0, -1)
+END
+}
+
+// the best symmetry with the share of tiles and objects matching and the
+// first tiles not matching, then the tile share of every symmetry
+int symmetries(struct Line *line, const void *data, size_t nbytes, struct Map *map) {
+  struct GSSymmetry symmetry;
+  const struct GSSymmetryScore *best;
+  GSPoint mismatches[MAX_MISMATCHES];
+  int kind, n, i;
+
+TRY
+  if (loadMap(data, nbytes, &map->preamble, map->pills, map->bases, map->starts, map->tiles) == -1) LOGFAIL(errno)
+  if (mapSymmetry(&map->preamble, map->pills, map->bases, map->starts, map->tiles, &symmetry) == -1) LOGFAIL(errno)
+
+  best = symmetry.scores + symmetry.best;
+  n = symmetryMismatches(&symmetry, symmetry.best, map->tiles, mismatches, MAX_MISMATCHES);
+
+  if (append(line, ",\"bounds\":[%d,%d,%d,%d],\"symmetry\":\"%s\",\"tiles\":%.1f,\"objects\":%.1f,\"mismatched\":%d,\"mismatches\":[",
+             GSMinX(symmetry.bounds), GSMinY(symmetry.bounds), GSWidth(symmetry.bounds), GSHeight(symmetry.bounds),
+             kSymmetryNames[symmetry.best], 100.0*symmetryTileMatch(best), 100.0*symmetryObjectMatch(best), n) == -1)
+    LOGFAIL(errno)
+
+  for (i = 0; i < MIN(n, MAX_MISMATCHES); i++) {
+    if (append(line, "%s[%d,%d]", i > 0 ? "," : "", mismatches[i].x, mismatches[i].y) == -1) LOGFAIL(errno)
+  }
+
+  if (append(line, "],\"scores\":{") == -1) LOGFAIL(errno)
+
+  for (kind = kFlipHorizontalSymmetry; kind < kSymmetryCount; kind++) {
+    if (append(line, "%s\"%s\":%.1f", kind > kFlipHorizontalSymmetry ? "," : "", kSymmetryNames[kind],
+               100.0*symmetryTileMatch(symmetry.scores + kind)) == -1)
+      LOGFAIL(errno)
+  }
+
+  if (append(line, "}") == -1) LOGFAIL(errno)
+
+CLEANUP
+ERRHANDLER(0, -1)
+END
+}
+
+// the closest start of each object, null if none and "shared" if tied
+int appendStarts(struct Line *line, const char *key, const uint8_t starts[], int n) {
+  int i;
+
+TRY
+  if (append(line, ",\"%s\":[", key) == -1) LOGFAIL(errno)
+
+  for (i = 0; i < n; i++) {
+    const char *separator = i > 0 ? "," : "";
+
+    switch (starts[i]) {
+    case TERRITORY_NONE:
+      if (append(line, "%snull", separator) == -1) LOGFAIL(errno)
+      break;
+
+    case TERRITORY_SHARED:
+      if (append(line, "%s\"shared\"", separator) == -1) LOGFAIL(errno)
+      break;
+
+    default:
+      if (append(line, "%s%d", separator, starts[i]) == -1) LOGFAIL(errno)
+      break;
+    }
+  }
+
+  if (append(line, "]") == -1) LOGFAIL(errno)
+
+CLEANUP
+ERRHANDLER(0, -1)
+END
+}
+
+// selects the rows of a feature index matching every comparison and
+// prints their names with the compared columns
+int queryIndex(int argc, char *const argv[]) {
+  static const char *kOperators[] = { "<=", ">=", "<", ">", "==", "=" };
+  GSFeatureTable *table;
+  struct Line line;
+  uint8_t *selection;
+  int *columns;
+  void *data;
+  ssize_t nbytes;
+  size_t row;
+  int i, k;
+
+  if (argc < 1) {
+    usage();
+    return 2;
+  }
+
+  table = NULL;
+  selection = NULL;
+  bzero(&line, sizeof(line));
+
+  if (
+    (columns = malloc((argc - 1)*sizeof(int) + 1)) == NULL ||
+    (nbytes = readFile(argv[0], &data)) == -1 ||
+    (table = loadFeatureTable(data, nbytes)) == NULL ||
+    (selection = malloc(featureTableCount(table) + 1)) == NULL
+  ) {
+    fprintf(stderr, "bmaptool: %s: %s\n", argv[0], errorString(errno));
+    return 1;
+  }
+
+  free(data);
+  featureSelectAll(table, selection);
+
+  for (i = 1; i < argc; i++) {
+    char name[32];
+    const char *op;
+    char *end;
+    unsigned long value;
+    uint32_t min, max;
+
+    // the first operator found, longest first so <= is not read as <
+    for (op = NULL, k = 0; k < (int)(sizeof(kOperators)/sizeof(kOperators[0])); k++) {
+      if ((op = strstr(argv[i], kOperators[k])) != NULL) {
+        break;
+      }
+    }
+
+    if (op == NULL || op == argv[i] || (size_t)(op - argv[i]) >= sizeof(name)) {
+      fprintf(stderr, "bmaptool: bad comparison %s\n", argv[i]);
+      return 2;
+    }
+
+    bcopy(argv[i], name, op - argv[i]);
+    name[op - argv[i]] = '\0';
+    errno = 0;
+    value = strtoul(op + strlen(kOperators[k]), &end, 10);
+
+    if ((columns[i - 1] = featureColumnIndex(name)) == -1 || *end != '\0' || end == op + strlen(kOperators[k]) || errno != 0 || value > UINT32_MAX) {
+      fprintf(stderr, "bmaptool: bad comparison %s\n", argv[i]);
+      return 2;
+    }
+
+    min = 0;
+    max = UINT32_MAX;
+
+    switch (kOperators[k][0]) {
+    case '<':
+      if (kOperators[k][1] == '=') {
+        max = value;
+      }
+      else if (value == 0) {
+        min = 1;
+        max = 0;
+      }
+      else {
+        max = value - 1;
+      }
+      break;
+
+    case '>':
+      if (kOperators[k][1] == '=') {
+        min = value;
+      }
+      else if (value == UINT32_MAX) {
+        min = 1;
+        max = 0;
+      }
+      else {
+        min = value + 1;
+      }
+      break;
+
+    default:
+      min = value;
+      max = value;
+      break;
+    }
+
+    featureSelectRange(table, columns[i - 1], min, max, selection);
+  }
+
+  for (row = 0; row < featureTableCount(table); row++) {
+    if (selection[row]) {
+      line.len = 0;
+
+      if (append(&line, "{\"file\":") == -1 || appendString(&line, featureTableName(table, row)) == -1) {
+        perror("bmaptool");
+        return 1;
+      }
+
+      for (i = 1; i < argc; i++) {
+        if (append(&line, ",\"%s\":%u", featureColumnName(columns[i - 1]), featureValue(table, columns[i - 1], row)) == -1) {
+          perror("bmaptool");
+          return 1;
+        }
+      }
+
+      printf("%s}\n", line.buf);
+    }
+  }
+
+  fprintf(stderr, "{\"maps\":%zu,\"selected\":%zu}\n", featureTableCount(table), featureSelectedCount(table, selection));
+
+  free(line.buf);
+  free(selection);
+  free(columns);
+  featureTableDestroy(table);
+
+  if (fflush(stdout) == EOF) {
+    perror("bmaptool");
+    return 1;
+  }
+
+  return 0;
+}
+
+// one colour per tile, mines are not shown
+static const uint8_t kTileColours[][3] = {
+  { 0x80, 0x60, 0x40 },  // wall
+  { 0x40, 0x80, 0xc0 },  // river
+  { 0x50, 0x70, 0x40 },  // swamp
+  { 0x70, 0x60, 0x50 },  // crater
+  { 0x30, 0x30, 0x30 },  // road
+  { 0x20, 0x60, 0x20 },  // forest
+  { 0x90, 0x80, 0x70 },  // rubble
+  { 0x50, 0xa0, 0x40 },  // grass
+  { 0xa0, 0x80, 0x60 },  // damaged wall
+  { 0xa0, 0x80, 0x40 },  // boat
+  { 0x50, 0x70, 0x40 },  // mined swamp
+  { 0x70, 0x60, 0x50 },  // mined crater
+  { 0x30, 0x30, 0x30 },  // mined road
+  { 0x20, 0x60, 0x20 },  // mined forest
+  { 0x90, 0x80, 0x70 },  // mined rubble
+  { 0x50, 0xa0, 0x40 },  // mined grass
+  { 0x10, 0x30, 0x80 },  // sea
+  { 0x10, 0x30, 0x80 },  // mined sea
+};
+
+static const uint8_t kPillColour[3] = { 0xff, 0x20, 0x20 };
+static const uint8_t kBaseColour[3] = { 0xff, 0xe0, 0x20 };
+static const uint8_t kStartColour[3] = { 0xff, 0xff, 0xff };
+
+// binary PPM with scale x scale pixels per tile
+ssize_t renderPreview(void **data, const struct Map *map, int scale) {
+  const uint8_t *colours[WIDTH];
+  char header[32];
+  int headerLen, width, x, y, i;
+  size_t size;
+  uint8_t *buf, *row;
+
+  *data = NULL;
+  size = 0;
+
+TRY
+  width = WIDTH*scale;
+  headerLen = snprintf(header, sizeof(header), "P6\n%d %d\n255\n", width, width);
+  size = headerLen + (size_t)width*width*3;
+
+  if ((buf = malloc(size)) == NULL) LOGFAIL(errno)
+  *data = buf;
+
+  bcopy(header, buf, headerLen);
+  row = buf + headerLen;
+
+  for (y = 0; y < WIDTH; y++) {
+    for (x = 0; x < WIDTH; x++) {
+      colours[x] = kTileColours[map->tiles[y][x] < kTokenTile ? map->tiles[y][x] : kSeaTile];
+    }
+
+    for (i = 0; i < map->preamble.npills; i++) {
+      if (map->pills[i].y == y) {
+        colours[map->pills[i].x] = kPillColour;
+      }
+    }
+
+    for (i = 0; i < map->preamble.nbases; i++) {
+      if (map->bases[i].y == y) {
+        colours[map->bases[i].x] = kBaseColour;
+      }
+    }
+
+    for (i = 0; i < map->preamble.nstarts; i++) {
+      if (map->starts[i].y == y) {
+        colours[map->starts[i].x] = kStartColour;
+      }
+    }
+
+    // draw the first pixel row of the tile row and copy it down
+    for (x = 0; x < width; x++) {
+      bcopy(colours[x/scale], row + x*3, 3);
+    }
+
+    for (i = 1; i < scale; i++) {
+      bcopy(row, row + i*width*3, width*3);
+    }
+
+    row += scale*width*3;
+  }
+
+CLEANUP
+ERRHANDLER(size, -1)
+END
+}
+
+// strerror() does not know the errors of errchk.h
+const char *errorString(int error) {
+  switch (error) {
+  case ECORFILE:
+    return "corrupt map file";
+
+  case EINCMPAT:
+    return "incompatible map version";
+
+  default:
+    return strerror(error);
+  }
+}
+
+int append(struct Line *line, const char *format, ...) {
+  va_list ap;
+  int len;
+
+TRY
+  for (;;) {
+    va_start(ap, format);
+    len = vsnprintf(line->buf + line->len, line->capacity - line->len, format, ap);
+    va_end(ap);
+
+    if (len < 0) LOGFAIL(errno)
+
+    if (line->len + len < line->capacity) {
+      line->len += len;
+      break;
+    }
+    else {
+      size_t capacity = MAX(line->capacity*2, line->len + len + 1);
+      char *buf;
+
+      if ((buf = realloc(line->buf, capacity)) == NULL) LOGFAIL(errno)
+      line->buf = buf;
+      line->capacity = capacity;
+    }
+  }
+
+CLEANUP
+ERRHANDLER(0, -1)
+END
+}
+
+// appends a quoted and escaped JSON string
+int appendString(struct Line *line, const char *string) {
+  const unsigned char *c;
+
+TRY
+  if (append(line, "\"") == -1) LOGFAIL(errno)
+
+  for (c = (const unsigned char *)string; *c != '\0'; c++) {
+    if (*c == '"' || *c == '\\') {
+      if (append(line, "\\%c", *c) == -1) LOGFAIL(errno)
+    }
+    else if (*c < 0x20) {
+      if (append(line, "\\u%04x", *c) == -1) LOGFAIL(errno)
+    }
+    else if (append(line, "%c", *c) == -1) LOGFAIL(errno)
+  }
+
+  if (append(line, "\"") == -1) LOGFAIL(errno)
+
+CLEANUP
+ERRHANDLER(0, -1)
+END
+}
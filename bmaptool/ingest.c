@@ -0,0 +1,759 @@
+//
+//  ingest.c
+//  XBolo Map Editor
+//
+//  Created by Robert Chrzanowski on 10/19/26.
+//  Copyright 2026 Robert Chrzanowski. All rights reserved.
+//
+
+#include "ingest.h"
+#include "pool.h"
+#include "errchk.h"
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#define URING
+#endif
+
+
+#define READER_THREADS  (16)   // blocking readers used without io_uring
+#define RING_ENTRIES    (256)
+#define RING_SLOTS      (64)   // files open at once, each with at most two requests in flight
+
+struct GSIngest {
+  size_t budget;
+  size_t maxFileSize;
+  int uring;  // io_uring and every request it needs are available
+
+  pthread_mutex_t lock;
+  pthread_cond_t released;
+  size_t reserved;  // bytes of buffers being read or handed out
+} ;
+
+// the files of one ingestFiles() call left to the blocking readers
+struct Readers {
+  GSIngest *ingest;
+  char *const *paths;
+  const size_t *indexes;  // NULL reads every path
+  GSIngestHandler handler;
+  void *context;
+} ;
+
+static int reserveBytes(GSIngest *ingest, size_t nbytes, int wait);
+static void unreserveBytes(GSIngest *ingest, size_t nbytes);
+static void readFiles(GSPool *pool, void *context, size_t begin, size_t end);
+static int readWholeFile(GSIngest *ingest, const char *path, void **data, size_t *nbytes);
+
+#if defined(URING)
+
+struct Ring {
+  int fd;
+  unsigned entries;
+
+  void *sqMap;
+  size_t sqMapSize;
+  void *cqMap;
+  size_t cqMapSize;
+  struct io_uring_sqe *sqes;
+  size_t sqesSize;
+
+  unsigned *sqHead;
+  unsigned *sqTail;
+  unsigned *sqMask;
+  unsigned *sqArray;
+  unsigned *cqHead;
+  unsigned *cqTail;
+  unsigned *cqMask;
+  struct io_uring_cqe *cqes;
+
+  unsigned sqeTail;   // sqes prepared, published to sqTail on enter
+  unsigned toSubmit;
+} ;
+
+// a file moving through open and stat, waiting for budget, read and close
+struct Slot {
+  size_t index;  // SIZE_MAX when the slot is free
+  int fd;
+  int error;
+  int ops;       // requests in flight
+  int waiting;   // opened and sized, waiting for budget
+  struct statx stx;
+  void *buf;
+  size_t size;
+  size_t got;
+} ;
+
+enum {
+  kOpenOp,
+  kStatOp,
+  kReadOp,
+  kCloseOp
+} ;
+
+#define USER_DATA(slot, op)  ((((uint64_t)(slot)) << 8) | (op))
+#define USER_SLOT(data)      ((size_t)((data) >> 8))
+#define USER_OP(data)        ((int)((data) & 0xff))
+
+static int ringSupported(void);
+static int ringSetup(struct Ring *ring, unsigned entries);
+static void ringDestroy(struct Ring *ring);
+static struct io_uring_sqe *ringSqe(struct Ring *ring);
+static int ringEnter(struct Ring *ring, unsigned minComplete);
+static int ingestUring(GSIngest *ingest, char *const paths[], size_t npaths, GSIngestHandler handler, void *context, size_t **left, size_t *nleft);
+
+#endif
+
+GSIngest *ingestCreate(size_t budget, size_t maxFileSize) {
+  GSIngest *ingest;
+
+TRY
+  if ((ingest = (GSIngest *)malloc(sizeof(GSIngest))) == NULL) LOGFAIL(errno)
+
+  ingest->budget = budget;
+  ingest->maxFileSize = maxFileSize;
+  ingest->reserved = 0;
+  pthread_mutex_init(&ingest->lock, NULL);
+  pthread_cond_init(&ingest->released, NULL);
+
+#if defined(URING)
+  ingest->uring = ringSupported();
+#else
+  ingest->uring = 0;
+#endif
+
+CLEANUP
+ERRHANDLER(ingest, NULL)
+END
+}
+
+void ingestDestroy(GSIngest *ingest) {
+  if (ingest == NULL) {
+    return;
+  }
+
+  pthread_cond_destroy(&ingest->released);
+  pthread_mutex_destroy(&ingest->lock);
+  free(ingest);
+}
+
+const char *ingestMethod(const GSIngest *ingest) {
+  return ingest->uring ? "io_uring" : "threads";
+}
+
+int ingestFiles(GSIngest *ingest, char *const paths[], size_t npaths, GSIngestHandler handler, void *context) {
+  struct Readers readers;
+  GSPool *pool;
+  size_t *left, nleft, i;
+
+  left = NULL;
+  nleft = npaths;
+
+TRY
+#if defined(URING)
+  if (ingest->uring) {
+    if (ingestUring(ingest, paths, npaths, handler, context, &left, &nleft) == 0) SUCCESS
+
+    // what the ring did not deliver is read the slow way
+    CLEARERRLOG
+  }
+#endif
+
+  readers.ingest = ingest;
+  readers.paths = paths;
+  readers.indexes = left;
+  readers.handler = handler;
+  readers.context = context;
+
+  if ((pool = poolCreate(READER_THREADS)) != NULL && poolSubmit(pool, readFiles, &readers, 0, nleft, 1) == 0) {
+    poolDestroy(pool);
+  }
+  else {
+    poolDestroy(pool);
+    CLEARERRLOG
+
+    for (i = 0; i < nleft; i++) {
+      readFiles(NULL, &readers, i, i + 1);
+    }
+  }
+
+CLEANUP
+  free(left);
+
+ERRHANDLER(0, -1)
+END
+}
+
+void ingestRelease(GSIngest *ingest, void *data, size_t nbytes) {
+  free(data);
+  unreserveBytes(ingest, nbytes);
+}
+
+// a single buffer larger than the budget is let through when nothing else is reserved
+int reserveBytes(GSIngest *ingest, size_t nbytes, int wait) {
+  int reserved;
+
+  pthread_mutex_lock(&ingest->lock);
+
+  while (ingest->reserved > 0 && ingest->reserved + nbytes > ingest->budget && wait) {
+    pthread_cond_wait(&ingest->released, &ingest->lock);
+  }
+
+  if ((reserved = ingest->reserved == 0 || ingest->reserved + nbytes <= ingest->budget)) {
+    ingest->reserved += nbytes;
+  }
+
+  pthread_mutex_unlock(&ingest->lock);
+
+  return reserved;
+}
+
+void unreserveBytes(GSIngest *ingest, size_t nbytes) {
+  if (nbytes == 0) {
+    return;
+  }
+
+  pthread_mutex_lock(&ingest->lock);
+  assert(ingest->reserved >= nbytes);
+  ingest->reserved -= nbytes;
+  pthread_cond_broadcast(&ingest->released);
+  pthread_mutex_unlock(&ingest->lock);
+}
+
+void readFiles(GSPool *pool, void *context, size_t begin, size_t end) {
+  struct Readers *readers = context;
+  size_t i;
+
+  for (i = begin; i < end; i++) {
+    size_t index = readers->indexes != NULL ? readers->indexes[i] : i;
+    void *data;
+    size_t nbytes;
+
+    if (readWholeFile(readers->ingest, readers->paths[index], &data, &nbytes) == -1) {
+      int error = errno;
+
+      CLEARERRLOG
+      readers->handler(readers->context, index, NULL, 0, error);
+    }
+    else {
+      readers->handler(readers->context, index, data, nbytes, 0);
+    }
+  }
+}
+
+// open, fstat, read and close, the file is read up to its size at the time of the fstat
+int readWholeFile(GSIngest *ingest, const char *path, void **data, size_t *nbytes) {
+  struct stat st;
+  ssize_t nread;
+  size_t size, got;
+  void *buf;
+  int fd, reserved;
+
+  *data = NULL;
+  *nbytes = 0;
+  buf = NULL;
+  fd = -1;
+  size = 0;
+  got = 0;
+  reserved = 0;
+
+TRY
+  if ((fd = open(path, O_RDONLY | O_CLOEXEC)) == -1) LOGFAIL(errno)
+  if (fstat(fd, &st) == -1) LOGFAIL(errno)
+  if (st.st_size > ingest->maxFileSize) LOGFAIL(EFBIG)
+
+  size = st.st_size;
+  reserved = reserveBytes(ingest, size, 1);
+
+  if (size > 0 && (buf = malloc(size)) == NULL) LOGFAIL(errno)
+
+  while (got < size) {
+    if ((nread = read(fd, buf + got, size - got)) == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+
+      LOGFAIL(errno)
+    }
+
+    if (nread == 0) {  // truncated since the fstat
+      break;
+    }
+
+    got += nread;
+  }
+
+  unreserveBytes(ingest, size - got);
+  *data = buf;
+  *nbytes = got;
+  buf = NULL;
+  reserved = 0;
+
+CLEANUP
+  if (fd != -1) {
+    close(fd);
+  }
+
+  if (buf != NULL) {
+    free(buf);
+  }
+
+  if (reserved) {
+    unreserveBytes(ingest, size);
+  }
+
+ERRHANDLER(0, -1)
+END
+}
+
+#if defined(URING)
+
+// the kernel has io_uring and the requests used here
+int ringSupported(void) {
+  struct Ring ring;
+  struct io_uring_probe *probe;
+  size_t probeSize;
+  int supported;
+
+  probeSize = sizeof(struct io_uring_probe) + 256*sizeof(struct io_uring_probe_op);
+  supported = 0;
+
+  if (ringSetup(&ring, 4) == -1) {
+    CLEARERRLOG
+    return 0;
+  }
+
+  if ((probe = calloc(1, probeSize)) != NULL) {
+    if (syscall(__NR_io_uring_register, ring.fd, IORING_REGISTER_PROBE, probe, 256) == 0) {
+      supported =
+        probe->last_op >= IORING_OP_STATX &&
+        (probe->ops[IORING_OP_OPENAT].flags & IO_URING_OP_SUPPORTED) &&
+        (probe->ops[IORING_OP_STATX].flags & IO_URING_OP_SUPPORTED) &&
+        (probe->ops[IORING_OP_READ].flags & IO_URING_OP_SUPPORTED) &&
+        (probe->ops[IORING_OP_CLOSE].flags & IO_URING_OP_SUPPORTED);
+    }
+
+    free(probe);
+  }
+
+  ringDestroy(&ring);
+
+  return supported;
+}
+
+int ringSetup(struct Ring *ring, unsigned entries) {
+  struct io_uring_params params;
+
+  bzero(ring, sizeof(struct Ring));
+  bzero(&params, sizeof(params));
+  ring->fd = -1;
+  ring->sqMap = MAP_FAILED;
+  ring->cqMap = MAP_FAILED;
+  ring->sqes = MAP_FAILED;
+
+TRY
+  if ((ring->fd = (int)syscall(__NR_io_uring_setup, entries, &params)) == -1) LOGFAIL(errno)
+
+  ring->entries = params.sq_entries;
+  ring->sqMapSize = params.sq_off.array + params.sq_entries*sizeof(unsigned);
+  ring->cqMapSize = params.cq_off.cqes + params.cq_entries*sizeof(struct io_uring_cqe);
+  ring->sqesSize = params.sq_entries*sizeof(struct io_uring_sqe);
+
+  // both rings share one mapping on newer kernels
+  if (params.features & IORING_FEAT_SINGLE_MMAP) {
+    ring->sqMapSize = ring->cqMapSize = ring->sqMapSize > ring->cqMapSize ? ring->sqMapSize : ring->cqMapSize;
+  }
+
+  if ((ring->sqMap = mmap(NULL, ring->sqMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING)) == MAP_FAILED) LOGFAIL(errno)
+
+  if (params.features & IORING_FEAT_SINGLE_MMAP) {
+    ring->cqMap = ring->sqMap;
+  }
+  else if ((ring->cqMap = mmap(NULL, ring->cqMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_CQ_RING)) == MAP_FAILED) LOGFAIL(errno)
+
+  if ((ring->sqes = mmap(NULL, ring->sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES)) == MAP_FAILED) LOGFAIL(errno)
+
+  ring->sqHead = ring->sqMap + params.sq_off.head;
+  ring->sqTail = ring->sqMap + params.sq_off.tail;
+  ring->sqMask = ring->sqMap + params.sq_off.ring_mask;
+  ring->sqArray = ring->sqMap + params.sq_off.array;
+  ring->cqHead = ring->cqMap + params.cq_off.head;
+  ring->cqTail = ring->cqMap + params.cq_off.tail;
+  ring->cqMask = ring->cqMap + params.cq_off.ring_mask;
+  ring->cqes = ring->cqMap + params.cq_off.cqes;
+  ring->sqeTail = *ring->sqTail;
+
+CLEANUP
+  if (ERROR != 0) {
+    ringDestroy(ring);
+  }
+
+ERRHANDLER(0, -1)
+END
+}
+
+void ringDestroy(struct Ring *ring) {
+  if (ring->sqes != MAP_FAILED) {
+    munmap(ring->sqes, ring->sqesSize);
+  }
+
+  if (ring->cqMap != MAP_FAILED && ring->cqMap != ring->sqMap) {
+    munmap(ring->cqMap, ring->cqMapSize);
+  }
+
+  if (ring->sqMap != MAP_FAILED) {
+    munmap(ring->sqMap, ring->sqMapSize);
+  }
+
+  if (ring->fd != -1) {
+    close(ring->fd);
+  }
+
+  ring->sqes = MAP_FAILED;
+  ring->cqMap = MAP_FAILED;
+  ring->sqMap = MAP_FAILED;
+  ring->fd = -1;
+}
+
+// returns a zeroed sqe, submitting what is queued if the ring is full
+struct io_uring_sqe *ringSqe(struct Ring *ring) {
+  struct io_uring_sqe *sqe;
+  unsigned index;
+
+  if (ring->sqeTail - __atomic_load_n(ring->sqHead, __ATOMIC_ACQUIRE) == ring->entries) {
+    if (ringEnter(ring, 0) == -1 || ring->sqeTail - __atomic_load_n(ring->sqHead, __ATOMIC_ACQUIRE) == ring->entries) {
+      return NULL;
+    }
+  }
+
+  index = ring->sqeTail & *ring->sqMask;
+  sqe = ring->sqes + index;
+  bzero(sqe, sizeof(struct io_uring_sqe));
+  ring->sqArray[index] = index;
+  ring->sqeTail++;
+  ring->toSubmit++;
+
+  return sqe;
+}
+
+// submits prepared sqes and waits for minComplete completions
+int ringEnter(struct Ring *ring, unsigned minComplete) {
+  long submitted;
+
+TRY
+  __atomic_store_n(ring->sqTail, ring->sqeTail, __ATOMIC_RELEASE);
+
+  if ((submitted = syscall(__NR_io_uring_enter, ring->fd, ring->toSubmit, minComplete, minComplete > 0 ? IORING_ENTER_GETEVENTS : 0, NULL, 0)) == -1) {
+    // try again on the next pass
+    if (errno == EINTR || errno == EAGAIN || errno == EBUSY) {
+      SUCCESS
+    }
+
+    LOGFAIL(errno)
+  }
+
+  ring->toSubmit -= submitted;
+
+CLEANUP
+ERRHANDLER(0, -1)
+END
+}
+
+// opens and stats up to RING_SLOTS files at a time, then reads and closes
+// each in one batch of requests per pass, sleeping in the kernel until some
+// complete.  on failure *left holds the indexes that were not delivered.
+int ingestUring(GSIngest *ingest, char *const paths[], size_t npaths, GSIngestHandler handler, void *context, size_t **left, size_t *nleft) {
+  struct Ring ring;
+  struct Slot slots[RING_SLOTS];
+  size_t next, i;
+  unsigned inflight;
+  int nfree, freeSlots[RING_SLOTS];
+
+  next = 0;
+  inflight = 0;
+  nfree = 0;
+  *left = NULL;
+  *nleft = npaths;
+
+  for (i = 0; i < RING_SLOTS; i++) {
+    slots[i].index = SIZE_MAX;
+    slots[i].buf = NULL;
+    freeSlots[nfree++] = RING_SLOTS - 1 - i;
+  }
+
+TRY
+  if (ringSetup(&ring, RING_ENTRIES) == -1) LOGFAIL(errno)
+
+  for (;;) {
+    unsigned head, tail;
+    int waiting;
+
+    // open and stat new files
+    while (next < npaths && nfree > 0 && inflight + 2 <= ring.entries) {
+      struct Slot *slot = slots + freeSlots[--nfree];
+      struct io_uring_sqe *openSqe, *statSqe;
+
+      slot->index = next++;
+      slot->fd = -1;
+      slot->error = 0;
+      slot->waiting = 0;
+      slot->buf = NULL;
+      slot->size = 0;
+      slot->got = 0;
+
+      if ((openSqe = ringSqe(&ring)) == NULL) LOGFAIL(errno)
+
+      openSqe->opcode = IORING_OP_OPENAT;
+      openSqe->fd = AT_FDCWD;
+      openSqe->addr = (uintptr_t)paths[slot->index];
+      openSqe->open_flags = O_RDONLY | O_CLOEXEC;
+      openSqe->user_data = USER_DATA(slot - slots, kOpenOp);
+
+      if ((statSqe = ringSqe(&ring)) == NULL) LOGFAIL(errno)
+
+      statSqe->opcode = IORING_OP_STATX;
+      statSqe->fd = AT_FDCWD;
+      statSqe->addr = (uintptr_t)paths[slot->index];
+      statSqe->len = STATX_SIZE;
+      statSqe->off = (uintptr_t)&slot->stx;
+      statSqe->user_data = USER_DATA(slot - slots, kStatOp);
+
+      slot->ops = 2;
+      inflight += 2;
+    }
+
+    // start reads as the budget allows, only block on it when nothing else can finish
+    waiting = 0;
+
+    for (i = 0; i < RING_SLOTS && inflight < ring.entries; i++) {
+      struct Slot *slot = slots + i;
+      struct io_uring_sqe *readSqe;
+
+      if (slot->index == SIZE_MAX || !slot->waiting) {
+        continue;
+      }
+
+      if (!reserveBytes(ingest, slot->size, inflight == 0)) {
+        waiting = 1;
+        continue;
+      }
+
+      slot->waiting = 0;
+
+      if ((slot->buf = malloc(slot->size)) == NULL) {
+        unreserveBytes(ingest, slot->size);
+        slot->error = errno;
+        slot->waiting = 1;  // closed below with the error
+        continue;
+      }
+
+      if ((readSqe = ringSqe(&ring)) == NULL) LOGFAIL(errno)
+
+      readSqe->opcode = IORING_OP_READ;
+      readSqe->fd = slot->fd;
+      readSqe->addr = (uintptr_t)slot->buf;
+      readSqe->len = slot->size;
+      readSqe->off = 0;
+      readSqe->user_data = USER_DATA(i, kReadOp);
+
+      slot->ops = 1;
+      inflight++;
+    }
+
+    // slots that could not get a buffer, and finished slots, are closed and delivered
+    for (i = 0; i < RING_SLOTS; i++) {
+      struct Slot *slot = slots + i;
+
+      if (slot->index == SIZE_MAX || slot->ops > 0 || (slot->waiting && slot->error == 0)) {
+        continue;
+      }
+
+      if (slot->fd != -1) {
+        struct io_uring_sqe *closeSqe;
+
+        if ((closeSqe = ringSqe(&ring)) == NULL) LOGFAIL(errno)
+
+        closeSqe->opcode = IORING_OP_CLOSE;
+        closeSqe->fd = slot->fd;
+        closeSqe->user_data = USER_DATA(0, kCloseOp);
+        inflight++;
+        slot->fd = -1;
+      }
+
+      if (slot->error != 0) {
+        if (slot->buf != NULL) {
+          free(slot->buf);
+          unreserveBytes(ingest, slot->size);
+        }
+
+        handler(context, slot->index, NULL, 0, slot->error);
+      }
+      else {
+        unreserveBytes(ingest, slot->size - slot->got);
+        handler(context, slot->index, slot->got > 0 ? slot->buf : NULL, slot->got, 0);
+
+        if (slot->got == 0 && slot->buf != NULL) {
+          free(slot->buf);
+        }
+      }
+
+      slot->buf = NULL;
+      slot->index = SIZE_MAX;
+      freeSlots[nfree++] = i;
+    }
+
+    if (inflight == 0 && ring.toSubmit == 0 && next == npaths && nfree == RING_SLOTS) {
+      break;
+    }
+
+    if (inflight == 0 && ring.toSubmit == 0 && !waiting) {
+      continue;
+    }
+
+    if (ringEnter(&ring, inflight > 0 ? 1 : 0) == -1) LOGFAIL(errno)
+
+    // reap
+    head = *ring.cqHead;
+    tail = __atomic_load_n(ring.cqTail, __ATOMIC_ACQUIRE);
+
+    for (; head != tail; head++) {
+      struct io_uring_cqe *cqe = ring.cqes + (head & *ring.cqMask);
+      struct Slot *slot = slots + USER_SLOT(cqe->user_data);
+      int res = cqe->res;
+
+      inflight--;
+
+      switch (USER_OP(cqe->user_data)) {
+      case kOpenOp:
+        slot->ops--;
+
+        if (res < 0) {
+          slot->error = slot->error != 0 ? slot->error : -res;
+        }
+        else {
+          slot->fd = res;
+        }
+
+        break;
+
+      case kStatOp:
+        slot->ops--;
+
+        if (res < 0) {
+          slot->error = slot->error != 0 ? slot->error : -res;
+        }
+        else if (slot->stx.stx_size > ingest->maxFileSize) {
+          slot->error = EFBIG;
+        }
+        else {
+          slot->size = slot->stx.stx_size;
+        }
+
+        break;
+
+      case kReadOp:
+        slot->ops--;
+
+        if (res > 0) {
+          slot->got += res;
+        }
+        else if (res < 0 && res != -EINTR && res != -EAGAIN) {
+          slot->error = -res;
+        }
+
+        // short reads are continued until the file ends or is full
+        if (slot->error == 0 && slot->got < slot->size && res != 0) {
+          struct io_uring_sqe *readSqe;
+
+          if ((readSqe = ringSqe(&ring)) == NULL) LOGFAIL(errno)
+
+          readSqe->opcode = IORING_OP_READ;
+          readSqe->fd = slot->fd;
+          readSqe->addr = (uintptr_t)slot->buf + slot->got;
+          readSqe->len = slot->size - slot->got;
+          readSqe->off = slot->got;
+          readSqe->user_data = cqe->user_data;
+
+          slot->ops = 1;
+          inflight++;
+        }
+
+        break;
+
+      case kCloseOp:
+        break;
+
+      default:
+        assert(0);
+        break;
+      }
+
+      // opened and sized, empty files skip the read
+      if ((USER_OP(cqe->user_data) == kOpenOp || USER_OP(cqe->user_data) == kStatOp) && slot->ops == 0 && slot->error == 0 && slot->size > 0) {
+        slot->waiting = 1;
+      }
+    }
+
+    __atomic_store_n(ring.cqHead, head, __ATOMIC_RELEASE);
+  }
+
+CLEANUP
+  if (ERROR != 0 && ring.fd != -1) {
+    size_t n;
+
+    // wait for what the kernel still has of ours before freeing it
+    while (inflight > 0 && ringEnter(&ring, 1) == 0) {
+      unsigned head = *ring.cqHead, tail = __atomic_load_n(ring.cqTail, __ATOMIC_ACQUIRE);
+
+      inflight -= tail - head;
+      __atomic_store_n(ring.cqHead, tail, __ATOMIC_RELEASE);
+    }
+
+    // hand back what was not delivered, the buffers leak if the ring could not be drained
+    n = 0;
+
+    if ((*left = malloc((npaths - next + RING_SLOTS)*sizeof(size_t))) != NULL) {
+      for (i = 0; i < RING_SLOTS; i++) {
+        if (slots[i].index != SIZE_MAX) {
+          (*left)[n++] = slots[i].index;
+
+          if (inflight == 0) {
+            if (slots[i].fd != -1) {
+              close(slots[i].fd);
+            }
+
+            if (slots[i].buf != NULL) {
+              free(slots[i].buf);
+              unreserveBytes(ingest, slots[i].size);
+            }
+          }
+        }
+      }
+
+      for (i = next; i < npaths; i++) {
+        (*left)[n++] = i;
+      }
+
+      *nleft = n;
+    }
+  }
+
+  if (ring.fd != -1) {
+    ringDestroy(&ring);
+  }
+
+ERRHANDLER(0, -1)
+END
+}
+
+#endif
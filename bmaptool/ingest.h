@@ -0,0 +1,40 @@
+//
+//  ingest.h
+//  XBolo Map Editor
+//
+//  Created by Robert Chrzanowski on 10/19/26.
+//  Copyright 2026 Robert Chrzanowski. All rights reserved.
+//
+
+#ifndef __INGEST__
+#define __INGEST__
+
+#include <stddef.h>
+
+
+#define DEFAULT_INGEST_BUDGET (64*1024*1024)  // bytes of file data read but not yet released
+
+typedef struct GSIngest GSIngest;
+
+// called once per path as its read completes, possibly from several threads
+// at once; data is NULL when error is set and must be given back with
+// ingestRelease() otherwise
+typedef void (*GSIngestHandler)(void *context, size_t index, void *data, size_t nbytes, int error);
+
+// create/destroy an ingest, files larger than maxFileSize fail with EFBIG
+GSIngest *ingestCreate(size_t budget, size_t maxFileSize);
+void ingestDestroy(GSIngest *ingest);
+
+// reads every path, on Linux with batches of io_uring requests and elsewhere
+// or when io_uring is not available with a pool of blocking readers, returns
+// once every path has been handed to handler, blocking while the buffers
+// handed out but not released exceed the budget
+int ingestFiles(GSIngest *ingest, char *const paths[], size_t npaths, GSIngestHandler handler, void *context);
+
+// frees data and returns its bytes to the budget
+void ingestRelease(GSIngest *ingest, void *data, size_t nbytes);
+
+// "io_uring" or "threads"
+const char *ingestMethod(const GSIngest *ingest);
+
+#endif  // __INGEST__
@@ -0,0 +1,766 @@
+//
+//  catalog.c
+//  XBolo Map Editor
+//
+//  Created by Robert Chrzanowski on 10/19/26.
+//  Copyright 2026 Robert Chrzanowski. All rights reserved.
+//
+
+#include "catalog.h"
+#include "symmetry.h"
+#include "errchk.h"
+
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+
+#define BLOCK (16)  // rows selected per step
+
+struct Column {
+  const char *name;
+  int width;
+  size_t offset;
+} ;
+
+#define FIELD(name, field) { name, sizeof(((struct GSMapFeatures *)0)->field), offsetof(struct GSMapFeatures, field) }
+
+static const struct Column kColumns[] = {
+  FIELD("pills", pills),
+  FIELD("bases", bases),
+  FIELD("starts", starts),
+  FIELD("owned_pills", ownedPills),
+  FIELD("owned_bases", ownedBases),
+  FIELD("owners", owners),
+  FIELD("left", left),
+  FIELD("top", top),
+  FIELD("width", width),
+  FIELD("height", height),
+  FIELD("water_percent", waterPercent),
+  FIELD("symmetry", symmetry),
+  FIELD("symmetry_kind", symmetryKind),
+  FIELD("land", land),
+  FIELD("water", water),
+  FIELD("mines", mines),
+  FIELD("islands", islands),
+  FIELD("lakes", lakes),
+  FIELD("wall", tiles[kWallTile]),
+  FIELD("river", tiles[kRiverTile]),
+  FIELD("swamp", tiles[kSwampTile]),
+  FIELD("crater", tiles[kCraterTile]),
+  FIELD("road", tiles[kRoadTile]),
+  FIELD("forest", tiles[kForestTile]),
+  FIELD("rubble", tiles[kRubbleTile]),
+  FIELD("grass", tiles[kGrassTile]),
+  FIELD("damaged_wall", tiles[kDamagedWallTile]),
+  FIELD("boat", tiles[kBoatTile]),
+  FIELD("mined_swamp", tiles[kMinedSwampTile]),
+  FIELD("mined_crater", tiles[kMinedCraterTile]),
+  FIELD("mined_road", tiles[kMinedRoadTile]),
+  FIELD("mined_forest", tiles[kMinedForestTile]),
+  FIELD("mined_rubble", tiles[kMinedRubbleTile]),
+  FIELD("mined_grass", tiles[kMinedGrassTile]),
+  FIELD("sea", tiles[kSeaTile]),
+  FIELD("mined_sea", tiles[kMinedSeaTile]),
+};
+
+#define NCOLUMNS ((int)(sizeof(kColumns)/sizeof(kColumns[0])))
+
+struct GSFeatureTable {
+  size_t count;
+  size_t capacity;
+  char **names;
+  void *columns[NCOLUMNS];
+} ;
+
+// scratch space for counting connected groups of tiles
+struct Fill {
+  uint8_t visited[WIDTH][WIDTH];
+  uint16_t queue[WIDTH*WIDTH];
+} ;
+
+static int isWater(GSTile tiles[][WIDTH], int x, int y);
+static void fill(struct Fill *f, GSTile tiles[][WIDTH], int x, int y);
+static int grow(GSFeatureTable *table);
+static void selectRange8(const uint8_t *values, size_t n, uint8_t min, uint8_t max, uint8_t *selection);
+static void selectRange16(const uint16_t *values, size_t n, uint16_t min, uint16_t max, uint8_t *selection);
+static void selectRange32(const uint32_t *values, size_t n, uint32_t min, uint32_t max, uint8_t *selection);
+
+int mapFeatures(const struct BMAP_Preamble *preamble, const struct BMAP_PillInfo pills[],
+                const struct BMAP_BaseInfo bases[], const struct BMAP_StartInfo starts[],
+                GSTile tiles[][WIDTH], struct GSMapFeatures *features) {
+  uint8_t owners[256];
+  struct GSSymmetry symmetry;
+  struct Fill *f;
+  int x, y, i, minx, miny, maxx, maxy, area;
+
+  f = NULL;
+
+TRY
+  if ((f = malloc(sizeof(struct Fill))) == NULL) LOGFAIL(errno)
+
+  bzero(features, sizeof(struct GSMapFeatures));
+  bzero(owners, sizeof(owners));
+  features->pills = MIN(preamble->npills, MAX_PILLS);
+  features->bases = MIN(preamble->nbases, MAX_BASES);
+  features->starts = MIN(preamble->nstarts, MAX_STARTS);
+
+  for (i = 0; i < features->pills; i++) {
+    if (pills[i].owner != NEUTRAL) {
+      features->ownedPills++;
+      features->owners += !owners[pills[i].owner];
+      owners[pills[i].owner] = 1;
+    }
+  }
+
+  for (i = 0; i < features->bases; i++) {
+    if (bases[i].owner != NEUTRAL) {
+      features->ownedBases++;
+      features->owners += !owners[bases[i].owner];
+      owners[bases[i].owner] = 1;
+    }
+  }
+
+  // one pass for the counts and the tile bounds
+  minx = WIDTH;
+  miny = WIDTH;
+  maxx = -1;
+  maxy = -1;
+
+  for (y = GSMinY(kSeaRect); y <= GSMaxY(kSeaRect); y++) {
+    for (x = GSMinX(kSeaRect); x <= GSMaxX(kSeaRect); x++) {
+      GSTile tile = tiles[y][x];
+
+      if (tile < kTokenTile) {
+        features->tiles[tile]++;
+      }
+
+      if (tile != kSeaTile) {
+        minx = MIN(minx, x);
+        miny = MIN(miny, y);
+        maxx = MAX(maxx, x);
+        maxy = MAX(maxy, y);
+
+        if (tile != kMinedSeaTile) {
+          features->land++;
+        }
+      }
+
+      if (isMinedTile(tiles, x, y)) {
+        features->mines++;
+      }
+    }
+  }
+
+  // objects only widen the bounds of a map that has tiles, as in mapRect
+  if (maxx == -1) {
+    minx = GSMinX(kSeaRect);
+    miny = GSMinY(kSeaRect);
+    maxx = GSMaxX(kSeaRect);
+    maxy = GSMaxY(kSeaRect);
+  }
+  else {
+    for (i = 0; i < features->pills; i++) {
+      minx = MIN(minx, pills[i].x);
+      maxx = MAX(maxx, pills[i].x);
+      miny = MIN(miny, pills[i].y);
+      maxy = MAX(maxy, pills[i].y);
+    }
+
+    for (i = 0; i < features->bases; i++) {
+      minx = MIN(minx, bases[i].x);
+      maxx = MAX(maxx, bases[i].x);
+      miny = MIN(miny, bases[i].y);
+      maxy = MAX(maxy, bases[i].y);
+    }
+
+    for (i = 0; i < features->starts; i++) {
+      minx = MIN(minx, starts[i].x);
+      maxx = MAX(maxx, starts[i].x);
+      miny = MIN(miny, starts[i].y);
+      maxy = MAX(maxy, starts[i].y);
+    }
+  }
+
+  features->left = minx;
+  features->top = miny;
+  features->width = maxx - minx + 1;
+  features->height = maxy - miny + 1;
+
+  for (y = miny; y <= maxy; y++) {
+    for (x = minx; x <= maxx; x++) {
+      features->water += isWater(tiles, x, y);
+    }
+  }
+
+  area = features->width*features->height;
+  features->waterPercent = (features->water*100)/area;
+
+  if (mapSymmetry(preamble, pills, bases, starts, tiles, &symmetry) == -1) LOGFAIL(errno)
+  features->symmetry = (symmetry.scores[symmetry.best].tiles - symmetry.scores[symmetry.best].mismatches)*100/symmetry.scores[symmetry.best].tiles;
+  features->symmetryKind = symmetry.best;
+
+  // water reaching the edge of the map is the open sea, every other
+  // unvisited group of tiles is an island or a lake
+  bzero(f->visited, sizeof(f->visited));
+
+  for (i = 0; i < WIDTH; i++) {
+    int edges[4][2] = { { i, 0 }, { i, WIDTH - 1 }, { 0, i }, { WIDTH - 1, i } };
+    int j;
+
+    for (j = 0; j < 4; j++) {
+      if (!f->visited[edges[j][1]][edges[j][0]] && isWater(tiles, edges[j][0], edges[j][1])) {
+        fill(f, tiles, edges[j][0], edges[j][1]);
+      }
+    }
+  }
+
+  for (y = 0; y < WIDTH; y++) {
+    for (x = 0; x < WIDTH; x++) {
+      if (!f->visited[y][x]) {
+        if (isWater(tiles, x, y)) {
+          features->lakes++;
+        }
+        else {
+          features->islands++;
+        }
+
+        fill(f, tiles, x, y);
+      }
+    }
+  }
+
+CLEANUP
+  free(f);
+
+ERRHANDLER(0, -1)
+END
+}
+
+int featureColumnCount(void) {
+  return NCOLUMNS;
+}
+
+const char *featureColumnName(int column) {
+  assert(column >= 0 && column < NCOLUMNS);
+  return kColumns[column].name;
+}
+
+int featureColumnIndex(const char *name) {
+  int i;
+
+  for (i = 0; i < NCOLUMNS; i++) {
+    if (strcmp(name, kColumns[i].name) == 0) {
+      return i;
+    }
+  }
+
+  return -1;
+}
+
+GSFeatureTable *featureTableCreate(void) {
+  GSFeatureTable *table;
+
+TRY
+  if ((table = calloc(1, sizeof(GSFeatureTable))) == NULL) LOGFAIL(errno)
+
+CLEANUP
+ERRHANDLER(table, NULL)
+END
+}
+
+void featureTableDestroy(GSFeatureTable *table) {
+  size_t i;
+  int c;
+
+  if (table != NULL) {
+    for (i = 0; i < table->count; i++) {
+      free(table->names[i]);
+    }
+
+    for (c = 0; c < NCOLUMNS; c++) {
+      free(table->columns[c]);
+    }
+
+    free(table->names);
+    free(table);
+  }
+}
+
+int featureTableAppend(GSFeatureTable *table, const char *name, const struct GSMapFeatures *features) {
+  char *copy;
+  int c;
+
+TRY
+  if (table->count == table->capacity && grow(table) == -1) LOGFAIL(errno)
+  if ((copy = strdup(name)) == NULL) LOGFAIL(errno)
+
+  table->names[table->count] = copy;
+
+  for (c = 0; c < NCOLUMNS; c++) {
+    bcopy((const void *)features + kColumns[c].offset, table->columns[c] + table->count*kColumns[c].width, kColumns[c].width);
+  }
+
+  table->count++;
+
+CLEANUP
+ERRHANDLER(0, -1)
+END
+}
+
+size_t featureTableCount(const GSFeatureTable *table) {
+  return table->count;
+}
+
+const char *featureTableName(const GSFeatureTable *table, size_t row) {
+  assert(row < table->count);
+  return table->names[row];
+}
+
+uint32_t featureValue(const GSFeatureTable *table, int column, size_t row) {
+  assert(column >= 0 && column < NCOLUMNS && row < table->count);
+
+  switch (kColumns[column].width) {
+  case 1:
+    return ((const uint8_t *)table->columns[column])[row];
+
+  case 2:
+    return ((const uint16_t *)table->columns[column])[row];
+
+  default:
+    return ((const uint32_t *)table->columns[column])[row];
+  }
+}
+
+GSFeatureTable *loadFeatureTable(const void *buf, size_t nbytes) {
+  const struct BFIX_Preamble *preamble;
+  const struct BFIX_Column *columns;
+  const void *data, *end;
+  GSFeatureTable *table;
+  size_t nrows, i, r;
+  int c, k, found[NCOLUMNS];
+
+  table = NULL;
+  end = buf + nbytes;
+
+TRY
+  if (nbytes < sizeof(struct BFIX_Preamble)) LOGFAIL(ECORFILE)
+  preamble = buf;
+  if (strncmp((const char *)preamble->ident, FEATURES_IDENT, FEATURES_IDENT_LEN) != 0) LOGFAIL(ECORFILE)
+  if (preamble->version != CURRENT_FEATURES_VERSION) LOGFAIL(EINCMPAT)
+
+  nrows = ((size_t)preamble->nrows[0] << 24) | (preamble->nrows[1] << 16) | (preamble->nrows[2] << 8) | preamble->nrows[3];
+  columns = buf + sizeof(struct BFIX_Preamble);
+  data = columns + preamble->ncolumns;
+  if (data > end || nrows > (size_t)(end - data)) LOGFAIL(ECORFILE)  // names are at least a byte
+
+  if ((table = featureTableCreate()) == NULL) LOGFAIL(errno)
+
+  while (table->capacity < nrows) {
+    if (grow(table) == -1) LOGFAIL(errno)
+  }
+
+  for (r = 0; r < nrows; r++) {
+    const char *name = data;
+    size_t len;
+
+    len = strnlen(name, end - data);
+    if (data + len == end) LOGFAIL(ECORFILE)
+    if ((table->names[r] = strdup(name)) == NULL) LOGFAIL(errno)
+    table->count = r + 1;
+    data += len + 1;
+  }
+
+  bzero(found, sizeof(found));
+
+  // columns this table does not know are skipped
+  for (k = 0; k < preamble->ncolumns; k++) {
+    char name[FEATURE_NAME_LEN + 1];
+    int width = columns[k].width;
+
+    if (width != 1 && width != 2 && width != 4) LOGFAIL(ECORFILE)
+    if ((size_t)(end - data) < nrows*width) LOGFAIL(ECORFILE)
+
+    bcopy(columns[k].name, name, FEATURE_NAME_LEN);
+    name[FEATURE_NAME_LEN] = '\0';
+
+    if ((c = featureColumnIndex(name)) != -1 && kColumns[c].width == width) {
+      const uint8_t *p = data;
+
+      for (i = 0; i < nrows; i++, p += width) {
+        switch (width) {
+        case 1:
+          ((uint8_t *)table->columns[c])[i] = p[0];
+          break;
+
+        case 2:
+          ((uint16_t *)table->columns[c])[i] = (p[0] << 8) | p[1];
+          break;
+
+        default:
+          ((uint32_t *)table->columns[c])[i] = ((uint32_t)p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+          break;
+        }
+      }
+
+      found[c] = 1;
+    }
+
+    data += nrows*width;
+  }
+
+  for (c = 0; c < NCOLUMNS; c++) {
+    if (!found[c]) LOGFAIL(EINCMPAT)
+  }
+
+CLEANUP
+  switch (ERROR) {
+  case 0:
+    RETURN(table)
+
+  default:
+    featureTableDestroy(table);
+    RETERR(NULL)
+  }
+END
+}
+
+ssize_t saveFeatureTable(void **data, const GSFeatureTable *table) {
+  struct BFIX_Preamble *preamble;
+  struct BFIX_Column *columns;
+  ssize_t size;
+  size_t i;
+  void *buf;
+  int c;
+
+  *data = NULL;
+  size = 0;
+
+TRY
+  if (table->count > UINT32_MAX) LOGFAIL(EOVERFLOW)
+
+  size = sizeof(struct BFIX_Preamble) + NCOLUMNS*sizeof(struct BFIX_Column);
+
+  for (i = 0; i < table->count; i++) {
+    size += strlen(table->names[i]) + 1;
+  }
+
+  for (c = 0; c < NCOLUMNS; c++) {
+    size += table->count*kColumns[c].width;
+  }
+
+  if ((buf = malloc(size)) == NULL) LOGFAIL(errno)
+  *data = buf;
+  bzero(buf, size);
+
+  preamble = buf;
+  bcopy(FEATURES_IDENT, preamble->ident, FEATURES_IDENT_LEN);
+  preamble->version = CURRENT_FEATURES_VERSION;
+  preamble->ncolumns = NCOLUMNS;
+  preamble->nrows[0] = table->count >> 24;
+  preamble->nrows[1] = table->count >> 16;
+  preamble->nrows[2] = table->count >> 8;
+  preamble->nrows[3] = table->count;
+  buf += sizeof(struct BFIX_Preamble);
+
+  columns = buf;
+
+  for (c = 0; c < NCOLUMNS; c++) {
+    strncpy((char *)columns[c].name, kColumns[c].name, FEATURE_NAME_LEN);
+    columns[c].width = kColumns[c].width;
+  }
+
+  buf += NCOLUMNS*sizeof(struct BFIX_Column);
+
+  for (i = 0; i < table->count; i++) {
+    size_t len = strlen(table->names[i]) + 1;
+
+    bcopy(table->names[i], buf, len);
+    buf += len;
+  }
+
+  for (c = 0; c < NCOLUMNS; c++) {
+    uint8_t *p = buf;
+
+    for (i = 0; i < table->count; i++) {
+      uint32_t value = featureValue(table, c, i);
+      int b;
+
+      for (b = kColumns[c].width - 1; b >= 0; b--) {
+        *p++ = value >> (b*8);
+      }
+    }
+
+    buf = p;
+  }
+
+CLEANUP
+  switch (ERROR) {
+  case 0:
+    RETURN(size)
+
+  default:
+    free(*data);
+    *data = NULL;
+    RETERR(-1)
+  }
+END
+}
+
+void featureSelectAll(const GSFeatureTable *table, uint8_t *selection) {
+  memset(selection, 0xff, table->count);
+}
+
+void featureSelectRange(const GSFeatureTable *table, int column, uint32_t min, uint32_t max, uint8_t *selection) {
+  uint32_t limit;
+
+  assert(column >= 0 && column < NCOLUMNS);
+
+  limit = kColumns[column].width == 4 ? UINT32_MAX : (1U << (kColumns[column].width*8)) - 1;
+  max = MIN(max, limit);
+
+  if (min > max) {
+    bzero(selection, table->count);
+    return;
+  }
+
+  switch (kColumns[column].width) {
+  case 1:
+    selectRange8(table->columns[column], table->count, min, max, selection);
+    break;
+
+  case 2:
+    selectRange16(table->columns[column], table->count, min, max, selection);
+    break;
+
+  default:
+    selectRange32(table->columns[column], table->count, min, max, selection);
+    break;
+  }
+}
+
+size_t featureSelectedCount(const GSFeatureTable *table, const uint8_t *selection) {
+  size_t i, count;
+
+  count = 0;
+
+  for (i = 0; i < table->count; i++) {
+    count += selection[i] != 0;
+  }
+
+  return count;
+}
+
+int isWater(GSTile tiles[][WIDTH], int x, int y) {
+  int class = tileClass(tiles[y][x]);
+
+  return class == kSeaClass || class == kRiverClass;
+}
+
+// marks the 4 connected tiles that are water or land like the tile at x, y
+void fill(struct Fill *f, GSTile tiles[][WIDTH], int x, int y) {
+  size_t head, tail;
+  int water;
+
+  water = isWater(tiles, x, y);
+  head = 0;
+  tail = 0;
+  f->visited[y][x] = 1;
+  f->queue[tail++] = (y << 8) | x;
+
+  while (head < tail) {
+    int p = f->queue[head++];
+    int px = p & 0xff, py = p >> 8;
+    int neighbours[4][2] = { { px - 1, py }, { px + 1, py }, { px, py - 1 }, { px, py + 1 } };
+    int i;
+
+    for (i = 0; i < 4; i++) {
+      int nx = neighbours[i][0], ny = neighbours[i][1];
+
+      if (nx >= 0 && nx < WIDTH && ny >= 0 && ny < WIDTH && !f->visited[ny][nx] && isWater(tiles, nx, ny) == water) {
+        f->visited[ny][nx] = 1;
+        f->queue[tail++] = (ny << 8) | nx;
+      }
+    }
+  }
+}
+
+int grow(GSFeatureTable *table) {
+  size_t capacity;
+  void *p;
+  int c;
+
+TRY
+  capacity = table->capacity > 0 ? table->capacity*2 : 1024;
+
+  if ((p = realloc(table->names, capacity*sizeof(char *))) == NULL) LOGFAIL(errno)
+  table->names = p;
+
+  for (c = 0; c < NCOLUMNS; c++) {
+    if ((p = realloc(table->columns[c], capacity*kColumns[c].width)) == NULL) LOGFAIL(errno)
+    table->columns[c] = p;
+  }
+
+  table->capacity = capacity;
+
+CLEANUP
+ERRHANDLER(0, -1)
+END
+}
+
+// each kernel ands selection with min <= value <= max a block at a time
+// and finishes the rows past the last whole block one at a time
+#if defined(__SSE2__)
+
+void selectRange8(const uint8_t *values, size_t n, uint8_t min, uint8_t max, uint8_t *selection) {
+  __m128i lo = _mm_set1_epi8((char)min), hi = _mm_set1_epi8((char)max), zero = _mm_setzero_si128();
+  size_t i;
+
+  for (i = 0; i + BLOCK <= n; i += BLOCK) {
+    __m128i v = _mm_loadu_si128((const __m128i *)(values + i));
+    __m128i in = _mm_and_si128(_mm_cmpeq_epi8(_mm_subs_epu8(lo, v), zero), _mm_cmpeq_epi8(_mm_subs_epu8(v, hi), zero));
+    __m128i *s = (__m128i *)(selection + i);
+    _mm_storeu_si128(s, _mm_and_si128(_mm_loadu_si128(s), in));
+  }
+
+  for (; i < n; i++) {
+    selection[i] &= (values[i] >= min && values[i] <= max) ? 0xff : 0;
+  }
+}
+
+void selectRange16(const uint16_t *values, size_t n, uint16_t min, uint16_t max, uint8_t *selection) {
+  __m128i lo = _mm_set1_epi16((short)min), hi = _mm_set1_epi16((short)max), zero = _mm_setzero_si128();
+  __m128i in[2];
+  size_t i;
+  int j;
+
+  for (i = 0; i + BLOCK <= n; i += BLOCK) {
+    __m128i *s = (__m128i *)(selection + i);
+
+    for (j = 0; j < 2; j++) {
+      __m128i v = _mm_loadu_si128((const __m128i *)(values + i) + j);
+      in[j] = _mm_and_si128(_mm_cmpeq_epi16(_mm_subs_epu16(lo, v), zero), _mm_cmpeq_epi16(_mm_subs_epu16(v, hi), zero));
+    }
+
+    _mm_storeu_si128(s, _mm_and_si128(_mm_loadu_si128(s), _mm_packs_epi16(in[0], in[1])));
+  }
+
+  for (; i < n; i++) {
+    selection[i] &= (values[i] >= min && values[i] <= max) ? 0xff : 0;
+  }
+}
+
+void selectRange32(const uint32_t *values, size_t n, uint32_t min, uint32_t max, uint8_t *selection) {
+  // unsigned compares are signed compares with the top bits flipped
+  __m128i bias = _mm_set1_epi32((int)0x80000000U);
+  __m128i lo = _mm_set1_epi32((int)(min ^ 0x80000000U)), hi = _mm_set1_epi32((int)(max ^ 0x80000000U));
+  __m128i out[4];
+  size_t i;
+  int j;
+
+  for (i = 0; i + BLOCK <= n; i += BLOCK) {
+    __m128i *s = (__m128i *)(selection + i);
+
+    for (j = 0; j < 4; j++) {
+      __m128i v = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(values + i) + j), bias);
+      out[j] = _mm_or_si128(_mm_cmpgt_epi32(lo, v), _mm_cmpgt_epi32(v, hi));
+    }
+
+    __m128i outside = _mm_packs_epi16(_mm_packs_epi32(out[0], out[1]), _mm_packs_epi32(out[2], out[3]));
+    _mm_storeu_si128(s, _mm_andnot_si128(outside, _mm_loadu_si128(s)));
+  }
+
+  for (; i < n; i++) {
+    selection[i] &= (values[i] >= min && values[i] <= max) ? 0xff : 0;
+  }
+}
+
+#elif defined(__ARM_NEON)
+
+void selectRange8(const uint8_t *values, size_t n, uint8_t min, uint8_t max, uint8_t *selection) {
+  uint8x16_t lo = vdupq_n_u8(min), hi = vdupq_n_u8(max);
+  size_t i;
+
+  for (i = 0; i + BLOCK <= n; i += BLOCK) {
+    uint8x16_t v = vld1q_u8(values + i);
+    uint8x16_t in = vandq_u8(vcgeq_u8(v, lo), vcleq_u8(v, hi));
+    vst1q_u8(selection + i, vandq_u8(vld1q_u8(selection + i), in));
+  }
+
+  for (; i < n; i++) {
+    selection[i] &= (values[i] >= min && values[i] <= max) ? 0xff : 0;
+  }
+}
+
+void selectRange16(const uint16_t *values, size_t n, uint16_t min, uint16_t max, uint8_t *selection) {
+  uint16x8_t lo = vdupq_n_u16(min), hi = vdupq_n_u16(max);
+  uint8x8_t in[2];
+  size_t i;
+  int j;
+
+  for (i = 0; i + BLOCK <= n; i += BLOCK) {
+    for (j = 0; j < 2; j++) {
+      uint16x8_t v = vld1q_u16(values + i + 8*j);
+      in[j] = vmovn_u16(vandq_u16(vcgeq_u16(v, lo), vcleq_u16(v, hi)));
+    }
+
+    vst1q_u8(selection + i, vandq_u8(vld1q_u8(selection + i), vcombine_u8(in[0], in[1])));
+  }
+
+  for (; i < n; i++) {
+    selection[i] &= (values[i] >= min && values[i] <= max) ? 0xff : 0;
+  }
+}
+
+void selectRange32(const uint32_t *values, size_t n, uint32_t min, uint32_t max, uint8_t *selection) {
+  uint32x4_t lo = vdupq_n_u32(min), hi = vdupq_n_u32(max);
+  uint16x4_t in[4];
+  size_t i;
+  int j;
+
+  for (i = 0; i + BLOCK <= n; i += BLOCK) {
+    for (j = 0; j < 4; j++) {
+      uint32x4_t v = vld1q_u32(values + i + 4*j);
+      in[j] = vmovn_u32(vandq_u32(vcgeq_u32(v, lo), vcleq_u32(v, hi)));
+    }
+
+    uint8x16_t all = vcombine_u8(vmovn_u16(vcombine_u16(in[0], in[1])), vmovn_u16(vcombine_u16(in[2], in[3])));
+    vst1q_u8(selection + i, vandq_u8(vld1q_u8(selection + i), all));
+  }
+
+  for (; i < n; i++) {
+    selection[i] &= (values[i] >= min && values[i] <= max) ? 0xff : 0;
+  }
+}
+
+#else
+
+void selectRange8(const uint8_t *values, size_t n, uint8_t min, uint8_t max, uint8_t *selection) {
+  size_t i;
+
+  for (i = 0; i < n; i++) {
+    selection[i] &= (values[i] >= min && values[i] <= max) ? 0xff : 0;
+  }
+}
+
+void selectRange16(const uint16_t *values, size_t n, uint16_t min, uint16_t max, uint8_t *selection) {
+  size_t i;
+
+  for (i = 0; i < n; i++) {
+    selection[i] &= (values[i] >= min && values[i] <= max) ? 0xff : 0;
+  }
+}
+
+void selectRange32(const uint32_t *values, size_t n, uint32_t min, uint32_t max, uint8_t *selection) {
+  size_t i;
+
+  for (i = 0; i < n; i++) {
+    selection[i] &= (values[i] >= min && values[i] <= max) ? 0xff : 0;
+  }
+}
+
+#endif
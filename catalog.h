@@ -0,0 +1,93 @@
+//
+//  catalog.h
+//  XBolo Map Editor
+//
+//  Created by Robert Chrzanowski on 10/19/26.
+//  Copyright 2026 Robert Chrzanowski. All rights reserved.
+//
+
+#ifndef __CATALOG__
+#define __CATALOG__
+
+#include <stddef.h>
+#include <stdint.h>
+#include "bmap.h"
+
+
+#define FEATURES_IDENT      ("BFIXBOLO")
+#define FEATURES_IDENT_LEN  (8)
+#define CURRENT_FEATURES_VERSION (1)
+
+#define FEATURE_NAME_LEN    (15)
+
+// a feature file is the preamble, ncolumns BFIX_Column, nrows NUL terminated
+// map names and then each column's nrows values big endian in column order
+struct BFIX_Preamble {
+  uint8_t ident[8];   // "BFIXBOLO"
+  uint8_t version;    // currently 1
+  uint8_t ncolumns;
+  uint8_t nrows[4];   // big endian
+} __attribute__((__packed__));
+
+struct BFIX_Column {
+  uint8_t name[FEATURE_NAME_LEN];  // NUL padded
+  uint8_t width;                   // bytes per value, 1, 2 or 4
+} __attribute__((__packed__));
+
+// one map's row, tile counts are of the tiles inside kSeaRect
+struct GSMapFeatures {
+  uint8_t pills;
+  uint8_t bases;
+  uint8_t starts;
+  uint8_t ownedPills;    // pills and bases not owned by NEUTRAL
+  uint8_t ownedBases;
+  uint8_t owners;        // distinct owners of pills and bases
+  uint8_t left;          // land bounds like -[GSXBoloMap mapRect], kSeaRect if there is no land
+  uint8_t top;
+  uint8_t width;
+  uint8_t height;
+  uint8_t waterPercent;  // sea, river and boat tiles as a percentage of the land bounds
+  uint8_t symmetry;      // tiles of the land bounds matching their image under symmetryKind as a percentage
+  uint8_t symmetryKind;  // the map's best symmetry, as in symmetry.h
+  uint16_t land;         // tiles that are not sea
+  uint16_t water;        // sea, river and boat tiles inside the land bounds
+  uint16_t mines;
+  uint16_t islands;      // 4 connected groups of tiles that are not water
+  uint16_t lakes;        // 4 connected groups of water cut off from the map's edge
+  uint16_t tiles[kTokenTile];
+} ;
+
+typedef struct GSFeatureTable GSFeatureTable;
+
+// fills in the features of a decoded map
+int mapFeatures(const struct BMAP_Preamble *preamble, const struct BMAP_PillInfo pills[],
+                const struct BMAP_BaseInfo bases[], const struct BMAP_StartInfo starts[],
+                GSTile tiles[][WIDTH], struct GSMapFeatures *features);
+
+// columns are named after the fields, tiles are named after their tile
+// ("forest", "mined_grass", ...), returns -1 for an unknown name
+int featureColumnCount(void);
+const char *featureColumnName(int column);
+int featureColumnIndex(const char *name);
+
+// create/destroy an empty table, rows are kept one array per column
+GSFeatureTable *featureTableCreate(void);
+void featureTableDestroy(GSFeatureTable *table);
+
+int featureTableAppend(GSFeatureTable *table, const char *name, const struct GSMapFeatures *features);
+size_t featureTableCount(const GSFeatureTable *table);
+const char *featureTableName(const GSFeatureTable *table, size_t row);
+uint32_t featureValue(const GSFeatureTable *table, int column, size_t row);
+
+// load/save a feature file, columns are matched by name
+GSFeatureTable *loadFeatureTable(const void *buf, size_t nbytes);
+ssize_t saveFeatureTable(void **data, const GSFeatureTable *table);
+
+// a selection is one byte per row, 0xff if the row is selected and 0 if not,
+// featureSelectRange() deselects the rows whose column is outside [min, max]
+// scanning 16 values at a time
+void featureSelectAll(const GSFeatureTable *table, uint8_t *selection);
+void featureSelectRange(const GSFeatureTable *table, int column, uint32_t min, uint32_t max, uint8_t *selection);
+size_t featureSelectedCount(const GSFeatureTable *table, const uint8_t *selection);
+
+#endif  // __CATALOG__
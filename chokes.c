@@ -0,0 +1,395 @@
+//
+//  chokes.c
+//  XBolo Map Editor
+//
+//  Created by Robert Chrzanowski on 10/19/26.
+//  Copyright 2026 Robert Chrzanowski. All rights reserved.
+//
+
+#include "chokes.h"
+#include "errchk.h"
+
+#include <stdlib.h>
+#include <strings.h>
+
+
+#define NODES     (WIDTH*WIDTH)
+#define IN(v)     (2*(v))      // flow enters a tile at its in half
+#define OUT(v)    (2*(v) + 1)  // and leaves from its out half
+#define SOURCE    (1)
+#define SINK      (2)
+
+// scratch space of a search, indexed by tile y*WIDTH + x
+struct Work {
+  uint8_t passable[NODES];
+  int32_t disc[NODES];       // order a tile was first reached in, 0 if not yet
+  int32_t low[NODES];        // least disc reached from the tile's subtree by one back edge
+  int32_t parent[NODES];
+  uint8_t next[NODES];       // next direction to follow from the tile
+  int32_t size[NODES];       // tiles in the tile's subtree
+  int32_t separated[NODES];  // tiles of the subtrees the tile splits off
+  int32_t largest[NODES];    // largest of those subtrees
+  int32_t stack[NODES];
+  int32_t island[NODES];     // island of each tile, -1 if not passable
+  int8_t flow[NODES][4];     // net flow from a tile towards each neighbour
+  uint8_t used[NODES];       // flow goes through the tile
+  uint8_t terminal[NODES];   // SOURCE or SINK
+  int32_t prev[2*NODES];     // half each half was reached from, -1 for a source
+  uint32_t seen[2*NODES];    // last search that reached each half
+  int32_t queue[2*NODES];
+  uint32_t search;
+} ;
+
+static int neighbour(int v, int d);
+static void articulations(struct Work *work, struct GSChokes *chokes);
+static int landing(struct Work *work, GSTile tiles[][WIDTH], int x, int y);
+static void islandCut(struct Work *work, const int sources[], int nsources, const int sinks[], int nsinks, struct GSChokeCut *cut);
+static int augment(struct Work *work, const int sources[], int nsources);
+
+int mapChokes(const struct BMAP_Preamble *preamble, const struct BMAP_BaseInfo bases[],
+              const struct BMAP_StartInfo starts[], GSTile tiles[][WIDTH], unsigned classes,
+              struct GSChokes *chokes) {
+  struct Work *work;
+  int startTiles[MAX_STARTS], baseTiles[MAX_BASES];
+  int sources[MAX_STARTS], sinks[MAX_BASES];
+  int nstarts, nbases, nsources, nsinks, v, i, j;
+
+  work = NULL;
+
+TRY
+  if ((work = malloc(sizeof(struct Work))) == NULL) LOGFAIL(errno)
+
+  bzero(chokes, sizeof(struct GSChokes));
+  bzero(work->seen, sizeof(work->seen));
+  work->search = 0;
+
+  for (v = 0; v < NODES; v++) {
+    work->passable[v] = (classes >> tileClass(tiles[v/WIDTH][v%WIDTH])) & 1;
+  }
+
+  articulations(work, chokes);
+
+  nstarts = MIN(preamble->nstarts, MAX_STARTS);
+  nbases = MIN(preamble->nbases, MAX_BASES);
+
+  for (i = 0; i < nstarts; i++) {
+    startTiles[i] = landing(work, tiles, starts[i].x, starts[i].y);
+  }
+
+  for (i = 0; i < nbases; i++) {
+    baseTiles[i] = landing(work, tiles, bases[i].x, bases[i].y);
+  }
+
+  // each island is cut once, at the first start landing on it
+  for (i = 0; i < nstarts; i++) {
+    int island;
+
+    if (startTiles[i] == -1) {
+      continue;
+    }
+
+    island = work->island[startTiles[i]];
+
+    for (j = 0; j < i; j++) {
+      if (startTiles[j] != -1 && work->island[startTiles[j]] == island) {
+        break;
+      }
+    }
+
+    if (j < i) {
+      continue;
+    }
+
+    for (nsources = 0, j = i; j < nstarts; j++) {
+      if (startTiles[j] != -1 && work->island[startTiles[j]] == island) {
+        sources[nsources++] = startTiles[j];
+      }
+    }
+
+    for (nsinks = 0, j = 0; j < nbases; j++) {
+      if (baseTiles[j] != -1 && work->island[baseTiles[j]] == island) {
+        sinks[nsinks++] = baseTiles[j];
+      }
+    }
+
+    if (nsinks > 0) {
+      struct GSChokeCut *cut = chokes->cuts + chokes->ncuts++;
+
+      cut->starts = nsources;
+      cut->bases = nsinks;
+      islandCut(work, sources, nsources, sinks, nsinks, cut);
+    }
+  }
+
+CLEANUP
+  free(work);
+
+ERRHANDLER(0, -1)
+END
+}
+
+// tile next to v in direction d, 0 to 3 for +x, -x, +y and -y so d^1 is
+// the way back, -1 off the map
+int neighbour(int v, int d) {
+  switch (d) {
+  case 0:
+    return v%WIDTH < WIDTH - 1 ? v + 1 : -1;
+
+  case 1:
+    return v%WIDTH > 0 ? v - 1 : -1;
+
+  case 2:
+    return v/WIDTH < WIDTH - 1 ? v + WIDTH : -1;
+
+  default:
+    return v/WIDTH > 0 ? v - WIDTH : -1;
+  }
+}
+
+// depth first from every tile not yet reached with an explicit stack.  a
+// child subtree whose low does not reach above its parent is split off by
+// the parent, which is then an articulation tile unless it is the root
+// with one child.  either way the cutoff comes out as 0 for a tile that
+// splits nothing off
+void articulations(struct Work *work, struct GSChokes *chokes) {
+  int32_t time, nislands;
+  int root, top, v, u, p;
+
+  bzero(work->disc, sizeof(work->disc));
+  time = 0;
+  nislands = 0;
+
+  for (v = 0; v < NODES; v++) {
+    work->island[v] = -1;
+  }
+
+  for (root = 0; root < NODES; root++) {
+    int32_t first;
+
+    if (!work->passable[root] || work->disc[root] != 0) {
+      continue;
+    }
+
+    first = time + 1;
+    top = 0;
+    work->stack[top++] = root;
+    work->disc[root] = work->low[root] = ++time;
+    work->parent[root] = -1;
+    work->next[root] = 0;
+    work->size[root] = 1;
+    work->separated[root] = 0;
+    work->largest[root] = 0;
+
+    while (top > 0) {
+      v = work->stack[top - 1];
+
+      if (work->next[v] < 4) {
+        if ((u = neighbour(v, work->next[v]++)) == -1 || !work->passable[u]) {
+          continue;
+        }
+
+        if (work->disc[u] == 0) {
+          work->disc[u] = work->low[u] = ++time;
+          work->parent[u] = v;
+          work->next[u] = 0;
+          work->size[u] = 1;
+          work->separated[u] = 0;
+          work->largest[u] = 0;
+          work->stack[top++] = u;
+        }
+        else if (u != work->parent[v]) {
+          work->low[v] = MIN(work->low[v], work->disc[u]);
+        }
+      }
+      else {
+        top--;
+
+        if ((p = work->parent[v]) != -1) {
+          work->size[p] += work->size[v];
+          work->low[p] = MIN(work->low[p], work->low[v]);
+
+          if (work->low[v] >= work->disc[p]) {
+            work->separated[p] += work->size[v];
+            work->largest[p] = MAX(work->largest[p], work->size[v]);
+          }
+        }
+      }
+    }
+
+    // walk the island's tree again to mark it and work out each cutoff now
+    // the size of the whole island is known
+    for (top = 0, work->stack[top++] = root; top > 0;) {
+      int d, rest, cutoff;
+
+      v = work->stack[--top];
+      work->island[v] = nislands;
+      rest = work->size[root] - 1 - work->separated[v];
+      cutoff = work->size[root] - 1 - MAX(work->largest[v], rest);
+
+      if (cutoff > 0) {
+        chokes->cutoff[v/WIDTH][v%WIDTH] = MIN(cutoff, UINT16_MAX);
+        chokes->narticulations++;
+      }
+
+      for (d = 0; d < 4; d++) {
+        if ((u = neighbour(v, d)) != -1 && work->passable[u] && work->parent[u] == v && work->disc[u] >= first) {
+          work->stack[top++] = u;
+        }
+      }
+    }
+
+    nislands++;
+  }
+}
+
+// nearest passable tile to x, y reached without crossing a wall, -1 if none
+int landing(struct Work *work, GSTile tiles[][WIDTH], int x, int y) {
+  int head, tail, v, u, d;
+
+  work->search++;
+  head = tail = 0;
+  v = y*WIDTH + x;
+  work->queue[tail++] = v;
+  work->seen[v] = work->search;
+
+  while (head < tail) {
+    v = work->queue[head++];
+
+    if (work->passable[v]) {
+      return v;
+    }
+
+    for (d = 0; d < 4; d++) {
+      if ((u = neighbour(v, d)) != -1 && work->seen[u] != work->search && tileClass(tiles[u/WIDTH][u%WIDTH]) != kWallClass) {
+        work->seen[u] = work->search;
+        work->queue[tail++] = u;
+      }
+    }
+  }
+
+  return -1;
+}
+
+// the max flow from the starts to the bases with every other tile split
+// into an in and an out half joined by an edge of capacity 1 is the size of
+// the least cut, which is the tiles whose in half the last search reached
+// and whose out half it did not
+void islandCut(struct Work *work, const int sources[], int nsources, const int sinks[], int nsinks, struct GSChokeCut *cut) {
+  int i, v, flow;
+
+  bzero(work->flow, sizeof(work->flow));
+  bzero(work->used, sizeof(work->used));
+  bzero(work->terminal, sizeof(work->terminal));
+
+  for (i = 0; i < nsources; i++) {
+    work->terminal[sources[i]] = SOURCE;
+  }
+
+  for (i = 0; i < nsinks; i++) {
+    if (work->terminal[sinks[i]] == SOURCE) {
+      cut->size = CHOKE_WIDE;
+      return;
+    }
+
+    work->terminal[sinks[i]] = SINK;
+  }
+
+  for (flow = 0; flow <= CHOKE_MAX_CUT && augment(work, sources, nsources); flow++);
+
+  if (flow > CHOKE_MAX_CUT) {
+    cut->size = CHOKE_WIDE;
+    return;
+  }
+
+  cut->size = 0;
+
+  for (v = 0; v < NODES; v++) {
+    if (work->seen[IN(v)] == work->search && work->seen[OUT(v)] != work->search && !work->terminal[v]) {
+      cut->tiles[cut->size++] = GSMakePoint(v%WIDTH, v/WIDTH);
+    }
+  }
+}
+
+// pushes one more unit of flow from a source to a sink along the shortest
+// path of the residual graph, returns 0 if there is none
+int augment(struct Work *work, const int sources[], int nsources) {
+  int head, tail, i, half, d, u, v;
+
+  work->search++;
+  head = tail = 0;
+
+  for (i = 0; i < nsources; i++) {
+    work->seen[IN(sources[i])] = work->search;
+    work->prev[IN(sources[i])] = -1;
+    work->queue[tail++] = IN(sources[i]);
+  }
+
+  for (half = -1; head < tail; half = -1) {
+    int next[4 + 1], nnext;
+
+    half = work->queue[head++];
+    v = half/2;
+    nnext = 0;
+
+    if (half == OUT(v) && work->terminal[v] == SINK) {
+      break;
+    }
+
+    if (half == IN(v)) {
+      // through the tile if it has room, or back along a flow into it
+      if (work->terminal[v] || !work->used[v]) {
+        next[nnext++] = OUT(v);
+      }
+
+      for (d = 0; d < 4; d++) {
+        if ((u = neighbour(v, d)) != -1 && work->flow[u][d ^ 1] > 0) {
+          next[nnext++] = OUT(u);
+        }
+      }
+    }
+    else {
+      // on to any neighbour, or back through the tile against its flow
+      for (d = 0; d < 4; d++) {
+        if ((u = neighbour(v, d)) != -1 && work->passable[u]) {
+          next[nnext++] = IN(u);
+        }
+      }
+
+      if (!work->terminal[v] && work->used[v]) {
+        next[nnext++] = IN(v);
+      }
+    }
+
+    for (i = 0; i < nnext; i++) {
+      if (work->seen[next[i]] != work->search) {
+        work->seen[next[i]] = work->search;
+        work->prev[next[i]] = half;
+        work->queue[tail++] = next[i];
+      }
+    }
+  }
+
+  if (half == -1) {
+    return 0;
+  }
+
+  for (; work->prev[half] != -1; half = work->prev[half]) {
+    int from = work->prev[half];
+
+    u = from/2;
+    v = half/2;
+
+    if (u == v) {
+      work->used[v] = half == OUT(v);
+    }
+    else {
+      for (d = 0; neighbour(u, d) != v; d++);
+
+      // a step out of u into v or back against a flow from v into u
+      work->flow[u][d]++;
+      work->flow[v][d ^ 1]--;
+    }
+  }
+
+  return 1;
+}
@@ -0,0 +1,50 @@
+//
+//  chokes.h
+//  XBolo Map Editor
+//
+//  Created by Robert Chrzanowski on 10/19/26.
+//  Copyright 2026 Robert Chrzanowski. All rights reserved.
+//
+
+#ifndef __CHOKES__
+#define __CHOKES__
+
+#include <stdint.h>
+#include "bmap.h"
+
+
+#define CHOKE_MAX_CUT  (32)  // cuts of more tiles are reported as wide
+#define CHOKE_WIDE     (-1)
+
+// classes of tiles.h a tank drives over once it has left its boat
+#define CHOKE_LAND_CLASSES \
+  ((1 << kRiverClass) | (1 << kRoadClass) | (1 << kGrassClass) | (1 << kForestClass) | (1 << kRoughClass))
+
+// fewest tiles whose loss cuts the starts landing on an island from its
+// bases, CHOKE_WIDE if more than CHOKE_MAX_CUT
+struct GSChokeCut {
+  int starts;                         // starts and bases landing on the island
+  int bases;
+  int size;
+  GSPoint tiles[CHOKE_MAX_CUT];
+} ;
+
+// narrow places of the graph of 4 way adjacent tiles of the given classes.
+// an articulation tile is one whose loss splits its island, cutoff is the
+// number of tiles it splits off the largest part that is left.  starts and
+// bases land on the nearest tile of the graph that is not across a wall
+struct GSChokes {
+  uint16_t cutoff[WIDTH][WIDTH];      // 0 for tiles that are not articulation tiles
+  int narticulations;
+  int ncuts;
+  struct GSChokeCut cuts[MAX_STARTS];  // islands with both starts and bases
+} ;
+
+// finds the articulation tiles by Tarjan's algorithm without recursion and
+// the cut of each island by augmenting paths over the tiles split in two,
+// returns -1 if memory runs out
+int mapChokes(const struct BMAP_Preamble *preamble, const struct BMAP_BaseInfo bases[],
+              const struct BMAP_StartInfo starts[], GSTile tiles[][WIDTH], unsigned classes,
+              struct GSChokes *chokes);
+
+#endif  // __CHOKES__
@@ -0,0 +1,316 @@
+//
+//  coverage.c
+//  XBolo Map Editor
+//
+//  Created by Robert Chrzanowski on 10/19/26.
+//  Copyright 2026 Robert Chrzanowski. All rights reserved.
+//
+
+#include "coverage.h"
+#include "tiles.h"
+#include "errchk.h"
+
+#include <stdlib.h>
+#include <strings.h>
+
+
+#define SPAN      COVERAGE_SPAN
+#define CELLS     (SPAN*SPAN)
+#define WORDS     COVERAGE_WORDS
+#define ROWWORDS  (WIDTH/64)            // words of a row of walls
+#define SPANMASK  ((UINT64_C(1) << SPAN) - 1)
+
+// a window bitboard has bit row*SPAN + column set for each of its cells,
+// the pill at its centre
+struct GSCoverage {
+  uint64_t walls[WIDTH][ROWWORDS];  // bit x of row y set for a wall at x, y
+  int ntargets;
+  uint16_t targets[CELLS];          // cells within PILL_RANGE of the centre
+  uint64_t rays[CELLS][WORDS];      // cells strictly between the centre and each cell
+  int npills;
+  GSPoint pills[MAX_PILLS];
+  uint64_t hits[MAX_PILLS][WORDS];  // cells each pill hits
+  int histogram[MAX_PILLS + 1];     // tiles hit by each number of pills
+  uint8_t counts[WIDTH][WIDTH];
+} ;
+
+static void buildRays(GSCoverage *coverage);
+static int roundDiv(int a, int b);
+static uint64_t wallBits(const GSCoverage *coverage, int x, int y);
+static void applyHits(GSCoverage *coverage, GSPoint pill, const uint64_t from[WORDS], const uint64_t to[WORDS]);
+static GSRect pillWindow(GSPoint pill);
+static GSRect growRect(GSRect rect, GSRect by);
+
+GSCoverage *coverageCreate(GSTile tiles[][WIDTH]) {
+  GSCoverage *coverage;
+
+TRY
+  if ((coverage = malloc(sizeof(GSCoverage))) == NULL) LOGFAIL(errno)
+  bzero(coverage, sizeof(GSCoverage));
+  coverage->histogram[0] = WIDTH*WIDTH;
+  buildRays(coverage);
+  coverageUpdateRect(coverage, tiles, kWorldRect);
+
+CLEANUP
+ERRHANDLER(coverage, NULL)
+END
+}
+
+void coverageDestroy(GSCoverage *coverage) {
+  free(coverage);
+}
+
+// pills are matched to the old ones by where they are so a pill that was
+// moved or dropped is the only one recast
+GSRect coverageSetPills(GSCoverage *coverage, const struct BMAP_PillInfo pills[], int npills) {
+  static const uint64_t kNoHits[WORDS] = { 0 };
+  GSPoint points[MAX_PILLS];
+  uint64_t hits[MAX_PILLS][WORDS];
+  int matched[MAX_PILLS];
+  GSRect changed;
+  int i, j;
+
+  assert(npills >= 0 && npills <= MAX_PILLS);
+
+  changed = GSMakeRect(0, 0, 0, 0);
+  bzero(matched, sizeof(matched));
+
+  for (j = 0; j < npills; j++) {
+    points[j] = GSMakePoint(pills[j].x, pills[j].y);
+
+    for (i = 0; i < coverage->npills; i++) {
+      if (!matched[i] && GSEqualPoints(coverage->pills[i], points[j])) {
+        break;
+      }
+    }
+
+    if (i < coverage->npills) {
+      matched[i] = 1;
+      bcopy(coverage->hits[i], hits[j], sizeof(hits[j]));
+    }
+    else {
+      coverageCast(coverage, points[j], hits[j]);
+      applyHits(coverage, points[j], kNoHits, hits[j]);
+      changed = growRect(changed, pillWindow(points[j]));
+    }
+  }
+
+  for (i = 0; i < coverage->npills; i++) {
+    if (!matched[i]) {
+      applyHits(coverage, coverage->pills[i], coverage->hits[i], kNoHits);
+      changed = growRect(changed, pillWindow(coverage->pills[i]));
+    }
+  }
+
+  coverage->npills = npills;
+  bcopy(points, coverage->pills, npills*sizeof(GSPoint));
+  bcopy(hits, coverage->hits, npills*sizeof(hits[0]));
+
+  return changed;
+}
+
+GSRect coverageUpdateRect(GSCoverage *coverage, GSTile tiles[][WIDTH], GSRect rect) {
+  uint64_t hits[WORDS];
+  GSRect changed;
+  int x, y, i, walled;
+
+  rect = GSIntersectionRect(rect, kWorldRect);
+  walled = 0;
+
+  for (y = GSMinY(rect); y <= GSMaxY(rect); y++) {
+    for (x = GSMinX(rect); x <= GSMaxX(rect); x++) {
+      uint64_t bit = UINT64_C(1) << (x%64);
+      uint64_t *word = coverage->walls[y] + x/64;
+      uint64_t old = *word;
+
+      if (tileClass(tiles[y][x]) == kWallClass) {
+        *word |= bit;
+      }
+      else {
+        *word &= ~bit;
+      }
+
+      walled |= old != *word;
+    }
+  }
+
+  changed = GSMakeRect(0, 0, 0, 0);
+
+  if (!walled) {
+    return changed;
+  }
+
+  for (i = 0; i < coverage->npills; i++) {
+    GSRect window = pillWindow(coverage->pills[i]);
+
+    if (GSIntersectsRect(window, rect)) {
+      coverageCast(coverage, coverage->pills[i], hits);
+      applyHits(coverage, coverage->pills[i], coverage->hits[i], hits);
+      bcopy(hits, coverage->hits[i], sizeof(hits));
+      changed = growRect(changed, window);
+    }
+  }
+
+  return changed;
+}
+
+// a target is hit if its ray has no blocker, cells off the map block and
+// are never hit
+void coverageCast(const GSCoverage *coverage, GSPoint pill, uint64_t hits[WORDS]) {
+  uint64_t blockers[WORDS];
+  int row, i, w;
+
+  bzero(blockers, sizeof(blockers));
+
+  for (row = 0; row < SPAN; row++) {
+    uint64_t bits = wallBits(coverage, pill.x - PILL_RANGE, pill.y - PILL_RANGE + row);
+    int at = row*SPAN;
+
+    blockers[at/64] |= bits << (at%64);
+
+    if (at%64 + SPAN > 64) {
+      blockers[at/64 + 1] |= bits >> (64 - at%64);
+    }
+  }
+
+  bzero(hits, WORDS*sizeof(uint64_t));
+
+  for (i = 0; i < coverage->ntargets; i++) {
+    int cell = coverage->targets[i];
+    uint64_t blocked = 0;
+
+    for (w = 0; w < WORDS; w++) {
+      blocked |= coverage->rays[cell][w] & blockers[w];
+    }
+
+    if (!blocked) {
+      hits[cell/64] |= UINT64_C(1) << (cell%64);
+    }
+  }
+
+  if (!GSContainsRect(kWorldRect, pillWindow(pill))) {
+    for (i = 0; i < CELLS; i++) {
+      if (!GSPointInRect(kWorldRect, GSMakePoint(pill.x - PILL_RANGE + i%SPAN, pill.y - PILL_RANGE + i/SPAN))) {
+        hits[i/64] &= ~(UINT64_C(1) << (i%64));
+      }
+    }
+  }
+}
+
+const uint8_t (*coverageGrid(const GSCoverage *coverage))[WIDTH] {
+  return coverage->counts;
+}
+
+void coverageStats(const GSCoverage *coverage, struct GSCoverageStats *stats) {
+  int i;
+
+  bzero(stats, sizeof(struct GSCoverageStats));
+
+  for (i = 1; i <= MAX_PILLS; i++) {
+    if (coverage->histogram[i] > 0) {
+      stats->covered += coverage->histogram[i];
+      stats->overlapped += i >= 2 ? coverage->histogram[i] : 0;
+      stats->most = i;
+    }
+  }
+}
+
+// rays are stepped along their longer axis with the other rounded, half
+// away from the centre, so a ray and its mirror images pass the same cells
+void buildRays(GSCoverage *coverage) {
+  int dx, dy, k, n;
+
+  coverage->ntargets = 0;
+
+  for (dy = -PILL_RANGE; dy <= PILL_RANGE; dy++) {
+    for (dx = -PILL_RANGE; dx <= PILL_RANGE; dx++) {
+      int cell = (dy + PILL_RANGE)*SPAN + dx + PILL_RANGE;
+
+      if ((dx == 0 && dy == 0) || dx*dx + dy*dy > PILL_RANGE*PILL_RANGE) {
+        continue;
+      }
+
+      coverage->targets[coverage->ntargets++] = cell;
+      n = MAX(abs(dx), abs(dy));
+
+      for (k = 1; k < n; k++) {
+        int between = (roundDiv(k*dy, n) + PILL_RANGE)*SPAN + roundDiv(k*dx, n) + PILL_RANGE;
+        coverage->rays[cell][between/64] |= UINT64_C(1) << (between%64);
+      }
+    }
+  }
+}
+
+// a/b rounded half away from zero, b > 0
+int roundDiv(int a, int b) {
+  return a >= 0 ? (2*a + b)/(2*b) : -((-2*a + b)/(2*b));
+}
+
+// SPAN bits of walls from x, y, set off the map
+uint64_t wallBits(const GSCoverage *coverage, int x, int y) {
+  uint64_t bits;
+  int i;
+
+  if (y < 0 || y >= WIDTH) {
+    return SPANMASK;
+  }
+
+  if (x >= 0 && x + SPAN <= WIDTH) {
+    bits = coverage->walls[y][x/64] >> (x%64);
+
+    if (x%64 + SPAN > 64) {
+      bits |= coverage->walls[y][x/64 + 1] << (64 - x%64);
+    }
+
+    return bits & SPANMASK;
+  }
+
+  for (bits = 0, i = 0; i < SPAN; i++) {
+    if (x + i < 0 || x + i >= WIDTH || (coverage->walls[y][(x + i)/64] >> ((x + i)%64) & 1)) {
+      bits |= UINT64_C(1) << i;
+    }
+  }
+
+  return bits;
+}
+
+// moves the counts of the cells of pill's window from from to to
+void applyHits(GSCoverage *coverage, GSPoint pill, const uint64_t from[WORDS], const uint64_t to[WORDS]) {
+  int w;
+
+  for (w = 0; w < WORDS; w++) {
+    uint64_t removed = from[w] & ~to[w];
+    uint64_t added = to[w] & ~from[w];
+
+    for (; removed != 0; removed &= removed - 1) {
+      int cell = w*64 + __builtin_ctzll(removed);
+      uint8_t *count = &coverage->counts[pill.y - PILL_RANGE + cell/SPAN][pill.x - PILL_RANGE + cell%SPAN];
+
+      coverage->histogram[*count]--;
+      coverage->histogram[--*count]++;
+    }
+
+    for (; added != 0; added &= added - 1) {
+      int cell = w*64 + __builtin_ctzll(added);
+      uint8_t *count = &coverage->counts[pill.y - PILL_RANGE + cell/SPAN][pill.x - PILL_RANGE + cell%SPAN];
+
+      coverage->histogram[*count]--;
+      coverage->histogram[++*count]++;
+    }
+  }
+}
+
+GSRect pillWindow(GSPoint pill) {
+  return GSMakeRect(pill.x - PILL_RANGE, pill.y - PILL_RANGE, SPAN, SPAN);
+}
+
+// union of rect and by within the map, either may be empty
+GSRect growRect(GSRect rect, GSRect by) {
+  by = GSIntersectionRect(by, kWorldRect);
+
+  if (GSIsEmptyRect(rect)) {
+    return by;
+  }
+
+  return GSIsEmptyRect(by) ? rect : GSUnionRect(rect, by);
+}
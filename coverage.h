@@ -0,0 +1,55 @@
+//
+//  coverage.h
+//  XBolo Map Editor
+//
+//  Created by Robert Chrzanowski on 10/19/26.
+//  Copyright 2026 Robert Chrzanowski. All rights reserved.
+//
+
+#ifndef __COVERAGE__
+#define __COVERAGE__
+
+#include <stdint.h>
+#include "bmap.h"
+
+
+#define PILL_RANGE      (8)  // tiles a pill fires at
+#define COVERAGE_SPAN   (2*PILL_RANGE + 1)  // tiles per side of a pill's window
+#define COVERAGE_WORDS  ((COVERAGE_SPAN*COVERAGE_SPAN + 63)/64)
+
+// number of pills that can hit each tile, a tile is hit when it is within
+// PILL_RANGE of a pill and no wall is between them.  each pill's hits are
+// kept as a bitboard of the window around it so moving a pill or changing
+// a wall recasts only the pills whose windows it touches
+typedef struct GSCoverage GSCoverage;
+
+// tiles hit by at least one, at least two and the most pills at once
+struct GSCoverageStats {
+  int covered;
+  int overlapped;
+  int most;
+} ;
+
+// create/destroy the coverage of no pills over tiles
+GSCoverage *coverageCreate(GSTile tiles[][WIDTH]);
+void coverageDestroy(GSCoverage *coverage);
+
+// replaces the pills, only pills that moved, came or went are recast.
+// returns the rect of tiles whose counts may have changed
+GSRect coverageSetPills(GSCoverage *coverage, const struct BMAP_PillInfo pills[], int npills);
+
+// rereads the walls of rect after its tiles changed and recasts the pills
+// that see into it if any changed.  returns the rect of tiles whose counts
+// may have changed
+GSRect coverageUpdateRect(GSCoverage *coverage, GSTile tiles[][WIDTH], GSRect rect);
+
+// tiles a pill at pill would hit over the walls of the last update, bit
+// row*COVERAGE_SPAN + column of the window centred on it
+void coverageCast(const GSCoverage *coverage, GSPoint pill, uint64_t hits[COVERAGE_WORDS]);
+
+// pills that hit each tile
+const uint8_t (*coverageGrid(const GSCoverage *coverage))[WIDTH];
+
+void coverageStats(const GSCoverage *coverage, struct GSCoverageStats *stats);
+
+#endif  // __COVERAGE__
@@ -0,0 +1,178 @@
+//
+//  distance.c
+//  XBolo Map Editor
+//
+//  Created by Robert Chrzanowski on 10/19/26.
+//  Copyright 2026 Robert Chrzanowski. All rights reserved.
+//
+
+#include "distance.h"
+#include "errchk.h"
+
+#include <math.h>
+
+
+#define LINE_GRAIN  (16)  // columns of one cache line, so workers do not share lines
+
+struct Transform {
+  GSTile (*tiles)[WIDTH];
+  uint8_t isSource[WIDTH];  // of each tile value
+  int metric;
+  uint32_t (*field)[WIDTH];
+} ;
+
+static void scanColumns(GSPool *pool, void *context, size_t begin, size_t end);
+static void scanRows(GSPool *pool, void *context, size_t begin, size_t end);
+static void euclideanRow(uint32_t row[WIDTH]);
+static void manhattanRow(uint32_t row[WIDTH]);
+
+int distanceTransform(GSPool *pool, GSTile tiles[][WIDTH], unsigned sources, int metric, uint32_t field[][WIDTH]) {
+  struct Transform context;
+  GSTile values[1][WIDTH];
+  int i;
+
+  assert(metric == kEuclideanDistance || metric == kManhattanDistance);
+
+  // a row holding every tile value answers for each value once
+  for (i = 0; i < WIDTH; i++) {
+    values[0][i] = i;
+  }
+
+  for (i = 0; i < WIDTH; i++) {
+    context.isSource[i] = ((sources >> tileClass(i)) & 1) || ((sources & DISTANCE_MINED) && isMinedTile(values, i, 0));
+  }
+
+  context.tiles = tiles;
+  context.metric = metric;
+  context.field = field;
+
+TRY
+  if (pool == NULL) {
+    scanColumns(NULL, &context, 0, WIDTH);
+    scanRows(NULL, &context, 0, WIDTH);
+  }
+  else {
+    // every column must be done before any row starts
+    if (poolSubmit(pool, scanColumns, &context, 0, WIDTH, LINE_GRAIN) == -1) LOGFAIL(errno)
+    poolWait(pool);
+    if (poolSubmit(pool, scanRows, &context, 0, WIDTH, LINE_GRAIN) == -1) LOGFAIL(errno)
+    poolWait(pool);
+  }
+
+CLEANUP
+ERRHANDLER(0, -1)
+END
+}
+
+// distance along each column to the nearest source in it, down then up.
+// the columns of the range are stepped together a row at a time so the
+// tiles are read in order
+void scanColumns(GSPool *pool, void *context, size_t begin, size_t end) {
+  const struct Transform *transform = context;
+  const uint8_t *isSource = transform->isSource;
+  GSTile (*tiles)[WIDTH] = transform->tiles;
+  uint32_t (*field)[WIDTH] = transform->field;
+  size_t x;
+  int y;
+
+  for (x = begin; x < end; x++) {
+    field[0][x] = isSource[tiles[0][x]] ? 0 : DISTANCE_NONE;
+  }
+
+  for (y = 1; y < WIDTH; y++) {
+    for (x = begin; x < end; x++) {
+      uint32_t above = field[y - 1][x];
+      field[y][x] = isSource[tiles[y][x]] ? 0 : above + (above != DISTANCE_NONE);
+    }
+  }
+
+  for (y = WIDTH - 2; y >= 0; y--) {
+    for (x = begin; x < end; x++) {
+      uint32_t below = field[y + 1][x] + (field[y + 1][x] != DISTANCE_NONE);
+      field[y][x] = MIN(field[y][x], below);
+    }
+  }
+}
+
+void scanRows(GSPool *pool, void *context, size_t begin, size_t end) {
+  const struct Transform *transform = context;
+  size_t y;
+
+  for (y = begin; y < end; y++) {
+    if (transform->metric == kEuclideanDistance) {
+      euclideanRow(transform->field[y]);
+    }
+    else {
+      manhattanRow(transform->field[y]);
+    }
+  }
+}
+
+// each column's distance g puts a parabola (x - q)^2 + g^2 over the row, the
+// distance at x is the lowest of them there.  the parabolas on the lower
+// envelope are kept in order with the x each starts to be lowest from, two
+// parabolas cross once so each is added and dropped at most once
+void euclideanRow(uint32_t row[WIDTH]) {
+  int64_t f[WIDTH];
+  int v[WIDTH];          // columns of the parabolas on the envelope
+  double z[WIDTH + 1];   // x each one is lowest from
+  int q, k, x;
+
+  k = -1;
+
+  for (q = 0; q < WIDTH; q++) {
+    if (row[q] == DISTANCE_NONE) {
+      continue;
+    }
+
+    f[q] = (int64_t)row[q]*row[q];
+
+    for (; k >= 0; k--) {
+      int p = v[k];
+      double s = (double)((f[q] + q*q) - (f[p] + p*p))/(2*(q - p));
+
+      if (s > z[k]) {
+        z[++k] = s;
+        break;
+      }
+    }
+
+    if (k < 0) {
+      z[++k] = -HUGE_VAL;
+    }
+
+    v[k] = q;
+  }
+
+  if (k < 0) {
+    return;
+  }
+
+  z[k + 1] = HUGE_VAL;
+
+  for (x = 0, q = 0; x < WIDTH; x++) {
+    while (z[q + 1] < x) {
+      q++;
+    }
+
+    row[x] = (uint32_t)((x - v[q])*(x - v[q]) + f[v[q]]);
+  }
+}
+
+// the nearest source is never more than one step further than the
+// nearest source of a neighbour, left then right
+void manhattanRow(uint32_t row[WIDTH]) {
+  int x;
+
+  for (x = 1; x < WIDTH; x++) {
+    if (row[x - 1] != DISTANCE_NONE && row[x - 1] + 1 < row[x]) {
+      row[x] = row[x - 1] + 1;
+    }
+  }
+
+  for (x = WIDTH - 2; x >= 0; x--) {
+    if (row[x + 1] != DISTANCE_NONE && row[x + 1] + 1 < row[x]) {
+      row[x] = row[x + 1] + 1;
+    }
+  }
+}
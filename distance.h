@@ -0,0 +1,36 @@
+//
+//  distance.h
+//  XBolo Map Editor
+//
+//  Created by Robert Chrzanowski on 10/19/26.
+//  Copyright 2026 Robert Chrzanowski. All rights reserved.
+//
+
+#ifndef __DISTANCE__
+#define __DISTANCE__
+
+#include <stdint.h>
+#include "bmap.h"
+#include "pool.h"
+
+
+#define DISTANCE_MINED  (1 << kTileClassCount)  // mined tiles of any class
+#define DISTANCE_NONE   (UINT32_MAX)            // no source tile on the map
+
+// water a tank needs a boat for
+#define DISTANCE_WATER_CLASSES ((1 << kSeaClass) | (1 << kRiverClass))
+
+enum {
+  kEuclideanDistance,  // squared, so every distance is an exact integer
+  kManhattanDistance
+} ;
+
+// distance from every tile to the nearest tile of the sources, a set of
+// 1 << class bits of tiles.h and DISTANCE_MINED.  each column is scanned for
+// its nearest source, then each row takes the least over the columns, for
+// euclidean distances as the lower envelope of parabolas.  both passes are
+// linear and split over the workers of pool, or run on the calling thread if
+// pool is NULL.  returns -1 if a task can not be submitted
+int distanceTransform(GSPool *pool, GSTile tiles[][WIDTH], unsigned sources, int metric, uint32_t field[][WIDTH]);
+
+#endif  // __DISTANCE__
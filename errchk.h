@@ -71,6 +71,7 @@
 // end of CLEANUP block
 #define END }
 
+// the error trail is per thread, file and function must be static strings
 void pushlineinfo(const char *file, const char *function, size_t line);
 void errchkcleanup();
 void printlineinfo();
@@ -0,0 +1,207 @@
+//
+//  feed.c
+//  XBolo Map Editor
+//
+//  Created by Robert Chrzanowski on 10/19/26.
+//  Copyright 2026 Robert Chrzanowski. All rights reserved.
+//
+
+#include "feed.h"
+#include "errchk.h"
+
+#include <stdlib.h>
+
+
+struct Subscriber {
+  GSFeedFunction function;
+  void *context;
+  unsigned interests;
+  int margin;
+  GSRegion tiles;    // changed tiles not yet handed out
+  unsigned objects;  // changed object kinds not yet handed out
+} ;
+
+struct GSFeed {
+  int count;
+  int next;  // subscriber the next drain starts with
+  struct Subscriber subscribers[MAX_FEED_SUBSCRIBERS];
+} ;
+
+static int isPending(const struct Subscriber *subscriber);
+static int handOut(struct Subscriber *subscriber, int allowance);
+static int cost(const struct Subscriber *subscriber, GSRect rect);
+
+GSFeed *feedCreate(void) {
+  GSFeed *feed;
+
+TRY
+  if ((feed = malloc(sizeof(GSFeed))) == NULL) LOGFAIL(errno)
+  feed->count = 0;
+  feed->next = 0;
+
+CLEANUP
+ERRHANDLER(feed, NULL)
+END
+}
+
+void feedDestroy(GSFeed *feed) {
+  free(feed);
+}
+
+int feedSubscribe(GSFeed *feed, GSFeedFunction function, void *context, unsigned interests, int margin) {
+  struct Subscriber *subscriber;
+
+TRY
+  if (feed->count == MAX_FEED_SUBSCRIBERS) LOGFAIL(ENOSPC)
+
+  subscriber = feed->subscribers + feed->count;
+  subscriber->function = function;
+  subscriber->context = context;
+  subscriber->interests = interests;
+  subscriber->margin = margin;
+  GSEmptyRegion(&subscriber->tiles);
+  subscriber->objects = 0;
+  feed->count++;
+
+CLEANUP
+ERRHANDLER(feed->count - 1, -1)
+END
+}
+
+void feedSetInterests(GSFeed *feed, int subscriber, unsigned interests) {
+  struct Subscriber *s = feed->subscribers + subscriber;
+
+  assert(subscriber >= 0 && subscriber < feed->count);
+
+  s->interests = interests;
+  s->objects &= interests;
+
+  if (!(interests & FEED_TILES)) {
+    GSEmptyRegion(&s->tiles);
+  }
+}
+
+void feedPublishTiles(GSFeed *feed, GSRect rect) {
+  int i;
+
+  rect = GSIntersectionRect(rect, kWorldRect);
+
+  for (i = 0; i < feed->count; i++) {
+    if (feed->subscribers[i].interests & FEED_TILES) {
+      GSRegionAddRect(&feed->subscribers[i].tiles, rect);
+    }
+  }
+}
+
+void feedPublishObjects(GSFeed *feed, unsigned objects) {
+  int i;
+
+  for (i = 0; i < feed->count; i++) {
+    feed->subscribers[i].objects |= objects & feed->subscribers[i].interests;
+  }
+}
+
+int feedIsPending(const GSFeed *feed) {
+  int i;
+
+  for (i = 0; i < feed->count; i++) {
+    if (isPending(feed->subscribers + i)) {
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+int feedDrain(GSFeed *feed, int budget) {
+  int spent, n;
+
+  spent = 0;
+
+  for (n = 0; n < feed->count; n++) {
+    int i = (feed->next + n) % feed->count;
+    int handed = 0;
+
+    while (isPending(feed->subscribers + i)) {
+      // a subscriber that has had its turn goes to the back
+      if (spent > 0 && spent >= budget) {
+        feed->next = handed ? (i + 1) % feed->count : i;
+        return 1;
+      }
+
+      spent += handOut(feed->subscribers + i, spent > 0 ? budget - spent : MAX(budget, 1));
+      handed = 1;
+    }
+  }
+
+  feed->next = 0;
+
+  return 0;
+}
+
+void feedDrainSubscriber(GSFeed *feed, int subscriber) {
+  assert(subscriber >= 0 && subscriber < feed->count);
+
+  while (isPending(feed->subscribers + subscriber)) {
+    handOut(feed->subscribers + subscriber, WIDTH*WIDTH);
+  }
+}
+
+int isPending(const struct Subscriber *subscriber) {
+  return subscriber->objects != 0 || !GSIsEmptyRegion(&subscriber->tiles);
+}
+
+// hands out the objects with the last rect, or a band of its top rows if
+// the whole rect costs more than allowance, and returns the work it cost
+int handOut(struct Subscriber *subscriber, int allowance) {
+  unsigned objects;
+  GSRect rect;
+
+  objects = subscriber->objects;
+  subscriber->objects = 0;
+
+  if (subscriber->margin == FEED_WHOLE_MAP) {
+    rect = GSRegionBounds(&subscriber->tiles);
+    GSEmptyRegion(&subscriber->tiles);
+  }
+  else if (GSIsEmptyRegion(&subscriber->tiles)) {
+    rect = GSMakeRect(0, 0, 0, 0);
+  }
+  else {
+    GSRect *last = subscriber->tiles.rects + subscriber->tiles.count - 1;
+    int rows;
+
+    rect = *last;
+
+    // the rest of a split rect stays where it was, it is still disjoint
+    // from the others
+    for (rows = GSHeight(rect); rows > 1 && cost(subscriber, GSMakeRect(GSMinX(rect), GSMinY(rect), GSWidth(rect), rows)) > allowance; rows /= 2);
+
+    if (rows < GSHeight(rect)) {
+      *last = GSMakeRect(GSMinX(rect), GSMinY(rect) + rows, GSWidth(rect), GSHeight(rect) - rows);
+      rect.size.height = rows;
+    }
+    else {
+      subscriber->tiles.count--;
+    }
+  }
+
+  subscriber->function(subscriber->context, rect, objects);
+
+  return MAX(cost(subscriber, rect), 1);
+}
+
+// tiles reworked for rect, those within margin of it
+int cost(const struct Subscriber *subscriber, GSRect rect) {
+  if (subscriber->margin == FEED_WHOLE_MAP) {
+    return WIDTH*WIDTH;
+  }
+
+  if (GSIsEmptyRect(rect)) {
+    return 0;
+  }
+
+  rect = GSIntersectionRect(GSInsetRect(rect, -subscriber->margin, -subscriber->margin), kWorldRect);
+
+  return GSWidth(rect)*GSHeight(rect);
+}
@@ -0,0 +1,66 @@
+//
+//  feed.h
+//  XBolo Map Editor
+//
+//  Created by Robert Chrzanowski on 10/19/26.
+//  Copyright 2026 Robert Chrzanowski. All rights reserved.
+//
+
+#ifndef __FEED__
+#define __FEED__
+
+#include "bmap.h"
+#include "region.h"
+
+
+#define MAX_FEED_SUBSCRIBERS (8)
+
+// changes a subscriber can be interested in
+#define FEED_TILES    (1 << 0)
+#define FEED_PILLS    (1 << 1)
+#define FEED_BASES    (1 << 2)
+#define FEED_STARTS   (1 << 3)
+#define FEED_OBJECTS  (FEED_PILLS | FEED_BASES | FEED_STARTS)
+
+#define FEED_WHOLE_MAP (-1)  // margin of a subscriber that reworks the whole map
+
+// changes to a map queued for the analyses kept over it.  each subscriber
+// has its own pending tiles, coalesced as a region, and its own pending
+// object kinds, so analyses that fall behind catch up with one update per
+// area rather than one per write
+typedef struct GSFeed GSFeed;
+
+// hands a subscriber the tiles of rect, which may be empty, and the kinds
+// of objects that changed since it was last handed them
+typedef void (*GSFeedFunction)(void *context, GSRect rect, unsigned objects);
+
+// create/destroy a feed with no subscribers
+GSFeed *feedCreate(void);
+void feedDestroy(GSFeed *feed);
+
+// subscribes function to the changes in interests.  margin is how far past
+// a changed tile the analysis reworks, which is what its work is counted in,
+// FEED_WHOLE_MAP hands every pending change at once as their bounds.
+// returns the subscriber or -1 if there are MAX_FEED_SUBSCRIBERS already
+int feedSubscribe(GSFeed *feed, GSFeedFunction function, void *context, unsigned interests, int margin);
+
+// changes what a subscriber hears about, dropping what it no longer wants
+void feedSetInterests(GSFeed *feed, int subscriber, unsigned interests);
+
+void feedPublishTiles(GSFeed *feed, GSRect rect);
+void feedPublishObjects(GSFeed *feed, unsigned objects);
+
+int feedIsPending(const GSFeed *feed);
+
+// hands out pending changes until about budget tiles of work have been
+// done, wide rects are split into bands of rows so no one call goes far
+// over.  the first change is handed out whatever it costs, and a drain
+// starts with the subscriber the last one stopped before, or the one after
+// the subscriber it stopped in, so none is starved.
+// returns non-zero if changes are left
+int feedDrain(GSFeed *feed, int budget);
+
+// hands out all of one subscriber's changes, for reads that must be current
+void feedDrainSubscriber(GSFeed *feed, int subscriber);
+
+#endif  // __FEED__
@@ -0,0 +1,368 @@
+//
+//  hash.c
+//  XBolo Map Editor
+//
+//  Created by Robert Chrzanowski on 10/19/26.
+//  Copyright 2026 Robert Chrzanowski. All rights reserved.
+//
+
+#include "hash.h"
+#include "transform.h"
+#include "errchk.h"
+
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#include <arm_neon.h>
+#endif
+
+
+#define PRIME1 (0x9e3779b185ebca87ULL)
+#define PRIME2 (0xc2b2ae3d27d4eb4fULL)
+#define PRIME3 (0x165667b19e3779f9ULL)
+#define PRIME4 (0x85ebca77c2b2ae63ULL)
+
+#define NKEYS  (16)
+
+// lane keys, stripe s uses kKeys[s % NKEYS] to kKeys[s % NKEYS + 7] so
+// the first 8 are repeated at the end
+static const uint64_t kKeys[NKEYS + 8] = {
+  0xdd5dcfe549ac1af4ULL, 0xeb96ebc66f9da6a6ULL, 0xdd9b61c08d5f0963ULL, 0x12dce6c02c62d532ULL,
+  0xe34a96ff169716d3ULL, 0xa8a5c38861a00f9eULL, 0x6142ab6d732c2a7dULL, 0x2f6821d997ec75afULL,
+  0xd00baea80e67877eULL, 0xa34b02aff7c3eae6ULL, 0xdc7cdf9d413b7281ULL, 0x0113f11a59c103b7ULL,
+  0xc08c1847a51c9d5cULL, 0x506bb71ea9e07076ULL, 0xa0bc18071359bf26ULL, 0x4a9078f7f5938f58ULL,
+  0xdd5dcfe549ac1af4ULL, 0xeb96ebc66f9da6a6ULL, 0xdd9b61c08d5f0963ULL, 0x12dce6c02c62d532ULL,
+  0xe34a96ff169716d3ULL, 0xa8a5c38861a00f9eULL, 0x6142ab6d732c2a7dULL, 0x2f6821d997ec75afULL,
+};
+
+static const uint64_t kInit[8] = {
+  PRIME3, PRIME1, PRIME2, PRIME4, PRIME3 ^ PRIME1, PRIME2 ^ PRIME4, PRIME1 + PRIME2, PRIME3 + PRIME4,
+};
+
+// a copy of a map's objects that can be sorted and transformed
+struct Objects {
+  int npills;
+  int nbases;
+  int nstarts;
+  struct BMAP_PillInfo pills[MAX_PILLS];
+  struct BMAP_BaseInfo bases[MAX_BASES];
+  struct BMAP_StartInfo starts[MAX_STARTS];
+} ;
+
+static void accumulate(uint64_t acc[8], const void *data, size_t nstripes);
+static uint64_t mergeLanes(const uint64_t acc[8], size_t nbytes);
+static uint64_t rotl64(uint64_t x, int r);
+static uint64_t mix(uint64_t acc, uint64_t x);
+static uint64_t avalanche(uint64_t h);
+
+static uint64_t hashTiles(GSTile tiles[][WIDTH]);
+static uint64_t hashObjects(const struct Objects *objects);
+static void copyObjects(struct Objects *objects, const struct BMAP_Preamble *preamble, const struct BMAP_PillInfo pills[],
+                        const struct BMAP_BaseInfo bases[], const struct BMAP_StartInfo starts[]);
+static void rotateObjectsLeft(struct Objects *objects);
+static void flipObjectsHorizontal(struct Objects *objects);
+static int comparePills(const void *a, const void *b);
+static int compareBases(const void *a, const void *b);
+static int compareStarts(const void *a, const void *b);
+
+uint64_t hashStripes(const void *data, size_t nbytes) {
+  uint64_t acc[8];
+
+  assert(nbytes % HASH_STRIPE == 0);
+
+  bcopy(kInit, acc, sizeof(acc));
+  accumulate(acc, data, nbytes/HASH_STRIPE);
+
+  return mergeLanes(acc, nbytes);
+}
+
+void hashRows(GSTile tiles[][WIDTH], uint64_t hashes[WIDTH]) {
+  int y;
+
+  for (y = 0; y < WIDTH; y++) {
+    hashes[y] = hashStripes(tiles[y], WIDTH*sizeof(GSTile));
+  }
+}
+
+uint64_t hashMap(const struct BMAP_Preamble *preamble, const struct BMAP_PillInfo pills[],
+                 const struct BMAP_BaseInfo bases[], const struct BMAP_StartInfo starts[],
+                 GSTile tiles[][WIDTH]) {
+  struct Objects objects;
+
+  copyObjects(&objects, preamble, pills, bases, starts);
+
+  return avalanche(mix(hashTiles(tiles), hashObjects(&objects)));
+}
+
+int hashMapDihedral(const struct BMAP_Preamble *preamble, const struct BMAP_PillInfo pills[],
+                    const struct BMAP_BaseInfo bases[], const struct BMAP_StartInfo starts[],
+                    GSTile tiles[][WIDTH], uint64_t *hash) {
+  struct Objects objects;
+  GSTile (*t)[WIDTH];
+  uint64_t h;
+  int flip, rotation;
+
+  t = NULL;
+
+TRY
+  if ((t = malloc(WIDTH*WIDTH*sizeof(GSTile))) == NULL) LOGFAIL(errno)
+  bcopy(tiles, t, WIDTH*WIDTH*sizeof(GSTile));
+  copyObjects(&objects, preamble, pills, bases, starts);
+  *hash = UINT64_MAX;
+
+  // four turns of the map and then four turns of its mirror image
+  for (flip = 0; flip < 2; flip++) {
+    for (rotation = 0; rotation < 4; rotation++) {
+      h = avalanche(mix(hashTiles(t), hashObjects(&objects)));
+      *hash = MIN(*hash, h);
+      rotateSquareTilesLeft(&t[0][0], WIDTH);
+      rotateObjectsLeft(&objects);
+    }
+
+    flipTilesHorizontal(&t[0][0], WIDTH, WIDTH);
+    flipObjectsHorizontal(&objects);
+  }
+
+CLEANUP
+  free(t);
+
+ERRHANDLER(0, -1)
+END
+}
+
+// the tile hash is a hash of the row hashes so that rows can be compared on their own
+uint64_t hashTiles(GSTile tiles[][WIDTH]) {
+  uint64_t rows[WIDTH];
+
+  hashRows(tiles, rows);
+
+  return hashStripes(rows, sizeof(rows));
+}
+
+// the counts and the sorted objects are packed into stripes padded with zeros
+uint64_t hashObjects(const struct Objects *objects) {
+  struct Objects sorted;
+  uint8_t buf[3 + sizeof(sorted.pills) + sizeof(sorted.bases) + sizeof(sorted.starts) + HASH_STRIPE];
+  size_t len;
+
+  sorted = *objects;
+  qsort(sorted.pills, sorted.npills, sizeof(struct BMAP_PillInfo), comparePills);
+  qsort(sorted.bases, sorted.nbases, sizeof(struct BMAP_BaseInfo), compareBases);
+  qsort(sorted.starts, sorted.nstarts, sizeof(struct BMAP_StartInfo), compareStarts);
+
+  bzero(buf, sizeof(buf));
+  buf[0] = sorted.npills;
+  buf[1] = sorted.nbases;
+  buf[2] = sorted.nstarts;
+  len = 3;
+  bcopy(sorted.pills, buf + len, sorted.npills*sizeof(struct BMAP_PillInfo));
+  len += sorted.npills*sizeof(struct BMAP_PillInfo);
+  bcopy(sorted.bases, buf + len, sorted.nbases*sizeof(struct BMAP_BaseInfo));
+  len += sorted.nbases*sizeof(struct BMAP_BaseInfo);
+  bcopy(sorted.starts, buf + len, sorted.nstarts*sizeof(struct BMAP_StartInfo));
+  len += sorted.nstarts*sizeof(struct BMAP_StartInfo);
+
+  return hashStripes(buf, (len + HASH_STRIPE - 1)/HASH_STRIPE*HASH_STRIPE);
+}
+
+void copyObjects(struct Objects *objects, const struct BMAP_Preamble *preamble, const struct BMAP_PillInfo pills[],
+                 const struct BMAP_BaseInfo bases[], const struct BMAP_StartInfo starts[]) {
+  objects->npills = MIN(preamble->npills, MAX_PILLS);
+  objects->nbases = MIN(preamble->nbases, MAX_BASES);
+  objects->nstarts = MIN(preamble->nstarts, MAX_STARTS);
+  bcopy(pills, objects->pills, objects->npills*sizeof(struct BMAP_PillInfo));
+  bcopy(bases, objects->bases, objects->nbases*sizeof(struct BMAP_BaseInfo));
+  bcopy(starts, objects->starts, objects->nstarts*sizeof(struct BMAP_StartInfo));
+}
+
+// matches rotateSquareTilesLeft() and -[GSXBoloMap rotateLeftObjectsInRect:]
+void rotateObjectsLeft(struct Objects *objects) {
+  int i;
+  uint8_t x;
+
+  for (i = 0; i < objects->npills; i++) {
+    x = objects->pills[i].x;
+    objects->pills[i].x = objects->pills[i].y;
+    objects->pills[i].y = WIDTH - 1 - x;
+  }
+
+  for (i = 0; i < objects->nbases; i++) {
+    x = objects->bases[i].x;
+    objects->bases[i].x = objects->bases[i].y;
+    objects->bases[i].y = WIDTH - 1 - x;
+  }
+
+  for (i = 0; i < objects->nstarts; i++) {
+    x = objects->starts[i].x;
+    objects->starts[i].x = objects->starts[i].y;
+    objects->starts[i].y = WIDTH - 1 - x;
+    objects->starts[i].dir = (objects->starts[i].dir + 4) % 16;
+  }
+}
+
+// matches flipTilesHorizontal() and -[GSXBoloMap flipHorizontalObjectsInRect:]
+void flipObjectsHorizontal(struct Objects *objects) {
+  int i;
+
+  for (i = 0; i < objects->npills; i++) {
+    objects->pills[i].x = WIDTH - 1 - objects->pills[i].x;
+  }
+
+  for (i = 0; i < objects->nbases; i++) {
+    objects->bases[i].x = WIDTH - 1 - objects->bases[i].x;
+  }
+
+  for (i = 0; i < objects->nstarts; i++) {
+    objects->starts[i].x = WIDTH - 1 - objects->starts[i].x;
+    objects->starts[i].dir = (24 - objects->starts[i].dir) % 16;
+  }
+}
+
+// objects sort by row, then column, then the rest of their fields
+int comparePills(const void *a, const void *b) {
+  const struct BMAP_PillInfo *p = a, *q = b;
+
+  if (p->y != q->y) {
+    return p->y - q->y;
+  }
+
+  return memcmp(p, q, sizeof(struct BMAP_PillInfo));
+}
+
+int compareBases(const void *a, const void *b) {
+  const struct BMAP_BaseInfo *p = a, *q = b;
+
+  if (p->y != q->y) {
+    return p->y - q->y;
+  }
+
+  return memcmp(p, q, sizeof(struct BMAP_BaseInfo));
+}
+
+int compareStarts(const void *a, const void *b) {
+  const struct BMAP_StartInfo *p = a, *q = b;
+
+  if (p->y != q->y) {
+    return p->y - q->y;
+  }
+
+  return memcmp(p, q, sizeof(struct BMAP_StartInfo));
+}
+
+// each 64 bit lane i of a stripe adds the lane's data to lane i^1 and the
+// product of the low and high halves of the data xor the key to itself
+#if defined(__SSE2__)
+
+void accumulate(uint64_t acc[8], const void *data, size_t nstripes) {
+  __m128i a[4];
+  size_t s;
+  int j;
+
+  for (j = 0; j < 4; j++) {
+    a[j] = _mm_loadu_si128((const __m128i *)acc + j);
+  }
+
+  for (s = 0; s < nstripes; s++) {
+    const __m128i *d = (const __m128i *)(data + s*HASH_STRIPE);
+    const __m128i *k = (const __m128i *)(kKeys + (s % NKEYS));
+
+    for (j = 0; j < 4; j++) {
+      __m128i v = _mm_loadu_si128(d + j);
+      __m128i vk = _mm_xor_si128(v, _mm_loadu_si128(k + j));
+      __m128i product = _mm_mul_epu32(vk, _mm_shuffle_epi32(vk, 0xb1));  // lo*hi of each lane
+      a[j] = _mm_add_epi64(a[j], _mm_add_epi64(product, _mm_shuffle_epi32(v, 0x4e)));
+    }
+  }
+
+  for (j = 0; j < 4; j++) {
+    _mm_storeu_si128((__m128i *)acc + j, a[j]);
+  }
+}
+
+#elif defined(__ARM_NEON) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+
+void accumulate(uint64_t acc[8], const void *data, size_t nstripes) {
+  uint64x2_t a[4];
+  size_t s;
+  int j;
+
+  for (j = 0; j < 4; j++) {
+    a[j] = vld1q_u64(acc + 2*j);
+  }
+
+  for (s = 0; s < nstripes; s++) {
+    const uint8_t *d = data + s*HASH_STRIPE;
+    const uint64_t *k = kKeys + (s % NKEYS);
+
+    for (j = 0; j < 4; j++) {
+      uint64x2_t v = vreinterpretq_u64_u8(vld1q_u8(d + 16*j));
+      uint64x2_t vk = veorq_u64(v, vld1q_u64(k + 2*j));
+      a[j] = vaddq_u64(a[j], vextq_u64(v, v, 1));
+      a[j] = vmlal_u32(a[j], vmovn_u64(vk), vshrn_n_u64(vk, 32));
+    }
+  }
+
+  for (j = 0; j < 4; j++) {
+    vst1q_u64(acc + 2*j, a[j]);
+  }
+}
+
+#else
+
+void accumulate(uint64_t acc[8], const void *data, size_t nstripes) {
+  size_t s;
+  int i;
+
+  for (s = 0; s < nstripes; s++) {
+    const uint8_t *d = data + s*HASH_STRIPE;
+    const uint64_t *k = kKeys + (s % NKEYS);
+
+    for (i = 0; i < 8; i++) {
+      uint64_t v;
+
+      memcpy(&v, d + 8*i, sizeof(v));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+      v = __builtin_bswap64(v);
+#endif
+      acc[i ^ 1] += v;
+      v ^= k[i];
+      acc[i] += (v & 0xffffffffULL)*(v >> 32);
+    }
+  }
+}
+
+#endif
+
+uint64_t mergeLanes(const uint64_t acc[8], size_t nbytes) {
+  uint64_t h;
+  int i;
+
+  h = nbytes*PRIME1;
+
+  for (i = 0; i < 8; i++) {
+    h = mix(h, acc[i]);
+  }
+
+  return avalanche(h);
+}
+
+uint64_t rotl64(uint64_t x, int r) {
+  return (x << r) | (x >> (64 - r));
+}
+
+// folds x into acc like an xxHash64 merge round
+uint64_t mix(uint64_t acc, uint64_t x) {
+  x = rotl64(x*PRIME2, 31)*PRIME1;
+  return rotl64(acc ^ x, 27)*PRIME1 + PRIME4;
+}
+
+uint64_t avalanche(uint64_t h) {
+  h ^= h >> 33;
+  h *= PRIME2;
+  h ^= h >> 29;
+  h *= PRIME3;
+  h ^= h >> 32;
+  return h;
+}
@@ -0,0 +1,40 @@
+//
+//  hash.h
+//  XBolo Map Editor
+//
+//  Created by Robert Chrzanowski on 10/19/26.
+//  Copyright 2026 Robert Chrzanowski. All rights reserved.
+//
+
+#ifndef __HASH__
+#define __HASH__
+
+#include <stddef.h>
+#include <stdint.h>
+#include "bmap.h"
+
+
+#define HASH_STRIPE (64)  // bytes hashed per step of hashStripes()
+
+// hashes nbytes of data, a multiple of HASH_STRIPE, eight 64 bit lanes at a
+// time with one 32x32 bit multiply per lane so SSE2 and NEON do a stripe in
+// a handful of instructions, the hash is the same on every host
+uint64_t hashStripes(const void *data, size_t nbytes);
+
+// hashes each row of tiles, equal rows hash equally wherever they are
+void hashRows(GSTile tiles[][WIDTH], uint64_t hashes[WIDTH]);
+
+// hash of the decoded tiles and objects, objects are sorted by position so
+// maps that differ only in their encoding or the order of their objects
+// hash the same
+uint64_t hashMap(const struct BMAP_Preamble *preamble, const struct BMAP_PillInfo pills[],
+                 const struct BMAP_BaseInfo bases[], const struct BMAP_StartInfo starts[],
+                 GSTile tiles[][WIDTH]);
+
+// smallest hashMap() of the 8 rotations and mirrors of the map, so maps
+// that are the same up to rotating or flipping hash the same
+int hashMapDihedral(const struct BMAP_Preamble *preamble, const struct BMAP_PillInfo pills[],
+                    const struct BMAP_BaseInfo bases[], const struct BMAP_StartInfo starts[],
+                    GSTile tiles[][WIDTH], uint64_t *hash);
+
+#endif  // __HASH__
@@ -0,0 +1,489 @@
+//
+//  journal.c
+//  XBolo Map Editor
+//
+//  Created by Robert Chrzanowski on 10/19/26.
+//  Copyright 2026 Robert Chrzanowski. All rights reserved.
+//
+
+#include "journal.h"
+#include "errchk.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+
+// an entry is the xor of the before and after state of the tiles in rect
+// and of the object tables, both run-length encoded as alternating runs of
+// unchanged bytes and literal changed bytes
+struct GSJournalEntry {
+  struct GSJournalEntry *prev;
+  struct GSJournalEntry *next;
+  GSRect rect;
+  size_t tilesLen;
+  size_t objectsLen;
+  uint8_t *data;  // NULL when spilled
+  long offset;    // offset in the spill file
+} ;
+
+struct GSJournal {
+  size_t budget;
+  size_t resident;
+  int open;
+
+  // every entry, oldest first
+  struct GSJournalEntry *first;
+  struct GSJournalEntry *last;
+
+  // entries older than this have been spilled
+  struct GSJournalEntry *oldestResident;
+
+  FILE *spill;
+  long spillSize;  // end of the spilled data
+  long spillDead;  // bytes of it belonging to discarded entries
+
+  // accumulated xor of the open entry
+  GSRect dirty;
+  GSTile delta[WIDTH][WIDTH];
+  struct GSObjectTables objects;
+
+  // scratch space for encoding and decoding
+  uint8_t gathered[WIDTH*WIDTH];
+  uint8_t buf[(WIDTH*WIDTH + sizeof(struct GSObjectTables))*2];
+} ;
+
+static size_t entrySize(const struct GSJournalEntry *entry);
+static void spillEntries(GSJournal *journal);
+static void compactSpill(GSJournal *journal);
+static size_t encodeDelta(const uint8_t *delta, size_t len, uint8_t *out);
+static int decodeDelta(const uint8_t *data, size_t dataLen, uint8_t *delta, size_t len);
+static size_t writeVarint(uint8_t *out, size_t value);
+static size_t readVarint(const uint8_t *data, size_t dataLen, size_t *value);
+
+GSJournal *journalCreate(size_t budget) {
+  GSJournal *journal;
+
+TRY
+  if ((journal = (GSJournal *)malloc(sizeof(GSJournal))) == NULL) LOGFAIL(errno)
+
+  journal->budget = budget;
+  journal->resident = 0;
+  journal->open = 0;
+  journal->first = NULL;
+  journal->last = NULL;
+  journal->oldestResident = NULL;
+  journal->spill = NULL;
+  journal->spillSize = 0;
+  journal->spillDead = 0;
+  journal->dirty = GSMakeRect(0, 0, 0, 0);
+  bzero(journal->delta, sizeof(journal->delta));
+
+CLEANUP
+ERRHANDLER(journal, NULL)
+END
+}
+
+void journalDestroy(GSJournal *journal) {
+  struct GSJournalEntry *entry;
+
+  if (journal == NULL) {
+    return;
+  }
+
+  while ((entry = journal->first) != NULL) {
+    journal->first = entry->next;
+
+    if (entry->data != NULL) {
+      free(entry->data);
+    }
+
+    free(entry);
+  }
+
+  if (journal->spill != NULL) {
+    fclose(journal->spill);
+  }
+
+  free(journal);
+}
+
+void journalSetBudget(GSJournal *journal, size_t budget) {
+  journal->budget = budget;
+  spillEntries(journal);
+}
+
+size_t journalBudget(const GSJournal *journal) {
+  return journal->budget;
+}
+
+size_t journalResidentSize(const GSJournal *journal) {
+  return journal->resident;
+}
+
+int journalBegin(GSJournal *journal, const struct GSObjectTables *objects) {
+  assert(!journal->open);
+
+  journal->open = 1;
+  journal->dirty = GSMakeRect(0, 0, 0, 0);
+  bcopy(objects, &journal->objects, sizeof(struct GSObjectTables));
+
+  return 0;
+}
+
+int journalIsOpen(const GSJournal *journal) {
+  return journal->open;
+}
+
+void journalRecordTile(GSJournal *journal, GSPoint point, GSTile from, GSTile to) {
+  assert(journal->open);
+
+  if (from != to) {
+    journal->delta[point.y][point.x] ^= from ^ to;
+    journal->dirty = GSIsEmptyRect(journal->dirty) ? GSMakeRect(point.x, point.y, 1, 1) : GSUnionRect(journal->dirty, GSMakeRect(point.x, point.y, 1, 1));
+  }
+}
+
+void journalRecordRect(GSJournal *journal, GSRect rect, GSTile tiles[][WIDTH], const GSTile *aTiles) {
+  int x, y;
+
+  assert(journal->open);
+
+  if (GSIsEmptyRect(rect)) {
+    return;
+  }
+
+  for (y = 0; y < GSHeight(rect); y++) {
+    GSTile *delta = journal->delta[GSMinY(rect) + y] + GSMinX(rect);
+    const GSTile *from = tiles[GSMinY(rect) + y] + GSMinX(rect);
+    const GSTile *to = aTiles + (y * GSWidth(rect));
+
+    for (x = 0; x < GSWidth(rect); x++) {
+      delta[x] ^= from[x] ^ to[x];
+    }
+  }
+
+  journal->dirty = GSIsEmptyRect(journal->dirty) ? rect : GSUnionRect(journal->dirty, rect);
+}
+
+int journalCommit(GSJournal *journal, const struct GSObjectTables *objects, GSJournalEntry **entry) {
+  struct GSJournalEntry *newEntry;
+  uint8_t objectDelta[sizeof(struct GSObjectTables)];
+  uint8_t *delta;
+  size_t i, len;
+  int y, changed;
+
+  assert(journal->open);
+
+  newEntry = NULL;
+  *entry = NULL;
+  journal->open = 0;
+
+TRY
+  // gather the changed rect into a contiguous buffer, clearing it behind us
+  delta = journal->gathered;
+  len = GSWidth(journal->dirty) * GSHeight(journal->dirty);
+  changed = 0;
+
+  for (y = 0; y < GSHeight(journal->dirty); y++) {
+    GSTile *row = journal->delta[GSMinY(journal->dirty) + y] + GSMinX(journal->dirty);
+    bcopy(row, delta + (y * GSWidth(journal->dirty)), GSWidth(journal->dirty));
+    bzero(row, GSWidth(journal->dirty));
+  }
+
+  // a tile changed and changed back cancels out
+  for (i = 0; i < len && !changed; i++) {
+    changed = delta[i] != 0;
+  }
+
+  if (!changed) {
+    len = 0;
+    journal->dirty = GSMakeRect(0, 0, 0, 0);
+  }
+
+  for (i = 0; i < sizeof(struct GSObjectTables); i++) {
+    objectDelta[i] = ((const uint8_t *)objects)[i] ^ ((const uint8_t *)&journal->objects)[i];
+    changed = changed || objectDelta[i] != 0;
+  }
+
+  if (!changed) SUCCESS
+
+  if ((newEntry = (struct GSJournalEntry *)malloc(sizeof(struct GSJournalEntry))) == NULL) LOGFAIL(errno)
+
+  newEntry->rect = journal->dirty;
+  newEntry->offset = -1;
+  newEntry->tilesLen = encodeDelta(delta, len, journal->buf);
+  newEntry->objectsLen = encodeDelta(objectDelta, sizeof(objectDelta), journal->buf + newEntry->tilesLen);
+
+  if ((newEntry->data = (uint8_t *)malloc(newEntry->tilesLen + newEntry->objectsLen)) == NULL) LOGFAIL(errno)
+  bcopy(journal->buf, newEntry->data, newEntry->tilesLen + newEntry->objectsLen);
+
+  // append to history
+  newEntry->next = NULL;
+  newEntry->prev = journal->last;
+
+  if (journal->last != NULL) {
+    journal->last->next = newEntry;
+  }
+  else {
+    journal->first = newEntry;
+  }
+
+  journal->last = newEntry;
+
+  if (journal->oldestResident == NULL) {
+    journal->oldestResident = newEntry;
+  }
+
+  journal->resident += entrySize(newEntry);
+  *entry = newEntry;
+  newEntry = NULL;
+
+  spillEntries(journal);
+
+CLEANUP
+  if (newEntry != NULL) {
+    free(newEntry);
+  }
+
+ERRHANDLER(0, -1)
+END
+}
+
+int journalApply(GSJournal *journal, GSJournalEntry *entry, GSTile tiles[][WIDTH], struct GSObjectTables *objects) {
+  const uint8_t *data;
+  uint8_t *delta;
+  uint8_t objectDelta[sizeof(struct GSObjectTables)];
+  size_t i;
+  int x, y;
+
+  assert(!journal->open);
+
+TRY
+  if (entry->data != NULL) {
+    data = entry->data;
+  }
+  else {
+    // read back from the spill file
+    if (fseek(journal->spill, entry->offset, SEEK_SET) == -1) LOGFAIL(errno)
+    if (fread(journal->buf, entrySize(entry), 1, journal->spill) != 1) LOGFAIL(ferror(journal->spill) ? errno : ECORFILE)
+    data = journal->buf;
+  }
+
+  delta = journal->gathered;
+
+  if (decodeDelta(data, entry->tilesLen, delta, GSWidth(entry->rect) * GSHeight(entry->rect)) == -1) LOGFAIL(errno)
+  if (decodeDelta(data + entry->tilesLen, entry->objectsLen, objectDelta, sizeof(objectDelta)) == -1) LOGFAIL(errno)
+
+  for (y = 0; y < GSHeight(entry->rect); y++) {
+    GSTile *row = tiles[GSMinY(entry->rect) + y] + GSMinX(entry->rect);
+
+    for (x = 0; x < GSWidth(entry->rect); x++) {
+      row[x] ^= delta[(y * GSWidth(entry->rect)) + x];
+    }
+  }
+
+  for (i = 0; i < sizeof(struct GSObjectTables); i++) {
+    ((uint8_t *)objects)[i] ^= objectDelta[i];
+  }
+
+CLEANUP
+ERRHANDLER(0, -1)
+END
+}
+
+void journalDiscard(GSJournal *journal, GSJournalEntry *entry) {
+  if (entry->prev != NULL) {
+    entry->prev->next = entry->next;
+  }
+  else {
+    journal->first = entry->next;
+  }
+
+  if (entry->next != NULL) {
+    entry->next->prev = entry->prev;
+  }
+  else {
+    journal->last = entry->prev;
+  }
+
+  if (journal->oldestResident == entry) {
+    journal->oldestResident = entry->next;
+  }
+
+  if (entry->data != NULL) {
+    journal->resident -= entrySize(entry);
+    free(entry->data);
+  }
+  else {
+    journal->spillDead += entrySize(entry);
+
+    if (journal->spillDead > journal->spillSize/2) {
+      compactSpill(journal);
+    }
+  }
+
+  free(entry);
+}
+
+GSRect journalEntryRect(const GSJournalEntry *entry) {
+  return entry->rect;
+}
+
+// bytes of encoded data, headers are not counted since every entry keeps
+// its header in memory wherever its data is
+size_t entrySize(const struct GSJournalEntry *entry) {
+  return entry->tilesLen + entry->objectsLen;
+}
+
+// moves the oldest entries to disk until the resident size fits the budget,
+// the newest entry always stays in memory
+void spillEntries(GSJournal *journal) {
+  while (journal->resident > journal->budget && journal->oldestResident != NULL && journal->oldestResident != journal->last) {
+    struct GSJournalEntry *entry = journal->oldestResident;
+    long offset;
+
+    if (journal->spill == NULL && (journal->spill = tmpfile()) == NULL) {
+      return;
+    }
+
+    offset = journal->spillSize;
+
+    if (fseek(journal->spill, offset, SEEK_SET) == -1 || fwrite(entry->data, entrySize(entry), 1, journal->spill) != 1) {
+      return;
+    }
+
+    journal->spillSize += entrySize(entry);
+    journal->resident -= entrySize(entry);
+    free(entry->data);
+    entry->data = NULL;
+    entry->offset = offset;
+    journal->oldestResident = entry->next;
+  }
+}
+
+// moves the data of the spilled entries, which are the oldest and in order
+// in the file, down over the gaps left by discarded entries.  an entry is
+// only ever moved towards the start so it never overwrites one not yet moved
+void compactSpill(GSJournal *journal) {
+  struct GSJournalEntry *entry;
+  long end;
+
+  end = 0;
+
+  for (entry = journal->first; entry != NULL && entry != journal->oldestResident; entry = entry->next) {
+    if (entry->offset != end) {
+      if (fseek(journal->spill, entry->offset, SEEK_SET) == -1 || fread(journal->buf, entrySize(entry), 1, journal->spill) != 1) {
+        return;
+      }
+
+      if (fseek(journal->spill, end, SEEK_SET) == -1 || fwrite(journal->buf, entrySize(entry), 1, journal->spill) != 1) {
+        return;
+      }
+
+      entry->offset = end;
+    }
+
+    end += entrySize(entry);
+  }
+
+  if (fflush(journal->spill) == EOF || ftruncate(fileno(journal->spill), end) == -1) {
+    return;
+  }
+
+  journal->spillSize = end;
+  journal->spillDead = 0;
+}
+
+// encodes delta as pairs of (unchanged count, changed count, changed bytes)
+size_t encodeDelta(const uint8_t *delta, size_t len, uint8_t *out) {
+  size_t i, j, n;
+
+  i = 0;
+  n = 0;
+
+  while (i < len) {
+    j = i;
+
+    while (j < len && delta[j] == 0) {
+      j++;
+    }
+
+    if (j == len) {
+      break;  // trailing zeros are implied
+    }
+
+    n += writeVarint(out + n, j - i);
+    i = j;
+
+    // a single zero between changes is cheaper to keep as a literal
+    while (j < len && (delta[j] != 0 || (j + 1 < len && delta[j + 1] != 0))) {
+      j++;
+    }
+
+    n += writeVarint(out + n, j - i);
+    bcopy(delta + i, out + n, j - i);
+    n += j - i;
+    i = j;
+  }
+
+  return n;
+}
+
+int decodeDelta(const uint8_t *data, size_t dataLen, uint8_t *delta, size_t len) {
+  size_t i, n, r, skip, count;
+
+TRY
+  bzero(delta, len);
+  i = 0;
+  n = 0;
+
+  while (n < dataLen) {
+    if ((r = readVarint(data + n, dataLen - n, &skip)) == 0) LOGFAIL(ECORFILE)
+    n += r;
+    if ((r = readVarint(data + n, dataLen - n, &count)) == 0) LOGFAIL(ECORFILE)
+    n += r;
+
+    if (i + skip + count > len || n + count > dataLen) LOGFAIL(ECORFILE)
+
+    i += skip;
+    bcopy(data + n, delta + i, count);
+    i += count;
+    n += count;
+  }
+
+CLEANUP
+ERRHANDLER(0, -1)
+END
+}
+
+size_t writeVarint(uint8_t *out, size_t value) {
+  size_t n;
+
+  for (n = 0; value >= 0x80; n++) {
+    out[n] = (value & 0x7f) | 0x80;
+    value >>= 7;
+  }
+
+  out[n++] = value;
+
+  return n;
+}
+
+size_t readVarint(const uint8_t *data, size_t dataLen, size_t *value) {
+  size_t n;
+  int shift;
+
+  *value = 0;
+
+  for (n = 0, shift = 0; n < dataLen && shift < 32; n++, shift += 7) {
+    *value |= (size_t)(data[n] & 0x7f) << shift;
+
+    if (!(data[n] & 0x80)) {
+      return n + 1;
+    }
+  }
+
+  return 0;
+}
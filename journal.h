@@ -0,0 +1,57 @@
+//
+//  journal.h
+//  XBolo Map Editor
+//
+//  Created by Robert Chrzanowski on 10/19/26.
+//  Copyright 2026 Robert Chrzanowski. All rights reserved.
+//
+
+#ifndef __JOURNAL__
+#define __JOURNAL__
+
+#include "bmap.h"
+
+
+#define DEFAULT_JOURNAL_BUDGET  (4*1024*1024)  // bytes of undo history kept in memory
+
+// a snapshot of the object tables of a map
+struct GSObjectTables {
+  struct BMAP_Preamble preamble;
+  struct BMAP_PillInfo pills[MAX_PILLS];
+  struct BMAP_BaseInfo bases[MAX_BASES];
+  struct BMAP_StartInfo starts[MAX_STARTS];
+} __attribute__((__packed__));
+
+typedef struct GSJournal GSJournal;
+typedef struct GSJournalEntry GSJournalEntry;
+
+// create/destroy a journal, budget is the number of bytes of entry data kept
+// in memory, older entries past it are spilled to a temporary file
+GSJournal *journalCreate(size_t budget);
+void journalDestroy(GSJournal *journal);
+
+void journalSetBudget(GSJournal *journal, size_t budget);
+size_t journalBudget(const GSJournal *journal);
+size_t journalResidentSize(const GSJournal *journal);
+
+// opens an entry, changes are recorded until the entry is committed
+int journalBegin(GSJournal *journal, const struct GSObjectTables *objects);
+int journalIsOpen(const GSJournal *journal);
+
+// records a changed tile or the change of a rect of tiles, aTiles has a stride of GSWidth(rect)
+void journalRecordTile(GSJournal *journal, GSPoint point, GSTile from, GSTile to);
+void journalRecordRect(GSJournal *journal, GSRect rect, GSTile tiles[][WIDTH], const GSTile *aTiles);
+
+// closes the open entry, *entry is set to NULL if nothing changed
+int journalCommit(GSJournal *journal, const struct GSObjectTables *objects, GSJournalEntry **entry);
+
+// applies an entry to a map, applying it again reverts it
+int journalApply(GSJournal *journal, GSJournalEntry *entry, GSTile tiles[][WIDTH], struct GSObjectTables *objects);
+
+// frees an entry no longer reachable by undo or redo, the spill file is
+// compacted once most of it is discarded entries
+void journalDiscard(GSJournal *journal, GSJournalEntry *entry);
+
+GSRect journalEntryRect(const GSJournalEntry *entry);
+
+#endif  // __JOURNAL__
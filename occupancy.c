@@ -0,0 +1,251 @@
+//
+//  occupancy.c
+//  XBolo Map Editor
+//
+//  Created by Robert Chrzanowski on 10/19/26.
+//  Copyright 2026 Robert Chrzanowski. All rights reserved.
+//
+
+#include "occupancy.h"
+#include "errchk.h"
+
+#include <stdlib.h>
+#include <strings.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+
+#define BLOCK  (16)   // tiles compared at once by scanRow
+#define CHUNK  (255)  // rows whose column counts fit in a byte
+
+// counts per index of one axis, min and max are the first and last
+// occupied indexes unless stale, which is set when one of them empties
+// and cleared by the next rescan
+struct GSAxis {
+  int counts[WIDTH];
+  int occupied;
+  int min;
+  int max;
+  int stale;
+} ;
+
+struct GSOccupancy {
+  struct GSAxis landRows;
+  struct GSAxis landColumns;
+  struct GSAxis objectRows;
+  struct GSAxis objectColumns;
+} ;
+
+static void axisAdd(struct GSAxis *axis, int i, int delta);
+static int axisBounds(struct GSAxis *axis, int *min, int *max);
+static int scanRow(const GSTile *row, int n, uint8_t columns[]);
+
+GSOccupancy *occupancyCreate(GSTile tiles[][WIDTH]) {
+  GSOccupancy *occupancy;
+
+TRY
+  if ((occupancy = malloc(sizeof(GSOccupancy))) == NULL) LOGFAIL(errno)
+  bzero(occupancy, sizeof(GSOccupancy));
+  occupancyBuild(occupancy, tiles);
+
+CLEANUP
+ERRHANDLER(occupancy, NULL)
+END
+}
+
+void occupancyDestroy(GSOccupancy *occupancy) {
+  free(occupancy);
+}
+
+void occupancyBuild(GSOccupancy *occupancy, GSTile tiles[][WIDTH]) {
+  bzero(&occupancy->landRows, sizeof(occupancy->landRows));
+  bzero(&occupancy->landColumns, sizeof(occupancy->landColumns));
+  occupancyCountTiles(occupancy, tiles, kSeaRect, 1);
+}
+
+// rows are scanned a block of tiles at a time, the column counts gather
+// in bytes for up to CHUNK rows before they are added to the axis
+void occupancyCountTiles(GSOccupancy *occupancy, GSTile tiles[][WIDTH], GSRect rect, int delta) {
+  uint8_t columns[WIDTH];
+  int x, y, n, miny, maxy;
+
+  rect = GSIntersectionRect(rect, kSeaRect);
+
+  if (GSIsEmptyRect(rect)) {
+    return;
+  }
+
+  for (miny = GSMinY(rect); miny <= GSMaxY(rect); miny = maxy + 1) {
+    maxy = MIN(miny + CHUNK - 1, GSMaxY(rect));
+    bzero(columns, GSWidth(rect));
+
+    for (y = miny; y <= maxy; y++) {
+      if ((n = scanRow(tiles[y] + GSMinX(rect), GSWidth(rect), columns)) != 0) {
+        axisAdd(&occupancy->landRows, y, n*delta);
+      }
+    }
+
+    for (x = 0; x < GSWidth(rect); x++) {
+      if (columns[x] != 0) {
+        axisAdd(&occupancy->landColumns, GSMinX(rect) + x, columns[x]*delta);
+      }
+    }
+  }
+}
+
+void occupancySetTile(GSOccupancy *occupancy, int x, int y, GSTile from, GSTile to) {
+  int delta;
+
+  if (!GSPointInRect(kSeaRect, GSMakePoint(x, y)) || (delta = (from != kSeaTile) - (to != kSeaTile)) == 0) {
+    return;
+  }
+
+  axisAdd(&occupancy->landRows, y, -delta);
+  axisAdd(&occupancy->landColumns, x, -delta);
+}
+
+void occupancyCountObject(GSOccupancy *occupancy, int x, int y, int delta) {
+  assert(x >= 0 && x < WIDTH && y >= 0 && y < WIDTH);
+
+  axisAdd(&occupancy->objectRows, y, delta);
+  axisAdd(&occupancy->objectColumns, x, delta);
+}
+
+void occupancyClearObjects(GSOccupancy *occupancy) {
+  bzero(&occupancy->objectRows, sizeof(occupancy->objectRows));
+  bzero(&occupancy->objectColumns, sizeof(occupancy->objectColumns));
+}
+
+GSRect occupancyLandBounds(GSOccupancy *occupancy) {
+  int minx, maxx, miny, maxy;
+
+  if (!axisBounds(&occupancy->landRows, &miny, &maxy) || !axisBounds(&occupancy->landColumns, &minx, &maxx)) {
+    return GSMakeRect(0, 0, 0, 0);
+  }
+
+  return GSMakeRect(minx, miny, maxx - minx + 1, maxy - miny + 1);
+}
+
+GSRect occupancyObjectBounds(GSOccupancy *occupancy) {
+  int minx, maxx, miny, maxy;
+
+  if (!axisBounds(&occupancy->objectRows, &miny, &maxy) || !axisBounds(&occupancy->objectColumns, &minx, &maxx)) {
+    return GSMakeRect(0, 0, 0, 0);
+  }
+
+  return GSMakeRect(minx, miny, maxx - minx + 1, maxy - miny + 1);
+}
+
+void axisAdd(struct GSAxis *axis, int i, int delta) {
+  int was;
+
+  was = axis->counts[i];
+  axis->counts[i] += delta;
+  assert(axis->counts[i] >= 0);
+
+  if (was == 0 && axis->counts[i] != 0) {
+    if (axis->occupied++ == 0) {
+      axis->min = i;
+      axis->max = i;
+      axis->stale = 0;
+    }
+    else {
+      axis->min = MIN(axis->min, i);
+      axis->max = MAX(axis->max, i);
+    }
+  }
+  else if (was != 0 && axis->counts[i] == 0) {
+    axis->occupied--;
+    axis->stale |= i == axis->min || i == axis->max;
+  }
+}
+
+// returns 0 if nothing is counted on the axis
+int axisBounds(struct GSAxis *axis, int *min, int *max) {
+  if (axis->occupied == 0) {
+    return 0;
+  }
+
+  if (axis->stale) {
+    for (axis->min = 0; axis->counts[axis->min] == 0; axis->min++);
+    for (axis->max = WIDTH - 1; axis->counts[axis->max] == 0; axis->max--);
+    axis->stale = 0;
+  }
+
+  *min = axis->min;
+  *max = axis->max;
+
+  return 1;
+}
+
+// returns the number of tiles of row that are not kSeaTile and adds one
+// to columns for each of them, n is at most WIDTH so no lane of a block
+// sum passes 255
+#if defined(__SSE2__)
+
+int scanRow(const GSTile *row, int n, uint8_t columns[]) {
+  __m128i sea = _mm_set1_epi8(kSeaTile), zero = _mm_setzero_si128(), sums = zero;
+  int i, count;
+
+  for (i = 0; i + BLOCK <= n; i += BLOCK) {
+    __m128i land = _mm_cmpeq_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(row + i)), sea), zero);
+    __m128i *c = (__m128i *)(columns + i);
+    _mm_storeu_si128(c, _mm_sub_epi8(_mm_loadu_si128(c), land));
+    sums = _mm_sub_epi8(sums, land);
+  }
+
+  sums = _mm_sad_epu8(sums, zero);
+  count = _mm_cvtsi128_si32(sums) + _mm_cvtsi128_si32(_mm_srli_si128(sums, 8));
+
+  for (; i < n; i++) {
+    columns[i] += row[i] != kSeaTile;
+    count += row[i] != kSeaTile;
+  }
+
+  return count;
+}
+
+#elif defined(__ARM_NEON)
+
+int scanRow(const GSTile *row, int n, uint8_t columns[]) {
+  uint8x16_t sea = vdupq_n_u8(kSeaTile), sums = vdupq_n_u8(0);
+  uint64x2_t total;
+  int i, count;
+
+  for (i = 0; i + BLOCK <= n; i += BLOCK) {
+    uint8x16_t land = vmvnq_u8(vceqq_u8(vld1q_u8(row + i), sea));
+    vst1q_u8(columns + i, vsubq_u8(vld1q_u8(columns + i), land));
+    sums = vsubq_u8(sums, land);
+  }
+
+  total = vpaddlq_u32(vpaddlq_u16(vpaddlq_u8(sums)));
+  count = (int)(vgetq_lane_u64(total, 0) + vgetq_lane_u64(total, 1));
+
+  for (; i < n; i++) {
+    columns[i] += row[i] != kSeaTile;
+    count += row[i] != kSeaTile;
+  }
+
+  return count;
+}
+
+#else
+
+int scanRow(const GSTile *row, int n, uint8_t columns[]) {
+  int i, count;
+
+  count = 0;
+
+  for (i = 0; i < n; i++) {
+    columns[i] += row[i] != kSeaTile;
+    count += row[i] != kSeaTile;
+  }
+
+  return count;
+}
+
+#endif
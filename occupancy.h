@@ -0,0 +1,42 @@
+//
+//  occupancy.h
+//  XBolo Map Editor
+//
+//  Created by Robert Chrzanowski on 10/19/26.
+//  Copyright 2026 Robert Chrzanowski. All rights reserved.
+//
+
+#ifndef __OCCUPANCY__
+#define __OCCUPANCY__
+
+#include "bmap.h"
+
+
+// counts per row and per column of the tiles in kSeaRect that are not
+// kSeaTile and of the objects, kept up to date as they are written so the
+// bounds of either are ready without a scan of the map
+typedef struct GSOccupancy GSOccupancy;
+
+// create/destroy the counts of tiles and no objects
+GSOccupancy *occupancyCreate(GSTile tiles[][WIDTH]);
+void occupancyDestroy(GSOccupancy *occupancy);
+
+// recounts every tile, objects are left alone
+void occupancyBuild(GSOccupancy *occupancy, GSTile tiles[][WIDTH]);
+
+// counts the tiles of rect in, delta of 1, or out, delta of -1, a rect
+// write is counted out before it and in after it
+void occupancyCountTiles(GSOccupancy *occupancy, GSTile tiles[][WIDTH], GSRect rect, int delta);
+
+// updates the counts after the tile at x, y changed from from to to
+void occupancySetTile(GSOccupancy *occupancy, int x, int y, GSTile from, GSTile to);
+
+// counts an object at x, y in, delta of 1, or out, delta of -1
+void occupancyCountObject(GSOccupancy *occupancy, int x, int y, int delta);
+void occupancyClearObjects(GSOccupancy *occupancy);
+
+// smallest rect holding the land or the objects, an empty rect if there are none
+GSRect occupancyLandBounds(GSOccupancy *occupancy);
+GSRect occupancyObjectBounds(GSOccupancy *occupancy);
+
+#endif  // __OCCUPANCY__
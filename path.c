@@ -0,0 +1,643 @@
+//
+//  path.c
+//  XBolo Map Editor
+//
+//  Created by Robert Chrzanowski on 10/19/26.
+//  Copyright 2026 Robert Chrzanowski. All rights reserved.
+//
+
+#include "path.h"
+#include "errchk.h"
+
+#include <stdlib.h>
+#include <strings.h>
+
+
+#define CLUSTERS   (WIDTH/PATH_CLUSTER)  // clusters per side of the map
+#define SLOTS      (8)                   // most crossings of one side of a cluster
+#define NODES      (4*SLOTS)             // crossings of a cluster, SLOTS per side
+#define LONG_RUN   (6)                   // runs this long are crossed at both ends
+#define NO_EDGE    (0xffff)
+
+// sides of a cluster, a side and its opposite differ in the low bit
+enum {
+  kNorthSide,
+  kSouthSide,
+  kWestSide,
+  kEastSide
+} ;
+
+// a node is a crossing of a side of a cluster, node k of a cluster is
+// slot k%SLOTS of side k/SLOTS and the slot's offset along the side is the
+// same for both clusters of a side so node k of one faces node k^SLOTS of
+// the other.  intra is the least cost from node to node inside the cluster
+struct GSPathGraph {
+  struct GSReachCosts classCosts;
+  uint8_t costs[WIDTH][WIDTH];
+  uint32_t leastCost;
+  uint8_t counts[CLUSTERS*CLUSTERS][4];
+  uint8_t offsets[CLUSTERS*CLUSTERS][4][SLOTS];
+  uint16_t intra[CLUSTERS*CLUSTERS][NODES][NODES];
+} ;
+
+struct HeapEntry {
+  uint32_t key;
+  uint32_t value;
+} ;
+
+// binary min heap of keys, stale entries are skipped when popped
+struct Heap {
+  struct HeapEntry *entries;
+  size_t count;
+  size_t capacity;
+} ;
+
+static void findCrossings(GSPathGraph *graph, int cluster, int side);
+static int buildCluster(GSPathGraph *graph, int cluster, struct Heap *heap);
+static int clusterSearch(const GSPathGraph *graph, int cluster, GSPoint point, int reverse, struct Heap *heap,
+                         uint32_t distances[][PATH_CLUSTER]);
+static GSPoint nodePoint(const GSPathGraph *graph, int cluster, int node);
+static int neighbourCluster(int cluster, int side);
+static uint32_t estimate(const GSPathGraph *graph, GSPoint from, GSPoint to);
+static int heapPush(struct Heap *heap, uint32_t key, uint32_t value);
+static struct HeapEntry heapPop(struct Heap *heap);
+
+GSPathGraph *pathCreate(GSTile tiles[][WIDTH], const struct GSReachCosts *costs) {
+  GSPathGraph *graph;
+  struct Heap heap;
+  int i, x, y;
+
+  graph = NULL;
+  bzero(&heap, sizeof(heap));
+
+TRY
+  // the north sides of the top row and west sides of the left column are
+  // never found and must have no crossings
+  if ((graph = calloc(1, sizeof(GSPathGraph))) == NULL) LOGFAIL(errno)
+
+  graph->classCosts = *costs;
+  graph->leastCost = 0;
+
+  for (i = 0; i < kTileClassCount; i++) {
+    if (costs->costs[i] != 0 && (graph->leastCost == 0 || costs->costs[i] < graph->leastCost)) {
+      graph->leastCost = costs->costs[i];
+    }
+  }
+
+  for (y = 0; y < WIDTH; y++) {
+    for (x = 0; x < WIDTH; x++) {
+      graph->costs[y][x] = costs->costs[tileClass(tiles[y][x])];
+    }
+  }
+
+  for (i = 0; i < CLUSTERS*CLUSTERS; i++) {
+    findCrossings(graph, i, kSouthSide);
+    findCrossings(graph, i, kEastSide);
+  }
+
+  for (i = 0; i < CLUSTERS*CLUSTERS; i++) {
+    if (buildCluster(graph, i, &heap) == -1) LOGFAIL(errno)
+  }
+
+CLEANUP
+  free(heap.entries);
+
+  switch (ERROR) {
+  case 0:
+    RETURN(graph)
+
+  default:
+    free(graph);
+    RETERR(NULL)
+  }
+END
+}
+
+void pathDestroy(GSPathGraph *graph) {
+  free(graph);
+}
+
+// the crossings of every side of a changed cluster are found again and
+// every cluster with a side that may have changed is rebuilt
+int pathUpdateRect(GSPathGraph *graph, GSTile tiles[][WIDTH], GSRect rect) {
+  struct Heap heap;
+  int x, y, cx, cy, minx, miny, maxx, maxy;
+
+  bzero(&heap, sizeof(heap));
+
+TRY
+  rect = GSIntersectionRect(rect, GSMakeRect(0, 0, WIDTH, WIDTH));
+
+  if (GSIsEmptyRect(rect)) {
+    SUCCESS
+  }
+
+  minx = GSMinX(rect)/PATH_CLUSTER;
+  miny = GSMinY(rect)/PATH_CLUSTER;
+  maxx = GSMaxX(rect)/PATH_CLUSTER;
+  maxy = GSMaxY(rect)/PATH_CLUSTER;
+
+  for (y = GSMinY(rect); y <= GSMaxY(rect); y++) {
+    for (x = GSMinX(rect); x <= GSMaxX(rect); x++) {
+      graph->costs[y][x] = graph->classCosts.costs[tileClass(tiles[y][x])];
+    }
+  }
+
+  for (cy = miny; cy <= maxy; cy++) {
+    for (cx = minx; cx <= maxx; cx++) {
+      findCrossings(graph, cy*CLUSTERS + cx, kSouthSide);
+      findCrossings(graph, cy*CLUSTERS + cx, kEastSide);
+
+      if (cy > 0) {
+        findCrossings(graph, (cy - 1)*CLUSTERS + cx, kSouthSide);
+      }
+
+      if (cx > 0) {
+        findCrossings(graph, cy*CLUSTERS + cx - 1, kEastSide);
+      }
+    }
+  }
+
+  for (cy = MAX(miny - 1, 0); cy <= MIN(maxy + 1, CLUSTERS - 1); cy++) {
+    for (cx = MAX(minx - 1, 0); cx <= MIN(maxx + 1, CLUSTERS - 1); cx++) {
+      // the corners share no side with the changed clusters
+      if ((cx < minx || cx > maxx) && (cy < miny || cy > maxy)) {
+        continue;
+      }
+
+      if (buildCluster(graph, cy*CLUSTERS + cx, &heap) == -1) LOGFAIL(errno)
+    }
+  }
+
+CLEANUP
+  free(heap.entries);
+
+ERRHANDLER(0, -1)
+END
+}
+
+// A* over the tiles, the estimate never overstates since every tile costs
+// at least leastCost
+ssize_t pathFind(const GSPathGraph *graph, GSPoint from, GSPoint to, GSPoint route[], size_t maxpoints, uint32_t *cost) {
+  static const int kDX[4] = { 1, -1, 0, 0 };
+  static const int kDY[4] = { 0, 0, 1, -1 };
+  uint32_t *g;
+  uint8_t *steps;  // direction taken onto each tile
+  struct Heap heap;
+  ssize_t npoints;
+  size_t i;
+  int x, y, d;
+
+  g = NULL;
+  steps = NULL;
+  bzero(&heap, sizeof(heap));
+  npoints = 0;
+  *cost = REACH_UNREACHED;
+
+TRY
+  if ((g = malloc(sizeof(uint32_t)*WIDTH*WIDTH)) == NULL) LOGFAIL(errno)
+  if ((steps = malloc(WIDTH*WIDTH)) == NULL) LOGFAIL(errno)
+
+  for (i = 0; i < WIDTH*WIDTH; i++) {
+    g[i] = REACH_UNREACHED;
+  }
+
+  g[from.y*WIDTH + from.x] = 0;
+  if (heapPush(&heap, estimate(graph, from, to), from.y*WIDTH + from.x) == -1) LOGFAIL(errno)
+
+  while (heap.count > 0) {
+    struct HeapEntry entry = heapPop(&heap);
+    uint32_t here = entry.value;
+
+    x = here%WIDTH;
+    y = here/WIDTH;
+
+    if (entry.key != g[here] + estimate(graph, GSMakePoint(x, y), to)) {
+      continue;
+    }
+
+    if (x == to.x && y == to.y) {
+      *cost = g[here];
+      break;
+    }
+
+    for (d = 0; d < 4; d++) {
+      int nx = x + kDX[d], ny = y + kDY[d];
+      uint32_t ng;
+
+      if (nx < 0 || nx >= WIDTH || ny < 0 || ny >= WIDTH || graph->costs[ny][nx] == 0) {
+        continue;
+      }
+
+      if ((ng = g[here] + graph->costs[ny][nx]) < g[ny*WIDTH + nx]) {
+        g[ny*WIDTH + nx] = ng;
+        steps[ny*WIDTH + nx] = d;
+        if (heapPush(&heap, ng + estimate(graph, GSMakePoint(nx, ny), to), ny*WIDTH + nx) == -1) LOGFAIL(errno)
+      }
+    }
+  }
+
+  if (*cost != REACH_UNREACHED) {
+    // the route is walked back from to once to count it and again to write it
+    for (x = to.x, y = to.y, npoints = 1; x != from.x || y != from.y; npoints++) {
+      d = steps[y*WIDTH + x];
+      x -= kDX[d];
+      y -= kDY[d];
+    }
+
+    if (route != NULL) {
+      for (x = to.x, y = to.y, i = npoints - 1;; i--) {
+        if (i < maxpoints) {
+          route[i] = GSMakePoint(x, y);
+        }
+
+        if (i == 0) {
+          break;
+        }
+
+        d = steps[y*WIDTH + x];
+        x -= kDX[d];
+        y -= kDY[d];
+      }
+    }
+  }
+
+CLEANUP
+  free(g);
+  free(steps);
+  free(heap.entries);
+
+ERRHANDLER(npoints, -1)
+END
+}
+
+// the cluster of from is searched out to its crossings and the cluster of
+// to back from to, the crossings between are searched with A* and the
+// route inside a single cluster is kept if it is cheaper
+int pathEstimate(const GSPathGraph *graph, GSPoint from, GSPoint to, uint32_t *cost) {
+  uint32_t fromCosts[PATH_CLUSTER][PATH_CLUSTER];
+  uint32_t toCosts[PATH_CLUSTER][PATH_CLUSTER];
+  uint32_t *g;
+  struct Heap heap;
+  GSPoint p;
+  uint32_t best;
+  int fromCluster, toCluster, k, j, n;
+
+  g = NULL;
+  bzero(&heap, sizeof(heap));
+
+TRY
+  if ((g = malloc(sizeof(uint32_t)*CLUSTERS*CLUSTERS*NODES)) == NULL) LOGFAIL(errno)
+
+  for (k = 0; k < CLUSTERS*CLUSTERS*NODES; k++) {
+    g[k] = REACH_UNREACHED;
+  }
+
+  fromCluster = (from.y/PATH_CLUSTER)*CLUSTERS + from.x/PATH_CLUSTER;
+  toCluster = (to.y/PATH_CLUSTER)*CLUSTERS + to.x/PATH_CLUSTER;
+
+  if (clusterSearch(graph, fromCluster, from, 0, &heap, fromCosts) == -1) LOGFAIL(errno)
+  if (clusterSearch(graph, toCluster, to, 1, &heap, toCosts) == -1) LOGFAIL(errno)
+
+  best = fromCluster == toCluster ? fromCosts[to.y%PATH_CLUSTER][to.x%PATH_CLUSTER] : REACH_UNREACHED;
+
+  for (k = 0; k < NODES; k++) {
+    if (k%SLOTS < graph->counts[fromCluster][k/SLOTS]) {
+      p = nodePoint(graph, fromCluster, k);
+
+      if (fromCosts[p.y%PATH_CLUSTER][p.x%PATH_CLUSTER] != REACH_UNREACHED) {
+        g[fromCluster*NODES + k] = fromCosts[p.y%PATH_CLUSTER][p.x%PATH_CLUSTER];
+        if (heapPush(&heap, g[fromCluster*NODES + k] + estimate(graph, p, to), fromCluster*NODES + k) == -1) LOGFAIL(errno)
+      }
+    }
+  }
+
+  while (heap.count > 0) {
+    struct HeapEntry entry = heapPop(&heap);
+    int cluster, node;
+
+    cluster = entry.value/NODES;
+    node = entry.value%NODES;
+    p = nodePoint(graph, cluster, node);
+
+    if (entry.key != g[entry.value] + estimate(graph, p, to)) {
+      continue;
+    }
+
+    // nothing left can beat the best route found
+    if (entry.key >= best) {
+      break;
+    }
+
+    if (cluster == toCluster && toCosts[p.y%PATH_CLUSTER][p.x%PATH_CLUSTER] != REACH_UNREACHED) {
+      best = MIN(best, g[entry.value] + toCosts[p.y%PATH_CLUSTER][p.x%PATH_CLUSTER]);
+    }
+
+    for (j = 0; j < NODES; j++) {
+      uint32_t ng;
+
+      if (graph->intra[cluster][node][j] == NO_EDGE) {
+        continue;
+      }
+
+      if ((ng = g[entry.value] + graph->intra[cluster][node][j]) < g[cluster*NODES + j]) {
+        g[cluster*NODES + j] = ng;
+        if (heapPush(&heap, ng + estimate(graph, nodePoint(graph, cluster, j), to), cluster*NODES + j) == -1) LOGFAIL(errno)
+      }
+    }
+
+    // across the side to the facing node
+    if ((n = neighbourCluster(cluster, node/SLOTS)) != -1) {
+      uint32_t ng;
+      GSPoint q = nodePoint(graph, n, node^SLOTS);
+
+      if ((ng = g[entry.value] + graph->costs[q.y][q.x]) < g[n*NODES + (node^SLOTS)]) {
+        g[n*NODES + (node^SLOTS)] = ng;
+        if (heapPush(&heap, ng + estimate(graph, q, to), n*NODES + (node^SLOTS)) == -1) LOGFAIL(errno)
+      }
+    }
+  }
+
+  *cost = best;
+
+CLEANUP
+  free(g);
+  free(heap.entries);
+
+ERRHANDLER(0, -1)
+END
+}
+
+// crossings are the middle of each run of tiles that can be driven onto
+// on both sides of a side, or both ends of a run of LONG_RUN or more, the
+// side is kept by both of its clusters
+void findCrossings(GSPathGraph *graph, int cluster, int side) {
+  int neighbour, i, begin, count, x, y, dx, dy;
+
+  assert(side == kSouthSide || side == kEastSide);
+
+  if ((neighbour = neighbourCluster(cluster, side)) == -1) {
+    graph->counts[cluster][side] = 0;
+    return;
+  }
+
+  // first tile of the side and the step along it
+  if (side == kSouthSide) {
+    x = (cluster%CLUSTERS)*PATH_CLUSTER;
+    y = (cluster/CLUSTERS)*PATH_CLUSTER + PATH_CLUSTER - 1;
+    dx = 1;
+    dy = 0;
+  }
+  else {
+    x = (cluster%CLUSTERS)*PATH_CLUSTER + PATH_CLUSTER - 1;
+    y = (cluster/CLUSTERS)*PATH_CLUSTER;
+    dx = 0;
+    dy = 1;
+  }
+
+  count = 0;
+  begin = -1;
+
+  for (i = 0; i <= PATH_CLUSTER; i++) {
+    int open = i < PATH_CLUSTER && graph->costs[y + dy*i][x + dx*i] != 0 && graph->costs[y + dy*i + dx][x + dx*i + dy] != 0;
+
+    if (open && begin == -1) {
+      begin = i;
+    }
+    else if (!open && begin != -1) {
+      if (i - begin >= LONG_RUN) {
+        graph->offsets[cluster][side][count++] = begin;
+        graph->offsets[cluster][side][count++] = i - 1;
+      }
+      else {
+        graph->offsets[cluster][side][count++] = (begin + i - 1)/2;
+      }
+
+      begin = -1;
+    }
+  }
+
+  assert(count <= SLOTS);
+
+  graph->counts[cluster][side] = count;
+  graph->counts[neighbour][side^1] = count;
+  bcopy(graph->offsets[cluster][side], graph->offsets[neighbour][side^1], count);
+}
+
+// least costs between every pair of a cluster's crossings, in a cluster
+// of a single cost such as open sea they are the manhattan distance
+int buildCluster(GSPathGraph *graph, int cluster, struct Heap *heap) {
+  uint32_t distances[PATH_CLUSTER][PATH_CLUSTER];
+  int left, top, x, y, k, j, uniform;
+
+TRY
+  for (k = 0; k < NODES; k++) {
+    for (j = 0; j < NODES; j++) {
+      graph->intra[cluster][k][j] = NO_EDGE;
+    }
+  }
+
+  left = (cluster%CLUSTERS)*PATH_CLUSTER;
+  top = (cluster/CLUSTERS)*PATH_CLUSTER;
+  uniform = graph->costs[top][left];
+
+  for (y = 0; y < PATH_CLUSTER && uniform != 0; y++) {
+    for (x = 0; x < PATH_CLUSTER; x++) {
+      if (graph->costs[top + y][left + x] != uniform) {
+        uniform = 0;
+        break;
+      }
+    }
+  }
+
+  if (uniform != 0) {
+    for (k = 0; k < NODES; k++) {
+      for (j = 0; j < NODES; j++) {
+        if (j != k && k%SLOTS < graph->counts[cluster][k/SLOTS] && j%SLOTS < graph->counts[cluster][j/SLOTS]) {
+          GSPoint p = nodePoint(graph, cluster, k), q = nodePoint(graph, cluster, j);
+          graph->intra[cluster][k][j] = (abs(p.x - q.x) + abs(p.y - q.y))*uniform;
+        }
+      }
+    }
+
+    SUCCESS
+  }
+
+  for (k = 0; k < NODES; k++) {
+    if (k%SLOTS >= graph->counts[cluster][k/SLOTS]) {
+      continue;
+    }
+
+    if (clusterSearch(graph, cluster, nodePoint(graph, cluster, k), 0, heap, distances) == -1) LOGFAIL(errno)
+
+    for (j = 0; j < NODES; j++) {
+      if (j != k && j%SLOTS < graph->counts[cluster][j/SLOTS]) {
+        GSPoint p = nodePoint(graph, cluster, j);
+
+        if (distances[p.y%PATH_CLUSTER][p.x%PATH_CLUSTER] != REACH_UNREACHED) {
+          graph->intra[cluster][k][j] = distances[p.y%PATH_CLUSTER][p.x%PATH_CLUSTER];
+        }
+      }
+    }
+  }
+
+CLEANUP
+ERRHANDLER(0, -1)
+END
+}
+
+// Dijkstra inside a cluster, the least cost from point to each tile or
+// with reverse from each tile to point
+int clusterSearch(const GSPathGraph *graph, int cluster, GSPoint point, int reverse, struct Heap *heap,
+                  uint32_t distances[][PATH_CLUSTER]) {
+  static const int kDX[4] = { 1, -1, 0, 0 };
+  static const int kDY[4] = { 0, 0, 1, -1 };
+  int left, top, x, y, d;
+
+  left = (cluster%CLUSTERS)*PATH_CLUSTER;
+  top = (cluster/CLUSTERS)*PATH_CLUSTER;
+
+  assert(point.x >= left && point.x < left + PATH_CLUSTER && point.y >= top && point.y < top + PATH_CLUSTER);
+
+TRY
+  for (y = 0; y < PATH_CLUSTER; y++) {
+    for (x = 0; x < PATH_CLUSTER; x++) {
+      distances[y][x] = REACH_UNREACHED;
+    }
+  }
+
+  heap->count = 0;
+  distances[point.y - top][point.x - left] = 0;
+  if (heapPush(heap, 0, (point.y - top)*PATH_CLUSTER + point.x - left) == -1) LOGFAIL(errno)
+
+  while (heap->count > 0) {
+    struct HeapEntry entry = heapPop(heap);
+
+    x = entry.value%PATH_CLUSTER;
+    y = entry.value/PATH_CLUSTER;
+
+    // going back a tile is only possible if this tile can be driven onto
+    if (entry.key != distances[y][x] || (reverse && graph->costs[top + y][left + x] == 0)) {
+      continue;
+    }
+
+    for (d = 0; d < 4; d++) {
+      int nx = x + kDX[d], ny = y + kDY[d];
+      uint32_t step, nd;
+
+      if (nx < 0 || nx >= PATH_CLUSTER || ny < 0 || ny >= PATH_CLUSTER) {
+        continue;
+      }
+
+      if ((step = graph->costs[top + (reverse ? y : ny)][left + (reverse ? x : nx)]) == 0) {
+        continue;
+      }
+
+      if ((nd = entry.key + step) < distances[ny][nx]) {
+        distances[ny][nx] = nd;
+        if (heapPush(heap, nd, ny*PATH_CLUSTER + nx) == -1) LOGFAIL(errno)
+      }
+    }
+  }
+
+CLEANUP
+ERRHANDLER(0, -1)
+END
+}
+
+GSPoint nodePoint(const GSPathGraph *graph, int cluster, int node) {
+  int left, top, offset;
+
+  left = (cluster%CLUSTERS)*PATH_CLUSTER;
+  top = (cluster/CLUSTERS)*PATH_CLUSTER;
+  offset = graph->offsets[cluster][node/SLOTS][node%SLOTS];
+
+  switch (node/SLOTS) {
+  case kNorthSide:
+    return GSMakePoint(left + offset, top);
+
+  case kSouthSide:
+    return GSMakePoint(left + offset, top + PATH_CLUSTER - 1);
+
+  case kWestSide:
+    return GSMakePoint(left, top + offset);
+
+  default:
+    return GSMakePoint(left + PATH_CLUSTER - 1, top + offset);
+  }
+}
+
+// -1 past the edge of the map
+int neighbourCluster(int cluster, int side) {
+  int cx, cy;
+
+  cx = cluster%CLUSTERS;
+  cy = cluster/CLUSTERS;
+
+  switch (side) {
+  case kNorthSide:
+    return cy > 0 ? cluster - CLUSTERS : -1;
+
+  case kSouthSide:
+    return cy < CLUSTERS - 1 ? cluster + CLUSTERS : -1;
+
+  case kWestSide:
+    return cx > 0 ? cluster - 1 : -1;
+
+  default:
+    return cx < CLUSTERS - 1 ? cluster + 1 : -1;
+  }
+}
+
+uint32_t estimate(const GSPathGraph *graph, GSPoint from, GSPoint to) {
+  return (abs(from.x - to.x) + abs(from.y - to.y))*graph->leastCost;
+}
+
+int heapPush(struct Heap *heap, uint32_t key, uint32_t value) {
+  size_t i;
+
+TRY
+  if (heap->count == heap->capacity) {
+    size_t capacity = heap->capacity > 0 ? heap->capacity*2 : 256;
+    struct HeapEntry *entries;
+
+    if ((entries = realloc(heap->entries, capacity*sizeof(struct HeapEntry))) == NULL) LOGFAIL(errno)
+    heap->entries = entries;
+    heap->capacity = capacity;
+  }
+
+  for (i = heap->count++; i > 0 && heap->entries[(i - 1)/2].key > key; i = (i - 1)/2) {
+    heap->entries[i] = heap->entries[(i - 1)/2];
+  }
+
+  heap->entries[i].key = key;
+  heap->entries[i].value = value;
+
+CLEANUP
+ERRHANDLER(0, -1)
+END
+}
+
+struct HeapEntry heapPop(struct Heap *heap) {
+  struct HeapEntry top, last;
+  size_t i, child;
+
+  top = heap->entries[0];
+  last = heap->entries[--heap->count];
+
+  for (i = 0; (child = 2*i + 1) < heap->count; i = child) {
+    if (child + 1 < heap->count && heap->entries[child + 1].key < heap->entries[child].key) {
+      child++;
+    }
+
+    if (heap->entries[child].key >= last.key) {
+      break;
+    }
+
+    heap->entries[i] = heap->entries[child];
+  }
+
+  heap->entries[i] = last;
+
+  return top;
+}
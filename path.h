@@ -0,0 +1,48 @@
+//
+//  path.h
+//  XBolo Map Editor
+//
+//  Created by Robert Chrzanowski on 10/19/26.
+//  Copyright 2026 Robert Chrzanowski. All rights reserved.
+//
+
+#ifndef __PATH__
+#define __PATH__
+
+#include <stddef.h>
+#include <stdint.h>
+#include "bmap.h"
+#include "reach.h"
+
+
+#define PATH_CLUSTER  (16)  // tiles per side of a cluster
+
+// a map's tiles with the cost of driving onto each from a reach.h cost
+// table, split into PATH_CLUSTER square clusters joined where their edges
+// can be crossed.  least costs within a cluster between the crossings are
+// kept so a route across the map is a search of a few thousand crossings
+// instead of every tile.  a graph may be searched from any number of
+// threads at once but not while it is updated.  bmaptool's travel builds a
+// graph per map and only estimates, pathUpdateRect() and pathFind() are
+// for callers that keep a graph over edits and are not used in this tree
+typedef struct GSPathGraph GSPathGraph;
+
+// create/destroy a graph of tiles
+GSPathGraph *pathCreate(GSTile tiles[][WIDTH], const struct GSReachCosts *costs);
+void pathDestroy(GSPathGraph *graph);
+
+// updates the clusters around rect after its tiles changed
+int pathUpdateRect(GSPathGraph *graph, GSTile tiles[][WIDTH], GSRect rect);
+
+// least cost of driving from from to to found by A* over every tile,
+// REACH_UNREACHED if there is no way.  up to maxpoints points of the route
+// from from to to are written to route if it is not NULL and the number
+// of points of the whole route returned, or -1 if memory runs out
+ssize_t pathFind(const GSPathGraph *graph, GSPoint from, GSPoint to, GSPoint route[], size_t maxpoints, uint32_t *cost);
+
+// cost of driving from from to to found by A* over the crossings, at
+// least the cost of pathFind and on average a few percent above it, more
+// for short routes that have to go through a crossing
+int pathEstimate(const GSPathGraph *graph, GSPoint from, GSPoint to, uint32_t *cost);
+
+#endif  // __PATH__
@@ -0,0 +1,639 @@
+//
+//  placement.c
+//  XBolo Map Editor
+//
+//  Created by Robert Chrzanowski on 10/19/26.
+//  Copyright 2026 Robert Chrzanowski. All rights reserved.
+//
+
+#include "placement.h"
+#include "coverage.h"
+#include "reach.h"
+#include "pool.h"
+#include "errchk.h"
+
+#include <stdlib.h>
+#include <strings.h>
+#include <math.h>
+
+
+#define SPAN           COVERAGE_SPAN
+#define CELLS          (SPAN*SPAN)
+#define WORDS          COVERAGE_WORDS
+#define APPROACH_COST  (48)   // reach.h cost of the farthest approach tile, 16 tiles of grass
+#define GLOBAL_MOVES   (8)    // one move in this many goes anywhere on the map
+#define SAMPLE_MOVES   (256)  // moves sampled for the starting temperature
+#define COOLING        (500)  // starting over final temperature
+
+// tile at the top left of a candidate's window
+#define CORNER(field, candidate) (((field)->points[candidate].y - PILL_RANGE)*WIDTH + (field)->points[candidate].x - PILL_RANGE)
+
+const struct GSPlacementSearch kDefaultPlacementSearch = { MAX_PILLS, 4, 1 << 16, 1, 0 };
+
+// weight of an approach tile for each pill hitting it after the first is
+// worth less so pills spread out before they stack up
+static const int kGain[MAX_PILLS + 2] = { 0, 8, 12, 14, [4 ... MAX_PILLS + 1] = 15 };
+
+// tiles a pill may go on and what it hits, shared by every chain
+struct Field {
+  int ncandidates;
+  GSPoint *points;
+  uint64_t (*hits)[WORDS];       // approach tiles each candidate hits
+  int32_t (*candidates)[WIDTH];  // candidate on each tile, -1 if none
+  uint8_t weights[WIDTH][WIDTH];
+  int offsets[CELLS];            // tile of each cell of a window from its corner
+  uint64_t columns[2*SPAN - 1][WORDS];  // cells of a window whose column less dx + SPAN - 1 is in it
+  int npills;
+  int ninitial;
+  int initial[MAX_PILLS];        // candidates chain 0 starts from
+  uint64_t moves;
+  uint64_t seed;
+} ;
+
+// up and down are the changes of score if one more or one fewer pill hit
+// each tile
+struct Chain {
+  uint8_t *counts;  // pills hitting each tile
+  int16_t *up;
+  int16_t *down;
+  int pills[MAX_PILLS];
+  int best[MAX_PILLS];
+  int64_t score;
+  int64_t bestScore;
+  uint64_t moves;
+  uint64_t accepted;
+} ;
+
+struct Search {
+  const struct Field *field;
+  struct Chain *chains;
+} ;
+
+static int buildField(struct Field *field, const struct BMAP_Preamble *preamble,
+                      const struct BMAP_PillInfo pills[], const struct BMAP_BaseInfo bases[],
+                      const struct BMAP_StartInfo starts[], GSTile tiles[][WIDTH], const GSCoverage *coverage);
+static int keepsSight(GSTile tile);
+static void nearApproach(const struct Field *field, uint8_t rows[][WIDTH], uint8_t near[][WIDTH]);
+static void runChains(GSPool *pool, void *context, size_t begin, size_t end);
+static void anneal(const struct Field *field, struct Chain *chain, int initial, uint64_t state);
+static void splitMove(const struct Field *field, int from, int to, uint64_t leaving[WORDS], uint64_t arriving[WORDS]);
+static void shiftBoard(const uint64_t in[WORDS], int shift, uint64_t out[WORDS]);
+static int64_t moveDelta(const struct Field *field, const struct Chain *chain, int from, int to,
+                         const uint64_t leaving[WORDS], const uint64_t arriving[WORDS]);
+static void commitMove(const struct Field *field, struct Chain *chain, int from, int to,
+                       const uint64_t leaving[WORDS], const uint64_t arriving[WORDS]);
+static void countChanged(const struct Field *field, struct Chain *chain, int tile);
+static int pickCandidate(const struct Field *field, const int pills[], int moved, int radius, uint64_t *state);
+static int isPlaced(const int pills[], int npills, int candidate);
+static double coveredShare(const struct Field *field, const GSCoverage *coverage, const GSPoint points[], int npoints, uint8_t *scratch);
+static uint64_t nextRandom(uint64_t *state);
+
+int placePills(const struct BMAP_Preamble *preamble, const struct BMAP_PillInfo pills[],
+               const struct BMAP_BaseInfo bases[], const struct BMAP_StartInfo starts[],
+               GSTile tiles[][WIDTH], const struct GSPlacementSearch *search, struct GSPlacement *placement) {
+  struct Field *field;
+  struct Chain *chains;
+  struct Search context;
+  GSCoverage *coverage;
+  GSPool *pool;
+  GSPoint points[MAX_PILLS];
+  int i, c, best, nchains;
+
+  assert(search->npills >= 0 && search->npills <= MAX_PILLS);
+  assert(search->chains > 0);
+
+  field = NULL;
+  chains = NULL;
+  coverage = NULL;
+  pool = NULL;
+  nchains = search->chains;
+
+TRY
+  if ((field = calloc(1, sizeof(struct Field))) == NULL) LOGFAIL(errno)
+  if ((chains = calloc(nchains, sizeof(struct Chain))) == NULL) LOGFAIL(errno)
+  if ((coverage = coverageCreate(tiles)) == NULL) LOGFAIL(errno)
+
+  field->moves = search->moves;
+  field->seed = search->seed;
+
+  if (buildField(field, preamble, pills, bases, starts, tiles, coverage) == -1) LOGFAIL(errno)
+
+  field->npills = MIN(search->npills, field->ncandidates);
+
+  for (c = 0; c < nchains; c++) {
+    if (
+      (chains[c].counts = malloc(WIDTH*WIDTH)) == NULL ||
+      (chains[c].up = malloc(WIDTH*WIDTH*sizeof(int16_t))) == NULL ||
+      (chains[c].down = malloc(WIDTH*WIDTH*sizeof(int16_t))) == NULL
+    ) LOGFAIL(errno)
+  }
+
+  context.field = field;
+  context.chains = chains;
+
+  if ((pool = poolCreate(search->nthreads)) == NULL) LOGFAIL(errno)
+  if (poolSubmit(pool, runChains, &context, 0, nchains, 1) == -1) LOGFAIL(errno)
+  poolWait(pool);
+
+  // ties go to the lowest chain so the result does not depend on threads
+  bzero(placement, sizeof(struct GSPlacement));
+
+  for (best = 0, c = 0; c < nchains; c++) {
+    if (chains[c].bestScore > chains[best].bestScore) {
+      best = c;
+    }
+
+    placement->moves += chains[c].moves;
+    placement->accepted += chains[c].accepted;
+  }
+
+  placement->npills = field->npills;
+  placement->score = chains[best].bestScore;
+
+  for (i = 0; i < field->npills; i++) {
+    points[i] = field->points[chains[best].best[i]];
+    placement->pills[i].x = points[i].x;
+    placement->pills[i].y = points[i].y;
+    placement->pills[i].owner = NEUTRAL;
+    placement->pills[i].armour = MAX_PILL_ARMOUR;
+    placement->pills[i].speed = MAX_PILL_SPEED;
+  }
+
+  placement->covered = coveredShare(field, coverage, points, field->npills, chains[0].counts);
+
+  for (i = 0; i < MIN(preamble->npills, MAX_PILLS); i++) {
+    points[i] = GSMakePoint(pills[i].x, pills[i].y);
+  }
+
+  placement->coveredBefore = coveredShare(field, coverage, points, MIN(preamble->npills, MAX_PILLS), chains[0].counts);
+
+CLEANUP
+  if (pool != NULL) {
+    poolDestroy(pool);
+  }
+
+  if (chains != NULL) {
+    for (c = 0; c < nchains; c++) {
+      free(chains[c].counts);
+      free(chains[c].up);
+      free(chains[c].down);
+    }
+
+    free(chains);
+  }
+
+  if (field != NULL) {
+    free(field->points);
+    free(field->hits);
+    free(field->candidates);
+    free(field);
+  }
+
+  if (coverage != NULL) {
+    coverageDestroy(coverage);
+  }
+
+ERRHANDLER(0, -1)
+END
+}
+
+// approach weights fall off with the cost of driving to the nearest base,
+// candidates are the tiles that hit an approach tile
+int buildField(struct Field *field, const struct BMAP_Preamble *preamble,
+               const struct BMAP_PillInfo pills[], const struct BMAP_BaseInfo bases[],
+               const struct BMAP_StartInfo starts[], GSTile tiles[][WIDTH], const GSCoverage *coverage) {
+  uint32_t (*distances)[WIDTH];
+  uint8_t (*near)[WIDTH], (*rows)[WIDTH];
+  GSPoint sources[MAX_BASES];
+  uint64_t hits[WORDS];
+  int nbases, x, y, i, w, n, dx;
+
+  distances = NULL;
+  near = NULL;
+  rows = NULL;
+
+TRY
+  if ((distances = malloc(sizeof(uint32_t)*WIDTH*WIDTH)) == NULL) LOGFAIL(errno)
+  if ((near = malloc(WIDTH*WIDTH)) == NULL || (rows = malloc(WIDTH*WIDTH)) == NULL) LOGFAIL(errno)
+  if ((field->candidates = malloc(sizeof(int32_t)*WIDTH*WIDTH)) == NULL) LOGFAIL(errno)
+
+  nbases = MIN(preamble->nbases, MAX_BASES);
+
+  for (i = 0; i < nbases; i++) {
+    sources[i] = GSMakePoint(bases[i].x, bases[i].y);
+  }
+
+  if (reachDistances(tiles, &kDefaultReachCosts, NULL, 0, sources, nbases, distances) == -1) LOGFAIL(errno)
+
+  for (y = 0; y < WIDTH; y++) {
+    for (x = 0; x < WIDTH; x++) {
+      field->weights[y][x] = distances[y][x] <= APPROACH_COST ? APPROACH_COST - distances[y][x] + 1 : 0;
+      field->candidates[y][x] = -1;
+    }
+  }
+
+  for (i = 0; i < CELLS; i++) {
+    field->offsets[i] = (i/SPAN)*WIDTH + i%SPAN;
+
+    for (dx = -(SPAN - 1); dx < SPAN; dx++) {
+      if (i%SPAN - dx >= 0 && i%SPAN - dx < SPAN) {
+        field->columns[dx + SPAN - 1][i/64] |= UINT64_C(1) << (i%64);
+      }
+    }
+  }
+
+  nearApproach(field, rows, near);
+
+  // objects keep their tiles
+  for (i = 0; i < nbases; i++) {
+    near[bases[i].y][bases[i].x] = 0;
+  }
+
+  for (i = 0; i < MIN(preamble->nstarts, MAX_STARTS); i++) {
+    near[starts[i].y][starts[i].x] = 0;
+  }
+
+  for (n = 0, y = GSMinY(kSeaRect); y <= GSMaxY(kSeaRect); y++) {
+    for (x = GSMinX(kSeaRect); x <= GSMaxX(kSeaRect); x++) {
+      if (near[y][x] && keepsSight(tiles[y][x])) {
+        n++;
+      }
+    }
+  }
+
+  if ((field->points = malloc(MAX(n, 1)*sizeof(GSPoint))) == NULL) LOGFAIL(errno)
+  if ((field->hits = malloc(MAX(n, 1)*sizeof(field->hits[0]))) == NULL) LOGFAIL(errno)
+
+  for (y = GSMinY(kSeaRect); y <= GSMaxY(kSeaRect); y++) {
+    for (x = GSMinX(kSeaRect); x <= GSMaxX(kSeaRect); x++) {
+      int any;
+
+      if (!near[y][x] || !keepsSight(tiles[y][x])) {
+        continue;
+      }
+
+      coverageCast(coverage, GSMakePoint(x, y), hits);
+
+      for (any = 0, w = 0; w < WORDS; w++) {
+        uint64_t bits;
+
+        for (bits = hits[w]; bits != 0; bits &= bits - 1) {
+          int cell = w*64 + __builtin_ctzll(bits);
+
+          if (field->weights[y - PILL_RANGE + cell/SPAN][x - PILL_RANGE + cell%SPAN] == 0) {
+            hits[w] &= ~(UINT64_C(1) << (cell%64));
+          }
+        }
+
+        any |= hits[w] != 0;
+      }
+
+      if (any) {
+        field->candidates[y][x] = field->ncandidates;
+        field->points[field->ncandidates] = GSMakePoint(x, y);
+        bcopy(hits, field->hits[field->ncandidates], sizeof(hits));
+        field->ncandidates++;
+      }
+    }
+  }
+
+  for (i = 0; i < MIN(preamble->npills, MAX_PILLS); i++) {
+    int candidate = field->candidates[pills[i].y][pills[i].x];
+
+    if (candidate != -1 && !isPlaced(field->initial, field->ninitial, candidate)) {
+      field->initial[field->ninitial++] = candidate;
+    }
+  }
+
+CLEANUP
+  free(distances);
+  free(near);
+  free(rows);
+
+ERRHANDLER(0, -1)
+END
+}
+
+// whether the tile a pill leaves behind blocks shots as tile does
+int keepsSight(GSTile tile) {
+  return (tileClass(appropriateTileForPill(tile)) == kWallClass) == (tileClass(tile) == kWallClass);
+}
+
+// tiles within PILL_RANGE of an approach tile on both axes, a row pass
+// then a column pass
+void nearApproach(const struct Field *field, uint8_t rows[][WIDTH], uint8_t near[][WIDTH]) {
+  int x, y, last;
+
+  for (y = 0; y < WIDTH; y++) {
+    for (last = -WIDTH, x = 0; x < WIDTH + PILL_RANGE; x++) {
+      if (x < WIDTH && field->weights[y][x] > 0) {
+        last = x;
+      }
+
+      if (x - PILL_RANGE >= 0) {
+        rows[y][x - PILL_RANGE] = x - last <= 2*PILL_RANGE;
+      }
+    }
+  }
+
+  for (x = 0; x < WIDTH; x++) {
+    for (last = -WIDTH, y = 0; y < WIDTH + PILL_RANGE; y++) {
+      if (y < WIDTH && rows[y][x]) {
+        last = y;
+      }
+
+      if (y - PILL_RANGE >= 0) {
+        near[y - PILL_RANGE][x] = y - last <= 2*PILL_RANGE;
+      }
+    }
+  }
+}
+
+void runChains(GSPool *pool, void *context, size_t begin, size_t end) {
+  struct Search *search = context;
+  size_t c;
+
+  for (c = begin; c < end; c++) {
+    uint64_t state = search->field->seed ^ (0x9e3779b97f4a7c15ull*(c + 1));
+    anneal(search->field, search->chains + c, c == 0, state);
+  }
+}
+
+// a move takes a pill to another candidate, near it while the chain is hot
+// and nearer as it cools, and is kept if it scores better or by chance
+void anneal(const struct Field *field, struct Chain *chain, int initial, uint64_t state) {
+  uint64_t leaving[WORDS], arriving[WORDS];
+  double hot, temperature, cooling;
+  int64_t sum, delta;
+  uint64_t m;
+  int i, moved, to, radius;
+
+  bzero(chain->counts, WIDTH*WIDTH);
+  bzero(chain->down, WIDTH*WIDTH*sizeof(int16_t));
+
+  for (i = 0; i < WIDTH*WIDTH; i++) {
+    chain->up[i] = field->weights[i/WIDTH][i%WIDTH]*kGain[1];
+  }
+
+  chain->score = 0;
+
+  for (i = 0; i < field->npills; i++) {
+    if (initial && i < field->ninitial) {
+      to = field->initial[i];
+    }
+    else {
+      do {
+        to = nextRandom(&state) % field->ncandidates;
+      } while (isPlaced(chain->pills, i, to));
+    }
+
+    chain->pills[i] = to;
+    splitMove(field, -1, to, leaving, arriving);
+    chain->score += moveDelta(field, chain, -1, to, leaving, arriving);
+    commitMove(field, chain, -1, to, leaving, arriving);
+  }
+
+  bcopy(chain->pills, chain->best, sizeof(chain->best));
+  chain->bestScore = chain->score;
+
+  if (field->npills == 0 || field->ncandidates <= field->npills) {
+    return;
+  }
+
+  // starts hot enough to take an average losing move often
+  for (sum = 0, m = 0; m < SAMPLE_MOVES; m++) {
+    moved = nextRandom(&state) % field->npills;
+
+    if ((to = pickCandidate(field, chain->pills, moved, WIDTH, &state)) != -1) {
+      splitMove(field, chain->pills[moved], to, leaving, arriving);
+      delta = moveDelta(field, chain, chain->pills[moved], to, leaving, arriving);
+      sum += delta < 0 ? -delta : delta;
+    }
+  }
+
+  hot = temperature = MAX((double)sum/SAMPLE_MOVES, 1.0);
+  cooling = pow(1.0/COOLING, 1.0/MAX(field->moves, 1));
+
+  for (m = 0; m < field->moves; m++, temperature *= cooling) {
+    radius = 1 + (int)(2*PILL_RANGE*sqrt(temperature/hot));
+    moved = nextRandom(&state) % field->npills;
+
+    if (nextRandom(&state) % GLOBAL_MOVES == 0) {
+      radius = WIDTH;
+    }
+
+    if ((to = pickCandidate(field, chain->pills, moved, radius, &state)) == -1) {
+      continue;
+    }
+
+    chain->moves++;
+    splitMove(field, chain->pills[moved], to, leaving, arriving);
+    delta = moveDelta(field, chain, chain->pills[moved], to, leaving, arriving);
+
+    if (delta >= 0 || (nextRandom(&state) >> 11)*0x1p-53 < exp(delta/temperature)) {
+      commitMove(field, chain, chain->pills[moved], to, leaving, arriving);
+      chain->pills[moved] = to;
+      chain->score += delta;
+      chain->accepted++;
+
+      if (chain->score > chain->bestScore) {
+        chain->bestScore = chain->score;
+        bcopy(chain->pills, chain->best, sizeof(chain->best));
+      }
+    }
+  }
+}
+
+// hits of from that to does not hit, in from's window, and hits of to
+// that from does not, in to's window.  tiles hit by both keep their counts
+// so only the edges of a short move are scored
+void splitMove(const struct Field *field, int from, int to, uint64_t leaving[WORDS], uint64_t arriving[WORDS]) {
+  uint64_t shifted[WORDS];
+  int dx, dy, w;
+
+  if (from == -1) {
+    bzero(leaving, WORDS*sizeof(uint64_t));
+    bcopy(field->hits[to], arriving, WORDS*sizeof(uint64_t));
+    return;
+  }
+
+  dx = field->points[to].x - field->points[from].x;
+  dy = field->points[to].y - field->points[from].y;
+
+  if (abs(dx) >= SPAN || abs(dy) >= SPAN) {
+    bcopy(field->hits[from], leaving, WORDS*sizeof(uint64_t));
+    bcopy(field->hits[to], arriving, WORDS*sizeof(uint64_t));
+    return;
+  }
+
+  // cell k of to's window is cell k + dy*SPAN + dx of from's
+  shiftBoard(field->hits[to], dy*SPAN + dx, shifted);
+
+  for (w = 0; w < WORDS; w++) {
+    leaving[w] = field->hits[from][w] & ~(shifted[w] & field->columns[dx + SPAN - 1][w]);
+  }
+
+  shiftBoard(field->hits[from], -dy*SPAN - dx, shifted);
+
+  for (w = 0; w < WORDS; w++) {
+    arriving[w] = field->hits[to][w] & ~(shifted[w] & field->columns[-dx + SPAN - 1][w]);
+  }
+}
+
+// out bit k is in bit k - shift
+void shiftBoard(const uint64_t in[WORDS], int shift, uint64_t out[WORDS]) {
+  int w, words, bits;
+
+  if (shift >= 0) {
+    words = shift/64;
+    bits = shift%64;
+
+    for (w = 0; w < WORDS; w++) {
+      out[w] = w - words >= 0 ? in[w - words] << bits : 0;
+      out[w] |= bits > 0 && w - words - 1 >= 0 ? in[w - words - 1] >> (64 - bits) : 0;
+    }
+  }
+  else {
+    words = -shift/64;
+    bits = -shift%64;
+
+    for (w = 0; w < WORDS; w++) {
+      out[w] = w + words < WORDS ? in[w + words] >> bits : 0;
+      out[w] |= bits > 0 && w + words + 1 < WORDS ? in[w + words + 1] << (64 - bits) : 0;
+    }
+  }
+}
+
+// change of score if the pill at from, or none if -1, moved to to
+int64_t moveDelta(const struct Field *field, const struct Chain *chain, int from, int to,
+                  const uint64_t leaving[WORDS], const uint64_t arriving[WORDS]) {
+  int64_t delta;
+  int corner, w;
+
+  delta = 0;
+
+  for (w = 0; w < WORDS; w++) {
+    uint64_t bits;
+
+    if (from != -1) {
+      for (corner = CORNER(field, from), bits = leaving[w]; bits != 0; bits &= bits - 1) {
+        delta -= chain->down[corner + field->offsets[w*64 + __builtin_ctzll(bits)]];
+      }
+    }
+
+    for (corner = CORNER(field, to), bits = arriving[w]; bits != 0; bits &= bits - 1) {
+      delta += chain->up[corner + field->offsets[w*64 + __builtin_ctzll(bits)]];
+    }
+  }
+
+  return delta;
+}
+
+void commitMove(const struct Field *field, struct Chain *chain, int from, int to,
+                const uint64_t leaving[WORDS], const uint64_t arriving[WORDS]) {
+  int corner, w;
+
+  for (w = 0; w < WORDS; w++) {
+    uint64_t bits;
+
+    if (from != -1) {
+      for (corner = CORNER(field, from), bits = leaving[w]; bits != 0; bits &= bits - 1) {
+        int tile = corner + field->offsets[w*64 + __builtin_ctzll(bits)];
+
+        chain->counts[tile]--;
+        countChanged(field, chain, tile);
+      }
+    }
+
+    for (corner = CORNER(field, to), bits = arriving[w]; bits != 0; bits &= bits - 1) {
+      int tile = corner + field->offsets[w*64 + __builtin_ctzll(bits)];
+
+      chain->counts[tile]++;
+      countChanged(field, chain, tile);
+    }
+  }
+}
+
+// scores of a pill more or less hitting tile
+void countChanged(const struct Field *field, struct Chain *chain, int tile) {
+  int weight = field->weights[tile/WIDTH][tile%WIDTH], count = chain->counts[tile];
+
+  chain->up[tile] = weight*(kGain[count + 1] - kGain[count]);
+  chain->down[tile] = count > 0 ? weight*(kGain[count] - kGain[count - 1]) : 0;
+}
+
+// a free candidate within radius of the moved pill, -1 if the tile picked
+// is not one
+int pickCandidate(const struct Field *field, const int pills[], int moved, int radius, uint64_t *state) {
+  GSPoint from;
+  int candidate, x, y;
+
+  if (radius >= WIDTH) {
+    candidate = nextRandom(state) % field->ncandidates;
+  }
+  else {
+    from = field->points[pills[moved]];
+    x = from.x + (int)(nextRandom(state) % (2*radius + 1)) - radius;
+    y = from.y + (int)(nextRandom(state) % (2*radius + 1)) - radius;
+
+    if (x < 0 || x >= WIDTH || y < 0 || y >= WIDTH || (candidate = field->candidates[y][x]) == -1) {
+      return -1;
+    }
+  }
+
+  return isPlaced(pills, field->npills, candidate) ? -1 : candidate;
+}
+
+int isPlaced(const int pills[], int npills, int candidate) {
+  int i;
+
+  for (i = 0; i < npills; i++) {
+    if (pills[i] == candidate) {
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+// approach weight hit by any of points over all approach weight
+double coveredShare(const struct Field *field, const GSCoverage *coverage, const GSPoint points[], int npoints, uint8_t *scratch) {
+  uint64_t hits[WORDS];
+  int64_t total, covered;
+  int i, w, x, y;
+
+  bzero(scratch, WIDTH*WIDTH);
+
+  for (i = 0; i < npoints; i++) {
+    coverageCast(coverage, points[i], hits);
+
+    for (w = 0; w < WORDS; w++) {
+      uint64_t bits;
+
+      for (bits = hits[w]; bits != 0; bits &= bits - 1) {
+        int cell = w*64 + __builtin_ctzll(bits);
+        scratch[(points[i].y - PILL_RANGE + cell/SPAN)*WIDTH + points[i].x - PILL_RANGE + cell%SPAN] = 1;
+      }
+    }
+  }
+
+  for (total = 0, covered = 0, y = 0; y < WIDTH; y++) {
+    for (x = 0; x < WIDTH; x++) {
+      total += field->weights[y][x];
+      covered += scratch[y*WIDTH + x] ? field->weights[y][x] : 0;
+    }
+  }
+
+  return total > 0 ? (double)covered/total : 0.0;
+}
+
+// splitmix64
+uint64_t nextRandom(uint64_t *state) {
+  uint64_t z;
+
+  z = (*state += 0x9e3779b97f4a7c15ull);
+  z = (z ^ (z >> 30))*0xbf58476d1ce4e5b9ull;
+  z = (z ^ (z >> 27))*0x94d049bb133111ebull;
+
+  return z ^ (z >> 31);
+}
@@ -0,0 +1,50 @@
+//
+//  placement.h
+//  XBolo Map Editor
+//
+//  Created by Robert Chrzanowski on 10/19/26.
+//  Copyright 2026 Robert Chrzanowski. All rights reserved.
+//
+
+#ifndef __PLACEMENT__
+#define __PLACEMENT__
+
+#include <stdint.h>
+#include "bmap.h"
+
+
+// how hard placePills searches
+struct GSPlacementSearch {
+  int npills;       // pills to place, at most MAX_PILLS
+  int chains;       // independent annealing runs, the best one is kept
+  uint64_t moves;   // moves tried by each chain
+  uint64_t seed;    // chain i starts from seed and i alone so results repeat
+  int nthreads;     // threads the chains are shared by, 0 for one per processor
+} ;
+
+extern const struct GSPlacementSearch kDefaultPlacementSearch;
+
+// pills found by placePills.  the approaches of a base are the tiles a tank
+// drives through on its way in, weighted by how close to the base they
+// are, and a pill scores the weight of each approach tile it hits with
+// less for every other pill already hitting it
+struct GSPlacement {
+  int npills;
+  struct BMAP_PillInfo pills[MAX_PILLS];
+  int64_t score;
+  double covered;        // share of the approach weight hit by a placed pill
+  double coveredBefore;  // the same for the map's own pills
+  uint64_t moves;        // moves tried by every chain
+  uint64_t accepted;
+} ;
+
+// searches for pills covering the approaches of the bases of a decoded map
+// by simulated annealing.  pills only go on tiles of kSeaRect, other than
+// those of bases and starts, whose appropriateTileForPill() tile blocks
+// shots the same so placing them opens no line of sight.  chain 0 starts
+// from the map's own pills.  returns -1 if memory runs out
+int placePills(const struct BMAP_Preamble *preamble, const struct BMAP_PillInfo pills[],
+               const struct BMAP_BaseInfo bases[], const struct BMAP_StartInfo starts[],
+               GSTile tiles[][WIDTH], const struct GSPlacementSearch *search, struct GSPlacement *placement);
+
+#endif  // __PLACEMENT__
@@ -0,0 +1,459 @@
+//
+//  pool.c
+//  XBolo Map Editor
+//
+//  Created by Robert Chrzanowski on 10/19/26.
+//  Copyright 2026 Robert Chrzanowski. All rights reserved.
+//
+
+#include "pool.h"
+#include "errchk.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+
+
+#define INITIAL_DEQUE_CAPACITY (64)
+
+// a range of items of a submitted task
+struct Task {
+  GSTaskFunction function;
+  void *context;
+  size_t begin;
+  size_t end;
+  size_t grain;
+} ;
+
+// the owner pushes and pops the bottom, thieves take from the top where
+// the oldest and so the largest ranges are
+struct Deque {
+  pthread_mutex_t lock;
+  struct Task *tasks;  // circular, top is tasks[head]
+  size_t capacity;
+  size_t head;
+  size_t count;
+} ;
+
+struct Worker {
+  GSPool *pool;
+  int index;
+  pthread_t thread;
+  uint32_t seed;  // picks the first victim to steal from
+  struct Deque deque;
+  struct GSPoolStatistics stats;
+} ;
+
+struct GSPool {
+  int nthreads;
+  struct Worker *workers;
+
+  pthread_mutex_t lock;
+  pthread_cond_t work;  // signalled when a task is queued or the pool stops
+  pthread_cond_t done;  // signalled when pending reaches 0
+  int stop;
+
+  // updated with atomics, sleepers and queued are checked against each
+  // other so that a push never misses a worker going to sleep
+  size_t queued;    // tasks sitting in deques
+  size_t pending;   // items submitted that have not finished
+  int sleepers;
+  unsigned next;    // deque receiving the next submission from outside the pool
+} ;
+
+// the worker running on this thread
+static __thread struct Worker *currentWorker = NULL;
+
+static void *workerMain(void *arg);
+static void runTask(struct Worker *worker, struct Task task);
+static int stealTask(struct Worker *worker, struct Task *task);
+static int pushTask(GSPool *pool, struct Worker *worker, struct Task task);
+static int initDeque(struct Deque *deque);
+static void destroyDeque(struct Deque *deque);
+static int pushBottom(struct Deque *deque, struct Task task);
+static int popBottom(struct Deque *deque, struct Task *task);
+static int popTop(struct Deque *deque, struct Task *task);
+static uint64_t monotonicNanos(void);
+
+GSPool *poolCreate(int nthreads) {
+  GSPool *pool;
+  int i, started;
+
+  pool = NULL;
+  started = 0;
+
+TRY
+  if (nthreads <= 0) {
+    nthreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+  }
+
+  nthreads = nthreads < 1 ? 1 : nthreads > MAX_POOL_THREADS ? MAX_POOL_THREADS : nthreads;
+
+  if ((pool = (GSPool *)malloc(sizeof(GSPool))) == NULL) LOGFAIL(errno)
+  bzero(pool, sizeof(GSPool));
+
+  if ((pool->workers = (struct Worker *)calloc(nthreads, sizeof(struct Worker))) == NULL) LOGFAIL(errno)
+
+  pool->nthreads = nthreads;
+  pthread_mutex_init(&pool->lock, NULL);
+  pthread_cond_init(&pool->work, NULL);
+  pthread_cond_init(&pool->done, NULL);
+
+  for (i = 0; i < nthreads; i++) {
+    pool->workers[i].pool = pool;
+    pool->workers[i].index = i;
+    pool->workers[i].seed = 2463534242u + i;
+    if (initDeque(&pool->workers[i].deque) == -1) LOGFAIL(errno)
+  }
+
+  for (started = 0; started < nthreads; started++) {
+    int err;
+
+    if ((err = pthread_create(&pool->workers[started].thread, NULL, workerMain, pool->workers + started)) != 0) LOGFAIL(err)
+  }
+
+CLEANUP
+  if (ERROR != 0 && pool != NULL) {
+    if (pool->workers != NULL) {
+      pthread_mutex_lock(&pool->lock);
+      pool->stop = 1;
+      pthread_cond_broadcast(&pool->work);
+      pthread_mutex_unlock(&pool->lock);
+
+      for (i = 0; i < started; i++) {
+        pthread_join(pool->workers[i].thread, NULL);
+      }
+
+      for (i = 0; i < nthreads; i++) {
+        destroyDeque(&pool->workers[i].deque);
+      }
+
+      free(pool->workers);
+      pthread_cond_destroy(&pool->done);
+      pthread_cond_destroy(&pool->work);
+      pthread_mutex_destroy(&pool->lock);
+    }
+
+    free(pool);
+    pool = NULL;
+  }
+
+ERRHANDLER(pool, NULL)
+END
+}
+
+void poolDestroy(GSPool *pool) {
+  int i;
+
+  if (pool == NULL) {
+    return;
+  }
+
+  poolWait(pool);
+
+  pthread_mutex_lock(&pool->lock);
+  pool->stop = 1;
+  pthread_cond_broadcast(&pool->work);
+  pthread_mutex_unlock(&pool->lock);
+
+  // workers still looking for work may steal from any deque until they have all exited
+  for (i = 0; i < pool->nthreads; i++) {
+    pthread_join(pool->workers[i].thread, NULL);
+  }
+
+  for (i = 0; i < pool->nthreads; i++) {
+    destroyDeque(&pool->workers[i].deque);
+  }
+
+  free(pool->workers);
+  pthread_cond_destroy(&pool->done);
+  pthread_cond_destroy(&pool->work);
+  pthread_mutex_destroy(&pool->lock);
+  free(pool);
+}
+
+int poolThreadCount(const GSPool *pool) {
+  return pool->nthreads;
+}
+
+int poolSubmit(GSPool *pool, GSTaskFunction function, void *context, size_t begin, size_t end, size_t grain) {
+  struct Task task;
+  struct Worker *worker;
+
+  assert(function != NULL);
+  assert(begin <= end);
+
+TRY
+  if (begin == end) {
+    SUCCESS
+  }
+
+  task.function = function;
+  task.context = context;
+  task.begin = begin;
+  task.end = end;
+  task.grain = grain > 0 ? grain : 1;
+
+  // tasks submitted by a task stay with its worker, others are dealt out
+  if (currentWorker != NULL && currentWorker->pool == pool) {
+    worker = currentWorker;
+  }
+  else {
+    worker = pool->workers + (__atomic_fetch_add(&pool->next, 1, __ATOMIC_RELAXED) % pool->nthreads);
+  }
+
+  __atomic_add_fetch(&pool->pending, end - begin, __ATOMIC_SEQ_CST);
+
+  if (pushTask(pool, worker, task) == -1) {
+    __atomic_sub_fetch(&pool->pending, end - begin, __ATOMIC_SEQ_CST);
+    LOGFAIL(errno)
+  }
+
+CLEANUP
+ERRHANDLER(0, -1)
+END
+}
+
+void poolWait(GSPool *pool) {
+  assert(currentWorker == NULL || currentWorker->pool != pool);
+
+  pthread_mutex_lock(&pool->lock);
+
+  while (__atomic_load_n(&pool->pending, __ATOMIC_SEQ_CST) != 0) {
+    pthread_cond_wait(&pool->done, &pool->lock);
+  }
+
+  pthread_mutex_unlock(&pool->lock);
+}
+
+int poolWorkerIndex(const GSPool *pool) {
+  return currentWorker != NULL && currentWorker->pool == pool ? currentWorker->index : -1;
+}
+
+int poolStatistics(const GSPool *pool, struct GSPoolStatistics stats[], int n) {
+  int i;
+
+  for (i = 0; i < n && i < pool->nthreads; i++) {
+    stats[i] = pool->workers[i].stats;
+  }
+
+  return pool->nthreads;
+}
+
+void poolResetStatistics(GSPool *pool) {
+  int i;
+
+  for (i = 0; i < pool->nthreads; i++) {
+    bzero(&pool->workers[i].stats, sizeof(struct GSPoolStatistics));
+  }
+}
+
+void *workerMain(void *arg) {
+  struct Worker *worker = arg;
+  GSPool *pool = worker->pool;
+
+  currentWorker = worker;
+
+  for (;;) {
+    struct Task task;
+
+    if (popBottom(&worker->deque, &task) || stealTask(worker, &task)) {
+      __atomic_sub_fetch(&pool->queued, 1, __ATOMIC_SEQ_CST);
+      runTask(worker, task);
+      continue;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+
+    if (pool->stop) {
+      pthread_mutex_unlock(&pool->lock);
+      break;
+    }
+
+    __atomic_add_fetch(&pool->sleepers, 1, __ATOMIC_SEQ_CST);
+
+    if (__atomic_load_n(&pool->queued, __ATOMIC_SEQ_CST) == 0) {
+      uint64_t start = monotonicNanos();
+
+      pthread_cond_wait(&pool->work, &pool->lock);
+      worker->stats.idleNanos += monotonicNanos() - start;
+    }
+
+    __atomic_sub_fetch(&pool->sleepers, 1, __ATOMIC_SEQ_CST);
+    pthread_mutex_unlock(&pool->lock);
+  }
+
+  currentWorker = NULL;
+  CLEARERRLOG
+
+  return NULL;
+}
+
+// halves the range until it is no larger than grain, pushing the upper
+// halves for this worker to pop or others to steal
+void runTask(struct Worker *worker, struct Task task) {
+  GSPool *pool = worker->pool;
+  size_t items;
+
+  while (task.end - task.begin > task.grain) {
+    struct Task upper = task;
+
+    upper.begin = task.begin + (task.end - task.begin)/2;
+
+    // without memory for the deque run the whole range here
+    if (pushTask(pool, worker, upper) == -1) {
+      CLEARERRLOG
+      break;
+    }
+
+    task.end = upper.begin;
+    worker->stats.splits++;
+  }
+
+  items = task.end - task.begin;
+  task.function(pool, task.context, task.begin, task.end);
+  worker->stats.tasks++;
+  worker->stats.items += items;
+
+  if (__atomic_sub_fetch(&pool->pending, items, __ATOMIC_SEQ_CST) == 0) {
+    pthread_mutex_lock(&pool->lock);
+    pthread_cond_broadcast(&pool->done);
+    pthread_mutex_unlock(&pool->lock);
+  }
+}
+
+// tries every other worker once starting at a random one
+int stealTask(struct Worker *worker, struct Task *task) {
+  GSPool *pool = worker->pool;
+  int i, victim;
+
+  if (pool->nthreads == 1) {
+    return 0;
+  }
+
+  // xorshift32
+  worker->seed ^= worker->seed << 13;
+  worker->seed ^= worker->seed >> 17;
+  worker->seed ^= worker->seed << 5;
+  victim = worker->seed % pool->nthreads;
+
+  for (i = 0; i < pool->nthreads; i++, victim = (victim + 1) % pool->nthreads) {
+    if (victim != worker->index && popTop(&pool->workers[victim].deque, task)) {
+      worker->stats.steals++;
+      return 1;
+    }
+  }
+
+  worker->stats.failedSteals++;
+  return 0;
+}
+
+int pushTask(GSPool *pool, struct Worker *worker, struct Task task) {
+TRY
+  if (pushBottom(&worker->deque, task) == -1) LOGFAIL(errno)
+
+  __atomic_add_fetch(&pool->queued, 1, __ATOMIC_SEQ_CST);
+
+  if (__atomic_load_n(&pool->sleepers, __ATOMIC_SEQ_CST) > 0) {
+    pthread_mutex_lock(&pool->lock);
+    pthread_cond_signal(&pool->work);
+    pthread_mutex_unlock(&pool->lock);
+  }
+
+CLEANUP
+ERRHANDLER(0, -1)
+END
+}
+
+int initDeque(struct Deque *deque) {
+TRY
+  if ((deque->tasks = (struct Task *)malloc(INITIAL_DEQUE_CAPACITY*sizeof(struct Task))) == NULL) LOGFAIL(errno)
+
+  pthread_mutex_init(&deque->lock, NULL);
+  deque->capacity = INITIAL_DEQUE_CAPACITY;
+  deque->head = 0;
+  deque->count = 0;
+
+CLEANUP
+ERRHANDLER(0, -1)
+END
+}
+
+void destroyDeque(struct Deque *deque) {
+  if (deque->tasks != NULL) {
+    free(deque->tasks);
+    deque->tasks = NULL;
+    pthread_mutex_destroy(&deque->lock);
+  }
+}
+
+int pushBottom(struct Deque *deque, struct Task task) {
+  pthread_mutex_lock(&deque->lock);
+
+TRY
+  if (deque->count == deque->capacity) {
+    struct Task *tasks;
+    size_t i;
+
+    if ((tasks = (struct Task *)malloc(deque->capacity*2*sizeof(struct Task))) == NULL) LOGFAIL(errno)
+
+    for (i = 0; i < deque->count; i++) {
+      tasks[i] = deque->tasks[(deque->head + i) % deque->capacity];
+    }
+
+    free(deque->tasks);
+    deque->tasks = tasks;
+    deque->capacity *= 2;
+    deque->head = 0;
+  }
+
+  deque->tasks[(deque->head + deque->count) % deque->capacity] = task;
+  deque->count++;
+
+CLEANUP
+  pthread_mutex_unlock(&deque->lock);
+
+ERRHANDLER(0, -1)
+END
+}
+
+int popBottom(struct Deque *deque, struct Task *task) {
+  int found;
+
+  pthread_mutex_lock(&deque->lock);
+
+  if ((found = deque->count > 0)) {
+    deque->count--;
+    *task = deque->tasks[(deque->head + deque->count) % deque->capacity];
+  }
+
+  pthread_mutex_unlock(&deque->lock);
+
+  return found;
+}
+
+int popTop(struct Deque *deque, struct Task *task) {
+  int found;
+
+  pthread_mutex_lock(&deque->lock);
+
+  if ((found = deque->count > 0)) {
+    *task = deque->tasks[deque->head];
+    deque->head = (deque->head + 1) % deque->capacity;
+    deque->count--;
+  }
+
+  pthread_mutex_unlock(&deque->lock);
+
+  return found;
+}
+
+uint64_t monotonicNanos(void) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec*1000000000 + ts.tv_nsec;
+}
@@ -0,0 +1,54 @@
+//
+//  pool.h
+//  XBolo Map Editor
+//
+//  Created by Robert Chrzanowski on 10/19/26.
+//  Copyright 2026 Robert Chrzanowski. All rights reserved.
+//
+
+#ifndef __POOL__
+#define __POOL__
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+#define MAX_POOL_THREADS (256)
+
+typedef struct GSPool GSPool;
+
+// runs items [begin, end) of a task, context is the pointer given to poolSubmit()
+typedef void (*GSTaskFunction)(GSPool *pool, void *context, size_t begin, size_t end);
+
+// counters kept by each worker, read them after poolWait()
+struct GSPoolStatistics {
+  uint64_t tasks;        // ranges run
+  uint64_t items;        // items run
+  uint64_t splits;       // ranges split in half and pushed back
+  uint64_t steals;       // ranges taken from another worker
+  uint64_t failedSteals; // scans of the other workers that found nothing
+  uint64_t idleNanos;    // time spent asleep waiting for work
+} ;
+
+// create/destroy a pool, nthreads 0 uses one worker per processor
+GSPool *poolCreate(int nthreads);
+void poolDestroy(GSPool *pool);
+
+int poolThreadCount(const GSPool *pool);
+
+// queues items [begin, end), ranges larger than grain are split in half
+// whenever a worker takes them so that idle workers have something to steal,
+// tasks may submit more tasks
+int poolSubmit(GSPool *pool, GSTaskFunction function, void *context, size_t begin, size_t end, size_t grain);
+
+// waits for every submitted item to finish, must not be called from a task
+void poolWait(GSPool *pool);
+
+// index of the calling worker or -1 when not called from a task
+int poolWorkerIndex(const GSPool *pool);
+
+// copies up to n workers' statistics, returns the number of workers
+int poolStatistics(const GSPool *pool, struct GSPoolStatistics stats[], int n);
+void poolResetStatistics(GSPool *pool);
+
+#endif  // __POOL__
@@ -0,0 +1,375 @@
+//
+//  reach.c
+//  XBolo Map Editor
+//
+//  Created by Robert Chrzanowski on 10/19/26.
+//  Copyright 2026 Robert Chrzanowski. All rights reserved.
+//
+
+#include "reach.h"
+#include "errchk.h"
+
+#include <stdlib.h>
+#include <strings.h>
+
+
+#define WORDS    (WIDTH/64)  // words of bits per row
+#define BUCKETS  (256)       // more than the largest cost
+
+const struct GSReachCosts kDefaultReachCosts = {
+  {
+    2,  // kSeaClass, by boat
+    2,  // kRiverClass, by boat
+    0,  // kWallClass
+    2,  // kRoadClass
+    3,  // kGrassClass
+    6,  // kForestClass
+    8,  // kRoughClass
+  }
+};
+
+// a row of bits per row of tiles, bit x%64 of word x/64 is tile x
+struct Bits {
+  uint64_t rows[WIDTH][WORDS];
+} ;
+
+// the tiles of each cost are a mask so a frontier is spread onto all the
+// tiles of one cost a word at a time, and the tiles reached at each
+// distance modulo span are a bucket of bits with the rows it has any in
+struct Search {
+  uint8_t costs[WIDTH][WIDTH];  // cost of driving onto each tile, 0 if blocked
+  int nlevels;
+  uint8_t levels[kTileClassCount];  // the different costs
+  struct Bits masks[kTileClassCount];
+  struct Bits visited;
+  struct Bits frontier;
+  int span;  // largest cost plus one
+  struct Bits buckets[BUCKETS];
+  int bucketMiny[BUCKETS];
+  int bucketMaxy[BUCKETS];
+} ;
+
+static void expandBits(struct Search *search, const GSPoint sources[], int nsources, uint32_t distances[][WIDTH]);
+static uint32_t pillDistance(uint32_t distances[][WIDTH], int x, int y);
+
+int reachDistances(GSTile tiles[][WIDTH], const struct GSReachCosts *costs,
+                   const struct BMAP_PillInfo pills[], int npills,
+                   const GSPoint sources[], int nsources, uint32_t distances[][WIDTH]) {
+  struct Search *search;
+  int x, y, i, j;
+
+  search = NULL;
+
+TRY
+  if ((search = malloc(sizeof(struct Search))) == NULL) LOGFAIL(errno)
+
+  for (y = 0; y < WIDTH; y++) {
+    for (x = 0; x < WIDTH; x++) {
+      search->costs[y][x] = costs->costs[tileClass(tiles[y][x])];
+    }
+  }
+
+  for (i = 0; i < npills; i++) {
+    search->costs[pills[i].y][pills[i].x] = 0;
+  }
+
+  for (y = 0; y < WIDTH; y++) {
+    for (x = 0; x < WIDTH; x++) {
+      distances[y][x] = REACH_UNREACHED;
+    }
+  }
+
+  search->nlevels = 0;
+  search->span = 1;
+
+  for (i = 0; i < kTileClassCount; i++) {
+    if (costs->costs[i] == 0) {
+      continue;
+    }
+
+    for (j = 0; j < search->nlevels && search->levels[j] != costs->costs[i]; j++);
+
+    if (j == search->nlevels) {
+      search->levels[search->nlevels++] = costs->costs[i];
+      search->span = MAX(search->span, costs->costs[i] + 1);
+    }
+  }
+
+  expandBits(search, sources, nsources, distances);
+
+CLEANUP
+  free(search);
+
+ERRHANDLER(0, -1)
+END
+}
+
+int mapTerritory(const struct BMAP_Preamble *preamble, const struct BMAP_PillInfo pills[],
+                 const struct BMAP_BaseInfo bases[], const struct BMAP_StartInfo starts[],
+                 GSTile tiles[][WIDTH], const struct GSReachCosts *costs, struct GSTerritory *territory) {
+  uint32_t (*distances)[WIDTH];
+  uint32_t d, minBase, maxBase;
+  int npills, nbases, nstarts, i, s, least, most;
+
+  distances = NULL;
+
+TRY
+  if ((distances = malloc(sizeof(uint32_t)*WIDTH*WIDTH)) == NULL) LOGFAIL(errno)
+
+  npills = MIN(preamble->npills, MAX_PILLS);
+  nbases = MIN(preamble->nbases, MAX_BASES);
+  nstarts = MIN(preamble->nstarts, MAX_STARTS);
+
+  bzero(territory, sizeof(struct GSTerritory));
+
+  for (i = 0; i < MAX_PILLS; i++) {
+    territory->pillStarts[i] = TERRITORY_NONE;
+    territory->pillDistances[i] = REACH_UNREACHED;
+  }
+
+  for (i = 0; i < MAX_BASES; i++) {
+    territory->baseStarts[i] = TERRITORY_NONE;
+    territory->baseDistances[i] = REACH_UNREACHED;
+  }
+
+  for (s = 0; s < MAX_STARTS; s++) {
+    territory->nearestBase[s] = REACH_UNREACHED;
+  }
+
+  // a distance field per start, each object keeps the closest
+  for (s = 0; s < nstarts; s++) {
+    GSPoint source = GSMakePoint(starts[s].x, starts[s].y);
+
+    if (reachDistances(tiles, costs, pills, npills, &source, 1, distances) == -1) LOGFAIL(errno)
+
+    for (i = 0; i < npills; i++) {
+      if ((d = pillDistance(distances, pills[i].x, pills[i].y)) == REACH_UNREACHED) {
+        continue;
+      }
+
+      if (d < territory->pillDistances[i]) {
+        territory->pillDistances[i] = d;
+        territory->pillStarts[i] = s;
+      }
+      else if (d == territory->pillDistances[i]) {
+        territory->pillStarts[i] = TERRITORY_SHARED;
+      }
+    }
+
+    for (i = 0; i < nbases; i++) {
+      if ((d = distances[bases[i].y][bases[i].x]) == REACH_UNREACHED) {
+        continue;
+      }
+
+      territory->nearestBase[s] = MIN(territory->nearestBase[s], d);
+
+      if (d < territory->baseDistances[i]) {
+        territory->baseDistances[i] = d;
+        territory->baseStarts[i] = s;
+      }
+      else if (d == territory->baseDistances[i]) {
+        territory->baseStarts[i] = TERRITORY_SHARED;
+      }
+    }
+  }
+
+  for (i = 0; i < npills; i++) {
+    switch (territory->pillStarts[i]) {
+    case TERRITORY_NONE:
+      territory->unreached++;
+      break;
+
+    case TERRITORY_SHARED:
+      territory->shared++;
+      break;
+
+    default:
+      territory->startPills[territory->pillStarts[i]]++;
+      break;
+    }
+  }
+
+  for (i = 0; i < nbases; i++) {
+    switch (territory->baseStarts[i]) {
+    case TERRITORY_NONE:
+      territory->unreached++;
+      break;
+
+    case TERRITORY_SHARED:
+      territory->shared++;
+      break;
+
+    default:
+      territory->startBases[territory->baseStarts[i]]++;
+      break;
+    }
+  }
+
+  // starts that reach no base are left out of the spread and count as
+  // having nothing in the balance
+  minBase = REACH_UNREACHED;
+  maxBase = 0;
+  least = MAX_PILLS + MAX_BASES;
+  most = 0;
+
+  for (s = 0; s < nstarts; s++) {
+    if (territory->nearestBase[s] != REACH_UNREACHED) {
+      minBase = MIN(minBase, territory->nearestBase[s]);
+      maxBase = MAX(maxBase, territory->nearestBase[s]);
+    }
+
+    least = MIN(least, territory->startPills[s] + territory->startBases[s]);
+    most = MAX(most, territory->startPills[s] + territory->startBases[s]);
+  }
+
+  territory->baseSpread = minBase != REACH_UNREACHED ? maxBase - minBase : 0;
+  territory->balance = most > 0 ? (double)least/most : 1.0;
+
+CLEANUP
+  free(distances);
+
+ERRHANDLER(0, -1)
+END
+}
+
+// Dial's algorithm a row of bits at a time.  the bucket of each distance
+// in turn less the visited tiles is the frontier, each tile of it is
+// settled at that distance and the frontier is spread by one tile in all
+// four directions into the bucket of that distance plus the cost of each
+// mask.  a tile may land in several buckets, the first to come up wins
+void expandBits(struct Search *search, const GSPoint sources[], int nsources, uint32_t distances[][WIDTH]) {
+  uint32_t distance, last;
+  int x, y, i, w, miny, maxy;
+
+  bzero(search->masks, sizeof(struct Bits)*search->nlevels);
+  bzero(&search->visited, sizeof(struct Bits));
+  bzero(&search->frontier, sizeof(struct Bits));
+  bzero(search->buckets, sizeof(struct Bits)*search->span);
+
+  for (i = 0; i < search->span; i++) {
+    search->bucketMiny[i] = WIDTH;
+    search->bucketMaxy[i] = -1;
+  }
+
+  for (y = 0; y < WIDTH; y++) {
+    for (x = 0; x < WIDTH; x++) {
+      for (i = 0; i < search->nlevels; i++) {
+        if (search->costs[y][x] == search->levels[i]) {
+          search->masks[i].rows[y][x/64] |= 1ULL << (x%64);
+        }
+      }
+    }
+  }
+
+  for (i = 0; i < nsources; i++) {
+    x = sources[i].x;
+    y = sources[i].y;
+    search->buckets[0].rows[y][x/64] |= 1ULL << (x%64);
+    search->bucketMiny[0] = MIN(search->bucketMiny[0], y);
+    search->bucketMaxy[0] = MAX(search->bucketMaxy[0], y);
+  }
+
+  // last is the greatest distance any bucket holds
+  for (distance = 0, last = 0; distance <= last; distance++) {
+    int b = distance%search->span;
+    struct Bits *bucket = search->buckets + b;
+
+    miny = WIDTH;
+    maxy = -1;
+
+    for (y = search->bucketMiny[b]; y <= search->bucketMaxy[b]; y++) {
+      for (w = 0; w < WORDS; w++) {
+        uint64_t f = bucket->rows[y][w] & ~search->visited.rows[y][w];
+
+        bucket->rows[y][w] = 0;
+        search->frontier.rows[y][w] = f;
+
+        if (f != 0) {
+          search->visited.rows[y][w] |= f;
+          miny = MIN(miny, y);
+          maxy = y;
+
+          for (; f != 0; f &= f - 1) {
+            distances[y][w*64 + __builtin_ctzll(f)] = distance;
+          }
+        }
+      }
+    }
+
+    search->bucketMiny[b] = WIDTH;
+    search->bucketMaxy[b] = -1;
+
+    if (maxy == -1) {
+      continue;
+    }
+
+    for (y = MAX(miny - 1, 0); y <= MIN(maxy + 1, WIDTH - 1); y++) {
+      for (w = 0; w < WORDS; w++) {
+        uint64_t f, spread;
+
+        f = search->frontier.rows[y][w];
+        spread = f | (f << 1) | (f >> 1);
+
+        if (w > 0) {
+          spread |= search->frontier.rows[y][w - 1] >> 63;
+        }
+
+        if (w < WORDS - 1) {
+          spread |= search->frontier.rows[y][w + 1] << 63;
+        }
+
+        if (y > 0) {
+          spread |= search->frontier.rows[y - 1][w];
+        }
+
+        if (y < WIDTH - 1) {
+          spread |= search->frontier.rows[y + 1][w];
+        }
+
+        spread &= ~search->visited.rows[y][w];
+
+        for (i = 0; spread != 0 && i < search->nlevels; i++) {
+          uint64_t n = spread & search->masks[i].rows[y][w];
+
+          if (n != 0) {
+            int to = (distance + search->levels[i])%search->span;
+
+            search->buckets[to].rows[y][w] |= n;
+            search->bucketMiny[to] = MIN(search->bucketMiny[to], y);
+            search->bucketMaxy[to] = MAX(search->bucketMaxy[to], y);
+            last = MAX(last, distance + search->levels[i]);
+          }
+        }
+      }
+    }
+
+    for (y = miny; y <= maxy; y++) {
+      bzero(search->frontier.rows[y], sizeof(search->frontier.rows[y]));
+    }
+  }
+}
+
+// least distance of the tiles next to a pill
+uint32_t pillDistance(uint32_t distances[][WIDTH], int x, int y) {
+  uint32_t d;
+
+  d = REACH_UNREACHED;
+
+  if (x > 0) {
+    d = MIN(d, distances[y][x - 1]);
+  }
+
+  if (x < WIDTH - 1) {
+    d = MIN(d, distances[y][x + 1]);
+  }
+
+  if (y > 0) {
+    d = MIN(d, distances[y - 1][x]);
+  }
+
+  if (y < WIDTH - 1) {
+    d = MIN(d, distances[y + 1][x]);
+  }
+
+  return d;
+}
@@ -0,0 +1,60 @@
+//
+//  reach.h
+//  XBolo Map Editor
+//
+//  Created by Robert Chrzanowski on 10/19/26.
+//  Copyright 2026 Robert Chrzanowski. All rights reserved.
+//
+
+#ifndef __REACH__
+#define __REACH__
+
+#include <stdint.h>
+#include "bmap.h"
+
+
+#define REACH_UNREACHED   (UINT32_MAX)
+#define TERRITORY_NONE    (0xff)  // no start reaches the object
+#define TERRITORY_SHARED  (0xfe)  // two or more starts are closest
+
+// cost of driving onto a tile of each class of tiles.h, 0 if it can not be
+// driven onto
+struct GSReachCosts {
+  uint8_t costs[kTileClassCount];
+} ;
+
+// a tank that keeps the boat it starts in, so sea and rivers are crossed
+// at boat speed, walls block and the rest cost about the inverse of the
+// tank's speed on them
+extern const struct GSReachCosts kDefaultReachCosts;
+
+// closest start of each object and how evenly the objects are shared
+// out, a pill is reached when a tile next to it is since pills block
+struct GSTerritory {
+  uint8_t pillStarts[MAX_PILLS];     // start index, TERRITORY_NONE or TERRITORY_SHARED
+  uint8_t baseStarts[MAX_BASES];
+  uint32_t pillDistances[MAX_PILLS];  // from the closest start, REACH_UNREACHED if none
+  uint32_t baseDistances[MAX_BASES];
+  uint8_t startPills[MAX_STARTS];    // pills and bases closest to each start alone
+  uint8_t startBases[MAX_STARTS];
+  uint32_t nearestBase[MAX_STARTS];  // distance from each start to its nearest base
+  int shared;                        // objects two or more starts are closest to
+  int unreached;                     // objects no start reaches
+  uint32_t baseSpread;               // largest less smallest nearestBase of the starts
+  double balance;                    // fewest over most objects of any start, 1 is even
+} ;
+
+// fills distances with the least cost from any of the nsources points to
+// each tile over tiles, REACH_UNREACHED if there is no way, the npills
+// pills block.  tiles are settled in order of distance a row of bits at a
+// time, with a bucket of bits per distance.  returns -1 if memory runs out
+int reachDistances(GSTile tiles[][WIDTH], const struct GSReachCosts *costs,
+                   const struct BMAP_PillInfo pills[], int npills,
+                   const GSPoint sources[], int nsources, uint32_t distances[][WIDTH]);
+
+// fills in the territory of every start of a decoded map
+int mapTerritory(const struct BMAP_Preamble *preamble, const struct BMAP_PillInfo pills[],
+                 const struct BMAP_BaseInfo bases[], const struct BMAP_StartInfo starts[],
+                 GSTile tiles[][WIDTH], const struct GSReachCosts *costs, struct GSTerritory *territory);
+
+#endif  // __REACH__
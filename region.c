@@ -0,0 +1,175 @@
+//
+//  region.c
+//  XBolo Map Editor
+//
+//  Created by Robert Chrzanowski on 10/19/26.
+//  Copyright 2026 Robert Chrzanowski. All rights reserved.
+//
+
+#include "region.h"
+
+
+static int area(GSRect rect);
+static int canJoin(GSRect r1, GSRect r2);
+static void removeRect(GSRegion *region, int i);
+
+void GSEmptyRegion(GSRegion *region) {
+  region->count = 0;
+}
+
+int GSIsEmptyRegion(const GSRegion *region) {
+  return region->count == 0;
+}
+
+void GSRegionAddRect(GSRegion *region, GSRect rect) {
+  int i, j, waste;
+  GSRect u;
+
+  if (GSIsEmptyRect(rect)) {
+    return;
+  }
+
+  for (i = 0; i < region->count; i++) {
+    // already damaged
+    if (GSContainsRect(region->rects[i], rect)) {
+      return;
+    }
+  }
+
+  // rects swallowed by the new one
+  for (i = region->count - 1; i >= 0; i--) {
+    if (GSContainsRect(rect, region->rects[i])) {
+      removeRect(region, i);
+    }
+  }
+
+  // keep only the part of the rect that is not yet damaged
+  for (i = 0; i < region->count; i++) {
+    if (GSIntersectsRect(region->rects[i], rect)) {
+      GSRect pieces[4];
+      int k;
+
+      GSSubtractRect(rect, GSIntersectionRect(rect, region->rects[i]), pieces);
+
+      for (k = 0; k < 4; k++) {
+        GSRegionAddRect(region, GSIntersectionRect(pieces[k], rect));
+      }
+
+      return;
+    }
+  }
+
+  // the rect is disjoint, join it with aligned neighbours
+  for (i = 0; i < region->count; i++) {
+    if (canJoin(region->rects[i], rect)) {
+      rect = GSUnionRect(region->rects[i], rect);
+      removeRect(region, i);
+      i = -1;
+    }
+  }
+
+  if (region->count == MAX_REGION_RECTS) {
+    // merge with the rect that wastes the least area
+    j = 0;
+    waste = -1;
+
+    for (i = 0; i < region->count; i++) {
+      int w = area(GSUnionRect(region->rects[i], rect)) - area(region->rects[i]) - area(rect);
+
+      if (waste == -1 || w < waste) {
+        waste = w;
+        j = i;
+      }
+    }
+
+    u = GSUnionRect(region->rects[j], rect);
+    removeRect(region, j);
+
+    // absorb everything the merged rect now overlaps
+    for (i = 0; i < region->count; i++) {
+      if (GSIntersectsRect(region->rects[i], u)) {
+        u = GSUnionRect(region->rects[i], u);
+        removeRect(region, i);
+        i = -1;
+      }
+    }
+
+    rect = u;
+  }
+
+  region->rects[region->count++] = rect;
+}
+
+void GSRegionUnion(GSRegion *region, const GSRegion *other) {
+  int i;
+
+  for (i = 0; i < other->count; i++) {
+    GSRegionAddRect(region, other->rects[i]);
+  }
+}
+
+void GSRegionIntersectRect(GSRegion *region, GSRect rect) {
+  int i;
+
+  for (i = region->count - 1; i >= 0; i--) {
+    region->rects[i] = GSIntersectionRect(region->rects[i], rect);
+
+    if (GSIsEmptyRect(region->rects[i])) {
+      removeRect(region, i);
+    }
+  }
+}
+
+int GSRegionIntersectsRect(const GSRegion *region, GSRect rect) {
+  int i;
+
+  for (i = 0; i < region->count; i++) {
+    if (GSIntersectsRect(region->rects[i], rect)) {
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+GSRect GSRegionBounds(const GSRegion *region) {
+  GSRect bounds;
+  int i;
+
+  if (region->count == 0) {
+    return GSMakeRect(0, 0, 0, 0);
+  }
+
+  bounds = region->rects[0];
+
+  for (i = 1; i < region->count; i++) {
+    bounds = GSUnionRect(bounds, region->rects[i]);
+  }
+
+  return bounds;
+}
+
+int GSRegionArea(const GSRegion *region) {
+  int i, a;
+
+  for (i = 0, a = 0; i < region->count; i++) {
+    a += area(region->rects[i]);
+  }
+
+  return a;
+}
+
+int area(GSRect rect) {
+  return GSIsEmptyRect(rect) ? 0 : GSWidth(rect) * GSHeight(rect);
+}
+
+// two disjoint rects whose union is exactly their area
+int canJoin(GSRect r1, GSRect r2) {
+  return
+    (GSMinY(r1) == GSMinY(r2) && GSHeight(r1) == GSHeight(r2) && (GSMaxX(r1) + 1 == GSMinX(r2) || GSMaxX(r2) + 1 == GSMinX(r1))) ||
+    (GSMinX(r1) == GSMinX(r2) && GSWidth(r1) == GSWidth(r2) && (GSMaxY(r1) + 1 == GSMinY(r2) || GSMaxY(r2) + 1 == GSMinY(r1)));
+}
+
+void removeRect(GSRegion *region, int i) {
+  region->rects[i] = region->rects[--region->count];
+}
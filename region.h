@@ -0,0 +1,33 @@
+//
+//  region.h
+//  XBolo Map Editor
+//
+//  Created by Robert Chrzanowski on 10/19/26.
+//  Copyright 2026 Robert Chrzanowski. All rights reserved.
+//
+
+#ifndef __REGION__
+#define __REGION__
+
+#include "rect.h"
+
+
+#define MAX_REGION_RECTS (16)
+
+// a set of disjoint rects, when more than MAX_REGION_RECTS are needed
+// the rects that waste the least area are merged
+typedef struct GSRegion {
+  int count;
+  GSRect rects[MAX_REGION_RECTS];
+} GSRegion;
+
+void GSEmptyRegion(GSRegion *region);
+int GSIsEmptyRegion(const GSRegion *region);
+void GSRegionAddRect(GSRegion *region, GSRect rect);
+void GSRegionUnion(GSRegion *region, const GSRegion *other);
+void GSRegionIntersectRect(GSRegion *region, GSRect rect);
+int GSRegionIntersectsRect(const GSRegion *region, GSRect rect);
+GSRect GSRegionBounds(const GSRegion *region);
+int GSRegionArea(const GSRegion *region);
+
+#endif  // __REGION__
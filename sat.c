@@ -0,0 +1,207 @@
+//
+//  sat.c
+//  XBolo Map Editor
+//
+//  Created by Robert Chrzanowski on 10/19/26.
+//  Copyright 2026 Robert Chrzanowski. All rights reserved.
+//
+
+#include "sat.h"
+#include "errchk.h"
+
+#include <stdlib.h>
+#include <strings.h>
+
+
+#define STRIDE (WIDTH + 1)
+
+// sums[layer][y][x] is the number of tiles of layer in [0, x) x [0, y),
+// kept modulo 2^16 which is exact for every rect but the whole map, so
+// the whole map's counts are kept apart in totals
+struct GSSummedArea {
+  int totals[kSummedAreaLayerCount];
+  uint16_t sums[kSummedAreaLayerCount][STRIDE][STRIDE];
+} ;
+
+static unsigned layerMask(GSTile tile);
+static void buildRows(GSSummedArea *area, GSTile tiles[][WIDTH], int miny, int maxy);
+static void addToSuffix(GSSummedArea *area, int layer, int x, int y, const uint16_t *delta);
+
+GSSummedArea *summedAreaCreate(GSTile tiles[][WIDTH]) {
+  GSSummedArea *area;
+
+TRY
+  if ((area = malloc(sizeof(GSSummedArea))) == NULL) LOGFAIL(errno)
+  summedAreaBuild(area, tiles);
+
+CLEANUP
+ERRHANDLER(area, NULL)
+END
+}
+
+void summedAreaDestroy(GSSummedArea *area) {
+  free(area);
+}
+
+void summedAreaBuild(GSSummedArea *area, GSTile tiles[][WIDTH]) {
+  int layer;
+
+  bzero(area->sums, sizeof(area->sums));
+  buildRows(area, tiles, 0, WIDTH - 1);
+
+  // a layer covering the whole map sums to 0 modulo 2^16
+  for (layer = 0; layer < kSummedAreaLayerCount; layer++) {
+    area->totals[layer] = area->sums[layer][WIDTH][WIDTH];
+
+    if (area->totals[layer] == 0 && (layerMask(tiles[0][0]) & (1 << layer))) {
+      area->totals[layer] = WIDTH*WIDTH;
+    }
+  }
+}
+
+void summedAreaSetTile(GSSummedArea *area, int x, int y, GSTile from, GSTile to) {
+  static const uint16_t kPlusOne[STRIDE] = { [0 ... STRIDE - 1] = 1 };
+  static const uint16_t kMinusOne[STRIDE] = { [0 ... STRIDE - 1] = 0xffff };
+  unsigned removed, added;
+  int layer;
+
+  removed = layerMask(from) & ~layerMask(to);
+  added = layerMask(to) & ~layerMask(from);
+
+  for (layer = 0; layer < kSummedAreaLayerCount; layer++) {
+    if (removed & (1 << layer)) {
+      addToSuffix(area, layer, x + 1, y + 1, kMinusOne);
+      area->totals[layer]--;
+    }
+    else if (added & (1 << layer)) {
+      addToSuffix(area, layer, x + 1, y + 1, kPlusOne);
+      area->totals[layer]++;
+    }
+  }
+}
+
+// rows of the rect are rebuilt and the change of the row below the rect
+// is added to every row after it
+void summedAreaUpdateRect(GSSummedArea *area, GSTile tiles[][WIDTH], GSRect rect) {
+  uint16_t before[kSummedAreaLayerCount][STRIDE];
+  int old[kSummedAreaLayerCount];
+  int layer, x, last;
+
+  rect = GSIntersectionRect(rect, GSMakeRect(0, 0, WIDTH, WIDTH));
+
+  if (GSIsEmptyRect(rect)) {
+    return;
+  }
+
+  if (GSWidth(rect)*GSHeight(rect) == WIDTH*WIDTH) {
+    summedAreaBuild(area, tiles);
+    return;
+  }
+
+  last = GSMaxY(rect) + 1;
+
+  for (layer = 0; layer < kSummedAreaLayerCount; layer++) {
+    old[layer] = summedAreaCount(area, layer, rect);
+    bcopy(area->sums[layer][last], before[layer], sizeof(before[layer]));
+  }
+
+  buildRows(area, tiles, GSMinY(rect), GSMaxY(rect));
+
+  for (layer = 0; layer < kSummedAreaLayerCount; layer++) {
+    area->totals[layer] += summedAreaCount(area, layer, rect) - old[layer];
+
+    if (last < WIDTH) {
+      for (x = 0; x < STRIDE; x++) {
+        before[layer][x] = area->sums[layer][last][x] - before[layer][x];
+      }
+
+      addToSuffix(area, layer, GSMinX(rect) + 1, last + 1, before[layer] + GSMinX(rect) + 1);
+    }
+  }
+}
+
+int summedAreaCount(const GSSummedArea *area, int layer, GSRect rect) {
+  int minx, miny, maxx, maxy;
+
+  assert(layer >= 0 && layer < kSummedAreaLayerCount);
+
+  rect = GSIntersectionRect(rect, GSMakeRect(0, 0, WIDTH, WIDTH));
+
+  if (GSIsEmptyRect(rect)) {
+    return 0;
+  }
+
+  if (GSWidth(rect)*GSHeight(rect) == WIDTH*WIDTH) {
+    return area->totals[layer];
+  }
+
+  minx = GSMinX(rect);
+  miny = GSMinY(rect);
+  maxx = GSMaxX(rect) + 1;
+  maxy = GSMaxY(rect) + 1;
+
+  return (uint16_t)(area->sums[layer][maxy][maxx] - area->sums[layer][miny][maxx] - area->sums[layer][maxy][minx] + area->sums[layer][miny][minx]);
+}
+
+// bit per layer that tile counts towards
+unsigned layerMask(GSTile tile) {
+  unsigned mask;
+
+  mask = 1 << tileClass(tile);
+
+  switch (tile) {
+  case kMinedSwampTile:
+  case kMinedCraterTile:
+  case kMinedRoadTile:
+  case kMinedForestTile:
+  case kMinedRubbleTile:
+  case kMinedGrassTile:
+  case kMinedSeaTile:
+    mask |= 1 << kMinedLayer;
+    break;
+
+  case kSeaTile:
+    mask |= 1 << kSeaTileLayer;
+    break;
+
+  default:
+    break;
+  }
+
+  return mask;
+}
+
+// rebuilds rows miny to maxy from the row above them
+void buildRows(GSSummedArea *area, GSTile tiles[][WIDTH], int miny, int maxy) {
+  int runs[kSummedAreaLayerCount];
+  int layer, x, y;
+
+  for (y = miny; y <= maxy; y++) {
+    bzero(runs, sizeof(runs));
+
+    for (x = 0; x < WIDTH; x++) {
+      unsigned mask = layerMask(tiles[y][x]);
+
+      for (layer = 0; layer < kSummedAreaLayerCount; layer++) {
+        runs[layer] += (mask >> layer) & 1;
+        area->sums[layer][y + 1][x + 1] = area->sums[layer][y][x + 1] + runs[layer];
+      }
+    }
+  }
+}
+
+// adds delta[0 ...] to sums[layer][y ...][x ...], a row at a time so the
+// inner loop is a plain vector add
+void addToSuffix(GSSummedArea *area, int layer, int x, int y, const uint16_t *delta) {
+  int i, n;
+
+  n = STRIDE - x;
+
+  for (; y < STRIDE; y++) {
+    uint16_t *row = area->sums[layer][y] + x;
+
+    for (i = 0; i < n; i++) {
+      row[i] += delta[i];
+    }
+  }
+}
@@ -0,0 +1,43 @@
+//
+//  sat.h
+//  XBolo Map Editor
+//
+//  Created by Robert Chrzanowski on 10/19/26.
+//  Copyright 2026 Robert Chrzanowski. All rights reserved.
+//
+
+#ifndef __SAT__
+#define __SAT__
+
+#include "rect.h"
+#include "tiles.h"
+
+
+// layers are the tile classes of tiles.h followed by these
+enum {
+  kMinedLayer = kTileClassCount,  // mined tiles, mined sea included
+  kSeaTileLayer,                  // unmined sea, what mapRect treats as empty
+  kSummedAreaLayerCount
+} ;
+
+// a summed-area table per layer of a map's tiles, the number of tiles of a
+// layer in any rect is four lookups
+typedef struct GSSummedArea GSSummedArea;
+
+// create/destroy a table of tiles
+GSSummedArea *summedAreaCreate(GSTile tiles[][WIDTH]);
+void summedAreaDestroy(GSSummedArea *area);
+
+// rebuilds the whole table
+void summedAreaBuild(GSSummedArea *area, GSTile tiles[][WIDTH]);
+
+// updates the table after the tile at x, y changed from from to to
+void summedAreaSetTile(GSSummedArea *area, int x, int y, GSTile from, GSTile to);
+
+// updates the table after any tiles in rect changed, tiles is the new map
+void summedAreaUpdateRect(GSSummedArea *area, GSTile tiles[][WIDTH], GSRect rect);
+
+// number of tiles of layer in rect
+int summedAreaCount(const GSSummedArea *area, int layer, GSRect rect);
+
+#endif  // __SAT__
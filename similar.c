@@ -0,0 +1,440 @@
+//
+//  similar.c
+//  XBolo Map Editor
+//
+//  Created by Robert Chrzanowski on 10/19/26.
+//  Copyright 2026 Robert Chrzanowski. All rights reserved.
+//
+
+#include "similar.h"
+#include "errchk.h"
+
+#include <string.h>
+#include <pthread.h>
+
+
+#define ROWS            (SIGNATURE_LENGTH/SIGNATURE_BANDS)
+#define BIN_SHIFT       (57)  // 64 - log2(SIGNATURE_LENGTH)
+#define WINDOW          (4)
+#define CLASS_BITS      (3)
+#define WINDOW_MASK     ((1ULL << (CLASS_BITS*WINDOW*WINDOW)) - 1)
+#define OBJECT_SHINGLE  (1ULL << 63)  // windows use the low 48 bits
+#define DENSIFY_STEP    (0x9e3779b9U)
+
+// the entries whose band hashes to the same key are chained through next
+struct Band {
+  uint64_t *keys;
+  uint32_t *heads;  // first entry + 1 of each slot, 0 if the slot is empty
+  size_t capacity;  // a power of two
+  size_t count;
+} ;
+
+struct GSSimilarIndex {
+  pthread_rwlock_t lock;
+
+  struct GSMapSignature *signatures;
+  size_t *ids;
+  uint32_t (*next)[SIGNATURE_BANDS];  // next entry + 1 with the same key in each band
+  size_t count;
+  size_t capacity;
+
+  struct Band bands[SIGNATURE_BANDS];
+} ;
+
+static void addShingle(struct GSMapSignature *signature, uint8_t filled[], uint64_t shingle);
+static void densify(struct GSMapSignature *signature, const uint8_t filled[]);
+static uint64_t bandKey(const struct GSMapSignature *signature, int band);
+static uint64_t mix64(uint64_t x);
+static uint32_t *findSlot(struct Band *band, uint64_t key);
+static int growBand(struct Band *band);
+static int growEntries(GSSimilarIndex *index);
+static int compareEntries(const void *a, const void *b);
+static int compareMatches(const void *a, const void *b);
+
+void mapSignature(const struct BMAP_Preamble *preamble, const struct BMAP_PillInfo pills[],
+                  const struct BMAP_BaseInfo bases[], const struct BMAP_StartInfo starts[],
+                  GSTile tiles[][WIDTH], struct GSMapSignature *signature) {
+  uint8_t classes[WINDOW][WIDTH];
+  uint16_t columns[WIDTH];
+  uint8_t filled[SIGNATURE_LENGTH];
+  uint64_t window;
+  int x, y, i, k;
+
+  memset(signature->mins, 0xff, sizeof(signature->mins));
+  bzero(filled, sizeof(filled));
+
+  // classes of the last WINDOW rows are kept in a ring
+  for (y = 0; y < WIDTH; y++) {
+    for (x = 0; x < WIDTH; x++) {
+      classes[y % WINDOW][x] = tileClass(tiles[y][x]);
+    }
+
+    if (y < WINDOW - 1) {
+      continue;
+    }
+
+    for (x = 0; x < WIDTH; x++) {
+      columns[x] = 0;
+
+      for (k = y - (WINDOW - 1); k <= y; k++) {
+        columns[x] = (columns[x] << CLASS_BITS) | classes[k % WINDOW][x];
+      }
+    }
+
+    // slide the window a column at a time, windows of nothing but sea are 0
+    window = 0;
+
+    for (x = 0; x < WIDTH; x++) {
+      window = ((window << (CLASS_BITS*WINDOW)) | columns[x]) & WINDOW_MASK;
+
+      if (x >= WINDOW - 1 && window != 0) {
+        addShingle(signature, filled, window);
+      }
+    }
+  }
+
+  // each object adds its kind at a fine and a coarse position
+  for (i = 0; i < MIN(preamble->npills, MAX_PILLS); i++) {
+    addShingle(signature, filled, OBJECT_SHINGLE | (0 << 20) | ((pills[i].y >> 2) << 8) | (pills[i].x >> 2));
+    addShingle(signature, filled, OBJECT_SHINGLE | (1 << 20) | ((pills[i].y >> 4) << 8) | (pills[i].x >> 4));
+  }
+
+  for (i = 0; i < MIN(preamble->nbases, MAX_BASES); i++) {
+    addShingle(signature, filled, OBJECT_SHINGLE | (2 << 20) | ((bases[i].y >> 2) << 8) | (bases[i].x >> 2));
+    addShingle(signature, filled, OBJECT_SHINGLE | (3 << 20) | ((bases[i].y >> 4) << 8) | (bases[i].x >> 4));
+  }
+
+  for (i = 0; i < MIN(preamble->nstarts, MAX_STARTS); i++) {
+    addShingle(signature, filled, OBJECT_SHINGLE | (4 << 20) | ((starts[i].y >> 2) << 8) | (starts[i].x >> 2));
+    addShingle(signature, filled, OBJECT_SHINGLE | (5 << 20) | ((starts[i].y >> 4) << 8) | (starts[i].x >> 4));
+  }
+
+  densify(signature, filled);
+}
+
+double signatureSimilarity(const struct GSMapSignature *a, const struct GSMapSignature *b) {
+  int i, equal;
+
+  equal = 0;
+
+  for (i = 0; i < SIGNATURE_LENGTH; i++) {
+    equal += a->mins[i] == b->mins[i];
+  }
+
+  return equal/(double)SIGNATURE_LENGTH;
+}
+
+GSSimilarIndex *similarCreate(void) {
+  GSSimilarIndex *index;
+
+  index = NULL;
+
+TRY
+  if ((index = calloc(1, sizeof(GSSimilarIndex))) == NULL) LOGFAIL(errno)
+  if ((errno = pthread_rwlock_init(&index->lock, NULL)) != 0) LOGFAIL(errno)
+
+CLEANUP
+  switch (ERROR) {
+  case 0:
+    RETURN(index)
+
+  default:
+    free(index);
+    RETERR(NULL)
+  }
+END
+}
+
+void similarDestroy(GSSimilarIndex *index) {
+  int b;
+
+  if (index != NULL) {
+    for (b = 0; b < SIGNATURE_BANDS; b++) {
+      free(index->bands[b].keys);
+      free(index->bands[b].heads);
+    }
+
+    free(index->signatures);
+    free(index->ids);
+    free(index->next);
+    pthread_rwlock_destroy(&index->lock);
+    free(index);
+  }
+}
+
+int similarAdd(GSSimilarIndex *index, size_t id, const struct GSMapSignature *signature) {
+  uint64_t keys[SIGNATURE_BANDS];
+  size_t entry;
+  int b, locked;
+
+  locked = 0;
+
+TRY
+  // keys are worked out before taking the lock
+  for (b = 0; b < SIGNATURE_BANDS; b++) {
+    keys[b] = bandKey(signature, b);
+  }
+
+  pthread_rwlock_wrlock(&index->lock);
+  locked = 1;
+
+  if (index->count == index->capacity && growEntries(index) == -1) LOGFAIL(errno)
+
+  for (b = 0; b < SIGNATURE_BANDS; b++) {
+    if (index->bands[b].count*2 >= index->bands[b].capacity && growBand(index->bands + b) == -1) LOGFAIL(errno)
+  }
+
+  entry = index->count++;
+  index->signatures[entry] = *signature;
+  index->ids[entry] = id;
+
+  for (b = 0; b < SIGNATURE_BANDS; b++) {
+    uint32_t *head = findSlot(index->bands + b, keys[b]);
+
+    if (*head == 0) {
+      index->bands[b].keys[head - index->bands[b].heads] = keys[b];
+      index->bands[b].count++;
+    }
+
+    index->next[entry][b] = *head;
+    *head = (uint32_t)entry + 1;
+  }
+
+CLEANUP
+  if (locked) {
+    pthread_rwlock_unlock(&index->lock);
+  }
+
+ERRHANDLER(0, -1)
+END
+}
+
+size_t similarCount(GSSimilarIndex *index) {
+  size_t count;
+
+  pthread_rwlock_rdlock(&index->lock);
+  count = index->count;
+  pthread_rwlock_unlock(&index->lock);
+
+  return count;
+}
+
+ssize_t similarQuery(GSSimilarIndex *index, const struct GSMapSignature *signature, double threshold, size_t exclude,
+                     struct GSSimilarMatch matches[], size_t nmatches) {
+  uint32_t *candidates;
+  struct GSSimilarMatch *found;
+  size_t ncandidates, capacity, nfound, i;
+  int b, locked;
+
+  candidates = NULL;
+  found = NULL;
+  ncandidates = 0;
+  capacity = 0;
+  nfound = 0;
+  locked = 0;
+
+TRY
+  pthread_rwlock_rdlock(&index->lock);
+  locked = 1;
+
+  // every entry sharing a band, with repeats
+  for (b = 0; b < SIGNATURE_BANDS; b++) {
+    uint32_t entry;
+
+    if (index->bands[b].capacity == 0) {
+      continue;
+    }
+
+    for (entry = *findSlot(index->bands + b, bandKey(signature, b)); entry != 0; entry = index->next[entry - 1][b]) {
+      if (ncandidates == capacity) {
+        uint32_t *c;
+
+        capacity = capacity > 0 ? capacity*2 : 64;
+        if ((c = realloc(candidates, capacity*sizeof(uint32_t))) == NULL) LOGFAIL(errno)
+        candidates = c;
+      }
+
+      candidates[ncandidates++] = entry - 1;
+    }
+  }
+
+  qsort(candidates, ncandidates, sizeof(uint32_t), compareEntries);
+
+  if (ncandidates > 0 && (found = malloc(ncandidates*sizeof(struct GSSimilarMatch))) == NULL) LOGFAIL(errno)
+
+  for (i = 0; i < ncandidates; i++) {
+    double similarity;
+
+    if ((i > 0 && candidates[i] == candidates[i - 1]) || index->ids[candidates[i]] == exclude) {
+      continue;
+    }
+
+    if ((similarity = signatureSimilarity(signature, index->signatures + candidates[i])) >= threshold) {
+      found[nfound].id = index->ids[candidates[i]];
+      found[nfound].similarity = similarity;
+      nfound++;
+    }
+  }
+
+  pthread_rwlock_unlock(&index->lock);
+  locked = 0;
+
+  qsort(found, nfound, sizeof(struct GSSimilarMatch), compareMatches);
+  nfound = MIN(nfound, nmatches);
+  bcopy(found, matches, nfound*sizeof(struct GSSimilarMatch));
+
+CLEANUP
+  if (locked) {
+    pthread_rwlock_unlock(&index->lock);
+  }
+
+  free(candidates);
+  free(found);
+
+ERRHANDLER(nfound, -1)
+END
+}
+
+// one permutation MinHash, the top bits of the shingle's hash pick the
+// minimum it competes for
+void addShingle(struct GSMapSignature *signature, uint8_t filled[], uint64_t shingle) {
+  uint64_t h = mix64(shingle);
+  int bin = (int)(h >> BIN_SHIFT);
+  uint32_t value = (uint32_t)h;
+
+  filled[bin] = 1;
+
+  if (value < signature->mins[bin]) {
+    signature->mins[bin] = value;
+  }
+}
+
+// empty minimums borrow the next filled one to their right, offset by the
+// distance so that borrowed minimums only match the same borrowing
+void densify(struct GSMapSignature *signature, const uint8_t filled[]) {
+  int i, d;
+
+  for (i = 0; i < SIGNATURE_LENGTH; i++) {
+    if (!filled[i]) {
+      for (d = 1; d < SIGNATURE_LENGTH && !filled[(i + d) % SIGNATURE_LENGTH]; d++);
+
+      if (d < SIGNATURE_LENGTH) {
+        signature->mins[i] = signature->mins[(i + d) % SIGNATURE_LENGTH] + d*DENSIFY_STEP;
+      }
+    }
+  }
+}
+
+uint64_t bandKey(const struct GSMapSignature *signature, int band) {
+  const uint32_t *m = signature->mins + band*ROWS;
+  uint64_t h;
+  int i;
+
+  h = mix64(band + 1);
+
+  for (i = 0; i < ROWS; i += 2) {
+    h = mix64(h ^ (((uint64_t)m[i] << 32) | m[i + 1]));
+  }
+
+  return h;
+}
+
+// the splitmix64 finalizer
+uint64_t mix64(uint64_t x) {
+  x ^= x >> 30;
+  x *= 0xbf58476d1ce4e5b9ULL;
+  x ^= x >> 27;
+  x *= 0x94d049bb133111ebULL;
+  x ^= x >> 31;
+  return x;
+}
+
+// the slot holding key or the empty slot where it belongs
+uint32_t *findSlot(struct Band *band, uint64_t key) {
+  size_t mask = band->capacity - 1;
+  size_t slot;
+
+  for (slot = key & mask; band->heads[slot] != 0 && band->keys[slot] != key; slot = (slot + 1) & mask);
+
+  return band->heads + slot;
+}
+
+int growBand(struct Band *band) {
+  struct Band grown;
+  size_t i;
+
+  grown.keys = NULL;
+  grown.heads = NULL;
+
+TRY
+  grown.capacity = band->capacity > 0 ? band->capacity*2 : 256;
+  grown.count = band->count;
+  if ((grown.keys = malloc(grown.capacity*sizeof(uint64_t))) == NULL) LOGFAIL(errno)
+  if ((grown.heads = calloc(grown.capacity, sizeof(uint32_t))) == NULL) LOGFAIL(errno)
+
+  for (i = 0; i < band->capacity; i++) {
+    if (band->heads[i] != 0) {
+      uint32_t *head = findSlot(&grown, band->keys[i]);
+
+      *head = band->heads[i];
+      grown.keys[head - grown.heads] = band->keys[i];
+    }
+  }
+
+  free(band->keys);
+  free(band->heads);
+  *band = grown;
+
+CLEANUP
+  switch (ERROR) {
+  case 0:
+    RETURN(0)
+
+  default:
+    free(grown.keys);
+    free(grown.heads);
+    RETERR(-1)
+  }
+END
+}
+
+int growEntries(GSSimilarIndex *index) {
+  size_t capacity;
+  void *p;
+
+TRY
+  capacity = index->capacity > 0 ? index->capacity*2 : 1024;
+
+  if (capacity > UINT32_MAX) {
+    errno = EOVERFLOW;
+    LOGFAIL(errno)
+  }
+
+  if ((p = realloc(index->signatures, capacity*sizeof(struct GSMapSignature))) == NULL) LOGFAIL(errno)
+  index->signatures = p;
+  if ((p = realloc(index->ids, capacity*sizeof(size_t))) == NULL) LOGFAIL(errno)
+  index->ids = p;
+  if ((p = realloc(index->next, capacity*sizeof(*index->next))) == NULL) LOGFAIL(errno)
+  index->next = p;
+  index->capacity = capacity;
+
+CLEANUP
+ERRHANDLER(0, -1)
+END
+}
+
+int compareEntries(const void *a, const void *b) {
+  uint32_t p = *(const uint32_t *)a, q = *(const uint32_t *)b;
+
+  return p < q ? -1 : p > q;
+}
+
+int compareMatches(const void *a, const void *b) {
+  const struct GSSimilarMatch *p = a, *q = b;
+
+  if (p->similarity != q->similarity) {
+    return p->similarity > q->similarity ? -1 : 1;
+  }
+
+  return p->id < q->id ? -1 : p->id > q->id;
+}
@@ -0,0 +1,55 @@
+//
+//  similar.h
+//  XBolo Map Editor
+//
+//  Created by Robert Chrzanowski on 10/19/26.
+//  Copyright 2026 Robert Chrzanowski. All rights reserved.
+//
+
+#ifndef __SIMILAR__
+#define __SIMILAR__
+
+#include <stddef.h>
+#include <stdint.h>
+#include "bmap.h"
+
+
+#define SIGNATURE_LENGTH  (128)  // minimums kept per map
+#define SIGNATURE_BANDS   (32)   // LSH bands of SIGNATURE_LENGTH/SIGNATURE_BANDS minimums
+
+// MinHash of the set of 4x4 windows of tile classes that are not all sea
+// and of the coarse positions of the objects of a map, the fraction of equal
+// minimums of two signatures estimates the Jaccard similarity of their sets
+struct GSMapSignature {
+  uint32_t mins[SIGNATURE_LENGTH];
+} ;
+
+struct GSSimilarMatch {
+  size_t id;
+  double similarity;
+} ;
+
+typedef struct GSSimilarIndex GSSimilarIndex;
+
+void mapSignature(const struct BMAP_Preamble *preamble, const struct BMAP_PillInfo pills[],
+                  const struct BMAP_BaseInfo bases[], const struct BMAP_StartInfo starts[],
+                  GSTile tiles[][WIDTH], struct GSMapSignature *signature);
+
+double signatureSimilarity(const struct GSMapSignature *a, const struct GSMapSignature *b);
+
+// create/destroy an index, maps may be added and queried from any number
+// of threads at once
+GSSimilarIndex *similarCreate(void);
+void similarDestroy(GSSimilarIndex *index);
+
+// adds a map under the caller's id
+int similarAdd(GSSimilarIndex *index, size_t id, const struct GSMapSignature *signature);
+size_t similarCount(GSSimilarIndex *index);
+
+// finds up to nmatches maps sharing a band with signature whose similarity
+// is at least threshold, most similar first, maps added under exclude are
+// skipped, returns the number of matches
+ssize_t similarQuery(GSSimilarIndex *index, const struct GSMapSignature *signature, double threshold, size_t exclude,
+                     struct GSSimilarMatch matches[], size_t nmatches);
+
+#endif  // __SIMILAR__
@@ -0,0 +1,373 @@
+//
+//  symmetry.c
+//  XBolo Map Editor
+//
+//  Created by Robert Chrzanowski on 10/19/26.
+//  Copyright 2026 Robert Chrzanowski. All rights reserved.
+//
+
+#include "symmetry.h"
+#include "hash.h"
+#include "transform.h"
+#include "errchk.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+
+#define BLOCK (16)  // tiles compared per step
+
+#define HASHED(n) (((n) + HASH_STRIPE - 1)/HASH_STRIPE*HASH_STRIPE)
+
+// the buffers are WIDTH x WIDTH with the tiles past their width and height
+// left 0, so a row can be hashed or compared past its end
+enum {
+  kBoundsBuffer,      // the bounds at 0, 0
+  kMirroredBuffer,    // the bounds with each row reversed
+  kSquareBuffer,      // the square around the bounds, sea around them
+  kTransposedBuffer,  // the square transposed
+  kTurnedBuffer,      // the square transposed with each row reversed
+  kBufferCount
+} ;
+
+struct Work {
+  GSTile buffers[kBufferCount][WIDTH][WIDTH];
+  uint64_t hashes[kBufferCount][WIDTH];
+} ;
+
+// the buffers holding the rows of tiles and of their images under each
+// kind, row y's image is row y of the image buffer, or that many rows up
+// from its last if reversed is set
+static const struct {
+  int tiles;
+  int image;
+  int reversed;
+} kRows[kSymmetryCount] = {
+  { kBoundsBuffer, kBoundsBuffer, 0 },
+  { kBoundsBuffer, kMirroredBuffer, 0 },
+  { kBoundsBuffer, kBoundsBuffer, 1 },
+  { kBoundsBuffer, kMirroredBuffer, 1 },
+  { kSquareBuffer, kTransposedBuffer, 0 },
+  { kSquareBuffer, kTurnedBuffer, 1 },
+  { kSquareBuffer, kTransposedBuffer, 1 },
+  { kSquareBuffer, kTurnedBuffer, 0 },
+};
+
+static GSRect landBounds(GSTile tiles[][WIDTH]);
+static void fillBuffers(struct Work *work, const struct GSSymmetry *symmetry, GSTile tiles[][WIDTH]);
+static GSTile boundsTile(const struct GSSymmetry *symmetry, GSTile tiles[][WIDTH], GSPoint point);
+static void scoreObjects(struct GSSymmetry *symmetry, int kind, const struct BMAP_Preamble *preamble,
+                         const struct BMAP_PillInfo pills[], const struct BMAP_BaseInfo bases[],
+                         const struct BMAP_StartInfo starts[]);
+static int findObject(GSPoint point, const uint8_t *xs, const uint8_t *ys, size_t stride, int n);
+static int countMismatches(const GSTile *a, const GSTile *b, int n);
+
+int mapSymmetry(const struct BMAP_Preamble *preamble, const struct BMAP_PillInfo pills[],
+                const struct BMAP_BaseInfo bases[], const struct BMAP_StartInfo starts[],
+                GSTile tiles[][WIDTH], struct GSSymmetry *symmetry) {
+  struct Work *work;
+  int kind, width, height, side, left, top, i;
+
+  work = NULL;
+
+TRY
+  if ((work = malloc(sizeof(struct Work))) == NULL) LOGFAIL(errno)
+
+  bzero(symmetry, sizeof(struct GSSymmetry));
+  symmetry->bounds = landBounds(tiles);
+  width = GSWidth(symmetry->bounds);
+  height = GSHeight(symmetry->bounds);
+  symmetry->side = side = MAX(width, height);
+  left = (side - width)/2;
+  top = (side - height)/2;
+
+  fillBuffers(work, symmetry, tiles);
+
+  // only rows of the same buffer are hashed together, so the hashes need
+  // only cover the width of the buffer's rows
+  for (i = 0; i < kBufferCount; i++) {
+    int n = i < kSquareBuffer ? width : side;
+    int rows = i < kSquareBuffer ? height : side;
+    int y;
+
+    for (y = 0; y < rows; y++) {
+      work->hashes[i][y] = hashStripes(work->buffers[i][y], HASHED(n));
+    }
+  }
+
+  for (kind = kIdentitySymmetry; kind < kSymmetryCount; kind++) {
+    struct GSSymmetryScore *score = symmetry->scores + kind;
+    int square = kRows[kind].tiles == kSquareBuffer;
+    int rows = square ? side : height;
+    int y;
+
+    score->tiles = width*height;
+
+    // the bounds are rows top to top + height - 1 and columns left to
+    // left + width - 1 of the square
+    for (y = square ? top : 0; y < (square ? top + height : height); y++) {
+      int row = kRows[kind].reversed ? rows - 1 - y : y;
+      int column = square ? left : 0;
+
+      if (work->hashes[kRows[kind].tiles][y] != work->hashes[kRows[kind].image][row]) {
+        score->mismatches += countMismatches(work->buffers[kRows[kind].tiles][y] + column,
+                                             work->buffers[kRows[kind].image][row] + column, width);
+      }
+    }
+
+    scoreObjects(symmetry, kind, preamble, pills, bases, starts);
+
+    if (kind == kIdentitySymmetry) {
+      continue;
+    }
+
+    if (symmetry->best == kIdentitySymmetry ||
+        score->mismatches < symmetry->scores[symmetry->best].mismatches ||
+        (score->mismatches == symmetry->scores[symmetry->best].mismatches &&
+         score->strays < symmetry->scores[symmetry->best].strays)) {
+      symmetry->best = kind;
+    }
+  }
+
+CLEANUP
+  free(work);
+
+ERRHANDLER(0, -1)
+END
+}
+
+GSPoint symmetryImage(const struct GSSymmetry *symmetry, int kind, GSPoint point) {
+  GSRect bounds = symmetry->bounds;
+  int side = symmetry->side;
+  int left = GSMinX(bounds) - (side - GSWidth(bounds))/2;
+  int top = GSMinY(bounds) - (side - GSHeight(bounds))/2;
+  int u = point.x - left, v = point.y - top;
+
+  switch (kind) {
+  case kFlipHorizontalSymmetry:
+    return GSMakePoint(GSMinX(bounds) + GSMaxX(bounds) - point.x, point.y);
+
+  case kFlipVerticalSymmetry:
+    return GSMakePoint(point.x, GSMinY(bounds) + GSMaxY(bounds) - point.y);
+
+  case kRotateHalfSymmetry:
+    return GSMakePoint(GSMinX(bounds) + GSMaxX(bounds) - point.x, GSMinY(bounds) + GSMaxY(bounds) - point.y);
+
+  // the rest turn the square, which is centred on the bounds to within half a tile
+  case kTransposeSymmetry:
+    return GSMakePoint(left + v, top + u);
+
+  case kAntitransposeSymmetry:
+    return GSMakePoint(left + side - 1 - v, top + side - 1 - u);
+
+  case kRotateLeftSymmetry:
+    return GSMakePoint(left + side - 1 - v, top + u);
+
+  case kRotateRightSymmetry:
+    return GSMakePoint(left + v, top + side - 1 - u);
+
+  default:
+    return point;
+  }
+}
+
+int symmetryMismatches(const struct GSSymmetry *symmetry, int kind, GSTile tiles[][WIDTH], GSPoint points[], int max) {
+  GSRect bounds = symmetry->bounds;
+  int x, y, n;
+
+  n = 0;
+
+  for (y = GSMinY(bounds); y <= GSMaxY(bounds); y++) {
+    for (x = GSMinX(bounds); x <= GSMaxX(bounds); x++) {
+      GSPoint image = symmetryImage(symmetry, kind, GSMakePoint(x, y));
+
+      if (tiles[y][x] != boundsTile(symmetry, tiles, image)) {
+        if (n < max) {
+          points[n] = GSMakePoint(x, y);
+        }
+
+        n++;
+      }
+    }
+  }
+
+  return n;
+}
+
+double symmetryTileMatch(const struct GSSymmetryScore *score) {
+  return score->tiles > 0 ? (double)(score->tiles - score->mismatches)/score->tiles : 1.0;
+}
+
+double symmetryObjectMatch(const struct GSSymmetryScore *score) {
+  return score->objects > 0 ? (double)(score->objects - score->strays)/score->objects : 1.0;
+}
+
+// tiles inside kSeaRect that are not sea, kSeaRect if there are none.
+// objects are left out so a start on the sea beside the land does not
+// move the axes, one out of place only counts against the objects
+GSRect landBounds(GSTile tiles[][WIDTH]) {
+  int x, y, minx, miny, maxx, maxy;
+
+  minx = WIDTH;
+  miny = WIDTH;
+  maxx = -1;
+  maxy = -1;
+
+  for (y = GSMinY(kSeaRect); y <= GSMaxY(kSeaRect); y++) {
+    for (x = GSMinX(kSeaRect); x <= GSMaxX(kSeaRect); x++) {
+      if (tiles[y][x] != kSeaTile) {
+        minx = MIN(minx, x);
+        miny = MIN(miny, y);
+        maxx = MAX(maxx, x);
+        maxy = MAX(maxy, y);
+      }
+    }
+  }
+
+  if (maxx == -1) {
+    return kSeaRect;
+  }
+
+  return GSMakeRect(minx, miny, maxx - minx + 1, maxy - miny + 1);
+}
+
+void fillBuffers(struct Work *work, const struct GSSymmetry *symmetry, GSTile tiles[][WIDTH]) {
+  GSRect bounds = symmetry->bounds;
+  int width = GSWidth(bounds), height = GSHeight(bounds), side = symmetry->side;
+  int left = (side - width)/2, top = (side - height)/2;
+  int y;
+
+  bzero(work->buffers, sizeof(work->buffers));
+
+  for (y = 0; y < side; y++) {
+    memset(work->buffers[kSquareBuffer][y], kSeaTile, side);
+  }
+
+  for (y = 0; y < height; y++) {
+    const GSTile *row = tiles[GSMinY(bounds) + y] + GSMinX(bounds);
+
+    memcpy(work->buffers[kBoundsBuffer][y], row, width);
+    memcpy(work->buffers[kMirroredBuffer][y], row, width);
+    reverseTiles(work->buffers[kMirroredBuffer][y], width);
+    memcpy(work->buffers[kSquareBuffer][top + y] + left, row, width);
+  }
+
+  transposeTiles(&work->buffers[kTransposedBuffer][0][0], &work->buffers[kSquareBuffer][0][0], WIDTH, WIDTH);
+
+  for (y = 0; y < side; y++) {
+    memcpy(work->buffers[kTurnedBuffer][y], work->buffers[kTransposedBuffer][y], side);
+    reverseTiles(work->buffers[kTurnedBuffer][y], side);
+  }
+}
+
+// tiles outside the bounds are sea
+GSTile boundsTile(const struct GSSymmetry *symmetry, GSTile tiles[][WIDTH], GSPoint point) {
+  return GSPointInRect(symmetry->bounds, point) ? tiles[point.y][point.x] : kSeaTile;
+}
+
+// an object matches if one of its kind is at its image, whatever its owner
+// or direction
+void scoreObjects(struct GSSymmetry *symmetry, int kind, const struct BMAP_Preamble *preamble,
+                  const struct BMAP_PillInfo pills[], const struct BMAP_BaseInfo bases[],
+                  const struct BMAP_StartInfo starts[]) {
+  struct GSSymmetryScore *score = symmetry->scores + kind;
+  int npills = MIN(preamble->npills, MAX_PILLS);
+  int nbases = MIN(preamble->nbases, MAX_BASES);
+  int nstarts = MIN(preamble->nstarts, MAX_STARTS);
+  int i;
+
+  score->objects = npills + nbases + nstarts;
+
+  for (i = 0; i < npills; i++) {
+    GSPoint image = symmetryImage(symmetry, kind, GSMakePoint(pills[i].x, pills[i].y));
+    score->strays += !findObject(image, &pills[0].x, &pills[0].y, sizeof(struct BMAP_PillInfo), npills);
+  }
+
+  for (i = 0; i < nbases; i++) {
+    GSPoint image = symmetryImage(symmetry, kind, GSMakePoint(bases[i].x, bases[i].y));
+    score->strays += !findObject(image, &bases[0].x, &bases[0].y, sizeof(struct BMAP_BaseInfo), nbases);
+  }
+
+  for (i = 0; i < nstarts; i++) {
+    GSPoint image = symmetryImage(symmetry, kind, GSMakePoint(starts[i].x, starts[i].y));
+    score->strays += !findObject(image, &starts[0].x, &starts[0].y, sizeof(struct BMAP_StartInfo), nstarts);
+  }
+}
+
+// is there one of n objects stride bytes apart at point
+int findObject(GSPoint point, const uint8_t *xs, const uint8_t *ys, size_t stride, int n) {
+  int i;
+
+  for (i = 0; i < n; i++) {
+    if (xs[i*stride] == point.x && ys[i*stride] == point.y) {
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+// each kernel counts the tiles of a and b that differ a block at a time
+// and finishes the tiles past the last whole block one at a time
+#if defined(__SSE2__)
+
+int countMismatches(const GSTile *a, const GSTile *b, int n) {
+  int i, count;
+
+  count = 0;
+
+  for (i = 0; i + BLOCK <= n; i += BLOCK) {
+    __m128i equal = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(a + i)), _mm_loadu_si128((const __m128i *)(b + i)));
+    count += BLOCK - __builtin_popcount(_mm_movemask_epi8(equal));
+  }
+
+  for (; i < n; i++) {
+    count += a[i] != b[i];
+  }
+
+  return count;
+}
+
+#elif defined(__ARM_NEON)
+
+int countMismatches(const GSTile *a, const GSTile *b, int n) {
+  uint8x16_t equal = vdupq_n_u8(0);
+  uint64x2_t sum;
+  int i, count;
+
+  // a lane counts at most WIDTH/BLOCK blocks so it can not overflow
+  for (i = 0; i + BLOCK <= n; i += BLOCK) {
+    equal = vaddq_u8(equal, vandq_u8(vceqq_u8(vld1q_u8(a + i), vld1q_u8(b + i)), vdupq_n_u8(1)));
+  }
+
+  sum = vpaddlq_u32(vpaddlq_u16(vpaddlq_u8(equal)));
+  count = i - (int)(vgetq_lane_u64(sum, 0) + vgetq_lane_u64(sum, 1));
+
+  for (; i < n; i++) {
+    count += a[i] != b[i];
+  }
+
+  return count;
+}
+
+#else
+
+int countMismatches(const GSTile *a, const GSTile *b, int n) {
+  int i, count;
+
+  count = 0;
+
+  for (i = 0; i < n; i++) {
+    count += a[i] != b[i];
+  }
+
+  return count;
+}
+
+#endif
@@ -0,0 +1,62 @@
+//
+//  symmetry.h
+//  XBolo Map Editor
+//
+//  Created by Robert Chrzanowski on 10/19/26.
+//  Copyright 2026 Robert Chrzanowski. All rights reserved.
+//
+
+#ifndef __SYMMETRY__
+#define __SYMMETRY__
+
+#include "bmap.h"
+
+
+// the 8 ways of turning and mirroring a map, each is scored about the land
+// bounds so a map need not be centred to be symmetric
+enum {
+  kIdentitySymmetry,
+  kFlipHorizontalSymmetry,  // mirrored left to right
+  kFlipVerticalSymmetry,    // mirrored top to bottom
+  kRotateHalfSymmetry,      // turned half way round
+  kTransposeSymmetry,       // mirrored in the diagonal from the top left
+  kAntitransposeSymmetry,   // mirrored in the diagonal from the top right
+  kRotateLeftSymmetry,      // turned a quarter left
+  kRotateRightSymmetry,     // turned a quarter right
+  kSymmetryCount
+} ;
+
+struct GSSymmetryScore {
+  int tiles;       // tiles compared with their image
+  int mismatches;  // of them unlike their image
+  int objects;     // pills, bases and starts
+  int strays;      // of them with no object of their kind at their image
+} ;
+
+struct GSSymmetry {
+  GSRect bounds;  // bounds of the land tiles, objects are not included
+  int side;       // of the square around bounds the turns and diagonals are taken in
+  struct GSSymmetryScore scores[kSymmetryCount];
+  int best;       // most tiles matching, then most objects, never kIdentitySymmetry
+} ;
+
+// scores every symmetry of the map.  the map and its mirror images are
+// compared a row at a time, rows whose hashes match are skipped and the rest
+// are compared 16 tiles at a time.  returns -1 if out of memory
+int mapSymmetry(const struct BMAP_Preamble *preamble, const struct BMAP_PillInfo pills[],
+                const struct BMAP_BaseInfo bases[], const struct BMAP_StartInfo starts[],
+                GSTile tiles[][WIDTH], struct GSSymmetry *symmetry);
+
+// the point whose tile lands on point when the map is transformed by kind,
+// tiles of the square off the map are sea
+GSPoint symmetryImage(const struct GSSymmetry *symmetry, int kind, GSPoint point);
+
+// lists up to max tiles unlike their image under kind in row order, returns
+// the number there are
+int symmetryMismatches(const struct GSSymmetry *symmetry, int kind, GSTile tiles[][WIDTH], GSPoint points[], int max);
+
+// share of the tiles and of the objects matching, 1 if there are none
+double symmetryTileMatch(const struct GSSymmetryScore *score);
+double symmetryObjectMatch(const struct GSSymmetryScore *score);
+
+#endif  // __SYMMETRY__
@@ -10,6 +10,16 @@
 #include "bmap.h"
 
 
+static const uint8_t kTileClasses[kTokenTile] = {
+  kWallClass, kRiverClass, kRoughClass, kRoughClass, kRoadClass, kForestClass, kRoughClass, kGrassClass,
+  kWallClass, kRiverClass, kRoughClass, kRoughClass, kRoadClass, kForestClass, kRoughClass, kGrassClass,
+  kSeaClass, kSeaClass,
+};
+
+int tileClass(GSTile tile) {
+  return tile < kTokenTile ? kTileClasses[tile] : kSeaClass;
+}
+
 int isForestLikeTile(GSTile tiles[][WIDTH], int x, int y) {
   if (x < 0 || x >= 256 || y < 0 || y >= 256) {
     return 1;
@@ -40,6 +40,20 @@ enum {
 
 typedef uint8_t GSTile;
 
+// coarse kinds of terrain, mines are ignored
+enum {
+  kSeaClass = 0,
+  kRiverClass,   // river and boats
+  kWallClass,    // walls and damaged walls
+  kRoadClass,
+  kGrassClass,
+  kForestClass,
+  kRoughClass,   // swamp, crater and rubble
+  kTileClassCount
+} ;
+
+int tileClass(GSTile tile);
+
 int isForestLikeTile(GSTile tiles[][WIDTH], int x, int y);
 int isCraterLikeTile(GSTile tiles[][WIDTH], int x, int y);
 int isRoadLikeTile(GSTile tiles[][WIDTH], int x, int y);
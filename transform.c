@@ -0,0 +1,256 @@
+//
+//  transform.c
+//  XBolo Map Editor
+//
+//  Created by Robert Chrzanowski on 10/19/26.
+//  Copyright 2026 Robert Chrzanowski. All rights reserved.
+//
+
+#include "transform.h"
+
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+
+// rotations and transposes are done in 16x16 blocks so that both the
+// reads and the writes of a block stay within a few cache lines
+#define BLOCK (16)
+
+static void transposeBlock(const GSTile *src, ptrdiff_t srcStride, GSTile *dst, ptrdiff_t dstStride);
+static void transposeEdge(const GSTile *src, ptrdiff_t srcStride, GSTile *dst, ptrdiff_t dstStride, int width, int height);
+static void transposeBlocks(const GSTile *src, ptrdiff_t srcStride, GSTile *dst, ptrdiff_t dstStride, int width, int height);
+static void transposeSquareTiles(GSTile *tiles, int width);
+
+// dst row j is dst + j*dstStride and src row i is src + i*srcStride,
+// strides may be negative to mirror rows while transposing
+void transposeBlocks(const GSTile *src, ptrdiff_t srcStride, GSTile *dst, ptrdiff_t dstStride, int width, int height) {
+  int bx, by;
+
+  for (by = 0; by + BLOCK <= height; by += BLOCK) {
+    for (bx = 0; bx + BLOCK <= width; bx += BLOCK) {
+      transposeBlock(src + (by * srcStride) + bx, srcStride, dst + (bx * dstStride) + by, dstStride);
+    }
+
+    // right edge
+    if (bx < width) {
+      transposeEdge(src + (by * srcStride) + bx, srcStride, dst + (bx * dstStride) + by, dstStride, width - bx, BLOCK);
+    }
+  }
+
+  // bottom edge
+  if (by < height) {
+    transposeEdge(src + (by * srcStride), srcStride, dst + by, dstStride, width, height - by);
+  }
+}
+
+void transposeTiles(GSTile *dst, const GSTile *src, int width, int height) {
+  transposeBlocks(src, width, dst, height, width, height);
+}
+
+void rotateTilesLeft(GSTile *dst, const GSTile *src, int width, int height) {
+  // dst[width - 1 - x][y] = src[y][x]
+  transposeBlocks(src, width, dst + ((width - 1) * height), -height, width, height);
+}
+
+void rotateTilesRight(GSTile *dst, const GSTile *src, int width, int height) {
+  // dst[x][height - 1 - y] = src[y][x], read src bottom up
+  transposeBlocks(src + ((height - 1) * width), -width, dst, height, width, height);
+}
+
+void rotateSquareTilesLeft(GSTile *tiles, int width) {
+  transposeSquareTiles(tiles, width);
+  flipTilesVertical(tiles, width, width);
+}
+
+void rotateSquareTilesRight(GSTile *tiles, int width) {
+  transposeSquareTiles(tiles, width);
+  flipTilesHorizontal(tiles, width, width);
+}
+
+void flipTilesHorizontal(GSTile *tiles, int width, int height) {
+  int y;
+
+  for (y = 0; y < height; y++) {
+    reverseTiles(tiles + (y * width), width);
+  }
+}
+
+void flipTilesVertical(GSTile *tiles, int width, int height) {
+  GSTile t[WIDTH];
+  int y;
+
+  for (y = 0; y < height/2; y++) {
+    GSTile *top = tiles + (y * width);
+    GSTile *bottom = tiles + ((height - 1 - y) * width);
+    int x, n;
+
+    for (x = 0; x < width; x += n) {
+      n = width - x < WIDTH ? width - x : WIDTH;
+      memcpy(t, top + x, n);
+      memcpy(top + x, bottom + x, n);
+      memcpy(bottom + x, t, n);
+    }
+  }
+}
+
+#if defined(__SSE2__)
+
+static inline __m128i reverse16(__m128i v) {
+  v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));  // swap bytes in words
+  v = _mm_shufflelo_epi16(v, 0x1b);                               // reverse words in each half
+  v = _mm_shufflehi_epi16(v, 0x1b);
+  return _mm_shuffle_epi32(v, 0x4e);                              // swap halves
+}
+
+void reverseTiles(GSTile *tiles, int n) {
+  int i, j;
+
+  // swap 16 tiles from each end at a time
+  for (i = 0, j = n; j - i >= 2*BLOCK; i += BLOCK, j -= BLOCK) {
+    __m128i a = _mm_loadu_si128((const __m128i *)(tiles + i));
+    __m128i b = _mm_loadu_si128((const __m128i *)(tiles + j - BLOCK));
+    _mm_storeu_si128((__m128i *)(tiles + i), reverse16(b));
+    _mm_storeu_si128((__m128i *)(tiles + j - BLOCK), reverse16(a));
+  }
+
+  for (j--; i < j; i++, j--) {
+    GSTile t = tiles[i];
+    tiles[i] = tiles[j];
+    tiles[j] = t;
+  }
+}
+
+// four rounds of interleaving row k with row k + 8 is a 16x16 transpose
+void transposeBlock(const GSTile *src, ptrdiff_t srcStride, GSTile *dst, ptrdiff_t dstStride) {
+  __m128i a[BLOCK], b[BLOCK];
+  int k, round;
+
+  for (k = 0; k < BLOCK; k++) {
+    a[k] = _mm_loadu_si128((const __m128i *)(src + (k * srcStride)));
+  }
+
+  for (round = 0; round < 4; round++) {
+    __m128i *from = round % 2 ? b : a;
+    __m128i *to = round % 2 ? a : b;
+
+    for (k = 0; k < BLOCK/2; k++) {
+      to[2*k] = _mm_unpacklo_epi8(from[k], from[k + BLOCK/2]);
+      to[2*k + 1] = _mm_unpackhi_epi8(from[k], from[k + BLOCK/2]);
+    }
+  }
+
+  for (k = 0; k < BLOCK; k++) {
+    _mm_storeu_si128((__m128i *)(dst + (k * dstStride)), a[k]);
+  }
+}
+
+#elif defined(__ARM_NEON)
+
+void reverseTiles(GSTile *tiles, int n) {
+  int i, j;
+
+  for (i = 0, j = n; j - i >= 2*BLOCK; i += BLOCK, j -= BLOCK) {
+    uint8x16_t a = vrev64q_u8(vld1q_u8(tiles + i));
+    uint8x16_t b = vrev64q_u8(vld1q_u8(tiles + j - BLOCK));
+    vst1q_u8(tiles + i, vcombine_u8(vget_high_u8(b), vget_low_u8(b)));
+    vst1q_u8(tiles + j - BLOCK, vcombine_u8(vget_high_u8(a), vget_low_u8(a)));
+  }
+
+  for (j--; i < j; i++, j--) {
+    GSTile t = tiles[i];
+    tiles[i] = tiles[j];
+    tiles[j] = t;
+  }
+}
+
+void transposeBlock(const GSTile *src, ptrdiff_t srcStride, GSTile *dst, ptrdiff_t dstStride) {
+  uint8x16_t a[BLOCK], b[BLOCK];
+  int k, round;
+
+  for (k = 0; k < BLOCK; k++) {
+    a[k] = vld1q_u8(src + (k * srcStride));
+  }
+
+  for (round = 0; round < 4; round++) {
+    uint8x16_t *from = round % 2 ? b : a;
+    uint8x16_t *to = round % 2 ? a : b;
+
+    for (k = 0; k < BLOCK/2; k++) {
+      uint8x16x2_t z = vzipq_u8(from[k], from[k + BLOCK/2]);
+      to[2*k] = z.val[0];
+      to[2*k + 1] = z.val[1];
+    }
+  }
+
+  for (k = 0; k < BLOCK; k++) {
+    vst1q_u8(dst + (k * dstStride), a[k]);
+  }
+}
+
+#else
+
+void reverseTiles(GSTile *tiles, int n) {
+  int i, j;
+
+  for (i = 0, j = n - 1; i < j; i++, j--) {
+    GSTile t = tiles[i];
+    tiles[i] = tiles[j];
+    tiles[j] = t;
+  }
+}
+
+void transposeBlock(const GSTile *src, ptrdiff_t srcStride, GSTile *dst, ptrdiff_t dstStride) {
+  transposeEdge(src, srcStride, dst, dstStride, BLOCK, BLOCK);
+}
+
+#endif
+
+void transposeEdge(const GSTile *src, ptrdiff_t srcStride, GSTile *dst, ptrdiff_t dstStride, int width, int height) {
+  int x, y;
+
+  for (y = 0; y < height; y++) {
+    for (x = 0; x < width; x++) {
+      dst[(x * dstStride) + y] = src[(y * srcStride) + x];
+    }
+  }
+}
+
+// swaps mirrored blocks across the diagonal through a pair of scratch blocks
+void transposeSquareTiles(GSTile *tiles, int width) {
+  GSTile a[BLOCK*BLOCK], b[BLOCK*BLOCK];
+  int bx, by, x, y;
+
+  for (by = 0; by + BLOCK <= width; by += BLOCK) {
+    for (bx = by; bx + BLOCK <= width; bx += BLOCK) {
+      GSTile *upper = tiles + (by * width) + bx;
+      GSTile *lower = tiles + (bx * width) + by;
+
+      transposeBlock(upper, width, a, BLOCK);
+      transposeBlock(lower, width, b, BLOCK);
+
+      for (y = 0; y < BLOCK; y++) {
+        memcpy(lower + (y * width), a + (y * BLOCK), BLOCK);
+      }
+
+      if (bx != by) {
+        for (y = 0; y < BLOCK; y++) {
+          memcpy(upper + (y * width), b + (y * BLOCK), BLOCK);
+        }
+      }
+    }
+  }
+
+  // the partial blocks along the right and bottom edges
+  for (y = 0; y < width; y++) {
+    for (x = y > by ? y + 1 : by; x < width; x++) {
+      GSTile t = tiles[(y * width) + x];
+      tiles[(y * width) + x] = tiles[(x * width) + y];
+      tiles[(x * width) + y] = t;
+    }
+  }
+}
@@ -0,0 +1,36 @@
+//
+//  transform.h
+//  XBolo Map Editor
+//
+//  Created by Robert Chrzanowski on 10/19/26.
+//  Copyright 2026 Robert Chrzanowski. All rights reserved.
+//
+
+#ifndef __TRANSFORM__
+#define __TRANSFORM__
+
+#include <stddef.h>
+#include "tiles.h"
+
+
+// tile buffers are row major with a stride equal to their width
+
+// rotates a width x height buffer into a height x width buffer, src and dst must not overlap
+void rotateTilesLeft(GSTile *dst, const GSTile *src, int width, int height);
+void rotateTilesRight(GSTile *dst, const GSTile *src, int width, int height);
+
+// rotates a width x width buffer in place
+void rotateSquareTilesLeft(GSTile *tiles, int width);
+void rotateSquareTilesRight(GSTile *tiles, int width);
+
+// mirrors a buffer in place
+void flipTilesHorizontal(GSTile *tiles, int width, int height);
+void flipTilesVertical(GSTile *tiles, int width, int height);
+
+// transposes a width x height buffer into a height x width buffer, src and dst must not overlap
+void transposeTiles(GSTile *dst, const GSTile *src, int width, int height);
+
+// reverses n tiles in place
+void reverseTiles(GSTile *tiles, int n);
+
+#endif  // __TRANSFORM__
@@ -0,0 +1,397 @@
+//
+//  visibility.c
+//  XBolo Map Editor
+//
+//  Created by Robert Chrzanowski on 10/19/26.
+//  Copyright 2026 Robert Chrzanowski. All rights reserved.
+//
+
+#include "visibility.h"
+#include "errchk.h"
+
+#include <stdlib.h>
+#include <strings.h>
+
+
+#define SPAN      VISIBILITY_SPAN
+#define WORDS     VISIBILITY_WORDS
+#define ROWWORDS  (WIDTH/64)  // words of a row of walls or forest
+#define SPANMASK  ((UINT64_C(1) << SPAN) - 1)
+
+enum {
+  kOpenSight = 0,
+  kWallSight,    // blocks sight and is not a viewer
+  kForestSight   // hides a tank in it beyond the next tile
+} ;
+
+// views are kept for every tile, walls with nothing in them
+struct GSVisibility {
+  uint8_t sights[WIDTH][WIDTH];
+  uint64_t walls[WIDTH][ROWWORDS];   // bit x of row y set for a wall at x, y
+  uint64_t forest[WIDTH][ROWWORDS];
+  uint64_t open[SPAN];               // cells of each row of a window in sight of the centre
+  uint64_t near[SPAN];               // cells next to the centre
+  uint64_t (*views)[WIDTH][WORDS];
+  uint16_t sees[WIDTH][WIDTH];
+  uint16_t seenBy[WIDTH][WIDTH];
+  int openView;  // tiles seen from the middle of an open field
+  double slopes[SIGHT_RANGE + 1][SIGHT_RANGE + 1][2];  // left and right of the cell -dx along row dy
+} ;
+
+// the column and row steps of each octant's x and y
+static const int kOctants[8][4] = {
+  {  1,  0,  0,  1 }, {  0,  1,  1,  0 }, {  0, -1,  1,  0 }, { -1,  0,  0,  1 },
+  { -1,  0,  0, -1 }, {  0, -1, -1,  0 }, {  0,  1, -1,  0 }, {  1,  0,  0, -1 },
+};
+
+static int sightOf(GSTile tile);
+static void recast(GSVisibility *visibility, GSRect viewers);
+static void castView(const GSVisibility *visibility, GSPoint viewer, uint64_t seen[WORDS]);
+static int isBlocked(const GSVisibility *visibility, int x, int y);
+static void setSight(GSVisibility *visibility, int x, int y, int sight);
+static uint64_t rowBits(const uint64_t rows[][ROWWORDS], int x, int y);
+static int castOpenView(const GSVisibility *visibility, GSPoint viewer, uint64_t seen[WORDS]);
+static void castOctant(const GSVisibility *visibility, GSPoint viewer, const int octant[4], int row, double start, double end, uint64_t seen[WORDS]);
+static void applyView(GSVisibility *visibility, GSPoint viewer, const uint64_t to[WORDS]);
+static int neighbourViewers(const GSVisibility *visibility, GSPoint point);
+
+GSVisibility *visibilityCreate(GSTile tiles[][WIDTH]) {
+  GSVisibility *visibility;
+  int x, y, dx, dy;
+
+  visibility = NULL;
+
+TRY
+  if ((visibility = malloc(sizeof(GSVisibility))) == NULL) LOGFAIL(errno)
+  bzero(visibility, sizeof(GSVisibility));
+  if ((visibility->views = calloc(WIDTH, sizeof(*visibility->views))) == NULL) LOGFAIL(errno)
+
+  for (dy = -SIGHT_RANGE; dy <= SIGHT_RANGE; dy++) {
+    for (dx = -SIGHT_RANGE; dx <= SIGHT_RANGE; dx++) {
+      if ((dx != 0 || dy != 0) && dx*dx + dy*dy <= SIGHT_RANGE*SIGHT_RANGE) {
+        visibility->open[dy + SIGHT_RANGE] |= UINT64_C(1) << (dx + SIGHT_RANGE);
+        visibility->openView++;
+      }
+
+      if ((dx != 0 || dy != 0) && abs(dx) <= 1 && abs(dy) <= 1) {
+        visibility->near[dy + SIGHT_RANGE] |= UINT64_C(1) << (dx + SIGHT_RANGE);
+      }
+    }
+  }
+
+  for (dy = 1; dy <= SIGHT_RANGE; dy++) {
+    for (dx = -dy; dx <= 0; dx++) {
+      visibility->slopes[dy][-dx][0] = (dx - 0.5)/(-dy + 0.5);
+      visibility->slopes[dy][-dx][1] = (dx + 0.5)/(-dy - 0.5);
+    }
+  }
+
+  for (y = 0; y < WIDTH; y++) {
+    for (x = 0; x < WIDTH; x++) {
+      setSight(visibility, x, y, sightOf(tiles[y][x]));
+    }
+  }
+
+  recast(visibility, kWorldRect);
+
+CLEANUP
+  if (visibility != NULL && visibility->views == NULL) {
+    free(visibility);
+    visibility = NULL;
+  }
+
+ERRHANDLER(visibility, NULL)
+END
+}
+
+void visibilityDestroy(GSVisibility *visibility) {
+  free(visibility->views);
+  free(visibility);
+}
+
+GSRect visibilityUpdateRect(GSVisibility *visibility, GSTile tiles[][WIDTH], GSRect rect) {
+  GSRect changed, viewers;
+  int x, y, minx, maxx, miny, maxy;
+
+  rect = GSIntersectionRect(rect, kWorldRect);
+  minx = miny = WIDTH;
+  maxx = maxy = -1;
+
+  for (y = GSMinY(rect); y <= GSMaxY(rect); y++) {
+    for (x = GSMinX(rect); x <= GSMaxX(rect); x++) {
+      int sight = sightOf(tiles[y][x]);
+
+      if (sight != visibility->sights[y][x]) {
+        setSight(visibility, x, y, sight);
+        minx = MIN(minx, x);
+        maxx = MAX(maxx, x);
+        miny = MIN(miny, y);
+        maxy = MAX(maxy, y);
+      }
+    }
+  }
+
+  if (maxx == -1) {
+    return GSMakeRect(0, 0, 0, 0);
+  }
+
+  changed = GSMakeRect(minx, miny, maxx - minx + 1, maxy - miny + 1);
+  viewers = GSIntersectionRect(GSInsetRect(changed, -SIGHT_RANGE, -SIGHT_RANGE), kWorldRect);
+  recast(visibility, viewers);
+
+  return GSIntersectionRect(GSInsetRect(viewers, -SIGHT_RANGE, -SIGHT_RANGE), kWorldRect);
+}
+
+void visibilityView(const GSVisibility *visibility, GSPoint viewer, uint64_t seen[WORDS]) {
+  bcopy(visibility->views[viewer.y][viewer.x], seen, WORDS*sizeof(uint64_t));
+}
+
+const uint16_t (*visibilitySees(const GSVisibility *visibility))[WIDTH] {
+  return visibility->sees;
+}
+
+const uint16_t (*visibilitySeenBy(const GSVisibility *visibility))[WIDTH] {
+  return visibility->seenBy;
+}
+
+// the tiles next to a viewer always see it, so it is concealed when they
+// are all that do
+int visibilityIsConcealed(const GSVisibility *visibility, GSPoint point) {
+  return visibility->sights[point.y][point.x] != kWallSight &&
+         visibility->seenBy[point.y][point.x] == neighbourViewers(visibility, point);
+}
+
+int visibilityIsSnipe(const GSVisibility *visibility, GSPoint point) {
+  return visibilityIsConcealed(visibility, point) && 2*visibility->sees[point.y][point.x] >= visibility->openView;
+}
+
+void visibilityStats(const GSVisibility *visibility, struct GSVisibilityStats *stats) {
+  int64_t sees;
+  int x, y;
+
+  bzero(stats, sizeof(struct GSVisibilityStats));
+  sees = 0;
+
+  for (y = 0; y < WIDTH; y++) {
+    for (x = 0; x < WIDTH; x++) {
+      if (visibility->sights[y][x] == kWallSight) {
+        continue;
+      }
+
+      stats->viewers++;
+      sees += visibility->sees[y][x];
+
+      stats->concealed += visibilityIsConcealed(visibility, GSMakePoint(x, y));
+      stats->snipes += visibilityIsSnipe(visibility, GSMakePoint(x, y));
+    }
+  }
+
+  stats->meanSees = stats->viewers > 0 ? (double)sees/stats->viewers : 0.0;
+}
+
+int sightOf(GSTile tile) {
+  switch (tileClass(tile)) {
+  case kWallClass:
+    return kWallSight;
+
+  case kForestClass:
+    return kForestSight;
+
+  default:
+    return kOpenSight;
+  }
+}
+
+void recast(GSVisibility *visibility, GSRect viewers) {
+  uint64_t seen[WORDS];
+  int x, y;
+
+  for (y = GSMinY(viewers); y <= GSMaxY(viewers); y++) {
+    for (x = GSMinX(viewers); x <= GSMaxX(viewers); x++) {
+      castView(visibility, GSMakePoint(x, y), seen);
+      applyView(visibility, GSMakePoint(x, y), seen);
+    }
+  }
+}
+
+// shadowcasting, each octant is swept row by row outwards between the
+// slopes still lit, a wall shades the slopes it spans from the rows beyond
+void castView(const GSVisibility *visibility, GSPoint viewer, uint64_t seen[WORDS]) {
+  int i;
+
+  bzero(seen, WORDS*sizeof(uint64_t));
+
+  if (visibility->sights[viewer.y][viewer.x] == kWallSight || castOpenView(visibility, viewer, seen)) {
+    return;
+  }
+
+  for (i = 0; i < 8; i++) {
+    castOctant(visibility, viewer, kOctants[i], 1, 1.0, 0.0, seen);
+  }
+}
+
+// nothing is shaded in a window on the map without walls, so its view is
+// every cell in sight but the forest beyond the next tiles.  returns 0
+// leaving seen empty if the window has walls or leaves the map
+int castOpenView(const GSVisibility *visibility, GSPoint viewer, uint64_t seen[WORDS]) {
+  int x, y, row;
+
+  x = viewer.x - SIGHT_RANGE;
+  y = viewer.y - SIGHT_RANGE;
+
+  if (x < 0 || y < 0 || x + SPAN > WIDTH || y + SPAN > WIDTH) {
+    return 0;
+  }
+
+  for (row = 0; row < SPAN; row++) {
+    if (rowBits(visibility->walls, x, y + row) != 0) {
+      bzero(seen, WORDS*sizeof(uint64_t));
+      return 0;
+    }
+  }
+
+  for (row = 0; row < SPAN; row++) {
+    uint64_t bits = visibility->open[row] & (~rowBits(visibility->forest, x, y + row) | visibility->near[row]);
+    int at = row*SPAN;
+
+    seen[at/64] |= bits << (at%64);
+
+    if (at%64 + SPAN > 64) {
+      seen[at/64 + 1] |= bits >> (64 - at%64);
+    }
+  }
+
+  return 1;
+}
+
+void setSight(GSVisibility *visibility, int x, int y, int sight) {
+  uint64_t bit = UINT64_C(1) << (x%64);
+
+  visibility->sights[y][x] = sight;
+  visibility->walls[y][x/64] &= ~bit;
+  visibility->forest[y][x/64] &= ~bit;
+
+  if (sight == kWallSight) {
+    visibility->walls[y][x/64] |= bit;
+  }
+  else if (sight == kForestSight) {
+    visibility->forest[y][x/64] |= bit;
+  }
+}
+
+// SPAN bits of rows from x, y, the span must be on the map
+uint64_t rowBits(const uint64_t rows[][ROWWORDS], int x, int y) {
+  uint64_t bits = rows[y][x/64] >> (x%64);
+
+  if (x%64 + SPAN > 64) {
+    bits |= rows[y][x/64 + 1] << (64 - x%64);
+  }
+
+  return bits & SPANMASK;
+}
+
+// tiles off the map block
+int isBlocked(const GSVisibility *visibility, int x, int y) {
+  return x < 0 || x >= WIDTH || y < 0 || y >= WIDTH || visibility->sights[y][x] == kWallSight;
+}
+
+// row is the distance out from the viewer, a cell at column -row to 0 of
+// it spans the slopes from its left edge to its right edge, measured from
+// the far side of the octant so they fall from start to end.  a run of
+// walls narrows the lit slopes of the next rows to either side of it
+void castOctant(const GSVisibility *visibility, GSPoint viewer, const int octant[4], int row, double start, double end, uint64_t seen[WORDS]) {
+  double next;
+  int blocked, dx, dy;
+
+  if (start < end) {
+    return;
+  }
+
+  next = start;
+
+  for (dy = row; dy <= SIGHT_RANGE; dy++) {
+    blocked = 0;
+
+    for (dx = -dy; dx <= 0; dx++) {
+      double left = visibility->slopes[dy][-dx][0];
+      double right = visibility->slopes[dy][-dx][1];
+      int x = viewer.x + dx*octant[0] + dy*octant[1];
+      int y = viewer.y + dx*octant[2] + dy*octant[3];
+      int wall;
+
+      if (start < right) {
+        continue;
+      }
+
+      if (end > left) {
+        break;
+      }
+
+      wall = isBlocked(visibility, x, y);
+
+      // a tank in forest shows only to the next tile
+      if (!wall && dx*dx + dy*dy <= SIGHT_RANGE*SIGHT_RANGE && (visibility->sights[y][x] != kForestSight || dy <= 1)) {
+        int cell = (y - viewer.y + SIGHT_RANGE)*SPAN + x - viewer.x + SIGHT_RANGE;
+        seen[cell/64] |= UINT64_C(1) << (cell%64);
+      }
+
+      if (blocked) {
+        if (wall) {
+          next = right;
+        }
+        else {
+          blocked = 0;
+          start = next;
+        }
+      }
+      else if (wall && dy < SIGHT_RANGE) {
+        blocked = 1;
+        castOctant(visibility, viewer, octant, dy + 1, start, left, seen);
+        next = right;
+      }
+    }
+
+    if (blocked) {
+      break;
+    }
+  }
+}
+
+// moves the seen counts of the cells of viewer's window from its old view
+// to its new one
+void applyView(GSVisibility *visibility, GSPoint viewer, const uint64_t to[WORDS]) {
+  uint64_t *from = visibility->views[viewer.y][viewer.x];
+  int w, sees;
+
+  for (sees = 0, w = 0; w < WORDS; w++) {
+    uint64_t removed = from[w] & ~to[w];
+    uint64_t added = to[w] & ~from[w];
+
+    for (; removed != 0; removed &= removed - 1) {
+      int cell = w*64 + __builtin_ctzll(removed);
+      visibility->seenBy[viewer.y - SIGHT_RANGE + cell/SPAN][viewer.x - SIGHT_RANGE + cell%SPAN]--;
+    }
+
+    for (; added != 0; added &= added - 1) {
+      int cell = w*64 + __builtin_ctzll(added);
+      visibility->seenBy[viewer.y - SIGHT_RANGE + cell/SPAN][viewer.x - SIGHT_RANGE + cell%SPAN]++;
+    }
+
+    from[w] = to[w];
+    sees += __builtin_popcountll(to[w]);
+  }
+
+  visibility->sees[viewer.y][viewer.x] = sees;
+}
+
+int neighbourViewers(const GSVisibility *visibility, GSPoint point) {
+  int dx, dy, n;
+
+  for (n = 0, dy = -1; dy <= 1; dy++) {
+    for (dx = -1; dx <= 1; dx++) {
+      n += (dx != 0 || dy != 0) && !isBlocked(visibility, point.x + dx, point.y + dy);
+    }
+  }
+
+  return n;
+}
@@ -0,0 +1,58 @@
+//
+//  visibility.h
+//  XBolo Map Editor
+//
+//  Created by Robert Chrzanowski on 10/19/26.
+//  Copyright 2026 Robert Chrzanowski. All rights reserved.
+//
+
+#ifndef __VISIBILITY__
+#define __VISIBILITY__
+
+#include <stdint.h>
+#include "bmap.h"
+
+
+#define SIGHT_RANGE       (8)  // tiles a tank looks, as far as its shells reach
+#define VISIBILITY_SPAN   (2*SIGHT_RANGE + 1)
+#define VISIBILITY_WORDS  ((VISIBILITY_SPAN*VISIBILITY_SPAN + 63)/64)
+
+// what every tile can see of the tiles a tank can be on.  walls block sight
+// and can not be stood on, a tank in forest is hidden from all but the
+// tiles next to it.  each tile's view is cast by shadowcasting into a
+// bitboard of the window around it, so a change of walls or forest
+// recasts only the views it falls in
+typedef struct GSVisibility GSVisibility;
+
+struct GSVisibilityStats {
+  int viewers;      // tiles that are not walls
+  double meanSees;  // tiles seen from each viewer, the same as seeing it
+  int concealed;    // viewers seen from no further than the next tile
+  int snipes;       // concealed viewers seeing at least half an open view
+} ;
+
+// create/destroy the visibility of tiles, creating casts every tile's view
+GSVisibility *visibilityCreate(GSTile tiles[][WIDTH]);
+void visibilityDestroy(GSVisibility *visibility);
+
+// rereads the walls and forest of rect after its tiles changed and recasts
+// the views they fall in if any changed.  returns the rect of tiles whose
+// counts may have changed
+GSRect visibilityUpdateRect(GSVisibility *visibility, GSTile tiles[][WIDTH], GSRect rect);
+
+// tiles seen from viewer, bit row*VISIBILITY_SPAN + column of the window
+// centred on it
+void visibilityView(const GSVisibility *visibility, GSPoint viewer, uint64_t seen[VISIBILITY_WORDS]);
+
+// tiles each tile sees and tiles each tile is seen from
+const uint16_t (*visibilitySees(const GSVisibility *visibility))[WIDTH];
+const uint16_t (*visibilitySeenBy(const GSVisibility *visibility))[WIDTH];
+
+// is a viewer seen from no further than the next tile, and is it also a
+// snipe seeing at least half as much as a viewer in the open
+int visibilityIsConcealed(const GSVisibility *visibility, GSPoint point);
+int visibilityIsSnipe(const GSVisibility *visibility, GSPoint point);
+
+void visibilityStats(const GSVisibility *visibility, struct GSVisibilityStats *stats);
+
+#endif  // __VISIBILITY__